@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: MIT
+
+// Contracts translated ahead of time by evmint-aot: every basic block becomes a C++ function with the
+// BlockFrame protocol of evm.hpp, built from the same word primitives the interpreter uses, and the
+// generated translation unit is compiled into evmint. The helpers below are what generated blocks
+// call to leave the block.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "evm.hpp"
+
+namespace evmint::aot {
+
+struct TranslatedCode {
+  std::span<std::byte const> bytecode;
+  std::span<std::uint8_t const> jump_destinations;
+  // indexed by program counter, nullptr where no translated block starts
+  std::span<BlockFunction const> blocks;
+
+  auto JumpDestinations() const -> std::uint8_t const* { return jump_destinations.data(); }
+  auto BlockAt(std::size_t program_counter) const -> BlockFunction { return blocks[program_counter]; }
+};
+
+// Defined in the translation unit generated by evmint-aot.
+auto TranslatedContracts() -> std::span<TranslatedCode const>;
+
+inline auto Continue(BlockFrame* frame, std::size_t program_counter, std::ptrdiff_t stack_delta) -> BlockExit {
+  frame->stack_size += stack_delta;
+  frame->program_counter = program_counter;
+  return BlockExit::kContinue;
+}
+
+inline auto Stop(BlockFrame* frame, std::size_t program_counter, std::ptrdiff_t stack_delta) -> BlockExit {
+  Continue(frame, program_counter, stack_delta);
+  return BlockExit::kStop;
+}
+
+// Restores the state before the instruction at `program_counter` for the interpreter to execute it.
+inline auto SideExit(BlockFrame* frame, std::size_t program_counter, std::ptrdiff_t stack_delta, std::size_t gas_refund) -> BlockExit {
+  frame->gas_left += gas_refund;
+  Continue(frame, program_counter, stack_delta);
+  return BlockExit::kSideExit;
+}
+
+// A JUMPDEST inside the code that the gas left can pay for; the interpreter reports any other target.
+inline auto IsJumpTarget(BlockFrame const* frame, word_t const& counter) -> bool {
+  return counter < word_t{frame->code_size} and frame->jump_destinations[static_cast<std::size_t>(counter)] != 0 and frame->gas_left >= kJumpDestGas;
+}
+
+// Jumps resume right after the JUMPDEST, charging its gas, as in the interpreter.
+inline auto Jump(BlockFrame* frame, word_t const& counter, std::ptrdiff_t stack_delta) -> BlockExit {
+  frame->gas_left -= kJumpDestGas;
+  return Continue(frame, static_cast<std::size_t>(counter) + 1, stack_delta);
+}
+
+inline auto IsWordInMemory(word_t const& offset) -> bool { return offset <= word_t{kMemorySize - kWordSize}; }
+
+// MSTORE at an offset IsWordInMemory() accepted.
+inline auto StoreToMemory(BlockFrame* frame, word_t const& offset, word_t const& value) -> void {
+  auto const memory_offset{static_cast<std::size_t>(offset)};
+  StoreWord(frame->memory + memory_offset, value);
+  frame->memory_size = std::max(frame->memory_size, memory_offset + kWordSize);
+}
+
+}  // namespace evmint::aot
@@ -0,0 +1,284 @@
+// SPDX-License-Identifier: MIT
+
+// evmint-aot: translates contract bytecode into a C++ translation unit for evmint (see aot.hpp).
+//
+//   evmint-aot <output.cpp> <contract.bin>...
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <format>
+#include <limits>
+#include <fstream>
+#include <print>
+#include <ranges>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "aot.hpp"
+#include "evm.hpp"
+
+using namespace evmint;
+
+namespace {
+
+// Emits one block function. Mirrors jit::BlockCompiler: stack slots are indexed relative to the
+// stack top on block entry, gas is charged on entry and anything off the happy path side-exits.
+class BlockTranslator {
+ public:
+  BlockTranslator(std::span<std::byte const> bytecode, BasicBlock const& block) : m_bytecode{bytecode}, m_block{block} {}
+
+  auto Translate() -> std::string {
+    Line("auto Block{}(BlockFrame* frame) -> BlockExit {{", m_block.begin);
+    auto entry_check = std::format("frame->stack_size > {}", kMaxStackSize - m_block.stack_growth);
+    if (m_block.stack_required != 0) {
+      entry_check += std::format(" or frame->stack_size < {}", m_block.stack_required);
+    }
+    if (m_block.gas_consumed != 0) {
+      entry_check += std::format(" or frame->gas_left < {}", m_block.gas_consumed);
+    }
+    Line("  if ({}) {{", entry_check);
+    Line("    return aot::SideExit(frame, {}, 0, 0);", m_block.begin);
+    Line("  }}");
+    Line("  frame->gas_left -= {};", m_block.gas_consumed);
+    Line("  [[maybe_unused]] auto* const stack{{frame->stack_base + frame->stack_size}};");
+
+    m_gas_remaining = m_block.gas_consumed;
+    for (std::size_t pc{m_block.begin}; pc < m_block.end; pc += 1 + ImmediateSize(m_bytecode[pc])) {
+      Line("  // {}: {:#04x}", pc, static_cast<std::uint8_t>(m_bytecode[pc]));
+      if (not TranslateInstruction(pc)) {
+        Line("}}");
+        return m_code;
+      }
+      m_gas_remaining -= kOpcodeInfo.at(m_bytecode[pc]).gas_consumed;
+    }
+
+    Line("  return aot::Continue(frame, {}, {});", m_block.end, m_stack_delta);
+    Line("}}");
+    return m_code;
+  }
+
+ private:
+  std::span<std::byte const> m_bytecode;
+  BasicBlock const& m_block;
+  std::string m_code{};
+  std::ptrdiff_t m_stack_delta{0};
+  std::size_t m_gas_remaining{0};
+
+  template <typename... Args>
+  auto Line(std::format_string<Args...> format, Args&&... args) -> void {
+    m_code += std::format(format, std::forward<Args>(args)...);
+    m_code += '\n';
+  }
+
+  // `stack[...]` of the item `depth` below the current top
+  auto Slot(std::size_t depth) const -> std::string { return std::format("stack[{}]", m_stack_delta - 1 - static_cast<std::ptrdiff_t>(depth)); }
+
+  auto SideExit(std::size_t pc) const -> std::string { return std::format("return aot::SideExit(frame, {}, {}, {});", pc, m_stack_delta, m_gas_remaining); }
+
+  auto BinaryOperation(std::string_view operation) -> void {
+    Line("  {1} = {2}{{}}({0}, {1});", Slot(0), Slot(1), operation);
+    m_stack_delta--;
+  }
+
+  auto Comparison(std::string_view operation) -> void {
+    Line("  {1} = word_t{{{2}{{}}({0}, {1})}};", Slot(0), Slot(1), operation);
+    m_stack_delta--;
+  }
+
+  auto JumpIfValid(std::size_t pc, std::ptrdiff_t stack_delta_after) -> void {
+    Line("  if (aot::IsJumpTarget(frame, {})) {{", Slot(0));
+    Line("    return aot::Jump(frame, {}, {});", Slot(0), stack_delta_after);
+    Line("  }}");
+    Line("  {}", SideExit(pc));
+  }
+
+  // returns false once the block has been left
+  auto TranslateInstruction(std::size_t pc) -> bool {
+    auto const opcode{m_bytecode[pc]};
+
+    if (auto const num_bytes{ImmediateSize(opcode)}; num_bytes != 0 or opcode == kPush0) {
+      word_t value{0};
+      if (num_bytes != 0) {
+        value = to_uint256(std::span{reinterpret_cast<std::uint8_t const*>(m_bytecode.data() + pc + 1), num_bytes});
+      }
+      m_stack_delta++;
+      if (value <= word_t{std::numeric_limits<std::uint64_t>::max()}) {
+        Line("  {} = word_t{{{:#x}}};", Slot(0), value[0]);
+      } else {
+        Line("  {} = word_t{{{:#x}, {:#x}, {:#x}, {:#x}}};", Slot(0), value[0], value[1], value[2], value[3]);
+      }
+      return true;
+    }
+
+    switch (opcode) {
+      case kStop:
+        Line("  return aot::Stop(frame, {}, {});", pc + 1, m_stack_delta);
+        return false;
+      case kAdd:
+        BinaryOperation("std::plus<>");
+        return true;
+      case kMul:
+        BinaryOperation("std::multiplies<>");
+        return true;
+      case kSub:
+        BinaryOperation("std::minus<>");
+        return true;
+      case kAnd:
+        BinaryOperation("std::bit_and<>");
+        return true;
+      case kOr:
+        BinaryOperation("std::bit_or<>");
+        return true;
+      case kXor:
+        BinaryOperation("std::bit_xor<>");
+        return true;
+      case kLt:
+        Comparison("std::less<>");
+        return true;
+      case kGt:
+        Comparison("std::greater<>");
+        return true;
+      case kEq:
+        Comparison("std::equal_to<>");
+        return true;
+      case kIsZero:
+        Line("  {0} = word_t{{std::logical_not<>{{}}({0})}};", Slot(0));
+        return true;
+      case kNot:
+        Line("  {0} = std::bit_not<>{{}}({0});", Slot(0));
+        return true;
+      case kShl:
+        Line("  {1} = {1} << {0};", Slot(0), Slot(1));
+        m_stack_delta--;
+        return true;
+      case kShr:
+        Line("  {1} = {1} >> {0};", Slot(0), Slot(1));
+        m_stack_delta--;
+        return true;
+      case kPop:
+        m_stack_delta--;
+        return true;
+      case kMLoad:
+        Line("  if (not aot::IsWordInMemory({})) {{", Slot(0));
+        Line("    {}", SideExit(pc));
+        Line("  }}");
+        Line("  {0} = LoadWord(frame->memory + static_cast<std::size_t>({0}));", Slot(0));
+        return true;
+      case kMStore:
+        Line("  if (not aot::IsWordInMemory({})) {{", Slot(0));
+        Line("    {}", SideExit(pc));
+        Line("  }}");
+        Line("  aot::StoreToMemory(frame, {}, {});", Slot(0), Slot(1));
+        m_stack_delta -= 2;
+        return true;
+      case kJump:
+        JumpIfValid(pc, m_stack_delta - 1);
+        return false;
+      case kJumpI:
+        Line("  if ({} == 0) {{", Slot(1));
+        Line("    return aot::Continue(frame, {}, {});", pc + 1, m_stack_delta - 2);
+        Line("  }}");
+        JumpIfValid(pc, m_stack_delta - 2);
+        return false;
+      case kJumpDest:
+        return true;
+      case kDup1:
+      case kDup2:
+      case kDup3: {
+        auto const source{Slot(static_cast<std::size_t>(opcode) - static_cast<std::size_t>(kDup1))};
+        m_stack_delta++;
+        Line("  {} = {};", Slot(0), source);
+        return true;
+      }
+      case kSwap1:
+        Line("  std::swap({}, {});", Slot(0), Slot(1));
+        return true;
+      default:
+        // not reached: AnalyzeCode() ends blocks before opcodes missing from kOpcodeInfo
+        Line("  {}", SideExit(pc));
+        return false;
+    }
+  }
+};
+
+// prefixed, since a file stem may start with a digit or be a keyword
+auto ToIdentifier(std::string_view name) -> std::string {
+  return "contract_" + (name | std::views::transform([](char character) { return std::isalnum(static_cast<unsigned char>(character)) ? character : '_'; }) | std::ranges::to<std::string>());
+}
+
+auto InitializerList(auto const& elements, auto&& to_literal) -> std::string {
+  std::string list{};
+  for (auto const& element : elements) {
+    list += to_literal(element);
+    list += ", ";
+  }
+  return list;
+}
+
+auto TranslateContract(std::filesystem::path const& bc_filepath, std::string const& name) -> std::string {
+  auto const bytecode{ReadBytecodeFile(bc_filepath.string())};
+  auto const analysis{AnalyzeCode(bytecode)};
+
+  std::string code{std::format("// {}\nnamespace {} {{\n\n", bc_filepath.filename().string(), name)};
+  auto const byte_literal = [](std::byte byte) { return std::format("std::byte{{{:#04x}}}", static_cast<unsigned>(byte)); };
+  auto const flag_literal = [](std::uint8_t flag) { return std::format("{}", flag); };
+  code += std::format("constexpr std::array<std::byte, {}> kBytecode{{{}}};\n", bytecode.size(), InitializerList(bytecode, byte_literal));
+  code += std::format("constexpr std::array<std::uint8_t, {}> kJumpDestinations{{{}}};\n\n", bytecode.size(), InitializerList(analysis.jump_destinations, flag_literal));
+
+  // as in jit::Compile, a block that grows the stack past its limit always overflows and is left to the interpreter
+  auto translated_blocks{analysis.basic_blocks | std::views::filter([](BasicBlock const& block) { return block.stack_growth <= kMaxStackSize; })};
+  for (auto const& block : translated_blocks) {
+    code += BlockTranslator{bytecode, block}.Translate();
+    code += '\n';
+  }
+
+  code += std::format("constexpr auto kBlocks{{[] {{\n  std::array<BlockFunction, {}> blocks{{}};\n", bytecode.size());
+  for (auto const& block : translated_blocks) {
+    code += std::format("  blocks[{0}] = &Block{0};\n", block.begin);
+  }
+  code += std::format("  return blocks;\n}}()}};\n\n}}  // namespace {}\n\n", name);
+  return code;
+}
+
+}  // namespace
+
+auto main(int argc, char* argv[]) -> int {
+  if (argc < 2) {
+    std::println("usage: {} <output.cpp> <contract.bin>...", argv[0]);
+    return 1;
+  }
+
+  std::vector<std::filesystem::path> const bc_filepaths(argv + 2, argv + argc);
+  std::vector<std::string> names{};
+  for (auto const& bc_filepath : bc_filepaths) {
+    names.push_back(ToIdentifier(bc_filepath.stem().string()));
+    if (std::ranges::count(names, names.back()) > 1) {
+      std::println("[ERROR] '{}' translates to the same name as another contract ({}).", bc_filepath.string(), names.back());
+      return 1;
+    }
+  }
+
+  std::string code{"// Generated by evmint-aot, do not edit.\n\n#include <array>\n#include <functional>\n#include <utility>\n\n#include \"aot.hpp\"\n\n"};
+  code += "namespace evmint::aot {\nnamespace {\n\n";
+  for (auto const& [bc_filepath, name] : std::views::zip(bc_filepaths, names)) {
+    code += TranslateContract(bc_filepath, name);
+  }
+  code += "}  // namespace\n\n";
+
+  code += "auto TranslatedContracts() -> std::span<TranslatedCode const> {\n";
+  code += std::format("  static std::array<TranslatedCode, {}> const kTranslatedContracts{{{{\n", bc_filepaths.size());
+  for (auto const& name : names) {
+    code += std::format("      {{{0}::kBytecode, {0}::kJumpDestinations, {0}::kBlocks}},\n", name);
+  }
+  code += "  }};\n  return kTranslatedContracts;\n}\n\n}  // namespace evmint::aot\n";
+
+  std::ofstream output{argv[1]};
+  if (not output.is_open()) {
+    std::println("[ERROR] Could not write '{}'.", argv[1]);
+    return 1;
+  }
+  output << code;
+  return 0;
+}
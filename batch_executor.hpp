@@ -0,0 +1,148 @@
+// SPDX-License-Identifier: MIT
+
+// Parallel execution of independent jobs (calls into contracts against a shared state) with work stealing.
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "evm.hpp"
+#include "interpreter.hpp"
+#include "state.hpp"
+#include "worker_pool.hpp"
+
+namespace evmint {
+
+struct BatchJob {
+  // shared, a batch typically runs the same contract many times
+  std::shared_ptr<std::vector<std::byte> const> bytecode{};
+  std::vector<std::byte> calldata{};
+  std::shared_ptr<StateView const> state{};
+  // account the code runs as
+  word_t address{0};
+  std::size_t gas_limit{kDefaultGasLimit};
+};
+
+struct BatchJobResult {
+  bool succeeded{false};
+  std::size_t gas_used{0};
+  // empty unless the job succeeded
+  Storage storage_writes{};
+};
+
+struct WorkerStatistics {
+  std::size_t jobs_executed{0};
+  // jobs taken over from other workers' ranges
+  std::size_t jobs_stolen{0};
+  std::size_t gas_used{0};
+  std::chrono::nanoseconds busy_time{0};
+};
+
+// Runs batches of independent jobs on a WorkerPool. A batch is split into one contiguous range of job indices per
+// worker; a worker that runs out steals the upper half of the first non-empty range it finds, so uneven jobs still
+// keep every worker busy.
+class BatchExecutor final {
+ public:
+  explicit BatchExecutor(std::size_t worker_count = std::max(std::thread::hardware_concurrency(), 1u), DispatchMode dispatch_mode = DispatchMode::kTiered,
+                         InterpreterOptions options = kExecutorOptions)
+      : m_dispatch_mode{dispatch_mode}, m_ranges(worker_count), m_statistics(worker_count), m_pool{worker_count, options} {}
+
+  // Blocks until every job has run; results are in job order. Not reentrant.
+  auto Execute(std::span<BatchJob const> jobs) -> std::vector<BatchJobResult> {
+    std::vector<BatchJobResult> results(jobs.size());
+
+    auto const worker_count{m_pool.WorkerCount()};
+    for (std::size_t worker_index{0}; worker_index < worker_count; ++worker_index) {
+      std::scoped_lock const range_lock{m_ranges[worker_index].mutex};
+      m_ranges[worker_index].begin = jobs.size() * worker_index / worker_count;
+      m_ranges[worker_index].end = jobs.size() * (worker_index + 1) / worker_count;
+    }
+
+    m_pool.RunOnEveryWorker([this, jobs, &results](std::size_t worker_index, Interpreter& interpreter) { m_statistics[worker_index] = RunJobs(interpreter, worker_index, jobs, results); });
+    return results;
+  }
+
+  auto WorkerCount() const -> std::size_t { return m_pool.WorkerCount(); }
+  // of the last batch, indexed by worker
+  auto Statistics() const -> std::span<WorkerStatistics const> { return m_statistics; }
+
+ private:
+  static constexpr std::size_t kCacheLineSize{64};
+
+  // job indices [begin, end) left to a worker; the owner takes from the front, thieves from the back
+  struct alignas(kCacheLineSize) JobRange {
+    std::mutex mutex{};
+    std::size_t begin{0};
+    std::size_t end{0};
+  };
+
+  DispatchMode m_dispatch_mode;
+  std::vector<JobRange> m_ranges;
+  std::vector<WorkerStatistics> m_statistics;
+  WorkerPool m_pool;
+
+  auto RunJobs(Interpreter& interpreter, std::size_t worker_index, std::span<BatchJob const> jobs, std::span<BatchJobResult> results) -> WorkerStatistics {
+    WorkerStatistics statistics{};
+    auto const start{std::chrono::steady_clock::now()};
+    while (auto const job_index{NextJob(worker_index, statistics)}) {
+      auto const& job{jobs[*job_index]};
+      // Execute() keeps the loaded bytecode (and its JIT tier) when consecutive jobs share it
+      auto execution{interpreter.Execute(
+          {.code = *job.bytecode, .calldata = job.calldata, .state = job.state.get(), .address = job.address, .gas_limit = job.gas_limit, .dispatch_mode = m_dispatch_mode})};
+
+      auto& result{results[*job_index]};
+      result.succeeded = execution.status == ExecutionStatus::kSuccess;
+      result.gas_used = execution.gas_used;
+      result.storage_writes = std::move(execution.storage_writes);
+
+      statistics.jobs_executed++;
+      statistics.gas_used += result.gas_used;
+    }
+
+    interpreter.AttachState(nullptr);
+    statistics.busy_time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    return statistics;
+  }
+
+  auto NextJob(std::size_t worker_index, WorkerStatistics& statistics) -> std::optional<std::size_t> {
+    auto& own_range{m_ranges[worker_index]};
+    {
+      std::scoped_lock const lock{own_range.mutex};
+      if (own_range.begin != own_range.end) {
+        return own_range.begin++;
+      }
+    }
+
+    for (std::size_t offset{1}; offset < m_ranges.size(); ++offset) {
+      auto& victim_range{m_ranges[(worker_index + offset) % m_ranges.size()]};
+      std::size_t stolen_begin{0};
+      std::size_t stolen_end{0};
+      {
+        std::scoped_lock const lock{victim_range.mutex};
+        if (victim_range.begin == victim_range.end) {
+          continue;
+        }
+        stolen_end = victim_range.end;
+        stolen_begin = victim_range.end - (victim_range.end - victim_range.begin + 1) / 2;
+        victim_range.end = stolen_begin;
+      }
+
+      statistics.jobs_stolen += stolen_end - stolen_begin;
+      std::scoped_lock const lock{own_range.mutex};
+      own_range.begin = stolen_begin + 1;
+      own_range.end = stolen_end;
+      return stolen_begin;
+    }
+    return std::nullopt;
+  }
+};
+
+}  // namespace evmint
@@ -0,0 +1,209 @@
+// SPDX-License-Identifier: MIT
+
+// evmint-bench: runs the workload fixtures of data/bench under each dispatch mode and reports ns per call, gas/s and
+// instructions/s, as the mean and standard deviation over repetitions that follow a warm-up.
+//
+//   evmint-bench [--fixtures <directory>] [--dispatch table|tos|tiered] [--repetitions <n>] [<fixture name>...]
+//
+// A fixture (<name>.fixture) is a line-based text file; `#` starts a comment:
+//
+//   code <hex>                     bytecode, run as account 0
+//   calldata <hex>                 call data, optional
+//   storage <slot> <value>         account 0's storage before the call, any number
+//   instructions <n>               instructions one call executes, for instructions/s
+//   expect gas_used <n>            gas one call uses
+//   expect storage <slot> <value>  every SSTORE of one call, any number
+//
+// Numbers and words are decimal or 0x-prefixed hex. Every fixture's first call is checked against its expectations
+// before it is timed.
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <optional>
+#include <print>
+#include <ranges>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <magic_enum.hpp>
+#include <intx/intx.hpp>
+
+#include "bench.hpp"
+#include "evm.hpp"
+#include "interpreter.hpp"
+#include "state.hpp"
+
+using namespace evmint;
+using namespace evmint::bench;
+
+namespace {
+
+// relative to the repository root, which evmint-bench is run from
+constexpr std::string_view kDefaultFixtureDirectory{"data/bench"};
+
+struct Fixture {
+  std::string name{};
+  std::vector<std::byte> code{};
+  std::vector<std::byte> calldata{};
+  Storage storage{};
+  std::size_t instructions{0};
+  std::size_t expected_gas_used{0};
+  Storage expected_storage_writes{};
+};
+
+auto ParseHex(std::string_view hex) -> std::vector<std::byte> {
+  if (hex.size() % 2 != 0 or not std::ranges::all_of(hex, [](char digit) { return std::isxdigit(static_cast<unsigned char>(digit)) != 0; })) {
+    throw std::runtime_error{std::format("'{}' is not hex bytes", hex)};
+  }
+  return std::views::iota(std::size_t{0}, hex.size() / 2) |
+         std::views::transform([hex](auto index) { return static_cast<std::byte>(std::stoi(std::string{hex.substr(2 * index, 2)}, nullptr, kHexBase)); }) |
+         std::ranges::to<std::vector>();
+}
+
+auto ParseWord(std::string const& word) -> word_t {
+  try {
+    return intx::from_string<word_t>(word.c_str());
+  } catch (std::exception const&) {
+    throw std::runtime_error{std::format("'{}' is not a number", word)};
+  }
+}
+
+auto ReadFixture(std::filesystem::path const& path) -> Fixture {
+  std::ifstream file{path};
+  if (not file.is_open()) {
+    throw std::runtime_error{std::format("[BENCH]: Could not open '{}'.", path.string())};
+  }
+
+  Fixture fixture{.name = path.stem().string()};
+  std::size_t line_number{0};
+  for (std::string line{}; std::getline(file, line);) {
+    ++line_number;
+    std::istringstream fields{line.substr(0, line.find('#'))};
+    std::vector<std::string> const words{std::views::istream<std::string>(fields) | std::ranges::to<std::vector>()};
+    if (words.empty()) {
+      continue;
+    }
+
+    try {
+      // the line is `keywords...` followed by `value_count` values
+      auto const is_entry{[&words](std::vector<std::string_view> const& keywords, std::size_t value_count) {
+        return words.size() == keywords.size() + value_count and std::ranges::equal(std::span{words}.first(keywords.size()), keywords);
+      }};
+      if (is_entry({"code"}, 1)) {
+        fixture.code = ParseHex(words[1]);
+      } else if (is_entry({"calldata"}, 1)) {
+        fixture.calldata = ParseHex(words[1]);
+      } else if (is_entry({"storage"}, 2)) {
+        fixture.storage.insert_or_assign(ParseWord(words[1]), ParseWord(words[2]));
+      } else if (is_entry({"instructions"}, 1)) {
+        fixture.instructions = static_cast<std::size_t>(ParseWord(words[1]));
+      } else if (is_entry({"expect", "gas_used"}, 1)) {
+        fixture.expected_gas_used = static_cast<std::size_t>(ParseWord(words[2]));
+      } else if (is_entry({"expect", "storage"}, 2)) {
+        fixture.expected_storage_writes.insert_or_assign(ParseWord(words[2]), ParseWord(words[3]));
+      } else {
+        throw std::runtime_error{"unknown entry"};
+      }
+    } catch (std::runtime_error const& ex) {
+      throw std::runtime_error{std::format("[BENCH]: {}:{}: {}.", path.string(), line_number, ex.what())};
+    }
+  }
+  if (fixture.code.empty()) {
+    throw std::runtime_error{std::format("[BENCH]: {} has no code.", path.string())};
+  }
+  return fixture;
+}
+
+// Describes how the result differs from the fixture's expectations, empty if it does not.
+auto CheckResult(Fixture const& fixture, ExecutionResult const& result) -> std::string {
+  if (result.status != ExecutionStatus::kSuccess) {
+    return std::format("ended with {}", magic_enum::enum_name(result.status));
+  }
+  if (result.gas_used != fixture.expected_gas_used) {
+    return std::format("used {} gas, expected {}", result.gas_used, fixture.expected_gas_used);
+  }
+  for (auto const& [slot, value] : result.storage_writes) {
+    if (auto const expected{fixture.expected_storage_writes.find(slot)}; expected == std::end(fixture.expected_storage_writes) or expected->second != value) {
+      return std::format("stored 0x{} at slot 0x{}", intx::to_string(value, kHexBase), intx::to_string(slot, kHexBase));
+    }
+  }
+  if (result.storage_writes.size() != fixture.expected_storage_writes.size()) {
+    return std::format("stored {} slots, expected {}", result.storage_writes.size(), fixture.expected_storage_writes.size());
+  }
+  return {};
+}
+
+}  // namespace
+
+auto main(int argc, char* argv[]) -> int {
+  std::vector<std::string_view> const arguments(argv + 1, argv + argc);
+
+  std::filesystem::path fixture_directory{kDefaultFixtureDirectory};
+  std::vector<DispatchMode> dispatch_modes{DispatchMode::kHandlerTable, DispatchMode::kTopOfStackCached, DispatchMode::kTiered};
+  std::size_t repetitions{kDefaultRepetitions};
+  std::vector<std::string_view> selected_names{};
+  for (std::size_t index{0}; index < arguments.size(); ++index) {
+    auto const value{index + 1 < arguments.size() ? std::optional{arguments[index + 1]} : std::nullopt};
+    if (arguments[index] == "--fixtures" and value) {
+      fixture_directory = *value;
+      ++index;
+    } else if (arguments[index] == "--dispatch" and value and ParseDispatchMode(*value)) {
+      dispatch_modes = {*ParseDispatchMode(*value)};
+      ++index;
+    } else if (arguments[index] == "--repetitions" and value) {
+      repetitions = std::max<std::size_t>(std::stoul(std::string{*value}), 1);
+      ++index;
+    } else if (arguments[index].starts_with("--")) {
+      std::println("[ERROR] Unknown or incomplete option '{}'.", arguments[index]);
+      return 1;
+    } else {
+      selected_names.push_back(arguments[index]);
+    }
+  }
+
+  std::vector<Fixture> fixtures{};
+  try {
+    for (auto const& entry : std::filesystem::directory_iterator{fixture_directory}) {
+      auto const is_selected{selected_names.empty() or std::ranges::find(selected_names, entry.path().stem().string()) != std::end(selected_names)};
+      if (entry.path().extension() == ".fixture" and is_selected) {
+        fixtures.push_back(ReadFixture(entry.path()));
+      }
+    }
+  } catch (std::exception const& ex) {
+    std::println("[ERROR] {}", ex.what());
+    return 1;
+  }
+  std::ranges::sort(fixtures, {}, &Fixture::name);
+
+  std::println("{:<16} {:<8} {:>12} {:>10} {:>10} {:>12}", "fixture", "dispatch", "ns/call", "stddev", "Mgas/s", "Minstr/s");
+  auto all_passed{true};
+  for (auto const& fixture : fixtures) {
+    StateSnapshot const state{Accounts{{0, {.storage = fixture.storage}}}};
+
+    for (auto const dispatch_mode : dispatch_modes) {
+      // a fresh interpreter per mode, so kTiered compiles the code anew
+      Interpreter interpreter{kExecutorOptions};
+      ExecutionRequest const request{.code = fixture.code, .calldata = fixture.calldata, .state = &state, .dispatch_mode = dispatch_mode};
+      if (auto const error{CheckResult(fixture, interpreter.Execute(request))}; not error.empty()) {
+        std::println("{:<16} {:<8} FAILED: {}", fixture.name, DispatchModeName(dispatch_mode), error);
+        all_passed = false;
+        continue;
+      }
+
+      auto const measurement{MeasureCalls(interpreter, request, repetitions)};
+      std::println("{:<16} {:<8} {:>12.1f} {:>9.1f}% {:>10.1f} {:>12.1f}", fixture.name, DispatchModeName(dispatch_mode), measurement.mean_ns_per_call,
+                   100.0 * measurement.stddev_ns_per_call / measurement.mean_ns_per_call, 1e3 * static_cast<double>(fixture.expected_gas_used) / measurement.mean_ns_per_call,
+                   1e3 * static_cast<double>(fixture.instructions) / measurement.mean_ns_per_call);
+    }
+  }
+  return all_passed ? 0 : 1;
+}
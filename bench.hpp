@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: MIT
+
+// Timing shared by the benchmark tools (evmint-bench, evmint-microbench).
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <numeric>
+#include <vector>
+
+#include "interpreter.hpp"
+
+namespace evmint::bench {
+
+constexpr std::size_t kDefaultRepetitions{10};
+// each repetition runs as many calls as fit in this long, the warm-up twice as long
+constexpr std::chrono::milliseconds kRepetitionTime{20};
+
+struct Measurement {
+  double mean_ns_per_call{0};
+  double stddev_ns_per_call{0};
+};
+
+// Warms up, then times `repetitions` runs of equally many calls. Interpreters should use kExecutorOptions, so kTiered
+// runs compiled code from the first call on.
+inline auto MeasureCalls(Interpreter& interpreter, ExecutionRequest const& request, std::size_t repetitions) -> Measurement {
+  auto const time_calls{[&](std::size_t call_count) {
+    auto const start{std::chrono::steady_clock::now()};
+    for (std::size_t call{0}; call < call_count; ++call) {
+      interpreter.Execute(request);
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  }};
+
+  constexpr auto kRepetitionNs{std::chrono::duration<double, std::nano>(kRepetitionTime).count()};
+  std::size_t call_count{1};
+  auto elapsed{time_calls(call_count)};
+  while (elapsed < 2 * kRepetitionNs) {
+    call_count *= 2;
+    elapsed = time_calls(call_count);
+  }
+  call_count = std::max<std::size_t>(static_cast<std::size_t>(kRepetitionNs * static_cast<double>(call_count) / elapsed), 1);
+
+  std::vector<double> ns_per_call(repetitions);
+  std::ranges::generate(ns_per_call, [&] { return time_calls(call_count) / static_cast<double>(call_count); });
+  auto const mean{std::accumulate(std::begin(ns_per_call), std::end(ns_per_call), 0.0) / static_cast<double>(repetitions)};
+  auto const squared_deviations{std::transform_reduce(std::begin(ns_per_call), std::end(ns_per_call), 0.0, std::plus<>{}, [mean](double sample) { return (sample - mean) * (sample - mean); })};
+  auto const variance{squared_deviations / static_cast<double>(std::max<std::size_t>(repetitions - 1, 1))};
+  return {.mean_ns_per_call = mean, .stddev_ns_per_call = std::sqrt(variance)};
+}
+
+}  // namespace evmint::bench
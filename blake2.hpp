@@ -0,0 +1,172 @@
+// SPDX-License-Identifier: MIT
+
+// BLAKE2b's compression function F with a caller-chosen number of rounds, for the BLAKE2F precompile (EIP-152). The
+// message is read where it lies. On x86-64 hosts with AVX2 the 16-word working vector is four 256-bit rows and every
+// G runs on four columns (or diagonals) at once, chosen once at startup; everywhere else the portable rounds run.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace evmint::blake2 {
+
+constexpr std::size_t kBlockSize{128};
+
+// h, the chained state
+using State = std::array<std::uint64_t, 8>;
+// t, the offset counter: the bytes compressed so far, low word first
+using Offset = std::array<std::uint64_t, 2>;
+
+constexpr State kInitializationVector{0x6a09'e667'f3bc'c908, 0xbb67'ae85'84ca'a73b, 0x3c6e'f372'fe94'f82b, 0xa54f'f53a'5f1d'36f1,
+                                      0x510e'527f'ade6'82d1, 0x9b05'688c'2b3e'6c1f, 0x1f83'd9ab'fb41'bd6b, 0x5be0'cd19'137e'2179};
+
+// the order round r reads the message words in is kSigma[r % 10]
+constexpr std::array<std::array<std::uint8_t, 16>, 10> kSigma{{
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+    {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
+    {11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4},
+    {7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8},
+    {9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13},
+    {2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9},
+    {12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11},
+    {13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10},
+    {6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5},
+    {10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0},
+}};
+
+// Message words are little-endian, as is every host evmint runs on (see keccak.hpp).
+inline auto LoadWord(std::byte const* source) -> std::uint64_t {
+  std::uint64_t word{0};
+  std::memcpy(&word, source, sizeof(word));
+  return word;
+}
+
+inline auto CompressPortable(State& state, std::byte const* message, Offset const& offset, bool final_block, std::uint32_t rounds) -> void {
+  std::array<std::uint64_t, 16> words{};
+  for (std::size_t word{0}; word < words.size(); ++word) {
+    words[word] = LoadWord(message + 8 * word);
+  }
+  std::array<std::uint64_t, 16> v{};
+  std::copy(std::begin(state), std::end(state), std::begin(v));
+  std::copy(std::begin(kInitializationVector), std::end(kInitializationVector), std::begin(v) + 8);
+  v[12] ^= offset[0];
+  v[13] ^= offset[1];
+  if (final_block) {
+    v[14] = ~v[14];
+  }
+
+  auto const mix{[&v](std::size_t a, std::size_t b, std::size_t c, std::size_t d, std::uint64_t x, std::uint64_t y) {
+    v[a] += v[b] + x;
+    v[d] = std::rotr(v[d] ^ v[a], 32);
+    v[c] += v[d];
+    v[b] = std::rotr(v[b] ^ v[c], 24);
+    v[a] += v[b] + y;
+    v[d] = std::rotr(v[d] ^ v[a], 16);
+    v[c] += v[d];
+    v[b] = std::rotr(v[b] ^ v[c], 63);
+  }};
+  for (std::uint32_t round{0}, sigma_index{0}; round < rounds; ++round, sigma_index = sigma_index == 9 ? 0 : sigma_index + 1) {
+    auto const& sigma{kSigma[sigma_index]};
+    mix(0, 4, 8, 12, words[sigma[0]], words[sigma[1]]);
+    mix(1, 5, 9, 13, words[sigma[2]], words[sigma[3]]);
+    mix(2, 6, 10, 14, words[sigma[4]], words[sigma[5]]);
+    mix(3, 7, 11, 15, words[sigma[6]], words[sigma[7]]);
+    mix(0, 5, 10, 15, words[sigma[8]], words[sigma[9]]);
+    mix(1, 6, 11, 12, words[sigma[10]], words[sigma[11]]);
+    mix(2, 7, 8, 13, words[sigma[12]], words[sigma[13]]);
+    mix(3, 4, 9, 14, words[sigma[14]], words[sigma[15]]);
+  }
+  for (std::size_t word{0}; word < state.size(); ++word) {
+    state[word] ^= v[word] ^ v[word + 8];
+  }
+}
+
+#if defined(__x86_64__)
+// Rows a = v0..v3, b = v4..v7, c = v8..v11 and d = v12..v15, so the column step is four Gs lane by lane; rotating b, c
+// and d by one, two and three lanes lines the diagonals up for the second step, and rotating them back restores the
+// columns. The ten message permutations are gathered into vectors once per call, so rounds past the tenth (the
+// precompile allows 2^32 - 1) only load them.
+__attribute__((target("avx2"))) inline auto CompressAvx2(State& state, std::byte const* message, Offset const& offset, bool final_block, std::uint32_t rounds)
+    -> void {
+  // rotations by 24 and 16 bits move whole bytes; by 32, whole halves
+  auto const rotate_24{_mm256_setr_epi8(3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10, 3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10)};
+  auto const rotate_16{_mm256_setr_epi8(2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9, 2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9)};
+
+  std::array<std::uint64_t, 16> words{};
+  for (std::size_t word{0}; word < words.size(); ++word) {
+    words[word] = LoadWord(message + 8 * word);
+  }
+  // per permutation: the x and y words of the column step, then of the diagonal step; not a std::array, which would
+  // drop __m256i's alignment attribute
+  __m256i schedule[kSigma.size()][4];
+  auto const gathered_rounds{rounds < kSigma.size() ? rounds : kSigma.size()};
+  for (std::size_t sigma_index{0}; sigma_index < gathered_rounds; ++sigma_index) {
+    auto const& sigma{kSigma[sigma_index]};
+#pragma GCC unroll 4
+    for (std::size_t step{0}; step < 4; ++step) {
+      auto const first{8 * (step / 2) + step % 2};
+      schedule[sigma_index][step] = _mm256_setr_epi64x(static_cast<long long>(words[sigma[first]]), static_cast<long long>(words[sigma[first + 2]]),
+                                                       static_cast<long long>(words[sigma[first + 4]]), static_cast<long long>(words[sigma[first + 6]]));
+    }
+  }
+
+  auto const h_low{_mm256_loadu_si256(reinterpret_cast<__m256i const*>(state.data()))};
+  auto const h_high{_mm256_loadu_si256(reinterpret_cast<__m256i const*>(state.data() + 4))};
+  auto a{h_low};
+  auto b{h_high};
+  auto c{_mm256_loadu_si256(reinterpret_cast<__m256i const*>(kInitializationVector.data()))};
+  auto d{_mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(kInitializationVector.data() + 4)),
+                          _mm256_setr_epi64x(static_cast<long long>(offset[0]), static_cast<long long>(offset[1]), final_block ? -1 : 0, 0))};
+
+  for (std::uint32_t round{0}, sigma_index{0}; round < rounds; ++round, sigma_index = sigma_index == 9 ? 0 : sigma_index + 1) {
+    auto const* const round_schedule{schedule[sigma_index]};
+#pragma GCC unroll 2
+    for (std::size_t step{0}; step < 2; ++step) {
+      // the message word goes in first: a is ready well before b, which ends the previous step's dependency chain
+      a = _mm256_add_epi64(_mm256_add_epi64(a, round_schedule[2 * step]), b);
+      d = _mm256_shuffle_epi32(_mm256_xor_si256(d, a), _MM_SHUFFLE(2, 3, 0, 1));
+      c = _mm256_add_epi64(c, d);
+      b = _mm256_shuffle_epi8(_mm256_xor_si256(b, c), rotate_24);
+      a = _mm256_add_epi64(_mm256_add_epi64(a, round_schedule[2 * step + 1]), b);
+      d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), rotate_16);
+      c = _mm256_add_epi64(c, d);
+      b = _mm256_xor_si256(b, c);
+      b = _mm256_or_si256(_mm256_srli_epi64(b, 63), _mm256_add_epi64(b, b));
+      if (step == 0) {
+        b = _mm256_permute4x64_epi64(b, _MM_SHUFFLE(0, 3, 2, 1));
+        c = _mm256_permute4x64_epi64(c, _MM_SHUFFLE(1, 0, 3, 2));
+        d = _mm256_permute4x64_epi64(d, _MM_SHUFFLE(2, 1, 0, 3));
+      } else {
+        b = _mm256_permute4x64_epi64(b, _MM_SHUFFLE(2, 1, 0, 3));
+        c = _mm256_permute4x64_epi64(c, _MM_SHUFFLE(1, 0, 3, 2));
+        d = _mm256_permute4x64_epi64(d, _MM_SHUFFLE(0, 3, 2, 1));
+      }
+    }
+  }
+
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(state.data()), _mm256_xor_si256(h_low, _mm256_xor_si256(a, c)));
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(state.data() + 4), _mm256_xor_si256(h_high, _mm256_xor_si256(b, d)));
+}
+#endif
+
+using CompressFunction = auto (*)(State&, std::byte const*, Offset const&, bool, std::uint32_t) -> void;
+
+inline CompressFunction const kCompress{[]() -> CompressFunction {
+#if defined(__x86_64__)
+  if (__builtin_cpu_supports("avx2")) {
+    return &CompressAvx2;
+  }
+#endif
+  return &CompressPortable;
+}()};
+
+}  // namespace evmint::blake2
@@ -0,0 +1,613 @@
+// SPDX-License-Identifier: MIT
+
+// Blocks of transactions: ExecuteBlockSerially as the reference, BlockExecutor in parallel with Block-STM.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "evm.hpp"
+#include "interpreter.hpp"
+#include "logs.hpp"
+#include "precompiles.hpp"
+#include "state.hpp"
+#include "worker_pool.hpp"
+
+namespace evmint {
+
+struct Transaction {
+  word_t from{};
+  // receives the value, then its code (if any) runs with the call data
+  word_t to{};
+  word_t value{};
+  std::vector<std::byte> calldata{};
+  std::size_t gas_limit{kDefaultGasLimit};
+};
+
+struct TransactionResult {
+  bool succeeded{false};
+  std::size_t gas_used{0};
+
+  auto operator==(TransactionResult const&) const -> bool = default;
+};
+
+struct BlockResult {
+  std::vector<TransactionResult> transaction_results{};
+  // per transaction: the logs it emitted and the bloom its receipt carries
+  std::vector<LogArena> transaction_logs{};
+  std::vector<Bloom> logs_blooms{};
+  // the block header's, the OR of every receipt's
+  Bloom logs_bloom{};
+  // every location written by the block, with its final value
+  StateWrites state_writes{};
+
+  auto operator==(BlockResult const&) const -> bool = default;
+};
+
+// What one transaction sees: its own writes, then whatever `read` returns for the state before the transaction. Code
+// cannot change within a block and comes straight from the pre-block state.
+template <typename Reader>
+class TransactionState final : public StateView {
+ public:
+  TransactionState(StateView const& pre_block_state, Reader& read) : m_pre_block_state{pre_block_state}, m_read{read} {}
+
+  auto StorageAt(word_t const& address, word_t const& slot) const -> word_t override { return Read(StateKey::Storage(address, slot)); }
+  auto BalanceOf(word_t const& address) const -> word_t override { return Read(StateKey::Balance(address)); }
+  auto CodeAt(word_t const& address) const -> std::span<std::byte const> override { return m_pre_block_state.CodeAt(address); }
+
+  auto Read(StateKey const& key) const -> word_t {
+    if (auto const written{m_writes.find(key)}; written != std::end(m_writes)) {
+      return written->second;
+    }
+    return m_read(key);
+  }
+
+  auto Write(StateKey const& key, word_t const& value) -> void { m_writes.insert_or_assign(key, value); }
+  auto Writes() -> StateWrites& { return m_writes; }
+
+ private:
+  StateView const& m_pre_block_state;
+  Reader& m_read;
+  StateWrites m_writes{};
+};
+
+struct TransactionOutcome {
+  TransactionResult result{};
+  StateWrites writes{};
+  Bloom logs_bloom{};
+};
+
+// Transfers the value and runs the code at `to`, reading state through `read`, with its logs going to `logs`. A
+// transaction that cannot pay its value or whose code fails writes nothing and emits no logs; a failed call consumes
+// its whole gas limit.
+template <typename Reader>
+auto ExecuteTransaction(Interpreter& interpreter, DispatchMode dispatch_mode, StateView const& pre_block_state, Transaction const& transaction, Reader& read, LogArena& logs)
+    -> TransactionOutcome {
+  logs.Clear();
+  TransactionState state{pre_block_state, read};
+  auto const from{ToAddress(transaction.from)};
+  auto const to{ToAddress(transaction.to)};
+
+  // zero-value calls leave balances alone, so calls into the same contract do not conflict on its balance
+  if (transaction.value != 0) {
+    auto const from_balance{state.Read(StateKey::Balance(from))};
+    if (from_balance < transaction.value) {
+      return {};
+    }
+    state.Write(StateKey::Balance(from), from_balance - transaction.value);
+    state.Write(StateKey::Balance(to), state.Read(StateKey::Balance(to)) + transaction.value);
+  }
+
+  TransactionResult result{.succeeded = true};
+  if (auto const code{pre_block_state.CodeAt(to)}; not code.empty() or precompile::Find(to) != nullptr) {
+    auto const execution{interpreter.Execute({.code = code,
+                                              .calldata = transaction.calldata,
+                                              .state = &state,
+                                              .address = to,
+                                              .gas_limit = transaction.gas_limit,
+                                              .dispatch_mode = dispatch_mode,
+                                              .logs = &logs})};
+    if (execution.status != ExecutionStatus::kSuccess) {
+      return {.result = {.gas_used = transaction.gas_limit}};
+    }
+    result.gas_used = execution.gas_used;
+    for (auto const& [slot, value] : execution.storage_writes) {
+      state.Write(StateKey::Storage(to, slot), value);
+    }
+  }
+  return {.result = result, .writes = std::move(state.Writes()), .logs_bloom = logs.empty() ? Bloom{} : LogsBloom(logs)};
+}
+
+// Reference semantics for BlockExecutor: the transactions one after another, each seeing all writes before it.
+inline auto ExecuteBlockSerially(Interpreter& interpreter, DispatchMode dispatch_mode, StateView const& pre_block_state, std::span<Transaction const> transactions) -> BlockResult {
+  BlockResult block_result{.transaction_logs = std::vector<LogArena>(transactions.size()), .logs_blooms = std::vector<Bloom>(transactions.size())};
+  auto read{[&pre_block_state, &block_result](StateKey const& key) {
+    auto const written{block_result.state_writes.find(key)};
+    return written == std::end(block_result.state_writes) ? ReadState(pre_block_state, key) : written->second;
+  }};
+
+  for (std::size_t index{0}; index < transactions.size(); ++index) {
+    auto outcome{ExecuteTransaction(interpreter, dispatch_mode, pre_block_state, transactions[index], read, block_result.transaction_logs[index])};
+    block_result.transaction_results.push_back(outcome.result);
+    block_result.logs_blooms[index] = outcome.logs_bloom;
+    for (auto const& [key, value] : outcome.writes) {
+      block_result.state_writes.insert_or_assign(key, value);
+    }
+  }
+  block_result.logs_bloom = BlockBloom(block_result.logs_blooms);
+  return block_result;
+}
+
+// Block-STM (Gelashvili et al., "Block-STM: Scaling Blockchain Execution by Turning Ordering Curse to a Performance
+// Blessing")
+//
+// Workers speculatively execute transactions in parallel. Every incarnation (execution attempt) of a transaction
+// publishes its writes to a multi-version memory, where later transactions read them, and records the version of
+// every location it read. Validation rereads those locations in transaction order; if a lower transaction has since
+// written a different version, the transaction is aborted, its writes become estimates (reading one waits for the
+// writer instead of speculating further) and it is executed again. Once every transaction has been validated after
+// the last write below it, the multi-version memory holds exactly the result of serial execution.
+namespace block_stm {
+
+struct Version {
+  std::size_t transaction{0};
+  std::size_t incarnation{0};
+
+  auto operator==(Version const&) const -> bool = default;
+};
+
+// Thrown out of an execution that read an estimate of `blocking_transaction`.
+struct ReadDependency {
+  std::size_t blocking_transaction{0};
+};
+
+struct ReadDescriptor {
+  StateKey key{};
+  // nullopt: read from the pre-block state
+  std::optional<Version> version{};
+};
+
+class MultiVersionMemory {
+ public:
+  struct Write {
+    Version version{};
+    // nullopt: estimate left behind by an aborted incarnation
+    std::optional<word_t> value{};
+  };
+
+  explicit MultiVersionMemory(std::size_t transaction_count) : m_transactions(transaction_count) {}
+
+  // Latest write to `key` by a transaction below `transaction`, if any.
+  auto LatestWriteBefore(StateKey const& key, std::size_t transaction) const -> std::optional<Write> {
+    auto const& shard{ShardOf(key)};
+    std::scoped_lock const lock{shard.mutex};
+    auto const versions{shard.entries.find(key)};
+    if (versions == std::end(shard.entries)) {
+      return std::nullopt;
+    }
+    auto const entry{versions->second.lower_bound(transaction)};
+    if (entry == std::begin(versions->second)) {
+      return std::nullopt;
+    }
+    auto const& [writer, write]{*std::prev(entry)};
+    return Write{.version = {.transaction = writer, .incarnation = write.incarnation}, .value = write.value};
+  }
+
+  // Publishes the reads and writes of an incarnation, replacing those of the previous one. Returns whether it wrote a
+  // location the previous incarnation did not, which may invalidate reads of higher transactions that already passed
+  // validation.
+  auto Record(Version const& version, std::vector<ReadDescriptor> read_set, StateWrites const& writes) -> bool {
+    auto& record{m_transactions[version.transaction]};
+    std::scoped_lock const record_lock{record.mutex};
+
+    for (auto const& [key, value] : writes) {
+      auto& shard{ShardOf(key)};
+      std::scoped_lock const lock{shard.mutex};
+      shard.entries[key].insert_or_assign(version.transaction, Entry{.incarnation = version.incarnation, .value = value});
+    }
+    for (auto const& key : record.written_keys) {
+      if (not writes.contains(key)) {
+        auto& shard{ShardOf(key)};
+        std::scoped_lock const lock{shard.mutex};
+        shard.entries[key].erase(version.transaction);
+      }
+    }
+
+    auto const wrote_new_location{std::ranges::any_of(writes, [&record](auto const& write) { return std::ranges::find(record.written_keys, write.first) == std::end(record.written_keys); })};
+    record.written_keys = writes | std::views::keys | std::ranges::to<std::vector>();
+    record.read_set = std::make_shared<std::vector<ReadDescriptor> const>(std::move(read_set));
+    return wrote_new_location;
+  }
+
+  // Marks the writes of an aborted incarnation, so readers wait for the next one instead of using them.
+  auto ConvertWritesToEstimates(std::size_t transaction) -> void {
+    auto& record{m_transactions[transaction]};
+    std::scoped_lock const record_lock{record.mutex};
+    for (auto const& key : record.written_keys) {
+      auto& shard{ShardOf(key)};
+      std::scoped_lock const lock{shard.mutex};
+      shard.entries[key][transaction].value.reset();
+    }
+  }
+
+  // Whether every location read by the last incarnation of `transaction` still resolves to the version it read.
+  auto ValidateReadSet(std::size_t transaction) const -> bool {
+    std::shared_ptr<std::vector<ReadDescriptor> const> read_set{};
+    {
+      std::scoped_lock const record_lock{m_transactions[transaction].mutex};
+      read_set = m_transactions[transaction].read_set;
+    }
+
+    return std::ranges::all_of(*read_set, [this, transaction](ReadDescriptor const& read) {
+      auto const latest_write{LatestWriteBefore(read.key, transaction)};
+      if (not latest_write) {
+        return not read.version.has_value();
+      }
+      return latest_write->value.has_value() and read.version == latest_write->version;
+    });
+  }
+
+  // Final value of every written location; only meaningful once all transactions are validated.
+  auto Snapshot() const -> StateWrites {
+    StateWrites state_writes{};
+    for (auto const& shard : m_shards) {
+      for (auto const& [key, versions] : shard.entries) {
+        if (not versions.empty()) {
+          state_writes.emplace(key, *std::rbegin(versions)->second.value);
+        }
+      }
+    }
+    return state_writes;
+  }
+
+ private:
+  static constexpr std::size_t kShardCount{64};
+
+  struct Entry {
+    std::size_t incarnation{0};
+    std::optional<word_t> value{};
+  };
+
+  struct alignas(64) Shard {
+    mutable std::mutex mutex{};
+    // writes to a location by transaction index
+    std::unordered_map<StateKey, std::map<std::size_t, Entry>, StateKeyHash> entries{};
+  };
+
+  struct TransactionRecord {
+    mutable std::mutex mutex{};
+    // swapped as a whole, so validators can keep reading the set they loaded while the next incarnation records its own
+    std::shared_ptr<std::vector<ReadDescriptor> const> read_set{std::make_shared<std::vector<ReadDescriptor> const>()};
+    std::vector<StateKey> written_keys{};
+  };
+
+  std::array<Shard, kShardCount> m_shards{};
+  std::vector<TransactionRecord> m_transactions;
+
+  auto ShardOf(StateKey const& key) -> Shard& { return m_shards[StateKeyHash{}(key) % kShardCount]; }
+  auto ShardOf(StateKey const& key) const -> Shard const& { return m_shards[StateKeyHash{}(key) % kShardCount]; }
+};
+
+enum class TaskKind { kExecution, kValidation };
+
+struct Task {
+  Version version{};
+  TaskKind kind{TaskKind::kExecution};
+};
+
+// Hands out execution and validation tasks, always preferring the lowest transaction index, and detects when the block
+// is done: both indices are past the end and no task is in flight.
+class Scheduler {
+ public:
+  explicit Scheduler(std::size_t transaction_count) : m_transaction_count{transaction_count}, m_transactions(transaction_count) {}
+
+  auto Done() const -> bool { return m_done.load(); }
+
+  auto NextTask() -> std::optional<Task> {
+    if (m_validation_index.load() < m_execution_index.load()) {
+      if (auto const version{NextVersionToValidate()}) {
+        return Task{.version = *version, .kind = TaskKind::kValidation};
+      }
+    } else if (auto const version{NextVersionToExecute()}) {
+      return Task{.version = *version, .kind = TaskKind::kExecution};
+    }
+    return std::nullopt;
+  }
+
+  // Parks `transaction` until `blocking_transaction` finishes its next execution. Returns false if that already
+  // happened, in which case the caller executes `transaction` again right away.
+  auto AddDependency(std::size_t transaction, std::size_t blocking_transaction) -> bool {
+    // blocking_transaction < transaction: locks are always taken in index order
+    auto& blocking{m_transactions[blocking_transaction]};
+    std::scoped_lock const blocking_lock{blocking.mutex};
+    if (blocking.status == Status::kExecuted) {
+      return false;
+    }
+    {
+      std::scoped_lock const lock{m_transactions[transaction].mutex};
+      m_transactions[transaction].status = Status::kAborting;
+    }
+    blocking.dependents.push_back(transaction);
+    m_active_tasks--;
+    return true;
+  }
+
+  auto FinishExecution(Version const& version, bool wrote_new_location) -> std::optional<Task> {
+    std::vector<std::size_t> dependents{};
+    {
+      auto& state{m_transactions[version.transaction]};
+      std::scoped_lock const lock{state.mutex};
+      state.status = Status::kExecuted;
+      dependents = std::exchange(state.dependents, {});
+    }
+    for (auto const dependent : dependents) {
+      SetReadyToExecute(dependent);
+    }
+    if (not dependents.empty()) {
+      DecreaseIndex(m_execution_index, std::ranges::min(dependents));
+    }
+
+    if (m_validation_index.load() > version.transaction) {
+      if (not wrote_new_location) {
+        // only this transaction needs revalidation, and this worker does it next
+        return Task{.version = version, .kind = TaskKind::kValidation};
+      }
+      // higher transactions may have read around the new location
+      DecreaseIndex(m_validation_index, version.transaction);
+    }
+    m_active_tasks--;
+    return std::nullopt;
+  }
+
+  // Claims the abort of `version` after a failed validation; false if another validator already did.
+  auto TryValidationAbort(Version const& version) -> bool {
+    auto& state{m_transactions[version.transaction]};
+    std::scoped_lock const lock{state.mutex};
+    if (state.status != Status::kExecuted or state.incarnation != version.incarnation) {
+      return false;
+    }
+    state.status = Status::kAborting;
+    return true;
+  }
+
+  auto FinishValidation(std::size_t transaction, bool aborted) -> std::optional<Task> {
+    if (aborted) {
+      SetReadyToExecute(transaction);
+      DecreaseIndex(m_validation_index, transaction + 1);
+      if (m_execution_index.load() > transaction) {
+        if (auto const version{TryIncarnate(transaction)}) {
+          return Task{.version = *version, .kind = TaskKind::kExecution};
+        }
+      }
+    }
+    m_active_tasks--;
+    return std::nullopt;
+  }
+
+ private:
+  enum class Status { kReadyToExecute, kExecuting, kExecuted, kAborting };
+
+  struct TransactionState {
+    std::mutex mutex{};
+    std::size_t incarnation{0};
+    Status status{Status::kReadyToExecute};
+    // transactions waiting for the next execution of this one
+    std::vector<std::size_t> dependents{};
+  };
+
+  std::size_t m_transaction_count;
+  std::vector<TransactionState> m_transactions;
+  std::atomic<std::size_t> m_execution_index{0};
+  std::atomic<std::size_t> m_validation_index{0};
+  // bumped on every decrease of either index, so Done() cannot miss one that raced with the check
+  std::atomic<std::size_t> m_decrease_count{0};
+  std::atomic<std::size_t> m_active_tasks{0};
+  std::atomic<bool> m_done{false};
+
+  auto DecreaseIndex(std::atomic<std::size_t>& index, std::size_t target) -> void {
+    auto current{index.load()};
+    while (current > target and not index.compare_exchange_weak(current, target)) {
+    }
+    m_decrease_count++;
+  }
+
+  auto CheckDone() -> void {
+    auto const observed_decrease_count{m_decrease_count.load()};
+    if (std::min(m_execution_index.load(), m_validation_index.load()) >= m_transaction_count and m_active_tasks.load() == 0 and observed_decrease_count == m_decrease_count.load()) {
+      m_done = true;
+    }
+  }
+
+  auto SetReadyToExecute(std::size_t transaction) -> void {
+    auto& state{m_transactions[transaction]};
+    std::scoped_lock const lock{state.mutex};
+    state.incarnation++;
+    state.status = Status::kReadyToExecute;
+  }
+
+  auto TryIncarnate(std::size_t transaction) -> std::optional<Version> {
+    auto& state{m_transactions[transaction]};
+    std::scoped_lock const lock{state.mutex};
+    if (state.status != Status::kReadyToExecute) {
+      return std::nullopt;
+    }
+    state.status = Status::kExecuting;
+    return Version{.transaction = transaction, .incarnation = state.incarnation};
+  }
+
+  auto NextVersionToExecute() -> std::optional<Version> {
+    if (m_execution_index.load() >= m_transaction_count) {
+      CheckDone();
+      return std::nullopt;
+    }
+    m_active_tasks++;
+    if (auto const transaction{m_execution_index.fetch_add(1)}; transaction < m_transaction_count) {
+      if (auto const version{TryIncarnate(transaction)}) {
+        return version;
+      }
+    }
+    m_active_tasks--;
+    return std::nullopt;
+  }
+
+  auto NextVersionToValidate() -> std::optional<Version> {
+    if (m_validation_index.load() >= m_transaction_count) {
+      CheckDone();
+      return std::nullopt;
+    }
+    m_active_tasks++;
+    if (auto const transaction{m_validation_index.fetch_add(1)}; transaction < m_transaction_count) {
+      auto& state{m_transactions[transaction]};
+      std::scoped_lock const lock{state.mutex};
+      if (state.status == Status::kExecuted) {
+        return Version{.transaction = transaction, .incarnation = state.incarnation};
+      }
+    }
+    m_active_tasks--;
+    return std::nullopt;
+  }
+};
+
+}  // namespace block_stm
+
+struct BlockStatistics {
+  // incarnations run, including ones cut short by a read dependency
+  std::size_t executions{0};
+  std::size_t validations{0};
+  std::size_t validation_aborts{0};
+  std::size_t dependency_waits{0};
+};
+
+// Executes blocks of transactions in parallel with Block-STM on a WorkerPool. The result is identical to
+// ExecuteBlockSerially for the same pre-block state.
+class BlockExecutor final {
+ public:
+  explicit BlockExecutor(std::size_t worker_count = std::max(std::thread::hardware_concurrency(), 1u), DispatchMode dispatch_mode = DispatchMode::kTiered,
+                         InterpreterOptions options = kExecutorOptions)
+      : m_dispatch_mode{dispatch_mode}, m_pool{worker_count, options} {}
+
+  // `pre_block_state` is read concurrently by all workers.
+  auto Execute(StateView const& pre_block_state, std::span<Transaction const> transactions) -> BlockResult {
+    m_statistics = {};
+    if (transactions.empty()) {
+      return {};
+    }
+
+    block_stm::MultiVersionMemory memory{transactions.size()};
+    block_stm::Scheduler scheduler{transactions.size()};
+    std::vector<TransactionResult> transaction_results(transactions.size());
+    std::vector<LogArena> transaction_logs(transactions.size());
+    std::vector<Bloom> logs_blooms(transactions.size());
+    std::mutex statistics_mutex{};
+
+    m_pool.RunOnEveryWorker([&](std::size_t, Interpreter& interpreter) {
+      BlockWorker worker{interpreter, m_dispatch_mode, pre_block_state, transactions, memory, scheduler, transaction_results, transaction_logs, logs_blooms};
+      worker.Run();
+      std::scoped_lock const lock{statistics_mutex};
+      m_statistics.executions += worker.statistics.executions;
+      m_statistics.validations += worker.statistics.validations;
+      m_statistics.validation_aborts += worker.statistics.validation_aborts;
+      m_statistics.dependency_waits += worker.statistics.dependency_waits;
+    });
+
+    auto const logs_bloom{BlockBloom(logs_blooms)};
+    return {.transaction_results = std::move(transaction_results),
+            .transaction_logs = std::move(transaction_logs),
+            .logs_blooms = std::move(logs_blooms),
+            .logs_bloom = logs_bloom,
+            .state_writes = memory.Snapshot()};
+  }
+
+  auto WorkerCount() const -> std::size_t { return m_pool.WorkerCount(); }
+  // of the last block
+  auto Statistics() const -> BlockStatistics const& { return m_statistics; }
+
+ private:
+  struct BlockWorker {
+    Interpreter& interpreter;
+    DispatchMode dispatch_mode;
+    StateView const& pre_block_state;
+    std::span<Transaction const> transactions;
+    block_stm::MultiVersionMemory& memory;
+    block_stm::Scheduler& scheduler;
+    std::span<TransactionResult> transaction_results;
+    // refilled by every incarnation of their transaction, and the scheduler never runs two at once
+    std::span<LogArena> transaction_logs;
+    std::span<Bloom> logs_blooms;
+    BlockStatistics statistics{};
+
+    auto Run() -> void {
+      std::optional<block_stm::Task> task{};
+      while (not scheduler.Done()) {
+        if (task) {
+          task = task->kind == block_stm::TaskKind::kExecution ? TryExecute(task->version) : Validate(task->version);
+        }
+        if (not task) {
+          task = scheduler.NextTask();
+        }
+      }
+    }
+
+    auto TryExecute(block_stm::Version const& version) -> std::optional<block_stm::Task> {
+      while (true) {
+        std::vector<block_stm::ReadDescriptor> read_set{};
+        auto read{[this, &version, &read_set](StateKey const& key) -> word_t {
+          auto const latest_write{memory.LatestWriteBefore(key, version.transaction)};
+          if (not latest_write) {
+            read_set.push_back({.key = key});
+            return ReadState(pre_block_state, key);
+          }
+          if (not latest_write->value) {
+            throw block_stm::ReadDependency{latest_write->version.transaction};
+          }
+          read_set.push_back({.key = key, .version = latest_write->version});
+          return *latest_write->value;
+        }};
+
+        statistics.executions++;
+        try {
+          auto outcome{ExecuteTransaction(interpreter, dispatch_mode, pre_block_state, transactions[version.transaction], read, transaction_logs[version.transaction])};
+          transaction_results[version.transaction] = outcome.result;
+          logs_blooms[version.transaction] = outcome.logs_bloom;
+          auto const wrote_new_location{memory.Record(version, std::move(read_set), outcome.writes)};
+          return scheduler.FinishExecution(version, wrote_new_location);
+        } catch (block_stm::ReadDependency const& dependency) {
+          statistics.dependency_waits++;
+          if (scheduler.AddDependency(version.transaction, dependency.blocking_transaction)) {
+            return std::nullopt;
+          }
+        }
+      }
+    }
+
+    auto Validate(block_stm::Version const& version) -> std::optional<block_stm::Task> {
+      statistics.validations++;
+      auto const aborted{not memory.ValidateReadSet(version.transaction) and scheduler.TryValidationAbort(version)};
+      if (aborted) {
+        statistics.validation_aborts++;
+        memory.ConvertWritesToEstimates(version.transaction);
+      }
+      return scheduler.FinishValidation(version.transaction, aborted);
+    }
+  };
+
+  DispatchMode m_dispatch_mode;
+  BlockStatistics m_statistics{};
+  WorkerPool m_pool;
+};
+
+}  // namespace evmint
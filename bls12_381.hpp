@@ -0,0 +1,358 @@
+// SPDX-License-Identifier: MIT
+
+// The BLS12-381 curve behind EIP-4844's KZG commitments: G1 is y^2 = x^3 + 4 over Fp (p of 381 bits), G2 its M-type
+// sextic twist y^2 = x^3 + 4 xi over Fp2 (xi = 1 + u), and the pairing the optimal ate pairing into Fp12, whose Miller
+// loop runs over the curve's parameter x, negative and of Hamming weight 6. Points travel compressed, as the x
+// coordinate and the sign of y (the Zcash encoding KZG uses). A G2 point that every pairing takes as it is, the trusted
+// setup's, is prepared once: the lines of its Miller loop are computed ahead and each pairing only evaluates them at
+// its G1 point.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+#include "curve.hpp"
+#include "field.hpp"
+#include "tower.hpp"
+
+namespace evmint::bls12_381 {
+
+struct FieldModulus {
+  static constexpr field::Limbs<6> kModulus{0xb9fe'ffff'ffff'aaab, 0x1eab'fffe'b153'ffff, 0x6730'd2a0'f6b0'f624,
+                                            0x6477'4b84'f385'12bf, 0x4b1b'a7b6'434b'acd7, 0x1a01'11ea'397f'e69a};
+};
+
+struct OrderModulus {
+  static constexpr field::Limbs<4> kModulus{0xffff'ffff'0000'0001, 0x53bd'a402'fffe'5bfe, 0x3339'd808'09a1'd805, 0x73ed'a753'299d'7d48};
+};
+
+// coordinates
+using Fp = field::PrimeField<FieldModulus>;
+using Fp2 = field::Fp2<Fp>;
+// scalars: the order r of G1 and G2, and the field KZG's polynomials are over
+using Fr = field::PrimeField<OrderModulus>;
+
+struct Tower {
+  using Fp = bls12_381::Fp;
+
+  // (1 + u) * value
+  static constexpr auto MulByXi(Fp2 const& value) -> Fp2 { return {value.c0 - value.c1, value.c0 + value.c1}; }
+};
+
+using Fp6 = field::Fp6<Tower>;
+using Fp12 = field::Fp12<Tower>;
+
+using G1Affine = curve::AffinePoint<Fp>;
+using G1 = curve::JacobianPoint<Fp>;
+using G2Affine = curve::AffinePoint<Fp2>;
+using G2 = curve::JacobianPoint<Fp2>;
+
+// -x, the curve's parameter being negative: p and r are polynomials in it
+constexpr std::uint64_t kMinusX{0xd201'0000'0001'0000};
+
+constexpr auto kB{*Fp::FromLimbs({4, 0, 0, 0, 0, 0})};
+// 4 xi
+constexpr auto kTwistB{Tower::MulByXi({kB, Fp{}})};
+
+constexpr G1Affine kG1Generator{*Fp::FromLimbs({0xfb3a'f00a'db22'c6bb, 0x6c55'e83f'f97a'1aef, 0xa14e'3a3f'171b'ac58, 0xc368'8c4f'9774'b905,
+                                                0x2695'638c'4fa9'ac0f, 0x17f1'd3a7'3197'd794}),
+                                *Fp::FromLimbs({0x0caa'2329'46c5'e7e1, 0xd03c'c744'a288'8ae4, 0x00db'18cb'2c04'b3ed, 0xfcf5'e095'd5d0'0af6,
+                                                0xa09e'30ed'741d'8ae4, 0x08b3'f481'e3aa'a0f1})};
+constexpr G2Affine kG2Generator{{*Fp::FromLimbs({0xd480'56c8'c121'bdb8, 0x0bac'0326'a805'bbef, 0xb451'0b64'7ae3'd177, 0xc6e4'7ad4'fa40'3b02,
+                                                 0x2608'0527'2dc5'1051, 0x024a'a2b2'f08f'0a91}),
+                                 *Fp::FromLimbs({0xe5ac'7d05'5d04'2b7e, 0x334c'f112'1394'5d57, 0xb5da'61bb'dc7f'5049, 0x596b'd0d0'9920'b61a,
+                                                 0x7dac'd3a0'8827'4f65, 0x13e0'2b60'5271'9f60})},
+                                {*Fp::FromLimbs({0xe193'5486'08b8'2801, 0x923a'c9cc'3bac'a289, 0x6d42'9a69'5160'd12c, 0xadfd'9baa'8cbd'd3a7,
+                                                 0x8cc9'cdc6'da2e'351a, 0x0ce5'd527'727d'6e11}),
+                                 *Fp::FromLimbs({0xaaa9'075f'f05f'79be, 0x3f37'0d27'5cec'1da1, 0x2674'92ab'572e'99ab, 0xcb3e'287e'85a7'63af,
+                                                 0x32ac'd2b0'2bc2'8b99, 0x0606'c4a0'2ea7'34cc})}};
+
+constexpr std::size_t kFpSize{48};
+constexpr std::size_t kG1CompressedSize{kFpSize};
+constexpr std::size_t kG2CompressedSize{2 * kFpSize};
+
+// The lines of a G2 point's Miller loop, one per doubling and one per addition, as (c0, c1, c2) evaluated at a G1 point
+// P as c2 + c1 * P.x * v + c0 * P.y * v * w.
+using Line = std::array<Fp2, 3>;
+constexpr std::size_t kLineCount{63 + 5};
+using PreparedG2 = std::array<Line, kLineCount>;
+
+namespace detail {
+
+// the first byte's top bits: compressed encoding, point at infinity, y the larger of the two roots
+constexpr std::byte kCompressedFlag{0x80};
+constexpr std::byte kInfinityFlag{0x40};
+constexpr std::byte kSignFlag{0x20};
+constexpr std::byte kFlags{kCompressedFlag | kInfinityFlag | kSignFlag};
+
+// a primitive cube root of unity: (x, y) -> (beta x, y) multiplies G1 points by -x^2
+constexpr auto kBeta{*Fp::FromLimbs({0x2e01'ffff'fffe'fffe, 0xde17'd813'620a'0002, 0xddb3'a93b'e6f8'9688, 0xba69'c607'6a0f'77ea,
+                                     0x5f19'672f'df76'ce51, 0})};
+
+// psi = untwist, Frobenius, twist: the endomorphism of the twist that acts on G2 as multiplication by p; an M-type
+// twist divides by the Frobenius constants a D-type one multiplies by
+constexpr auto kPsiX{Fp12::kFrobenius[2].Inverse()};
+constexpr auto kPsiY{Fp12::kFrobenius[3].Inverse()};
+
+inline auto Psi(G2 const& point) -> G2 { return {point.x.Conjugate() * kPsiX, point.y.Conjugate() * kPsiY, point.z.Conjugate()}; }
+
+// -x's bits below the top one, most significant first, as the Miller loop walks them
+constexpr auto kLoopBits{[] {
+  std::array<bool, 63> bits{};
+  for (std::size_t bit{0}; bit < bits.size(); ++bit) {
+    bits[bit] = ((kMinusX >> (62 - bit)) & 1) != 0;
+  }
+  return bits;
+}()};
+
+// (p - 3) / 4 and (p - 1) / 2, for square roots in Fp2
+constexpr auto kSqrtExponents{[] {
+  auto modulus_minus_three{Fp::kModulus};
+  modulus_minus_three[0] -= 3;
+  auto modulus_minus_one{Fp::kModulus};
+  modulus_minus_one[0] -= 1;
+  return std::array{field::detail::Divide(modulus_minus_three, 4), field::detail::Divide(modulus_minus_one, 2)};
+}()};
+
+// Doubles `point` (Jacobian) and returns the tangent line at it: Costello, Lange and Naehrig's doubling with the line
+// for an M-type twist.
+inline auto DoublingStep(G2& point) -> Line {
+  auto const a{point.x.Square()};
+  auto const b{point.y.Square()};
+  auto const c{b.Square()};
+  auto const d{((b + point.x).Square() - a - c).Double()};
+  auto const e{a.Double() + a};
+  auto const g{e.Square()};
+  auto const z_square{point.z.Square()};
+  auto const x{g - d.Double()};
+  auto const z{(point.z + point.y).Square() - b - z_square};
+  auto const y{(d - x) * e - c.Double().Double().Double()};
+  auto const line_x{-(e * z_square).Double()};
+  auto const line_constant{(point.x + e).Square() - a - g - b.Double().Double()};
+  point = {x, y, z};
+  return {(z * z_square).Double(), line_x, line_constant};
+}
+
+// Adds `addend` to `point` (Jacobian) and returns the line through both.
+inline auto AdditionStep(G2& point, G2Affine const& addend) -> Line {
+  auto const z_square{point.z.Square()};
+  auto const y_square{addend.y.Square()};
+  auto const u2{z_square * addend.x};
+  auto const s2{((addend.y + point.z).Square() - y_square - z_square) * z_square};
+  auto const h{u2 - point.x};
+  auto const hh{h.Square()};
+  auto const i{hh.Double().Double()};
+  auto const j{i * h};
+  auto const r{s2 - point.y.Double()};
+  auto const v{i * point.x};
+  auto const x{r.Square() - j - v.Double()};
+  auto const z{(point.z + h).Square() - z_square - hh};
+  auto const y{(v - x) * r - (point.y * j).Double()};
+  auto const line_constant{(r * addend.x).Double() - ((addend.y + z).Square() - y_square - z.Square())};
+  point = {x, y, z};
+  return {z.Double(), -r.Double(), line_constant};
+}
+
+// f^x for f in the cyclotomic subgroup: the inverse, a conjugate there, of f^-x
+inline auto PowX(Fp12 const& f) -> Fp12 { return f.CyclotomicPow(kMinusX).Conjugate(); }
+
+}  // namespace detail
+
+inline auto IsOnCurve(G1Affine const& point) -> bool { return point.y.Square() == point.x.Square() * point.x + kB; }
+inline auto IsOnCurve(G2Affine const& point) -> bool { return point.y.Square() == point.x.Square() * point.x + kTwistB; }
+
+// Whether a curve point has order r (the curve has others, of cofactor order): if and only if (beta x, y) == [-x^2]P
+// (Scott), two 64-bit multiplications rather than a 255-bit one.
+inline auto IsInG1(G1 const& point) -> bool {
+  auto const minus_x_times{curve::Multiply(point, field::Limbs<1>{kMinusX})};
+  return G1{point.x * detail::kBeta, point.y, point.z} == -curve::Multiply(minus_x_times, field::Limbs<1>{kMinusX});
+}
+
+// Whether a point of the twist is in G2: if and only if psi(Q) == [x]Q (Scott).
+inline auto IsInG2(G2 const& point) -> bool { return detail::Psi(point) == -curve::Multiply(point, field::Limbs<1>{kMinusX}); }
+
+namespace detail {
+
+// The larger of y and -y as integers, which the sign flag marks; Fp2 compares c1 first.
+inline auto IsLarger(Fp const& y) -> bool { return field::detail::Less((-y).ToLimbs(), y.ToLimbs()); }
+inline auto IsLarger(Fp2 const& y) -> bool { return y.c1.IsZero() ? IsLarger(y.c0) : IsLarger(y.c1); }
+
+// Square roots in Fp2 for p = 3 mod 4 (Adj and Rodriguez-Henriquez, algorithm 9); nullopt for a non-square.
+inline auto Sqrt(Fp2 const& value) -> std::optional<Fp2> {
+  auto const a1{value.Pow(kSqrtExponents[0])};
+  auto const x0{a1 * value};
+  auto const alpha{a1 * x0};
+  auto const root{alpha == -Fp2::One() ? Fp2{-x0.c1, x0.c0} : (Fp2::One() + alpha).Pow(kSqrtExponents[1]) * x0};
+  if (root.Square() != value) {
+    return std::nullopt;
+  }
+  return root;
+}
+
+// the x coordinate with the flags masked off, and the flags; nullopt for an uncompressed encoding or invalid flags
+inline auto ReadFlags(std::span<std::byte> bytes) -> std::optional<std::byte> {
+  auto const flags{bytes[0] & kFlags};
+  bytes[0] &= ~kFlags;
+  if ((flags & kCompressedFlag) == std::byte{0}) {
+    return std::nullopt;
+  }
+  if ((flags & kInfinityFlag) != std::byte{0} and
+      ((flags & kSignFlag) != std::byte{0} or std::ranges::any_of(bytes, [](std::byte byte) { return byte != std::byte{0}; }))) {
+    return std::nullopt;
+  }
+  return flags;
+}
+
+}  // namespace detail
+
+// A compressed G1 point: nullopt for invalid flags, x not below p, or a point off the curve or outside G1.
+inline auto DecompressG1(std::byte const* source) -> std::optional<G1> {
+  std::array<std::byte, kG1CompressedSize> bytes{};
+  std::copy_n(source, bytes.size(), bytes.data());
+  auto const flags{detail::ReadFlags(bytes)};
+  if (not flags) {
+    return std::nullopt;
+  }
+  if ((*flags & detail::kInfinityFlag) != std::byte{0}) {
+    return G1{};
+  }
+  auto const x{Fp::FromLimbs(field::LoadBigEndian<6>(bytes.data()))};
+  if (not x) {
+    return std::nullopt;
+  }
+  auto y{(x->Square() * *x + kB).Sqrt()};
+  if (not y) {
+    return std::nullopt;
+  }
+  if (detail::IsLarger(*y) != ((*flags & detail::kSignFlag) != std::byte{0})) {
+    *y = -*y;
+  }
+  auto const point{G1::FromAffine({*x, *y})};
+  if (not IsInG1(point)) {
+    return std::nullopt;
+  }
+  return point;
+}
+
+// A compressed G2 point, x written c1 then c0: nullopt as for DecompressG1().
+inline auto DecompressG2(std::byte const* source) -> std::optional<G2> {
+  std::array<std::byte, kG2CompressedSize> bytes{};
+  std::copy_n(source, bytes.size(), bytes.data());
+  auto const flags{detail::ReadFlags(bytes)};
+  if (not flags) {
+    return std::nullopt;
+  }
+  if ((*flags & detail::kInfinityFlag) != std::byte{0}) {
+    return G2{};
+  }
+  auto const x1{Fp::FromLimbs(field::LoadBigEndian<6>(bytes.data()))};
+  auto const x0{Fp::FromLimbs(field::LoadBigEndian<6>(bytes.data() + kFpSize))};
+  if (not x0 or not x1) {
+    return std::nullopt;
+  }
+  Fp2 const x{*x0, *x1};
+  auto y{detail::Sqrt(x.Square() * x + kTwistB)};
+  if (not y) {
+    return std::nullopt;
+  }
+  if (detail::IsLarger(*y) != ((*flags & detail::kSignFlag) != std::byte{0})) {
+    *y = -*y;
+  }
+  auto const point{G2::FromAffine({x, *y})};
+  if (not IsInG2(point)) {
+    return std::nullopt;
+  }
+  return point;
+}
+
+inline auto CompressG1(G1 const& point, std::byte* destination) -> void {
+  if (point.IsInfinity()) {
+    std::fill_n(destination, kG1CompressedSize, std::byte{0});
+    destination[0] = detail::kCompressedFlag | detail::kInfinityFlag;
+    return;
+  }
+  auto const affine_point{curve::ToAffine(point)};
+  field::StoreBigEndian(affine_point.x.ToLimbs(), destination);
+  destination[0] |= detail::kCompressedFlag | (detail::IsLarger(affine_point.y) ? detail::kSignFlag : std::byte{0});
+}
+
+inline auto CompressG2(G2 const& point, std::byte* destination) -> void {
+  if (point.IsInfinity()) {
+    std::fill_n(destination, kG2CompressedSize, std::byte{0});
+    destination[0] = detail::kCompressedFlag | detail::kInfinityFlag;
+    return;
+  }
+  auto const affine_point{curve::ToAffine(point)};
+  field::StoreBigEndian(affine_point.x.c1.ToLimbs(), destination);
+  field::StoreBigEndian(affine_point.x.c0.ToLimbs(), destination + kFpSize);
+  destination[0] |= detail::kCompressedFlag | (detail::IsLarger(affine_point.y) ? detail::kSignFlag : std::byte{0});
+}
+
+// The lines of `point`'s Miller loop, not at infinity.
+inline auto Prepare(G2Affine const& point) -> PreparedG2 {
+  PreparedG2 lines{};
+  auto accumulator{G2::FromAffine(point)};
+  std::size_t line{0};
+  for (auto const bit : detail::kLoopBits) {
+    lines[line++] = detail::DoublingStep(accumulator);
+    if (bit) {
+      lines[line++] = detail::AdditionStep(accumulator, point);
+    }
+  }
+  return lines;
+}
+
+// The product of the Miller loops of the pairs (p[i], q[i]), none of them at infinity, each q[i] prepared.
+inline auto MillerLoop(std::span<G1Affine const> p, std::span<PreparedG2 const* const> q) -> Fp12 {
+  auto f{Fp12::One()};
+  auto const multiply_line{[&f](Line const& line, G1Affine const& point) { f = f.MulBy014(line[2], line[1] * point.x, line[0] * point.y); }};
+  std::size_t line{0};
+  for (std::size_t step{0}; step < detail::kLoopBits.size(); ++step) {
+    if (step != 0) {
+      f = f.Square();
+    }
+    for (std::size_t pair{0}; pair < p.size(); ++pair) {
+      multiply_line((*q[pair])[line], p[pair]);
+    }
+    ++line;
+    if (detail::kLoopBits[step]) {
+      for (std::size_t pair{0}; pair < p.size(); ++pair) {
+        multiply_line((*q[pair])[line], p[pair]);
+      }
+      ++line;
+    }
+  }
+  // x is negative
+  return f.Conjugate();
+}
+
+// f^((p^12 - 1) / r), up to a power coprime to r: the easy part (p^6 - 1)(p^2 + 1) with an inversion and Frobenius
+// maps, the hard part as Hayashida, Hayasaka and Teruya's (x - 1)^2 (x + p)(x^2 + p^2 - 1) + 3, five exponentiations
+// by x, which computes its third power.
+inline auto FinalExponentiation(Fp12 const& f) -> Fp12 {
+  auto const easy_p6{f.Conjugate() * f.Inverse()};
+  auto const m{easy_p6.Frobenius(2) * easy_p6};
+
+  auto const m_cubed{m.CyclotomicSquare() * m};
+  auto const m_x_minus_one{detail::PowX(m) * m.Conjugate()};
+  // a = m^((x - 1)^2)
+  auto const a{detail::PowX(m_x_minus_one) * m_x_minus_one.Conjugate()};
+  // b = a^(x + p)
+  auto const b{detail::PowX(a) * a.Frobenius(1)};
+  // b^(x^2 + p^2 - 1)
+  auto const b_x{detail::PowX(b)};
+  auto const c{detail::PowX(b_x) * b.Frobenius(2) * b.Conjugate()};
+  return m_cubed * c;
+}
+
+// Whether the pairings of the pairs multiply to 1; the G1 points are affine and, like the G2 points, not at infinity.
+inline auto PairingCheck(std::span<G1Affine const> p, std::span<PreparedG2 const* const> q) -> bool {
+  return FinalExponentiation(MillerLoop(p, q)) == Fp12::One();
+}
+
+}  // namespace evmint::bls12_381
@@ -0,0 +1,294 @@
+// SPDX-License-Identifier: MIT
+
+// The alt_bn128 (BN254) curve behind the ECADD, ECMUL and ECPAIRING precompiles that zk-SNARK verifiers call: G1 is
+// y^2 = x^3 + 3 over Fp, G2 its D-type sextic twist y^2 = x^3 + 3 / xi over Fp2 (xi = 9 + u), and the pairing the
+// optimal ate pairing into Fp12. A pairing check runs one Miller loop over all its pairs at once (a squaring of the
+// accumulator per step, shared by every pair) and one final exponentiation for the product. G2 points are kept in
+// homogeneous projective coordinates through the loop, so no step inverts.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "curve.hpp"
+#include "field.hpp"
+#include "tower.hpp"
+
+namespace evmint::bn254 {
+
+struct FieldModulus {
+  static constexpr field::Limbs<4> kModulus{0x3c20'8c16'd87c'fd47, 0x9781'6a91'6871'ca8d, 0xb850'45b6'8181'585d, 0x3064'4e72'e131'a029};
+};
+
+struct OrderModulus {
+  static constexpr field::Limbs<4> kModulus{0x43e1'f593'f000'0001, 0x2833'e848'79b9'7091, 0xb850'45b6'8181'585d, 0x3064'4e72'e131'a029};
+};
+
+// coordinates
+using Fp = field::PrimeField<FieldModulus>;
+using Fp2 = field::Fp2<Fp>;
+// scalars: the order r of G1 and G2
+using Fr = field::PrimeField<OrderModulus>;
+
+struct Tower {
+  using Fp = bn254::Fp;
+
+  // (9 + u) * value, by additions
+  static constexpr auto MulByXi(Fp2 const& value) -> Fp2 {
+    auto const eight_times{value.Double().Double().Double()};
+    return {eight_times.c0 + value.c0 - value.c1, eight_times.c1 + value.c1 + value.c0};
+  }
+};
+
+using Fp6 = field::Fp6<Tower>;
+using Fp12 = field::Fp12<Tower>;
+
+using G1Affine = curve::AffinePoint<Fp>;
+using G1 = curve::JacobianPoint<Fp>;
+using G2Affine = curve::AffinePoint<Fp2>;
+using G2 = curve::JacobianPoint<Fp2>;
+
+// the curve's parameter: p and r are polynomials in it
+constexpr std::uint64_t kX{0x44e9'92b4'4a69'09f1};
+
+constexpr auto kB{*Fp::FromLimbs({3, 0, 0, 0})};
+// 3 / xi
+constexpr Fp2 kTwistB{*Fp::FromLimbs({0x3267'e6dc'24a1'38e5, 0xb5b4'c5e5'59db'efa3, 0x81be'1899'1be0'6ac3, 0x2b14'9d40'ceb8'aaae}),
+                      *Fp::FromLimbs({0xe4a2'bd06'85c3'15d2, 0xa74f'a084'e52d'1852, 0xcd2c'afad'eed8'fdf4, 0x0097'13b0'3af0'fed4})};
+
+// G1's generator (1, 2), and G2's
+constexpr G1Affine kG1Generator{*Fp::FromLimbs({1, 0, 0, 0}), *Fp::FromLimbs({2, 0, 0, 0})};
+constexpr G2Affine kG2Generator{{*Fp::FromLimbs({0x46de'bd5c'd992'f6ed, 0x6743'22d4'f75e'dadd, 0x426a'0066'5e5c'4479, 0x1800'deef'121f'1e76}),
+                                 *Fp::FromLimbs({0x97e4'85b7'aef3'12c2, 0xf1aa'4933'35a9'e712, 0x7260'bfb7'31fb'5d25, 0x198e'9393'920d'483a})},
+                                {*Fp::FromLimbs({0x4ce6'cc01'66fa'7daa, 0xe3d1'e769'0c43'd37b, 0x4aab'7180'8dcb'408f, 0x12c8'5ea5'db8c'6deb}),
+                                 *Fp::FromLimbs({0x55ac'dadc'd122'975b, 0xbc4b'3133'70b3'8ef3, 0xec9e'99ad'690c'3395, 0x0906'89d0'585f'f075})}};
+
+constexpr std::size_t kFpSize{32};
+constexpr std::size_t kG1Size{2 * kFpSize};
+constexpr std::size_t kG2Size{4 * kFpSize};
+
+namespace detail {
+
+constexpr auto kTwoInverse{*Fp::FromLimbs({0x9e10'460b'6c3e'7ea4, 0xcbc0'b548'b438'e546, 0xdc28'22db'40c0'ac2e, 0x1832'2739'7098'd014})};
+
+// 6x + 2 in non-adjacent form, least significant digit first: the optimal ate pairing's loop, with fewer additions
+// than in binary
+constexpr auto kAteLoop{[] {
+  auto value{6 * field::uint128_t{kX} + 2};
+  std::array<std::int8_t, 66> digits{};
+  for (std::size_t digit{0}; value != 0; ++digit, value >>= 1) {
+    if ((value & 1) != 0) {
+      digits[digit] = (value & 3) == 1 ? 1 : -1;
+      value = digits[digit] == 1 ? value - 1 : value + 1;
+    }
+  }
+  return digits;
+}()};
+// the top digit, a 1 the loop starts from
+constexpr auto kAteLoopTop{[] {
+  auto top{kAteLoop.size() - 1};
+  while (kAteLoop[top] == 0) {
+    --top;
+  }
+  return top;
+}()};
+
+// x / z, y / z
+struct ProjectivePoint {
+  Fp2 x{};
+  Fp2 y{};
+  Fp2 z{};
+};
+
+// (c0, c1, c2) of a line through G2 points, evaluated at a G1 point P as c0 * P.y + c1 * P.x * w + c2 * v * w
+using Line = std::array<Fp2, 3>;
+
+// Doubles `point` and returns the tangent line at it (Costello, Lange and Naehrig's formulas for a D-type twist).
+inline auto DoublingStep(ProjectivePoint& point) -> Line {
+  auto const a{point.x * point.y * kTwoInverse};
+  auto const b{point.y.Square()};
+  auto const c{point.z.Square()};
+  auto const e{kTwistB * (c.Double() + c)};
+  auto const f{e.Double() + e};
+  auto const g{(b + f) * kTwoInverse};
+  auto const h{(point.y + point.z).Square() - (b + c)};
+  auto const j{point.x.Square()};
+  auto const e_square{e.Square()};
+  point = {a * (b - f), g.Square() - (e_square.Double() + e_square), b * h};
+  return {-h, j.Double() + j, e - b};
+}
+
+// Adds `addend` to `point` and returns the line through both.
+inline auto AdditionStep(ProjectivePoint& point, G2Affine const& addend) -> Line {
+  auto const theta{point.y - addend.y * point.z};
+  auto const lambda{point.x - addend.x * point.z};
+  auto const c{theta.Square()};
+  auto const d{lambda.Square()};
+  auto const e{lambda * d};
+  auto const f{point.z * c};
+  auto const g{point.x * d};
+  auto const h{e + f - g.Double()};
+  point = {lambda * h, theta * (g - h) - e * point.y, point.z * e};
+  return {lambda, -theta, theta * addend.x - lambda * addend.y};
+}
+
+// psi = untwist, Frobenius, twist: the endomorphism of the twist that acts on G2 as multiplication by p
+inline auto Psi(G2Affine const& point) -> G2Affine { return {point.x.Conjugate() * Fp12::kFrobenius[2], point.y.Conjugate() * Fp12::kFrobenius[3]}; }
+inline auto Psi(G2 const& point) -> G2 { return {point.x.Conjugate() * Fp12::kFrobenius[2], point.y.Conjugate() * Fp12::kFrobenius[3], point.z.Conjugate()}; }
+
+// f^(-x) for f in the cyclotomic subgroup
+inline auto PowMinusX(Fp12 const& f) -> Fp12 { return f.CyclotomicPow(kX).Conjugate(); }
+
+}  // namespace detail
+
+inline auto IsOnCurve(G1Affine const& point) -> bool { return point.y.Square() == point.x.Square() * point.x + kB; }
+inline auto IsOnCurve(G2Affine const& point) -> bool { return point.y.Square() == point.x.Square() * point.x + kTwistB; }
+
+// Whether a point of the twist is in G2, of order r: the twist has many other points. [r]Q == 0 if and only if
+// [x + 1]Q + psi([x]Q) + psi^2([x]Q) == psi^3([2x]Q) (El Housni, Guillevic and Piellard), which takes a 63-bit
+// multiplication rather than a 254-bit one.
+inline auto IsInG2(G2 const& point) -> bool {
+  auto const x_times{curve::Multiply(point, field::Limbs<1>{kX})};
+  auto const psi_x_times{detail::Psi(x_times)};
+  auto const lhs{curve::Add(curve::Add(curve::Add(x_times, point), psi_x_times), detail::Psi(psi_x_times))};
+  return lhs == detail::Psi(detail::Psi(detail::Psi(curve::Double(x_times))));
+}
+
+// A G1 point as two big-endian coordinates, (0, 0) standing for the point at infinity; nullopt for a coordinate not
+// below p or a point off the curve.
+inline auto ReadG1(std::byte const* source) -> std::optional<G1> {
+  auto const x{Fp::FromLimbs(field::LoadBigEndian<4>(source))};
+  auto const y{Fp::FromLimbs(field::LoadBigEndian<4>(source + kFpSize))};
+  if (not x or not y) {
+    return std::nullopt;
+  }
+  if (x->IsZero() and y->IsZero()) {
+    return G1{};
+  }
+  if (not IsOnCurve(G1Affine{*x, *y})) {
+    return std::nullopt;
+  }
+  return G1::FromAffine({*x, *y});
+}
+
+inline auto WriteG1(G1 const& point, std::byte* destination) -> void {
+  auto const affine_point{curve::ToAffine(point)};
+  field::StoreBigEndian(affine_point.x.ToLimbs(), destination);
+  field::StoreBigEndian(affine_point.y.ToLimbs(), destination + kFpSize);
+}
+
+// A G2 point as x and y, each an element c1 * u + c0 of Fp2 written as c1 then c0; all zeros for the point at
+// infinity. nullopt for a coordinate not below p, a point off the twist, or one outside G2.
+inline auto ReadG2(std::byte const* source) -> std::optional<G2> {
+  std::array<std::optional<Fp>, 4> coordinates{};
+  for (std::size_t index{0}; index < coordinates.size(); ++index) {
+    coordinates[index] = Fp::FromLimbs(field::LoadBigEndian<4>(source + index * kFpSize));
+    if (not coordinates[index]) {
+      return std::nullopt;
+    }
+  }
+  G2Affine const point{{*coordinates[1], *coordinates[0]}, {*coordinates[3], *coordinates[2]}};
+  if (point.x.IsZero() and point.y.IsZero()) {
+    return G2{};
+  }
+  if (not IsOnCurve(point) or not IsInG2(G2::FromAffine(point))) {
+    return std::nullopt;
+  }
+  return G2::FromAffine(point);
+}
+
+inline auto WriteG2(G2 const& point, std::byte* destination) -> void {
+  auto const affine_point{curve::ToAffine(point)};
+  for (std::size_t index{0}; auto const* const coordinate : {&affine_point.x.c1, &affine_point.x.c0, &affine_point.y.c1, &affine_point.y.c0}) {
+    field::StoreBigEndian(coordinate->ToLimbs(), destination + index++ * kFpSize);
+  }
+}
+
+// The product of the Miller loops of the pairs (p[i], q[i]), none of them at infinity.
+inline auto MillerLoop(std::span<G1Affine const> p, std::span<G2Affine const> q) -> Fp12 {
+  thread_local std::vector<detail::ProjectivePoint> points{};
+  points.resize(q.size());
+  for (std::size_t pair{0}; pair < q.size(); ++pair) {
+    points[pair] = {q[pair].x, q[pair].y, Fp2::One()};
+  }
+  auto f{Fp12::One()};
+  auto const multiply_line{[&f](detail::Line const& line, G1Affine const& point) { f = f.MulBy034(line[0] * point.y, line[1] * point.x, line[2]); }};
+
+  for (auto digit{detail::kAteLoopTop}; digit-- != 0;) {
+    if (digit + 1 != detail::kAteLoopTop) {
+      f = f.Square();
+    }
+    for (std::size_t pair{0}; pair < q.size(); ++pair) {
+      multiply_line(detail::DoublingStep(points[pair]), p[pair]);
+    }
+    if (detail::kAteLoop[digit] != 0) {
+      for (std::size_t pair{0}; pair < q.size(); ++pair) {
+        multiply_line(detail::AdditionStep(points[pair], detail::kAteLoop[digit] == 1 ? q[pair] : G2Affine{q[pair].x, -q[pair].y}), p[pair]);
+      }
+    }
+  }
+  // the optimal ate pairing's two closing lines, through psi(Q) and -psi^2(Q)
+  for (std::size_t pair{0}; pair < q.size(); ++pair) {
+    auto const q1{detail::Psi(q[pair])};
+    auto const q2{detail::Psi(q1)};
+    multiply_line(detail::AdditionStep(points[pair], q1), p[pair]);
+    multiply_line(detail::AdditionStep(points[pair], {q2.x, -q2.y}), p[pair]);
+  }
+  return f;
+}
+
+// f^((p^12 - 1) / r), up to a power coprime to r: the easy part (p^6 - 1)(p^2 + 1) with an inversion and Frobenius
+// maps, the hard part (p^4 - p^2 + 1) / r as Fuentes-Castaneda, Knapp and Rodriguez-Henriquez's chain of three
+// exponentiations by x, which computes its 2x(6x^2 + 3x + 1)-th power.
+inline auto FinalExponentiation(Fp12 const& f) -> Fp12 {
+  auto const easy_p6{f.Conjugate() * f.Inverse()};
+  auto const r{easy_p6.Frobenius(2) * easy_p6};
+
+  auto const y0{detail::PowMinusX(r)};
+  auto const y1{y0.CyclotomicSquare()};
+  auto const y2{y1.CyclotomicSquare()};
+  auto const y3{y2 * y1};
+  auto const y4{detail::PowMinusX(y3)};
+  auto const y5{y4.CyclotomicSquare()};
+  auto const y6{detail::PowMinusX(y5)};
+  auto const y7{y6.Conjugate() * y4};
+  auto const y8{y7 * y3.Conjugate()};
+  auto const y9{y8 * y1};
+  auto const y10{y8 * y4};
+  auto const y11{y10 * r};
+  auto const y13{y9.Frobenius(1) * y11};
+  auto const y14{y8.Frobenius(2) * y13};
+  auto const y15{(r.Conjugate() * y9).Frobenius(3)};
+  return y15 * y14;
+}
+
+// Whether the pairings of the pairs multiply to 1. Pairs with a point at infinity contribute 1 and are skipped.
+inline auto PairingCheck(std::span<G1 const> p, std::span<G2 const> q) -> bool {
+  thread_local std::vector<G1> finite_p{};
+  thread_local std::vector<G2> finite_q{};
+  thread_local std::vector<G1Affine> affine_p{};
+  thread_local std::vector<G2Affine> affine_q{};
+  finite_p.clear();
+  finite_q.clear();
+  for (std::size_t pair{0}; pair < p.size(); ++pair) {
+    if (not p[pair].IsInfinity() and not q[pair].IsInfinity()) {
+      finite_p.push_back(p[pair]);
+      finite_q.push_back(q[pair]);
+    }
+  }
+  if (finite_p.empty()) {
+    return true;
+  }
+  affine_p.resize(finite_p.size());
+  affine_q.resize(finite_q.size());
+  curve::ToAffine<Fp>(finite_p, affine_p);
+  curve::ToAffine<Fp2>(finite_q, affine_q);
+  return FinalExponentiation(MillerLoop(affine_p, affine_q)) == Fp12::One();
+}
+
+}  // namespace evmint::bn254
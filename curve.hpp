@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: MIT
+
+// Points of short Weierstrass curves y^2 = x^3 + b (a = 0, as for secp256k1, BN254 and BLS12-381) over any field with
+// PrimeField's interface: Fp for the curves themselves, Fp2 for the twists pairings take their second argument from.
+// Jacobian coordinates keep additions and doublings free of inversions; b never enters them.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "field.hpp"
+
+namespace evmint::curve {
+
+template <typename Field>
+struct AffinePoint {
+  Field x{};
+  Field y{};
+};
+
+// (x / z^2, y / z^3); z == 0 is the point at infinity
+template <typename Field>
+struct JacobianPoint {
+  Field x{};
+  Field y{};
+  Field z{};
+
+  static auto FromAffine(AffinePoint<Field> const& point) -> JacobianPoint { return {point.x, point.y, Field::One()}; }
+  auto IsInfinity() const -> bool { return z.IsZero(); }
+  auto operator-() const -> JacobianPoint { return {x, -y, z}; }
+
+  // the same point, whatever the z of each
+  auto operator==(JacobianPoint const& rhs) const -> bool {
+    if (IsInfinity() or rhs.IsInfinity()) {
+      return IsInfinity() and rhs.IsInfinity();
+    }
+    auto const z1z1{z.Square()};
+    auto const z2z2{rhs.z.Square()};
+    return x * z2z2 == rhs.x * z1z1 and y * z2z2 * rhs.z == rhs.y * z1z1 * z;
+  }
+};
+
+template <typename Field>
+auto Double(JacobianPoint<Field> const& point) -> JacobianPoint<Field> {
+  // dbl-2009-l, for a = 0
+  auto const a{point.x.Square()};
+  auto const b{point.y.Square()};
+  auto const c{b.Square()};
+  auto const d{((point.x + b).Square() - a - c).Double()};
+  auto const e{a.Double() + a};
+  auto const x{e.Square() - d.Double()};
+  auto const eight_c{c.Double().Double().Double()};
+  return {x, e * (d - x) - eight_c, (point.y * point.z).Double()};
+}
+
+template <typename Field>
+auto Add(JacobianPoint<Field> const& lhs, AffinePoint<Field> const& rhs) -> JacobianPoint<Field> {
+  if (lhs.IsInfinity()) {
+    return JacobianPoint<Field>::FromAffine(rhs);
+  }
+  // madd-2007-bl
+  auto const z1z1{lhs.z.Square()};
+  auto const h{rhs.x * z1z1 - lhs.x};
+  auto const r{(rhs.y * lhs.z * z1z1 - lhs.y).Double()};
+  if (h.IsZero()) {
+    return r.IsZero() ? Double(lhs) : JacobianPoint<Field>{};
+  }
+  auto const hh{h.Square()};
+  auto const i{hh.Double().Double()};
+  auto const j{h * i};
+  auto const v{lhs.x * i};
+  auto const x{r.Square() - j - v.Double()};
+  return {x, r * (v - x) - (lhs.y * j).Double(), (lhs.z + h).Square() - z1z1 - hh};
+}
+
+template <typename Field>
+auto Add(JacobianPoint<Field> const& lhs, JacobianPoint<Field> const& rhs) -> JacobianPoint<Field> {
+  if (lhs.IsInfinity()) {
+    return rhs;
+  }
+  if (rhs.IsInfinity()) {
+    return lhs;
+  }
+  // add-2007-bl
+  auto const z1z1{lhs.z.Square()};
+  auto const z2z2{rhs.z.Square()};
+  auto const u1{lhs.x * z2z2};
+  auto const s1{lhs.y * rhs.z * z2z2};
+  auto const h{rhs.x * z1z1 - u1};
+  auto const r{(rhs.y * lhs.z * z1z1 - s1).Double()};
+  if (h.IsZero()) {
+    return r.IsZero() ? Double(lhs) : JacobianPoint<Field>{};
+  }
+  auto const i{h.Double().Square()};
+  auto const j{h * i};
+  auto const v{u1 * i};
+  auto const x{r.Square() - j - v.Double()};
+  return {x, r * (v - x) - (s1 * j).Double(), ((lhs.z + rhs.z).Square() - z1z1 - z2z2) * h};
+}
+
+// Converts to affine coordinates with one inversion for all of them; points at infinity come out as (0, 0).
+template <typename Field>
+auto ToAffine(std::span<JacobianPoint<Field> const> points, std::span<AffinePoint<Field>> affine_points) -> void {
+  thread_local std::vector<Field> inverses{};
+  inverses.resize(points.size());
+  for (std::size_t index{0}; index < points.size(); ++index) {
+    inverses[index] = points[index].z;
+  }
+  field::InvertAll(std::span{inverses});
+  for (std::size_t index{0}; index < points.size(); ++index) {
+    auto const inverse_squared{inverses[index].Square()};
+    affine_points[index] = {points[index].x * inverse_squared, points[index].y * inverse_squared * inverses[index]};
+  }
+}
+
+template <typename Field>
+auto ToAffine(JacobianPoint<Field> const& point) -> AffinePoint<Field> {
+  AffinePoint<Field> affine_point{};
+  ToAffine<Field>(std::span{&point, 1}, std::span{&affine_point, 1});
+  return affine_point;
+}
+
+// scalar * point by 4-bit windows, most significant first: 4 doublings and at most one addition per window
+template <typename Field, std::size_t kLimbCount>
+auto Multiply(JacobianPoint<Field> const& point, field::Limbs<kLimbCount> const& scalar) -> JacobianPoint<Field> {
+  constexpr std::size_t kWindowBits{4};
+  std::array<JacobianPoint<Field>, (1 << kWindowBits) - 1> multiples{point};
+  for (std::size_t digit{1}; digit < multiples.size(); ++digit) {
+    multiples[digit] = digit % 2 == 1 ? Double(multiples[digit / 2]) : Add(multiples[digit - 1], point);
+  }
+  JacobianPoint<Field> result{};
+  for (auto window{64 * kLimbCount / kWindowBits}; window-- != 0;) {
+    if (not result.IsInfinity()) {
+      for (std::size_t bit{0}; bit < kWindowBits; ++bit) {
+        result = Double(result);
+      }
+    }
+    auto const bit{window * kWindowBits};
+    if (auto const digit{static_cast<std::size_t>(scalar[bit / 64] >> (bit % 64)) & ((1 << kWindowBits) - 1)}; digit != 0) {
+      result = Add(result, multiples[digit - 1]);
+    }
+  }
+  return result;
+}
+
+}  // namespace evmint::curve
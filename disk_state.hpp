@@ -0,0 +1,507 @@
+// SPDX-License-Identifier: MIT
+
+// State on disk, read asynchronously: executions that need state nobody has read yet suspend instead of blocking
+// their thread, so one thread keeps many executions and their disk reads in flight. Linux only (io_uring).
+//
+// State file. A header page, then kBucketCount pages forming a hash table of fixed-size records, one per account
+// (balance and code size) and one per non-zero storage slot. A key lives in the page its hash picks or, if that page
+// is full, in one of the following pages (linear probing), so most lookups read exactly one page. Pages are read with
+// O_DIRECT where the file system allows it, so a cold replay measures the disk rather than the page cache. Words are
+// stored in host byte order; the file is a local cache, not an exchange format.
+//
+// Execution. An AsyncExecutor runs a batch of requests on the calling thread in up to `lane_count` lanes, each a C++20
+// coroutine with its own Interpreter. A lane runs its execution until the interpreter suspends it on state that is not
+// resident (ExecutionStatus::kStateMissing), queues the page read on an io_uring and co_awaits it; the executor keeps
+// running the other lanes, submits all queued reads at once and resumes each lane when its read completes.
+
+#pragma once
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "evm.hpp"
+#include "interpreter.hpp"
+#include "state.hpp"
+
+namespace evmint::disk {
+
+constexpr std::size_t kPageSize{4'096};
+constexpr std::uint64_t kStateFileMagic{0x4554'4154'5354'4d45};  // "EMTSTATE"
+
+// One key of the state file; accounts use slot 0.
+struct Record {
+  word_t address{};
+  word_t slot{};
+  // balance for accounts
+  word_t value{};
+  std::uint32_t is_account{0};
+  std::uint32_t code_size{0};
+};
+static_assert(std::is_trivially_copyable_v<Record>);
+
+struct PageHeader {
+  std::uint64_t record_count{0};
+};
+
+constexpr std::size_t kRecordsPerPage{(kPageSize - sizeof(PageHeader)) / sizeof(Record)};
+
+struct FileHeader {
+  std::uint64_t magic{kStateFileMagic};
+  std::uint64_t bucket_count{0};
+};
+
+// What the state file holds for a key: a storage value, or an account's balance and code size.
+struct Entry {
+  word_t value{};
+  std::uint32_t code_size{0};
+};
+
+inline auto BucketOf(StateKey const& key, std::uint64_t bucket_count) -> std::uint64_t {
+  // StateKeyHash keeps neighbouring slots neighbouring; mix it so they spread over the buckets
+  auto hash{static_cast<std::uint64_t>(StateKeyHash{}(key))};
+  hash = (hash ^ (hash >> 30)) * 0xbf58'476d'1ce4'e5b9;
+  hash = (hash ^ (hash >> 27)) * 0x94d0'49bb'1331'11eb;
+  return (hash ^ (hash >> 31)) % bucket_count;
+}
+
+inline auto RecordKey(Record const& record) -> StateKey { return record.is_account != 0 ? StateKey::Balance(record.address) : StateKey::Storage(record.address, record.slot); }
+
+// Writes `accounts` as a state file at `path`, buckets filled to about half on average.
+inline auto WriteStateFile(std::filesystem::path const& path, Accounts const& accounts) -> void {
+  std::vector<Record> records{};
+  for (auto const& [address, account] : accounts) {
+    records.push_back({.address = address, .value = account.balance, .is_account = 1, .code_size = static_cast<std::uint32_t>(account.code.size())});
+    for (auto const& [slot, value] : account.storage) {
+      if (value != 0) {
+        records.push_back({.address = address, .slot = slot, .value = value});
+      }
+    }
+  }
+
+  FileHeader const header{.bucket_count = std::max<std::uint64_t>(2 * records.size() / kRecordsPerPage, 1) + 1};
+  std::vector<std::byte> pages((header.bucket_count + 1) * kPageSize);
+  std::memcpy(pages.data(), &header, sizeof(header));
+  for (auto const& record : records) {
+    for (auto bucket{BucketOf(RecordKey(record), header.bucket_count)};; bucket = (bucket + 1) % header.bucket_count) {
+      auto* const page{pages.data() + (bucket + 1) * kPageSize};
+      PageHeader page_header{};
+      std::memcpy(&page_header, page, sizeof(page_header));
+      if (page_header.record_count < kRecordsPerPage) {
+        std::memcpy(page + sizeof(PageHeader) + page_header.record_count * sizeof(Record), &record, sizeof(record));
+        page_header.record_count++;
+        std::memcpy(page, &page_header, sizeof(page_header));
+        break;
+      }
+    }
+  }
+
+  std::ofstream file{path, std::ios::binary | std::ios::trunc};
+  file.write(reinterpret_cast<char const*>(pages.data()), static_cast<std::streamsize>(pages.size()));
+  if (not file) {
+    throw std::runtime_error{std::format("[DISK]: Could not write the state file '{}'.", path.string())};
+  }
+}
+
+// Page buffers for O_DIRECT reads, which want them aligned to the page size.
+struct PageDeleter {
+  auto operator()(std::byte* page) const -> void { ::operator delete[](page, std::align_val_t{kPageSize}); }
+};
+using PageBuffer = std::unique_ptr<std::byte[], PageDeleter>;
+
+inline auto MakePageBuffer() -> PageBuffer { return PageBuffer{static_cast<std::byte*>(::operator new[](kPageSize, std::align_val_t{kPageSize}))}; }
+
+// Looks `key` up in a bucket page: its entry, or nullopt if the page is full and the key may be in the next page.
+// A key in neither is absent, which reads as zero.
+inline auto FindInPage(std::span<std::byte const> page, StateKey const& key) -> std::optional<Entry> {
+  PageHeader page_header{};
+  std::memcpy(&page_header, page.data(), sizeof(page_header));
+  for (std::size_t index{0}; index < std::min<std::size_t>(page_header.record_count, kRecordsPerPage); ++index) {
+    Record record{};
+    std::memcpy(&record, page.data() + sizeof(PageHeader) + index * sizeof(Record), sizeof(record));
+    if (RecordKey(record) == key) {
+      return Entry{.value = record.value, .code_size = record.code_size};
+    }
+  }
+  return page_header.record_count < kRecordsPerPage ? std::optional{Entry{}} : std::nullopt;
+}
+
+// The submission and completion rings of one io_uring, set up with raw system calls, for page reads only.
+class IoUring final {
+ public:
+  explicit IoUring(unsigned entries) {
+    io_uring_params params{};
+    m_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (m_fd < 0) {
+      throw std::runtime_error{std::format("[DISK]: Could not set up an io_uring: {}.", std::strerror(errno))};
+    }
+    m_ring_size = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned), params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    if ((params.features & IORING_FEAT_SINGLE_MMAP) == 0) {
+      close(m_fd);
+      throw std::runtime_error{"[DISK]: The kernel's io_uring is too old (no IORING_FEAT_SINGLE_MMAP)."};
+    }
+    m_ring = mmap(nullptr, m_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+    m_sqes = static_cast<io_uring_sqe*>(mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES));
+    if (m_ring == MAP_FAILED or m_sqes == MAP_FAILED) {
+      auto const error{errno};
+      this->~IoUring();
+      throw std::runtime_error{std::format("[DISK]: Could not map the io_uring: {}.", std::strerror(error))};
+    }
+
+    auto* const ring{static_cast<std::byte*>(m_ring)};
+    m_sq_head = reinterpret_cast<unsigned*>(ring + params.sq_off.head);
+    m_sq_tail = reinterpret_cast<unsigned*>(ring + params.sq_off.tail);
+    m_sq_mask = *reinterpret_cast<unsigned*>(ring + params.sq_off.ring_mask);
+    m_sq_entries = params.sq_entries;
+    m_sq_array = reinterpret_cast<unsigned*>(ring + params.sq_off.array);
+    m_cq_head = reinterpret_cast<unsigned*>(ring + params.cq_off.head);
+    m_cq_tail = reinterpret_cast<unsigned*>(ring + params.cq_off.tail);
+    m_cq_mask = *reinterpret_cast<unsigned*>(ring + params.cq_off.ring_mask);
+    m_cqes = reinterpret_cast<io_uring_cqe*>(ring + params.cq_off.cqes);
+  }
+  IoUring(IoUring const&) = delete;
+  auto operator=(IoUring const&) -> IoUring& = delete;
+  ~IoUring() {
+    if (m_sqes != nullptr and m_sqes != MAP_FAILED) {
+      munmap(m_sqes, m_sqes_size);
+    }
+    if (m_ring != nullptr and m_ring != MAP_FAILED) {
+      munmap(m_ring, m_ring_size);
+    }
+    close(m_fd);
+  }
+
+  // Queues a read of `buffer.size()` bytes at `offset`; false if the submission ring is full.
+  auto QueueRead(int fd, std::span<std::byte> buffer, std::uint64_t offset, std::uint64_t user_data) -> bool {
+    auto const tail{*m_sq_tail};
+    if (tail - std::atomic_ref{*m_sq_head}.load(std::memory_order_acquire) == m_sq_entries) {
+      return false;
+    }
+    auto const index{tail & m_sq_mask};
+    auto& sqe{m_sqes[index]};
+    sqe = {};
+    sqe.opcode = IORING_OP_READ;
+    sqe.fd = fd;
+    sqe.addr = reinterpret_cast<std::uint64_t>(buffer.data());
+    sqe.len = static_cast<std::uint32_t>(buffer.size());
+    sqe.off = offset;
+    sqe.user_data = user_data;
+    m_sq_array[index] = index;
+    std::atomic_ref{*m_sq_tail}.store(tail + 1, std::memory_order_release);
+    m_queued++;
+    return true;
+  }
+
+  // Submits the queued reads and waits until at least `wait_for` completions are ready.
+  auto Submit(unsigned wait_for) -> void {
+    while (true) {
+      auto const submitted{syscall(__NR_io_uring_enter, m_fd, m_queued, wait_for, wait_for == 0 ? 0U : IORING_ENTER_GETEVENTS, nullptr, 0)};
+      if (submitted >= 0) {
+        m_queued -= static_cast<unsigned>(submitted);
+        return;
+      }
+      if (errno != EINTR) {
+        throw std::runtime_error{std::format("[DISK]: io_uring_enter failed: {}.", std::strerror(errno))};
+      }
+    }
+  }
+
+  // Calls `handler(user_data, result)` for every completion ready, result being bytes read or -errno.
+  auto ForEachCompletion(auto&& handler) -> void {
+    auto head{*m_cq_head};
+    for (auto const tail{std::atomic_ref{*m_cq_tail}.load(std::memory_order_acquire)}; head != tail; ++head) {
+      auto const& cqe{m_cqes[head & m_cq_mask]};
+      // released before the handler runs, which may queue reads of its own
+      std::atomic_ref{*m_cq_head}.store(head + 1, std::memory_order_release);
+      handler(cqe.user_data, cqe.res);
+    }
+  }
+
+ private:
+  int m_fd{-1};
+  void* m_ring{nullptr};
+  std::size_t m_ring_size{0};
+  io_uring_sqe* m_sqes{nullptr};
+  std::size_t m_sqes_size{0};
+  unsigned* m_sq_head{nullptr};
+  unsigned* m_sq_tail{nullptr};
+  unsigned m_sq_mask{0};
+  unsigned m_sq_entries{0};
+  unsigned* m_sq_array{nullptr};
+  unsigned* m_cq_head{nullptr};
+  unsigned* m_cq_tail{nullptr};
+  unsigned m_cq_mask{0};
+  io_uring_cqe* m_cqes{nullptr};
+  // queued but not yet submitted
+  unsigned m_queued{0};
+};
+
+// A state file opened for one thread: keys read so far stay resident in memory, the rest are fetched from disk through
+// the thread's io_uring. Not thread-safe, unlike the StateViews executors share.
+class DiskState final : public StateView {
+ public:
+  DiskState(std::filesystem::path const& path, IoUring& ring) : m_ring{ring} {
+    m_fd = open(path.c_str(), O_RDONLY | O_DIRECT);
+    if (m_fd < 0 and errno == EINVAL) {
+      m_fd = open(path.c_str(), O_RDONLY);
+    }
+    if (m_fd < 0) {
+      throw std::runtime_error{std::format("[DISK]: Could not open the state file '{}': {}.", path.string(), std::strerror(errno))};
+    }
+    auto const page{MakePageBuffer()};
+    FileHeader header{};
+    if (pread(m_fd, page.get(), kPageSize, 0) != static_cast<ssize_t>(kPageSize) or (std::memcpy(&header, page.get(), sizeof(header)), header.magic != kStateFileMagic)) {
+      close(m_fd);
+      throw std::runtime_error{std::format("[DISK]: '{}' is not a state file.", path.string())};
+    }
+    m_bucket_count = header.bucket_count;
+  }
+  DiskState(DiskState const&) = delete;
+  auto operator=(DiskState const&) -> DiskState& = delete;
+  ~DiskState() override { close(m_fd); }
+
+  auto StorageAt(word_t const& address, word_t const& slot) const -> word_t override { return Read(StateKey::Storage(address, slot)).value; }
+  auto BalanceOf(word_t const& address) const -> word_t override { return Read(StateKey::Balance(ToAddress(address))).value; }
+  // code is not kept in the state file; executions bring their own in the request
+  auto CodeAt(word_t const& /*address*/) const -> std::span<std::byte const> override { return {}; }
+  auto CodeSizeAt(word_t const& address) const -> std::size_t override { return Read(StateKey::Balance(ToAddress(address))).code_size; }
+  auto IsResident(StateKey const& key) const -> bool override { return m_resident.contains(key); }
+
+  // Awaits `key` becoming resident; lanes waiting for the same key share one read.
+  class Fetch {
+   public:
+    Fetch(DiskState& state, StateKey const& key) : m_state{state}, m_key{key} {}
+    auto await_ready() const -> bool { return m_state.IsResident(m_key); }
+    auto await_suspend(std::coroutine_handle<> waiter) -> void { m_state.QueueFetch(m_key, waiter); }
+    auto await_resume() const -> void {}
+
+   private:
+    DiskState& m_state;
+    StateKey m_key;
+  };
+
+  // Handles one completion of the ring: makes the key resident and resumes its waiters, or reads the next page. A failed
+  // read is recorded in Error() instead of thrown, as other reads may still be in flight; completions after it are only
+  // counted.
+  auto Complete(std::uint64_t user_data, std::int32_t result) -> void {
+    m_reads_in_flight--;
+    if (m_error) {
+      return;
+    }
+    auto* const read{reinterpret_cast<PendingRead*>(user_data)};
+    if (result != static_cast<std::int32_t>(kPageSize)) {
+      m_error = std::format("[DISK]: Reading state page {} failed: {}.", read->bucket, result < 0 ? std::strerror(-result) : "short read");
+      return;
+    }
+    auto const entry{FindInPage({read->page.get(), kPageSize}, read->key)};
+    if (not entry) {
+      read->bucket = (read->bucket + 1) % m_bucket_count;
+      QueueRead(*read);
+      return;
+    }
+
+    m_resident.insert_or_assign(read->key, *entry);
+    auto const pending{m_pending.extract(read->key)};
+    for (auto const waiter : pending.mapped()->waiters) {
+      waiter.resume();
+    }
+  }
+
+  auto InFlightReads() const -> std::size_t { return m_pending.size(); }
+  auto PageReads() const -> std::size_t { return m_page_reads; }
+  auto Error() const -> std::optional<std::string> const& { return m_error; }
+
+  // Waits for every read queued on the ring without handling it, so the kernel is done with the pages before they are
+  // freed.
+  auto Drain() -> void {
+    while (m_reads_in_flight != 0) {
+      m_ring.Submit(1);
+      m_ring.ForEachCompletion([this](std::uint64_t /*user_data*/, std::int32_t /*result*/) { m_reads_in_flight--; });
+    }
+  }
+
+ private:
+  struct PendingRead {
+    StateKey key{};
+    std::uint64_t bucket{0};
+    PageBuffer page{MakePageBuffer()};
+    std::vector<std::coroutine_handle<>> waiters{};
+  };
+
+  IoUring& m_ring;
+  int m_fd{-1};
+  std::uint64_t m_bucket_count{0};
+  mutable std::unordered_map<StateKey, Entry, StateKeyHash> m_resident{};
+  std::unordered_map<StateKey, std::unique_ptr<PendingRead>, StateKeyHash> m_pending{};
+  mutable std::size_t m_page_reads{0};
+  // queued on the ring and not completed yet
+  std::size_t m_reads_in_flight{0};
+  std::optional<std::string> m_error{};
+
+  auto QueueFetch(StateKey const& key, std::coroutine_handle<> waiter) -> void {
+    auto& pending{m_pending[key]};
+    if (not pending) {
+      pending = std::make_unique<PendingRead>(PendingRead{.key = key, .bucket = BucketOf(key, m_bucket_count)});
+      QueueRead(*pending);
+    }
+    pending->waiters.push_back(waiter);
+  }
+
+  auto QueueRead(PendingRead& read) -> void {
+    m_page_reads++;
+    m_reads_in_flight++;
+    while (not m_ring.QueueRead(m_fd, {read.page.get(), kPageSize}, (read.bucket + 1) * kPageSize, reinterpret_cast<std::uint64_t>(&read))) {
+      m_ring.Submit(0);
+    }
+  }
+
+  // For reads outside an AsyncExecutor (plain Interpreter::Execute() never reads state that is not resident, but
+  // hosts may): blocks on the disk.
+  auto Read(StateKey const& key) const -> Entry const& {
+    if (auto const resident{m_resident.find(key)}; resident != std::end(m_resident)) {
+      return resident->second;
+    }
+    auto const page{MakePageBuffer()};
+    for (auto bucket{BucketOf(key, m_bucket_count)};; bucket = (bucket + 1) % m_bucket_count) {
+      m_page_reads++;
+      if (pread(m_fd, page.get(), kPageSize, static_cast<off_t>((bucket + 1) * kPageSize)) != static_cast<ssize_t>(kPageSize)) {
+        throw std::runtime_error{std::format("[DISK]: Reading state page {} failed.", bucket)};
+      }
+      if (auto const entry{FindInPage({page.get(), kPageSize}, key)}) {
+        return m_resident.insert_or_assign(key, *entry).first->second;
+      }
+    }
+  }
+};
+
+// A lane's coroutine. It starts running right away, and its frame lives until the Task is destroyed.
+class Task final {
+ public:
+  struct promise_type {
+    std::exception_ptr exception{};
+
+    auto get_return_object() -> Task { return Task{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+    auto initial_suspend() noexcept -> std::suspend_never { return {}; }
+    auto final_suspend() noexcept -> std::suspend_always { return {}; }
+    auto return_void() -> void {}
+    auto unhandled_exception() -> void { exception = std::current_exception(); }
+  };
+
+  explicit Task(std::coroutine_handle<promise_type> handle) : m_handle{handle} {}
+  Task(Task&& other) noexcept : m_handle{std::exchange(other.m_handle, {})} {}
+  auto operator=(Task&&) -> Task& = delete;
+  ~Task() {
+    if (m_handle) {
+      m_handle.destroy();
+    }
+  }
+
+  // Done and rethrows what the coroutine threw, if anything.
+  auto Done() const -> bool {
+    if (m_handle.done() and m_handle.promise().exception) {
+      std::rethrow_exception(m_handle.promise().exception);
+    }
+    return m_handle.done();
+  }
+
+ private:
+  std::coroutine_handle<promise_type> m_handle;
+};
+
+struct AsyncStatistics {
+  // times an execution was suspended on missing state
+  std::size_t suspensions{0};
+  std::size_t page_reads{0};
+};
+
+// Runs batches of requests against a state file on the calling thread, up to `lane_count` executions at once.
+class AsyncExecutor final {
+ public:
+  AsyncExecutor(std::filesystem::path state_path, std::size_t lane_count, InterpreterOptions options = kExecutorOptions)
+      : m_state_path{std::move(state_path)}, m_ring{static_cast<unsigned>(std::bit_ceil(std::max<std::size_t>(lane_count, 1)))} {
+    for (std::size_t lane{0}; lane < std::max<std::size_t>(lane_count, 1); ++lane) {
+      m_interpreters.push_back(std::make_unique<Interpreter>(options));
+    }
+  }
+
+  // Runs `requests` (their `state` replaced by the state file) and returns the results in request order. Every batch
+  // starts from a cold state: nothing read by an earlier batch is resident.
+  auto Execute(std::span<ExecutionRequest const> requests) -> std::vector<ExecutionResult> {
+    DiskState state{m_state_path, m_ring};
+    std::vector<ExecutionResult> results(requests.size());
+    std::size_t next_request{0};
+    m_statistics = {};
+
+    std::vector<Task> lanes{};
+    for (auto& interpreter : m_interpreters) {
+      lanes.push_back(RunLane(*interpreter, state, requests, next_request, results));
+    }
+    try {
+      while (not state.Error() and not std::ranges::all_of(lanes, &Task::Done)) {
+        m_ring.Submit(1);
+        m_ring.ForEachCompletion([&state](std::uint64_t user_data, std::int32_t result) { state.Complete(user_data, result); });
+      }
+    } catch (...) {
+      state.Drain();
+      throw;
+    }
+    if (auto const& error{state.Error()}) {
+      state.Drain();
+      throw std::runtime_error{*error};
+    }
+    m_statistics.page_reads = state.PageReads();
+    return results;
+  }
+
+  auto LaneCount() const -> std::size_t { return m_interpreters.size(); }
+  // of the last batch
+  auto Statistics() const -> AsyncStatistics const& { return m_statistics; }
+
+ private:
+  std::filesystem::path m_state_path;
+  IoUring m_ring;
+  std::vector<std::unique_ptr<Interpreter>> m_interpreters{};
+  AsyncStatistics m_statistics{};
+
+  auto RunLane(Interpreter& interpreter, DiskState& state, std::span<ExecutionRequest const> requests, std::size_t& next_request, std::vector<ExecutionResult>& results)
+      -> Task {
+    for (auto index{next_request++}; index < requests.size(); index = next_request++) {
+      auto request{requests[index]};
+      request.state = &state;
+      auto result{interpreter.Execute(request)};
+      while (result.status == ExecutionStatus::kStateMissing) {
+        m_statistics.suspensions++;
+        co_await DiskState::Fetch{state, interpreter.MissingState()};
+        result = interpreter.Resume();
+      }
+      results[index] = std::move(result);
+    }
+  }
+};
+
+}  // namespace evmint::disk
@@ -0,0 +1,478 @@
+// SPDX-License-Identifier: MIT
+
+// Opcode tables, code analysis and word primitives shared by the interpreter, the JIT and the
+// ahead-of-time translator (evmint-aot).
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <range/v3/all.hpp>
+#include <magic_enum.hpp>
+#include <intx/intx.hpp>
+
+namespace evmint {
+
+constexpr std::size_t kHexBase{16};
+constexpr std::size_t kWordSize{32};
+constexpr std::size_t kByteSize{8};
+constexpr std::size_t kMaxStackWordsSize{1024};
+constexpr std::size_t kMaxStackSize{kMaxStackWordsSize * 8};
+// TODO: 2^256
+constexpr std::size_t kMemorySize{100'000};
+
+// intrinsic gas of a transaction: a base cost, call data by the byte (EIP-2028) and access lists (EIP-2930)
+constexpr std::size_t kTransactionGas{21'000};
+constexpr std::size_t kZeroDataByteGas{4};
+constexpr std::size_t kNonZeroDataByteGas{16};
+constexpr std::size_t kAccessListAddressGas{2'400};
+constexpr std::size_t kAccessListSlotGas{1'900};
+
+// the JUMPDEST a taken JUMP/JUMPI lands on, charged by the jump as execution resumes right after it
+constexpr std::size_t kJumpDestGas{1};
+
+// LOGn: a base cost and one per topic, charged up front like any static cost, and the data by the byte
+constexpr std::size_t kLogGas{375};
+constexpr std::size_t kLogTopicGas{375};
+constexpr std::size_t kLogDataByteGas{8};
+
+using opcode_t = std::byte;
+using word_t = intx::uint256;
+
+constexpr opcode_t kStop{0x00};
+constexpr opcode_t kAdd{0x01};
+constexpr opcode_t kMul{0x02};
+constexpr opcode_t kSub{0x03};
+constexpr opcode_t kLt{0x10};
+constexpr opcode_t kGt{0x11};
+constexpr opcode_t kEq{0x14};
+constexpr opcode_t kIsZero{0x15};
+constexpr opcode_t kAnd{0x16};
+constexpr opcode_t kOr{0x17};
+constexpr opcode_t kXor{0x18};
+constexpr opcode_t kNot{0x19};
+constexpr opcode_t kShl{0x1b};
+constexpr opcode_t kShr{0x1c};
+constexpr opcode_t kBalance{0x31};
+constexpr opcode_t kCallDataLoad{0x35};
+constexpr opcode_t kCallDataSize{0x36};
+constexpr opcode_t kExtCodeSize{0x3b};
+constexpr opcode_t kPop{0x50};
+constexpr opcode_t kMLoad{0x51};
+constexpr opcode_t kMStore{0x52};
+constexpr opcode_t kSLoad{0x54};
+constexpr opcode_t kSStore{0x55};
+constexpr opcode_t kJump{0x56};
+constexpr opcode_t kJumpI{0x57};
+constexpr opcode_t kJumpDest{0x5b};
+constexpr opcode_t kPush0{0x5f};
+constexpr opcode_t kPush1{0x60};
+constexpr opcode_t kPush2{0x61};
+constexpr opcode_t kPush12{0x6b};
+constexpr opcode_t kPush32{0x7f};
+constexpr opcode_t kDup1{0x80};
+constexpr opcode_t kDup2{0x81};
+constexpr opcode_t kDup3{0x82};
+constexpr opcode_t kSwap1{0x90};
+constexpr opcode_t kLog0{0xa0};
+constexpr opcode_t kLog1{0xa1};
+constexpr opcode_t kLog2{0xa2};
+constexpr opcode_t kLog3{0xa3};
+constexpr opcode_t kLog4{0xa4};
+
+enum class RevertError { kStackOverflow, kGasExceeded, kStackUnderflow, kMemoryUnalignedAccess, kMemoryOutOfBounds, kInvalidJump };
+
+// Thrown by opcode handlers; keeps the error next to the message so callers can report it as a status.
+class Revert : public std::runtime_error {
+ public:
+  Revert(std::string_view mnemonic, RevertError error) : std::runtime_error{std::format("[{}]: Revert due to {}.", mnemonic, magic_enum::enum_name(error))}, m_error{error} {}
+
+  auto Error() const noexcept -> RevertError { return m_error; }
+
+ private:
+  RevertError m_error;
+};
+
+struct OpcodeInfo {
+  std::size_t advance_by{0};
+  std::size_t gas_consumed{0};
+  // stack items the opcode needs on entry and leaves behind (DUPn: n in, n + 1 out)
+  std::size_t stack_inputs{0};
+  std::size_t stack_outputs{0};
+  // reads call data or state, or appends logs, which compiled blocks have no access to
+  bool interpreted_only{false};
+};
+
+// TODO: MLOAD/MSTORE memory expansion cost
+// TODO: BALANCE/EXTCODESIZE/SLOAD/SSTORE warm and cold access (EIP-2929) and SSTORE refunds, every access is charged
+// as cold
+inline std::unordered_map<opcode_t, OpcodeInfo> const kOpcodeInfo{{kMLoad, {.gas_consumed = 3, .stack_inputs = 1, .stack_outputs = 1}},
+                                                           {kJump, {.gas_consumed = 8, .stack_inputs = 1}},
+                                                           {kDup3, {.gas_consumed = 3, .stack_inputs = 3, .stack_outputs = 4}},
+                                                           {kPush2, {.advance_by = 2, .gas_consumed = 3, .stack_outputs = 1}},
+                                                           {kPush0, {.gas_consumed = 2, .stack_outputs = 1}},
+                                                           {kPush12, {.advance_by = 12, .gas_consumed = 3, .stack_outputs = 1}},
+                                                           {kPush1, {.advance_by = 1, .gas_consumed = 3, .stack_outputs = 1}},
+                                                           {kPush32, {.advance_by = 32, .gas_consumed = 3, .stack_outputs = 1}},
+                                                           {kMStore, {.gas_consumed = 3, .stack_inputs = 2}},
+                                                           {kSwap1, {.gas_consumed = 3, .stack_inputs = 2, .stack_outputs = 2}},
+                                                           {kDup2, {.gas_consumed = 3, .stack_inputs = 2, .stack_outputs = 3}},
+                                                           {kShl, {.gas_consumed = 3, .stack_inputs = 2, .stack_outputs = 1}},
+                                                           {kStop, {}},
+                                                           {kAdd, {.gas_consumed = 3, .stack_inputs = 2, .stack_outputs = 1}},
+                                                           {kMul, {.gas_consumed = 5, .stack_inputs = 2, .stack_outputs = 1}},
+                                                           {kSub, {.gas_consumed = 3, .stack_inputs = 2, .stack_outputs = 1}},
+                                                           {kLt, {.gas_consumed = 3, .stack_inputs = 2, .stack_outputs = 1}},
+                                                           {kGt, {.gas_consumed = 3, .stack_inputs = 2, .stack_outputs = 1}},
+                                                           {kEq, {.gas_consumed = 3, .stack_inputs = 2, .stack_outputs = 1}},
+                                                           {kIsZero, {.gas_consumed = 3, .stack_inputs = 1, .stack_outputs = 1}},
+                                                           {kAnd, {.gas_consumed = 3, .stack_inputs = 2, .stack_outputs = 1}},
+                                                           {kOr, {.gas_consumed = 3, .stack_inputs = 2, .stack_outputs = 1}},
+                                                           {kXor, {.gas_consumed = 3, .stack_inputs = 2, .stack_outputs = 1}},
+                                                           {kNot, {.gas_consumed = 3, .stack_inputs = 1, .stack_outputs = 1}},
+                                                           {kShr, {.gas_consumed = 3, .stack_inputs = 2, .stack_outputs = 1}},
+                                                           {kPop, {.gas_consumed = 2, .stack_inputs = 1}},
+                                                           {kJumpI, {.gas_consumed = 10, .stack_inputs = 2}},
+                                                           {kJumpDest, {.gas_consumed = kJumpDestGas}},
+                                                           {kDup1, {.gas_consumed = 3, .stack_inputs = 1, .stack_outputs = 2}},
+                                                           {kBalance, {.gas_consumed = 2600, .stack_inputs = 1, .stack_outputs = 1, .interpreted_only = true}},
+                                                           {kCallDataLoad, {.gas_consumed = 3, .stack_inputs = 1, .stack_outputs = 1, .interpreted_only = true}},
+                                                           {kCallDataSize, {.gas_consumed = 2, .stack_outputs = 1, .interpreted_only = true}},
+                                                           {kExtCodeSize, {.gas_consumed = 2600, .stack_inputs = 1, .stack_outputs = 1, .interpreted_only = true}},
+                                                           {kSLoad, {.gas_consumed = 2100, .stack_inputs = 1, .stack_outputs = 1, .interpreted_only = true}},
+                                                           {kSStore, {.gas_consumed = 20000, .stack_inputs = 2, .interpreted_only = true}},
+                                                           {kLog0, {.gas_consumed = kLogGas, .stack_inputs = 2, .interpreted_only = true}},
+                                                           {kLog1, {.gas_consumed = kLogGas + kLogTopicGas, .stack_inputs = 3, .interpreted_only = true}},
+                                                           {kLog2, {.gas_consumed = kLogGas + 2 * kLogTopicGas, .stack_inputs = 4, .interpreted_only = true}},
+                                                           {kLog3, {.gas_consumed = kLogGas + 3 * kLogTopicGas, .stack_inputs = 5, .interpreted_only = true}},
+                                                           {kLog4, {.gas_consumed = kLogGas + 4 * kLogTopicGas, .stack_inputs = 6, .interpreted_only = true}}};
+
+// Dense copy of the gas costs in kOpcodeInfo for the switch-dispatched loop.
+inline std::array<std::size_t, 256> const kGasCost{[] {
+  std::array<std::size_t, 256> gas_cost{};
+  for (auto const& [opcode, info] : kOpcodeInfo) {
+    gas_cost[static_cast<std::size_t>(opcode)] = info.gas_consumed;
+  }
+  return gas_cost;
+}()};
+
+// PUSH1..PUSH32 carry their immediate operand inline; every other opcode is a single byte.
+constexpr auto ImmediateSize(opcode_t opcode) -> std::size_t {
+  if (opcode < kPush1 or opcode > kPush32) {
+    return 0;
+  }
+  return static_cast<std::size_t>(opcode) - static_cast<std::size_t>(kPush0);
+}
+
+// Name of the opcodes the interpreter knows, empty for any other byte.
+constexpr auto Mnemonic(opcode_t opcode) -> std::string_view {
+  switch (opcode) {
+    case kStop:
+      return "STOP";
+    case kAdd:
+      return "ADD";
+    case kMul:
+      return "MUL";
+    case kSub:
+      return "SUB";
+    case kLt:
+      return "LT";
+    case kGt:
+      return "GT";
+    case kEq:
+      return "EQ";
+    case kIsZero:
+      return "ISZERO";
+    case kAnd:
+      return "AND";
+    case kOr:
+      return "OR";
+    case kXor:
+      return "XOR";
+    case kNot:
+      return "NOT";
+    case kShl:
+      return "SHL";
+    case kShr:
+      return "SHR";
+    case kBalance:
+      return "BALANCE";
+    case kCallDataLoad:
+      return "CALLDATALOAD";
+    case kCallDataSize:
+      return "CALLDATASIZE";
+    case kExtCodeSize:
+      return "EXTCODESIZE";
+    case kPop:
+      return "POP";
+    case kMLoad:
+      return "MLOAD";
+    case kMStore:
+      return "MSTORE";
+    case kSLoad:
+      return "SLOAD";
+    case kSStore:
+      return "SSTORE";
+    case kJump:
+      return "JUMP";
+    case kJumpI:
+      return "JUMPI";
+    case kJumpDest:
+      return "JUMPDEST";
+    case kPush0:
+      return "PUSH0";
+    case kPush1:
+      return "PUSH1";
+    case kPush2:
+      return "PUSH2";
+    case kPush12:
+      return "PUSH12";
+    case kPush32:
+      return "PUSH32";
+    case kDup1:
+      return "DUP1";
+    case kDup2:
+      return "DUP2";
+    case kDup3:
+      return "DUP3";
+    case kSwap1:
+      return "SWAP1";
+    case kLog0:
+      return "LOG0";
+    case kLog1:
+      return "LOG1";
+    case kLog2:
+      return "LOG2";
+    case kLog3:
+      return "LOG3";
+    case kLog4:
+      return "LOG4";
+    default:
+      return {};
+  }
+}
+
+// LIFO of words with the std::stack interface (push, pop, top, empty, size) on top of storage that is
+// allocated once, so any slot can be peeked and slot addresses stay stable (jitted code addresses
+// them directly).
+class WordStack {
+ public:
+  // one spare slot: overflow is detected right after the offending push
+  WordStack() : m_words(kMaxStackSize + 1) {}
+
+  auto push(word_t const& word) -> void { m_words[m_size++] = word; }
+  auto pop() -> void { m_size--; }
+  auto top() -> word_t& { return m_words[m_size - 1]; }
+  auto top() const -> word_t const& { return m_words[m_size - 1]; }
+  auto empty() const -> bool { return m_size == 0; }
+  auto size() const -> std::size_t { return m_size; }
+
+  // 0 is the topmost item
+  auto peek(std::size_t depth) const -> word_t const& { return m_words[m_size - 1 - depth]; }
+  auto clear() -> void { m_size = 0; }
+  auto data() -> word_t* { return m_words.data(); }
+  auto resize(std::size_t size) -> void { m_size = size; }
+
+  auto operator==(WordStack const& other) const -> bool { return std::ranges::equal(std::span{m_words}.first(m_size), std::span{other.m_words}.first(other.m_size)); }
+
+ private:
+  std::vector<word_t> m_words;
+  std::size_t m_size{0};
+};
+
+struct BasicBlock {
+  std::size_t begin{0};  // pc of the first instruction
+  std::size_t end{0};    // pc one past the last instruction
+  std::size_t gas_consumed{0};
+  std::size_t stack_required{0};  // stack items needed on entry
+  std::size_t stack_growth{0};    // largest stack growth reached inside the block
+};
+
+struct CodeAnalysis {
+  std::vector<BasicBlock> basic_blocks{};
+  // 1 at every JUMPDEST that is an instruction (not PUSH data)
+  std::vector<std::uint8_t> jump_destinations{};
+};
+
+// 1 at every JUMPDEST that is an instruction (not PUSH data), refilling `jump_destinations` in place.
+inline auto MarkJumpDestinations(std::span<std::byte const> bytecode, std::vector<std::uint8_t>& jump_destinations) -> void {
+  jump_destinations.assign(bytecode.size(), 0);
+  for (std::size_t pc{0}; pc < bytecode.size(); pc += 1 + ImmediateSize(bytecode[pc])) {
+    if (bytecode[pc] == kJumpDest) {
+      jump_destinations[pc] = 1;
+    }
+  }
+}
+
+// Splits bytecode into straight-line blocks of known opcodes. A block ends after JUMP, JUMPI, STOP and
+// JUMPDEST (jumps resume right after their JUMPDEST, charging its gas), and before any opcode missing
+// from kOpcodeInfo, interpreted-only opcodes and a PUSH whose data runs past the end of the code; those
+// are left to the interpreter.
+inline auto AnalyzeCode(std::span<std::byte const> bytecode) -> CodeAnalysis {
+  CodeAnalysis analysis{};
+  MarkJumpDestinations(bytecode, analysis.jump_destinations);
+
+  std::optional<BasicBlock> block{};
+  std::ptrdiff_t stack_height{0};
+  auto const close_block{[&analysis, &block](std::size_t end) {
+    if (block and block->begin != end) {
+      block->end = end;
+      analysis.basic_blocks.push_back(*block);
+    }
+    block.reset();
+  }};
+
+  for (std::size_t pc{0}; pc < bytecode.size(); pc += 1 + ImmediateSize(bytecode[pc])) {
+    auto const opcode{bytecode[pc]};
+    auto const opcode_info{kOpcodeInfo.find(opcode)};
+
+    if (opcode_info == std::end(kOpcodeInfo) or opcode_info->second.interpreted_only or pc + ImmediateSize(opcode) >= bytecode.size()) {
+      close_block(pc);
+      continue;
+    }
+
+    if (not block) {
+      block = BasicBlock{.begin = pc};
+      stack_height = 0;
+    }
+
+    auto const& [advance_by, gas_consumed, stack_inputs, stack_outputs, interpreted_only]{opcode_info->second};
+    block->gas_consumed += gas_consumed;
+    block->stack_required = std::max(block->stack_required, static_cast<std::size_t>(std::max<std::ptrdiff_t>(0, static_cast<std::ptrdiff_t>(stack_inputs) - stack_height)));
+    stack_height += static_cast<std::ptrdiff_t>(stack_outputs) - static_cast<std::ptrdiff_t>(stack_inputs);
+    block->stack_growth = std::max(block->stack_growth, static_cast<std::size_t>(std::max<std::ptrdiff_t>(0, stack_height)));
+
+    if (opcode == kJump or opcode == kJumpI or opcode == kStop or opcode == kJumpDest) {
+      close_block(pc + 1);
+    }
+  }
+  close_block(bytecode.size());
+
+  return analysis;
+}
+
+// Like std::vector::at(), throws std::out_of_range past the end of the code.
+inline auto OpcodeAt(std::span<std::byte const> bytecode, std::size_t program_counter) -> opcode_t {
+  if (program_counter >= bytecode.size()) {
+    throw std::out_of_range{std::format("Program counter {} is past the end of the code.", program_counter)};
+  }
+  return bytecode[program_counter];
+}
+
+struct WordHash {
+  auto operator()(word_t const& word) const noexcept -> std::size_t {
+    std::size_t hash{0};
+    for (std::size_t limb{0}; limb < 4; ++limb) {
+      hash ^= std::hash<std::uint64_t>{}(word[limb]) + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2);
+    }
+    return hash;
+  }
+};
+
+// storage slots of the executing contract
+using Storage = std::unordered_map<word_t, word_t, WordHash>;
+
+inline auto to_uint256(std::span<std::uint8_t const> byte_array) -> intx::uint256 {
+  if (byte_array.size() > kWordSize) {
+    throw std::invalid_argument{"Passed in byte array can not fit in uint256 object."};
+  }
+
+  intx::uint256 word{};
+  for (auto const byte : byte_array) {
+    word = (word << kByteSize) | byte;
+  }
+  return word;
+}
+
+// Memory does not expand yet, so a word access has to fit inside the fixed-size memory.
+inline auto MemoryOffset(word_t const& offset, std::string_view mnemonic) -> std::size_t {
+  if (offset > kMemorySize - kWordSize) {
+    throw Revert{mnemonic, RevertError::kMemoryOutOfBounds};
+  }
+  return static_cast<std::size_t>(offset);
+}
+
+// The same for a range of `size` bytes, as LOGn reads; an empty range needs no memory, wherever it starts.
+inline auto MemoryRangeOffset(word_t const& offset, word_t const& size, std::string_view mnemonic) -> std::size_t {
+  if (size == 0) {
+    return 0;
+  }
+  if (size > kMemorySize or offset > kMemorySize - size) {
+    throw Revert{mnemonic, RevertError::kMemoryOutOfBounds};
+  }
+  return static_cast<std::size_t>(offset);
+}
+
+// Memory holds words big-endian. Loaded as four byte-swapped limbs (the host is little-endian) rather than a byte at a
+// time, as decoders load every integer and address through here.
+inline auto LoadWord(std::uint8_t const* source) -> word_t {
+  std::array<std::uint64_t, 4> limbs{};
+  std::memcpy(limbs.data(), source, kWordSize);
+  return word_t{std::byteswap(limbs[3]), std::byteswap(limbs[2]), std::byteswap(limbs[1]), std::byteswap(limbs[0])};
+}
+
+inline auto StoreWord(std::uint8_t* destination, word_t const& value) -> void {
+  std::span<std::uint8_t const> value_bytes_span{intx::as_bytes(value), kWordSize};
+  std::ranges::copy(value_bytes_span | std::views::reverse, destination);
+}
+
+// Calls body(std::integral_constant<std::size_t, index>) for index 0 .. kCount - 1, unrolled, so every index in the
+// body is a constant and short fixed-size loops (Keccak lanes, field limbs) keep their state in registers.
+template <std::size_t kCount>
+constexpr auto Unrolled(auto&& body) -> void {
+  [&body]<std::size_t... kIndex>(std::index_sequence<kIndex...>) { (body(std::integral_constant<std::size_t, kIndex>{}), ...); }(std::make_index_sequence<kCount>{});
+}
+
+// Reads a hex-encoded bytecode file as produced by solc --bin.
+inline auto ReadBytecodeFile(std::string_view bc_filepath) -> std::vector<std::byte> {
+  std::ifstream bc_ifs{bc_filepath};
+  if (not bc_ifs.is_open()) {
+    throw std::runtime_error(std::format("Could not find '{}' file.", bc_filepath).c_str());
+  }
+
+  auto bc_str{std::views::istream<char>(bc_ifs) | std::ranges::to<std::string>()};
+  return bc_str | ranges::views::chunk(2) | ranges::views::transform([](auto const& chunk) {
+           std::string byte_str{std::begin(chunk), std::end(chunk)};
+           return static_cast<std::byte>(std::stoi(byte_str, nullptr, kHexBase));
+         }) |
+         ranges::to<std::vector>;
+}
+
+// Compiled code (jitted or translated ahead of time) runs one basic block per call on a BlockFrame.
+// The block charges its gas up front and either runs to its end or takes a side exit, leaving the
+// frame as it was before the instruction at program_counter for the interpreter to execute.
+struct BlockFrame {
+  word_t* stack_base{nullptr};
+  std::size_t stack_size{0};
+  std::size_t gas_left{0};
+  std::uint8_t* memory{nullptr};
+  std::size_t program_counter{0};
+  std::uint8_t const* jump_destinations{nullptr};
+  std::size_t code_size{0};
+  // bytes up to the end of the highest word stored to memory, grown by every MSTORE
+  std::size_t memory_size{0};
+};
+static_assert(std::is_standard_layout_v<BlockFrame>);
+
+enum class BlockExit : std::uint32_t { kContinue, kSideExit, kStop };
+
+using BlockFunction = BlockExit (*)(BlockFrame*);
+
+}  // namespace evmint
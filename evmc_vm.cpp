@@ -0,0 +1,204 @@
+// SPDX-License-Identifier: MIT
+
+// EVMC front end: exposes evmint as an evmc_vm (libevmint.so, created by evmc_create_evmint()) so clients that load
+// VMs through the EVMC ABI can run it in place of another VM. Code and call data are handed to the interpreter as
+// spans over the caller's buffers, and every thread keeps one Interpreter across execute calls. State reads go to
+// the host; storage writes and logs of a successful execution are passed to the host's set_storage and emit_log once it
+// has finished.
+//
+// The interpreter has no CALL* or CREATE* opcodes yet, so the host's call entry is never used.
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include <evmc/evmc.h>
+#include <evmc/utils.h>
+
+#include "evm.hpp"
+#include "interpreter.hpp"
+#include "kzg.hpp"
+#include "state.hpp"
+
+using namespace evmint;
+
+namespace {
+
+auto ToWord(evmc_bytes32 const& bytes) -> word_t { return LoadWord(bytes.bytes); }
+auto ToWord(evmc_address const& address) -> word_t { return to_uint256(address.bytes); }
+
+auto ToBytes32(word_t const& word) -> evmc_bytes32 {
+  evmc_bytes32 bytes{};
+  StoreWord(bytes.bytes, word);
+  return bytes;
+}
+
+auto ToEvmcAddress(word_t const& word) -> evmc_address {
+  auto const bytes{ToBytes32(word)};
+  evmc_address address{};
+  std::ranges::copy(std::span{bytes.bytes}.last<kAddressSize>(), address.bytes);
+  return address;
+}
+
+// The host's state as a StateView. Code is only copied out of the host when an opcode needs more than its size.
+class HostState final : public StateView {
+ public:
+  HostState(evmc_host_interface const& host, evmc_host_context* context) : m_host{host}, m_context{context} {}
+
+  auto StorageAt(word_t const& address, word_t const& slot) const -> word_t override {
+    auto const account{ToEvmcAddress(address)};
+    auto const key{ToBytes32(slot)};
+    return ToWord(m_host.get_storage(m_context, &account, &key));
+  }
+
+  auto BalanceOf(word_t const& address) const -> word_t override {
+    auto const account{ToEvmcAddress(address)};
+    return ToWord(m_host.get_balance(m_context, &account));
+  }
+
+  auto CodeAt(word_t const& address) const -> std::span<std::byte const> override {
+    auto const account{ToEvmcAddress(address)};
+    m_code.resize(m_host.get_code_size(m_context, &account));
+    m_code.resize(m_host.copy_code(m_context, &account, 0, reinterpret_cast<std::uint8_t*>(m_code.data()), m_code.size()));
+    return m_code;
+  }
+
+  auto CodeSizeAt(word_t const& address) const -> std::size_t override {
+    auto const account{ToEvmcAddress(address)};
+    return m_host.get_code_size(m_context, &account);
+  }
+
+  auto SetStorage(word_t const& address, word_t const& slot, word_t const& value) const -> void {
+    auto const account{ToEvmcAddress(address)};
+    auto const key{ToBytes32(slot)};
+    auto const stored{ToBytes32(value)};
+    m_host.set_storage(m_context, &account, &key, &stored);
+  }
+
+ private:
+  evmc_host_interface const& m_host;
+  evmc_host_context* m_context;
+  // backs the span CodeAt() returns, valid until its next call
+  mutable std::vector<std::byte> m_code{};
+};
+
+auto ToStatusCode(ExecutionStatus status) -> evmc_status_code {
+  switch (status) {
+    case ExecutionStatus::kSuccess:
+      return EVMC_SUCCESS;
+    case ExecutionStatus::kStackOverflow:
+      return EVMC_STACK_OVERFLOW;
+    case ExecutionStatus::kGasExceeded:
+      return EVMC_OUT_OF_GAS;
+    case ExecutionStatus::kStackUnderflow:
+      return EVMC_STACK_UNDERFLOW;
+    case ExecutionStatus::kMemoryUnalignedAccess:
+    case ExecutionStatus::kMemoryOutOfBounds:
+      return EVMC_INVALID_MEMORY_ACCESS;
+    case ExecutionStatus::kInvalidJump:
+      return EVMC_BAD_JUMP_DESTINATION;
+    case ExecutionStatus::kUnrecognizedOpcode:
+      return EVMC_UNDEFINED_INSTRUCTION;
+    case ExecutionStatus::kPrecompileFailure:
+      return EVMC_PRECOMPILE_FAILURE;
+    case ExecutionStatus::kInternalError:
+    case ExecutionStatus::kStateMissing:
+      break;
+  }
+  return EVMC_INTERNAL_ERROR;
+}
+
+// EVMC wants gas_left only from successful (or reverted) executions; everything else consumed all of it.
+auto MakeResult(evmc_status_code status_code, std::int64_t gas_left) -> evmc_result {
+  evmc_result result{};
+  result.status_code = status_code;
+  result.gas_left = status_code == EVMC_SUCCESS ? gas_left : 0;
+  return result;
+}
+
+class EvmintVm final : public evmc_vm {
+ public:
+  EvmintVm() : evmc_vm{EVMC_ABI_VERSION, "evmint", "0.1.0", Destroy, Execute, GetCapabilities, SetOption} {}
+
+ private:
+  DispatchMode m_dispatch_mode{DispatchMode::kTiered};
+
+  static auto Destroy(evmc_vm* vm) -> void { delete static_cast<EvmintVm*>(vm); }
+
+  static auto GetCapabilities(evmc_vm* /*vm*/) -> evmc_capabilities_flagset { return EVMC_CAPABILITY_EVM1; }
+
+  // "dispatch": "table", "tos" or "tiered" (the default)
+  // "trusted-setup": the path of the KZG trusted setup (trusted_setup.txt) the point evaluation precompile verifies
+  // against, for the whole process; until one is set, the precompile fails every call
+  static auto SetOption(evmc_vm* vm, char const* name, char const* value) -> evmc_set_option_result {
+    auto& self{*static_cast<EvmintVm*>(vm)};
+    if (std::string_view{name} == "trusted-setup") {
+      try {
+        kzg::LoadTrustedSetup(value);
+        return EVMC_SET_OPTION_SUCCESS;
+      } catch (...) {
+        // no exception may cross the C ABI
+        return EVMC_SET_OPTION_INVALID_VALUE;
+      }
+    }
+    if (std::string_view{name} != "dispatch") {
+      return EVMC_SET_OPTION_INVALID_NAME;
+    }
+    auto const dispatch_mode{ParseDispatchMode(value)};
+    if (not dispatch_mode) {
+      return EVMC_SET_OPTION_INVALID_VALUE;
+    }
+    self.m_dispatch_mode = *dispatch_mode;
+    return EVMC_SET_OPTION_SUCCESS;
+  }
+
+  static auto Execute(evmc_vm* vm, evmc_host_interface const* host, evmc_host_context* context, evmc_revision /*revision*/, evmc_message const* message,
+                      std::uint8_t const* code, std::size_t code_size) -> evmc_result {
+    // reused across calls on this thread, so tiering state and buffers survive from one execution to the next
+    thread_local Interpreter interpreter{};
+
+    // no exception may cross the C ABI
+    try {
+      HostState const state{*host, context};
+      auto const gas_limit{static_cast<std::size_t>(std::max<std::int64_t>(message->gas, 0))};
+      auto const address{ToWord(message->recipient)};
+      auto const result{interpreter.Execute({.code = std::as_bytes(std::span{code, code_size}),
+                                             .calldata = std::as_bytes(std::span{message->input_data, message->input_size}),
+                                             .state = &state,
+                                             .address = address,
+                                             .gas_limit = gas_limit,
+                                             .dispatch_mode = static_cast<EvmintVm*>(vm)->m_dispatch_mode})};
+      if (result.status != ExecutionStatus::kSuccess) {
+        return MakeResult(ToStatusCode(result.status), 0);
+      }
+      auto const& logs{interpreter.Logs()};
+      if ((message->flags & EVMC_STATIC) != 0 and (not result.storage_writes.empty() or not logs.empty())) {
+        return MakeResult(EVMC_STATIC_MODE_VIOLATION, 0);
+      }
+
+      for (auto const& [slot, value] : result.storage_writes) {
+        state.SetStorage(address, slot, value);
+      }
+      for (std::size_t index{0}; index < logs.size(); ++index) {
+        auto const log{logs[index]};
+        std::array<evmc_bytes32, kMaxTopicCount> topics{};
+        std::ranges::transform(log.topics, std::begin(topics), [](word_t const& topic) { return ToBytes32(topic); });
+        host->emit_log(context, &message->recipient, reinterpret_cast<std::uint8_t const*>(log.data.data()), log.data.size(), topics.data(), log.topics.size());
+      }
+      return MakeResult(EVMC_SUCCESS, static_cast<std::int64_t>(gas_limit - result.gas_used));
+    } catch (std::bad_alloc const&) {
+      return MakeResult(EVMC_OUT_OF_MEMORY, 0);
+    } catch (...) {
+      return MakeResult(EVMC_INTERNAL_ERROR, 0);
+    }
+  }
+};
+
+}  // namespace
+
+extern "C" EVMC_EXPORT auto evmc_create_evmint() noexcept -> evmc_vm* { return new EvmintVm{}; }
@@ -0,0 +1,424 @@
+// SPDX-License-Identifier: MIT
+
+// Arithmetic modulo a fixed prime, for the elliptic curves behind signatures and precompiles. Elements are kept in
+// Montgomery form (a * R mod p, R = 2^(64 * limbs)), so a multiplication reduces with multiplies and adds instead of a
+// division. Not constant time: everything evmint computes on is public (signatures, call data). On x86-64 hosts with
+// BMI2 and ADX, 4- and 6-limb primes with the top bit clear multiply with mulx and two interleaved carry chains
+// (adcx/adox), chosen once at startup.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
+#include "evm.hpp"
+
+namespace evmint::field {
+
+// little-endian: limb 0 is the least significant
+template <std::size_t kLimbCount>
+using Limbs = std::array<std::uint64_t, kLimbCount>;
+
+using uint128_t = unsigned __int128;
+
+namespace detail {
+
+template <std::size_t kLimbCount>
+constexpr auto Add(Limbs<kLimbCount>& result, Limbs<kLimbCount> const& lhs, Limbs<kLimbCount> const& rhs) -> std::uint64_t {
+  std::uint64_t carry{0};
+  Unrolled<kLimbCount>([&](auto limb) {
+    auto const sum{uint128_t{lhs[limb]} + rhs[limb] + carry};
+    result[limb] = static_cast<std::uint64_t>(sum);
+    carry = static_cast<std::uint64_t>(sum >> 64);
+  });
+  return carry;
+}
+
+template <std::size_t kLimbCount>
+constexpr auto Subtract(Limbs<kLimbCount>& result, Limbs<kLimbCount> const& lhs, Limbs<kLimbCount> const& rhs) -> std::uint64_t {
+  std::uint64_t borrow{0};
+  Unrolled<kLimbCount>([&](auto limb) {
+    auto const difference{uint128_t{lhs[limb]} - rhs[limb] - borrow};
+    result[limb] = static_cast<std::uint64_t>(difference);
+    borrow = static_cast<std::uint64_t>(difference >> 64) & 1;
+  });
+  return borrow;
+}
+
+template <std::size_t kLimbCount>
+constexpr auto Less(Limbs<kLimbCount> const& lhs, Limbs<kLimbCount> const& rhs) -> bool {
+  for (auto limb{kLimbCount}; limb-- != 0;) {
+    if (lhs[limb] != rhs[limb]) {
+      return lhs[limb] < rhs[limb];
+    }
+  }
+  return false;
+}
+
+// 2^bits mod modulus, by doubling
+template <std::size_t kLimbCount>
+constexpr auto PowerOfTwo(Limbs<kLimbCount> const& modulus, std::size_t bits) -> Limbs<kLimbCount> {
+  Limbs<kLimbCount> value{1};
+  for (std::size_t bit{0}; bit < bits; ++bit) {
+    auto const carry{Add(value, value, value)};
+    if (carry != 0 or not Less(value, modulus)) {
+      Subtract(value, value, modulus);
+    }
+  }
+  return value;
+}
+
+#if defined(__x86_64__)
+// mulx (BMI2) and adcx/adox (ADX): CPUID leaf 7, EBX bits 8 and 19
+inline bool const kHasMulxAdx{[] {
+  unsigned eax{0};
+  unsigned ebx{0};
+  unsigned ecx{0};
+  unsigned edx{0};
+  if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) == 0) {
+    return false;
+  }
+  return (ebx & (1U << 8)) != 0 and (ebx & (1U << 19)) != 0;
+}()};
+
+// One row of MultiplyMulxAdx(): t0..tN += lhs * rhs[row], then + factor * modulus, which clears t0; the limbs are then
+// shifted down by one. adcx carries the low halves of the products and adox the high ones, so the two chains run side
+// by side. A row starts with tN == 0 and leaves the sum below 2^(64 (N + 1)) (the modulus being below 2^(64 N - 1)), so
+// neither chain carries out of tN.
+#define EVMINT_MULX_ADX_PRODUCT(source, offset, low_limb, high_limb) \
+  "mulxq " #offset "(%[" #source "]), %[low], %[high]\n\t"           \
+  "adcxq %[low], %[" #low_limb "]\n\t"                               \
+  "adoxq %[high], %[" #high_limb "]\n\t"
+#define EVMINT_MULX_ADX_CARRY(limb) \
+  "movq $0, %[low]\n\t"             \
+  "adcxq %[low], %[" #limb "]\n\t"
+#define EVMINT_MULX_ADX_FACTOR  \
+  "movq %[t0], %%rdx\n\t"       \
+  "imulq %[inverse], %%rdx\n\t" \
+  "xorq %[low], %[low]\n\t"
+
+#define EVMINT_MULX_ADX_ROW4(offset)           \
+  "movq " #offset "(%[rhs]), %%rdx\n\t"        \
+  "xorq %[t4], %[t4]\n\t"                      \
+  EVMINT_MULX_ADX_PRODUCT(lhs, 0, t0, t1)      \
+  EVMINT_MULX_ADX_PRODUCT(lhs, 8, t1, t2)      \
+  EVMINT_MULX_ADX_PRODUCT(lhs, 16, t2, t3)     \
+  EVMINT_MULX_ADX_PRODUCT(lhs, 24, t3, t4)     \
+  EVMINT_MULX_ADX_CARRY(t4)                    \
+  EVMINT_MULX_ADX_FACTOR                       \
+  EVMINT_MULX_ADX_PRODUCT(modulus, 0, t0, t1)  \
+  EVMINT_MULX_ADX_PRODUCT(modulus, 8, t1, t2)  \
+  EVMINT_MULX_ADX_PRODUCT(modulus, 16, t2, t3) \
+  EVMINT_MULX_ADX_PRODUCT(modulus, 24, t3, t4) \
+  EVMINT_MULX_ADX_CARRY(t4)                    \
+  "movq %[t1], %[t0]\n\t"                      \
+  "movq %[t2], %[t1]\n\t"                      \
+  "movq %[t3], %[t2]\n\t"                      \
+  "movq %[t4], %[t3]\n\t"
+
+#define EVMINT_MULX_ADX_ROW6(offset)           \
+  "movq " #offset "(%[rhs]), %%rdx\n\t"        \
+  "xorq %[t6], %[t6]\n\t"                      \
+  EVMINT_MULX_ADX_PRODUCT(lhs, 0, t0, t1)      \
+  EVMINT_MULX_ADX_PRODUCT(lhs, 8, t1, t2)      \
+  EVMINT_MULX_ADX_PRODUCT(lhs, 16, t2, t3)     \
+  EVMINT_MULX_ADX_PRODUCT(lhs, 24, t3, t4)     \
+  EVMINT_MULX_ADX_PRODUCT(lhs, 32, t4, t5)     \
+  EVMINT_MULX_ADX_PRODUCT(lhs, 40, t5, t6)     \
+  EVMINT_MULX_ADX_CARRY(t6)                    \
+  EVMINT_MULX_ADX_FACTOR                       \
+  EVMINT_MULX_ADX_PRODUCT(modulus, 0, t0, t1)  \
+  EVMINT_MULX_ADX_PRODUCT(modulus, 8, t1, t2)  \
+  EVMINT_MULX_ADX_PRODUCT(modulus, 16, t2, t3) \
+  EVMINT_MULX_ADX_PRODUCT(modulus, 24, t3, t4) \
+  EVMINT_MULX_ADX_PRODUCT(modulus, 32, t4, t5) \
+  EVMINT_MULX_ADX_PRODUCT(modulus, 40, t5, t6) \
+  EVMINT_MULX_ADX_CARRY(t6)                    \
+  "movq %[t1], %[t0]\n\t"                      \
+  "movq %[t2], %[t1]\n\t"                      \
+  "movq %[t3], %[t2]\n\t"                      \
+  "movq %[t4], %[t3]\n\t"                      \
+  "movq %[t5], %[t4]\n\t"                      \
+  "movq %[t6], %[t5]\n\t"
+
+// lhs * rhs / R modulo a 4-limb modulus below 2^255, both operands below it; the result is below twice the modulus
+inline auto MultiplyMulxAdx(Limbs<4> const& lhs, Limbs<4> const& rhs, Limbs<4> const& modulus, std::uint64_t inverse) -> Limbs<4> {
+  std::uint64_t t0{0};
+  std::uint64_t t1{0};
+  std::uint64_t t2{0};
+  std::uint64_t t3{0};
+  std::uint64_t t4{0};
+  std::uint64_t low{0};
+  std::uint64_t high{0};
+  asm(EVMINT_MULX_ADX_ROW4(0) EVMINT_MULX_ADX_ROW4(8) EVMINT_MULX_ADX_ROW4(16) EVMINT_MULX_ADX_ROW4(24)
+      : [t0] "+&r"(t0), [t1] "+&r"(t1), [t2] "+&r"(t2), [t3] "+&r"(t3), [t4] "+&r"(t4), [low] "=&r"(low), [high] "=&r"(high)
+      : [lhs] "r"(lhs.data()), [rhs] "r"(rhs.data()), [modulus] "r"(modulus.data()), [inverse] "rm"(inverse), "m"(lhs), "m"(rhs), "m"(modulus)
+      : "rdx", "cc");
+  return {t0, t1, t2, t3};
+}
+
+// the same for a 6-limb modulus below 2^383 (BLS12-381's p); the inverse stays in memory, every register but rdx and
+// two others being taken
+inline auto MultiplyMulxAdx(Limbs<6> const& lhs, Limbs<6> const& rhs, Limbs<6> const& modulus, std::uint64_t inverse) -> Limbs<6> {
+  std::uint64_t t0{0};
+  std::uint64_t t1{0};
+  std::uint64_t t2{0};
+  std::uint64_t t3{0};
+  std::uint64_t t4{0};
+  std::uint64_t t5{0};
+  std::uint64_t t6{0};
+  std::uint64_t low{0};
+  std::uint64_t high{0};
+  asm(EVMINT_MULX_ADX_ROW6(0) EVMINT_MULX_ADX_ROW6(8) EVMINT_MULX_ADX_ROW6(16) EVMINT_MULX_ADX_ROW6(24) EVMINT_MULX_ADX_ROW6(32)
+          EVMINT_MULX_ADX_ROW6(40)
+      : [t0] "+&r"(t0), [t1] "+&r"(t1), [t2] "+&r"(t2), [t3] "+&r"(t3), [t4] "+&r"(t4), [t5] "+&r"(t5), [t6] "+&r"(t6), [low] "=&r"(low),
+        [high] "=&r"(high)
+      : [lhs] "r"(lhs.data()), [rhs] "r"(rhs.data()), [modulus] "r"(modulus.data()), [inverse] "m"(inverse), "m"(lhs), "m"(rhs), "m"(modulus)
+      : "rdx", "cc");
+  return {t0, t1, t2, t3, t4, t5};
+}
+
+#undef EVMINT_MULX_ADX_ROW6
+#undef EVMINT_MULX_ADX_ROW4
+#undef EVMINT_MULX_ADX_FACTOR
+#undef EVMINT_MULX_ADX_CARRY
+#undef EVMINT_MULX_ADX_PRODUCT
+#endif
+
+}  // namespace detail
+
+// `Modulus` names the prime: a type with `static constexpr Limbs<N> kModulus`, odd and below 2^(64 * N).
+template <typename Modulus>
+class PrimeField final {
+ public:
+  static constexpr auto kModulus{Modulus::kModulus};
+  static constexpr std::size_t kLimbCount{kModulus.size()};
+  using limbs_t = Limbs<kLimbCount>;
+
+  // zero
+  constexpr PrimeField() = default;
+
+  // nullopt if `value` is not below the modulus
+  static constexpr auto FromLimbs(limbs_t const& value) -> std::optional<PrimeField> {
+    if (not detail::Less(value, kModulus)) {
+      return std::nullopt;
+    }
+    return PrimeField{Multiply(value, kRSquared)};
+  }
+
+  // `value` modulo the modulus
+  static constexpr auto Reduce(limbs_t value) -> PrimeField {
+    while (not detail::Less(value, kModulus)) {
+      detail::Subtract(value, value, kModulus);
+    }
+    return PrimeField{Multiply(value, kRSquared)};
+  }
+
+  static constexpr auto One() -> PrimeField { return PrimeField{kR}; }
+
+  constexpr auto ToLimbs() const -> limbs_t { return Multiply(m_value, limbs_t{1}); }
+  constexpr auto IsZero() const -> bool { return m_value == limbs_t{}; }
+  constexpr auto operator==(PrimeField const&) const -> bool = default;
+
+  constexpr auto operator+(PrimeField const& rhs) const -> PrimeField {
+    PrimeField sum{};
+    auto const carry{detail::Add(sum.m_value, m_value, rhs.m_value)};
+    if (carry != 0 or not detail::Less(sum.m_value, kModulus)) {
+      detail::Subtract(sum.m_value, sum.m_value, kModulus);
+    }
+    return sum;
+  }
+
+  constexpr auto operator-(PrimeField const& rhs) const -> PrimeField {
+    PrimeField difference{};
+    if (detail::Subtract(difference.m_value, m_value, rhs.m_value) != 0) {
+      detail::Add(difference.m_value, difference.m_value, kModulus);
+    }
+    return difference;
+  }
+
+  constexpr auto operator-() const -> PrimeField { return PrimeField{} - *this; }
+  constexpr auto operator*(PrimeField const& rhs) const -> PrimeField { return PrimeField{Multiply(m_value, rhs.m_value)}; }
+  constexpr auto operator+=(PrimeField const& rhs) -> PrimeField& { return *this = *this + rhs; }
+  constexpr auto operator-=(PrimeField const& rhs) -> PrimeField& { return *this = *this - rhs; }
+  constexpr auto operator*=(PrimeField const& rhs) -> PrimeField& { return *this = *this * rhs; }
+
+  constexpr auto Square() const -> PrimeField { return *this * *this; }
+  constexpr auto Double() const -> PrimeField { return *this + *this; }
+
+  // this^exponent, a 4-bit window at a time
+  constexpr auto Pow(limbs_t const& exponent) const -> PrimeField {
+    std::array<PrimeField, 16> powers{One(), *this};
+    for (std::size_t power{2}; power < powers.size(); ++power) {
+      powers[power] = powers[power - 1] * *this;
+    }
+    auto result{One()};
+    for (auto limb{kLimbCount}; limb-- != 0;) {
+      for (auto shift{64}; shift != 0;) {
+        shift -= 4;
+        result = result.Square().Square().Square().Square();
+        if (auto const window{(exponent[limb] >> shift) & 0xf}; window != 0) {
+          result *= powers[window];
+        }
+      }
+    }
+    return result;
+  }
+
+  // 1/this by Fermat's little theorem; zero for zero
+  constexpr auto Inverse() const -> PrimeField { return Pow(kModulusMinusTwo); }
+
+  // A square root, nullopt if there is none. Only for primes that are 3 mod 4, where it is this^((p + 1) / 4).
+  constexpr auto Sqrt() const -> std::optional<PrimeField>
+    requires(kModulus[0] % 4 == 3)
+  {
+    auto const root{Pow(kSqrtExponent)};
+    if (root.Square() != *this) {
+      return std::nullopt;
+    }
+    return root;
+  }
+
+  constexpr auto IsOdd() const -> bool { return (ToLimbs()[0] & 1) != 0; }
+
+ private:
+  // the value times R, modulo the modulus
+  limbs_t m_value{};
+
+  constexpr explicit PrimeField(limbs_t const& montgomery_value) : m_value{montgomery_value} {}
+
+  // -modulus^-1 mod 2^64, by Newton's iteration (each round doubles the correct low bits)
+  static constexpr std::uint64_t kInverse{[] {
+    std::uint64_t inverse{1};
+    for (auto round{0}; round < 6; ++round) {
+      inverse *= 2 - kModulus[0] * inverse;
+    }
+    return ~inverse + 1;
+  }()};
+
+  static constexpr limbs_t kR{detail::PowerOfTwo(kModulus, 64 * kLimbCount)};
+  static constexpr limbs_t kRSquared{detail::PowerOfTwo(kModulus, 2 * 64 * kLimbCount)};
+
+  static constexpr limbs_t kModulusMinusTwo{[] {
+    limbs_t exponent{};
+    detail::Subtract(exponent, kModulus, limbs_t{2});
+    return exponent;
+  }()};
+
+  static constexpr limbs_t kSqrtExponent{[] {
+    limbs_t exponent{};
+    auto const carry{detail::Add(exponent, kModulus, limbs_t{1})};
+    for (std::size_t limb{0}; limb < kLimbCount; ++limb) {
+      auto const next{limb + 1 < kLimbCount ? exponent[limb + 1] : carry};
+      exponent[limb] = exponent[limb] >> 2 | next << 62;
+    }
+    return exponent;
+  }()};
+
+  // lhs * rhs / R mod modulus (coarsely integrated operand scanning: reduce by one limb after multiplying by each).
+  // The loops are unrolled so the accumulator stays in registers.
+  static constexpr auto Multiply(limbs_t const& lhs, limbs_t const& rhs) -> limbs_t {
+#if defined(__x86_64__)
+    if constexpr ((kLimbCount == 4 or kLimbCount == 6) and kModulus.back() >> 63 == 0) {
+      if (not std::is_constant_evaluated() and detail::kHasMulxAdx) {
+        auto result{detail::MultiplyMulxAdx(lhs, rhs, kModulus, kInverse)};
+        if (not detail::Less(result, kModulus)) {
+          detail::Subtract(result, result, kModulus);
+        }
+        return result;
+      }
+    }
+#endif
+    std::array<std::uint64_t, kLimbCount + 2> accumulator{};
+#pragma GCC unroll 8
+    for (std::size_t limb{0}; limb < kLimbCount; ++limb) {
+      std::uint64_t carry{0};
+#pragma GCC unroll 8
+      for (std::size_t index{0}; index < kLimbCount; ++index) {
+        auto const product{uint128_t{lhs[index]} * rhs[limb] + accumulator[index] + carry};
+        accumulator[index] = static_cast<std::uint64_t>(product);
+        carry = static_cast<std::uint64_t>(product >> 64);
+      }
+      auto const top{uint128_t{accumulator[kLimbCount]} + carry};
+      accumulator[kLimbCount] = static_cast<std::uint64_t>(top);
+      accumulator[kLimbCount + 1] = static_cast<std::uint64_t>(top >> 64);
+
+      // adding factor * modulus clears the lowest limb, which is then shifted out
+      auto const factor{accumulator[0] * kInverse};
+      carry = static_cast<std::uint64_t>((uint128_t{factor} * kModulus[0] + accumulator[0]) >> 64);
+#pragma GCC unroll 8
+      for (std::size_t index{1}; index < kLimbCount; ++index) {
+        auto const product{uint128_t{factor} * kModulus[index] + accumulator[index] + carry};
+        accumulator[index - 1] = static_cast<std::uint64_t>(product);
+        carry = static_cast<std::uint64_t>(product >> 64);
+      }
+      auto const sum{uint128_t{accumulator[kLimbCount]} + carry};
+      accumulator[kLimbCount - 1] = static_cast<std::uint64_t>(sum);
+      accumulator[kLimbCount] = accumulator[kLimbCount + 1] + static_cast<std::uint64_t>(sum >> 64);
+    }
+
+    limbs_t result{};
+    std::copy_n(std::begin(accumulator), kLimbCount, std::begin(result));
+    if (accumulator[kLimbCount] != 0 or not detail::Less(result, kModulus)) {
+      detail::Subtract(result, result, kModulus);
+    }
+    return result;
+  }
+};
+
+// A big-endian number of 8 * kLimbCount bytes, as the precompiles encode field elements and scalars.
+template <std::size_t kLimbCount>
+auto LoadBigEndian(std::byte const* source) -> Limbs<kLimbCount> {
+  Limbs<kLimbCount> limbs{};
+  for (std::size_t limb{0}; limb < kLimbCount; ++limb) {
+    std::memcpy(&limbs[kLimbCount - 1 - limb], source + limb * sizeof(std::uint64_t), sizeof(std::uint64_t));
+    limbs[kLimbCount - 1 - limb] = std::byteswap(limbs[kLimbCount - 1 - limb]);
+  }
+  return limbs;
+}
+
+template <std::size_t kLimbCount>
+auto StoreBigEndian(Limbs<kLimbCount> const& limbs, std::byte* destination) -> void {
+  for (std::size_t limb{0}; limb < kLimbCount; ++limb) {
+    auto const big_endian_limb{std::byteswap(limbs[kLimbCount - 1 - limb])};
+    std::memcpy(destination + limb * sizeof(std::uint64_t), &big_endian_limb, sizeof(std::uint64_t));
+  }
+}
+
+// Replaces every nonzero value by its inverse with a single field inversion (Montgomery's trick): three
+// multiplications per value instead of an inversion each. Zeros stay zero.
+template <typename Field>
+auto InvertAll(std::span<Field> values) -> void {
+  thread_local std::vector<Field> prefix_products{};
+  prefix_products.resize(values.size());
+  auto product{Field::One()};
+  for (std::size_t index{0}; index < values.size(); ++index) {
+    prefix_products[index] = product;
+    if (not values[index].IsZero()) {
+      product *= values[index];
+    }
+  }
+  auto inverse{product.Inverse()};
+  for (auto index{values.size()}; index-- != 0;) {
+    if (values[index].IsZero()) {
+      continue;
+    }
+    auto const value{values[index]};
+    values[index] = inverse * prefix_products[index];
+    inverse *= value;
+  }
+}
+
+}  // namespace evmint::field
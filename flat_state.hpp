@@ -0,0 +1,334 @@
+// SPDX-License-Identifier: MIT
+
+// Flat state snapshots: the whole state in one sorted binary file that is memory-mapped and read in place, so opening
+// a snapshot costs a page table instead of building heap maps. POSIX only (mmap).
+//
+// File layout, all integers in host byte order (the header's magic tells a foreign byte order apart), every section
+// starting on a kSectionAlignment boundary:
+//   header    magic, version, counts and section offsets
+//   accounts  AccountRecord per account, sorted by address
+//   storage   StorageRecord per non-zero slot, sorted by (address, slot): each account's slots are contiguous, at the
+//             range its AccountRecord gives, so the address is not repeated per slot
+//   codes     CodeRecord per distinct code, sorted by content hash
+//   code      the code bytes, each distinct code once
+// Lookups search the sorted sections directly (interpolation search while the range is large, binary search for the
+// rest), and CodeAt() returns a span into the mapping.
+
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <intx/intx.hpp>
+
+#include "evm.hpp"
+#include "state.hpp"
+
+namespace evmint::flat {
+
+constexpr std::uint64_t kSnapshotMagic{0x5441'4c46'544e'4d45};  // "EMNTFLAT"
+constexpr std::uint32_t kSnapshotVersion{1};
+constexpr std::size_t kSectionAlignment{64};
+
+struct Header {
+  std::uint64_t magic{kSnapshotMagic};
+  std::uint32_t version{kSnapshotVersion};
+  std::uint32_t reserved{0};
+  std::uint64_t account_count{0};
+  std::uint64_t storage_count{0};
+  std::uint64_t code_count{0};
+  std::uint64_t accounts_offset{0};
+  std::uint64_t storage_offset{0};
+  std::uint64_t codes_offset{0};
+  std::uint64_t code_bytes_offset{0};
+  std::uint64_t file_size{0};
+};
+
+struct AccountRecord {
+  word_t address{};
+  word_t balance{};
+  // CodeRecord::hash, 0 for an account without code
+  std::uint64_t code_hash{0};
+  // [storage_begin, storage_end) in the storage section
+  std::uint64_t storage_begin{0};
+  std::uint64_t storage_end{0};
+  std::uint64_t reserved{0};
+};
+
+struct StorageRecord {
+  word_t slot{};
+  word_t value{};
+};
+
+struct CodeRecord {
+  std::uint64_t hash{0};
+  // from the start of the code section
+  std::uint64_t offset{0};
+  std::uint64_t size{0};
+  std::uint64_t reserved{0};
+};
+
+static_assert(std::is_trivially_copyable_v<AccountRecord> and std::is_trivially_copyable_v<StorageRecord> and std::is_trivially_copyable_v<CodeRecord>);
+static_assert(sizeof(AccountRecord) % 32 == 0 and sizeof(StorageRecord) % 32 == 0 and sizeof(CodeRecord) % 32 == 0);
+
+// Content hash that identifies code in a snapshot (64-bit FNV-1a; never 0, which stands for no code).
+inline auto CodeHash(std::span<std::byte const> code) -> std::uint64_t {
+  std::uint64_t hash{0xcbf2'9ce4'8422'2325};
+  for (auto const byte : code) {
+    hash = (hash ^ static_cast<std::uint64_t>(byte)) * 0x0000'0100'0000'01b3;
+  }
+  return hash == 0 ? 1 : hash;
+}
+
+// Writes `accounts` as a snapshot at `path`; zero storage values are left out as they read as zero anyway.
+inline auto WriteSnapshot(std::filesystem::path const& path, Accounts const& accounts) -> Header {
+  std::vector<std::pair<word_t, Account const*>> sorted_accounts{};
+  for (auto const& [address, account] : accounts) {
+    sorted_accounts.emplace_back(address, &account);
+  }
+  std::ranges::sort(sorted_accounts, {}, &std::pair<word_t, Account const*>::first);
+
+  std::vector<AccountRecord> account_records{};
+  std::vector<StorageRecord> storage_records{};
+  // hash -> code, each distinct code once
+  std::map<std::uint64_t, std::span<std::byte const>> codes{};
+  for (auto const& [address, account] : sorted_accounts) {
+    AccountRecord record{.address = address, .balance = account->balance, .storage_begin = storage_records.size()};
+    if (not account->code.empty()) {
+      record.code_hash = CodeHash(account->code);
+      auto const [code, inserted]{codes.try_emplace(record.code_hash, account->code)};
+      if (not inserted and not std::ranges::equal(code->second, account->code)) {
+        throw std::runtime_error{std::format("[SNAPSHOT]: Two different codes hash to {:#x}.", record.code_hash)};
+      }
+    }
+    auto const first_slot{storage_records.size()};
+    for (auto const& [slot, value] : account->storage) {
+      if (value != 0) {
+        storage_records.push_back({.slot = slot, .value = value});
+      }
+    }
+    std::ranges::sort(std::next(std::begin(storage_records), static_cast<std::ptrdiff_t>(first_slot)), std::end(storage_records), {}, &StorageRecord::slot);
+    record.storage_end = storage_records.size();
+    account_records.push_back(record);
+  }
+
+  std::vector<CodeRecord> code_records{};
+  std::vector<std::byte> code_bytes{};
+  for (auto const& [hash, code] : codes) {
+    code_records.push_back({.hash = hash, .offset = code_bytes.size(), .size = code.size()});
+    code_bytes.insert(std::end(code_bytes), std::begin(code), std::end(code));
+  }
+
+  auto const align{[](std::uint64_t offset) { return (offset + kSectionAlignment - 1) / kSectionAlignment * kSectionAlignment; }};
+  Header header{.account_count = account_records.size(), .storage_count = storage_records.size(), .code_count = code_records.size()};
+  header.accounts_offset = align(sizeof(Header));
+  header.storage_offset = align(header.accounts_offset + account_records.size() * sizeof(AccountRecord));
+  header.codes_offset = align(header.storage_offset + storage_records.size() * sizeof(StorageRecord));
+  header.code_bytes_offset = align(header.codes_offset + code_records.size() * sizeof(CodeRecord));
+  header.file_size = header.code_bytes_offset + code_bytes.size();
+
+  std::ofstream file{path, std::ios::binary | std::ios::trunc};
+  auto const write_at{[&file](std::uint64_t offset, void const* data, std::size_t size) {
+    file.seekp(static_cast<std::streamoff>(offset));
+    file.write(static_cast<char const*>(data), static_cast<std::streamsize>(size));
+  }};
+  write_at(0, &header, sizeof(header));
+  write_at(header.accounts_offset, account_records.data(), account_records.size() * sizeof(AccountRecord));
+  write_at(header.storage_offset, storage_records.data(), storage_records.size() * sizeof(StorageRecord));
+  write_at(header.codes_offset, code_records.data(), code_records.size() * sizeof(CodeRecord));
+  write_at(header.code_bytes_offset, code_bytes.data(), code_bytes.size());
+  if (not file) {
+    throw std::runtime_error{std::format("[SNAPSHOT]: Could not write the snapshot '{}'.", path.string())};
+  }
+  return header;
+}
+
+// Index of the first of `count` sorted records whose key (`key_at(index)`) is not less than `key`. Interpolating on the
+// leading 32 significant bits of the key range guesses the position, which for keys spread evenly (hashes) is off by
+// about the square root of the range; galloping from the guess brackets the answer, a second round narrows the
+// bracket the same way, and bisecting finds the answer in it. Skewed keys cost about twice a binary search.
+inline auto LowerBound(std::uint64_t count, word_t const& key, auto&& key_at) -> std::uint64_t {
+  constexpr std::uint64_t kBisectBelow{16};
+  constexpr std::size_t kMaxInterpolations{2};
+
+  std::uint64_t low{0};
+  std::uint64_t high{count};
+  for (std::size_t round{0}; round < kMaxInterpolations and high - low > kBisectBelow; ++round) {
+    auto const low_key{key_at(low)};
+    auto const high_key{key_at(high - 1)};
+    if (key <= low_key) {
+      return low;
+    }
+    if (key > high_key) {
+      return high;
+    }
+    auto const key_range{high_key - low_key};
+    auto const range_bits{static_cast<unsigned>(kWordSize * kByteSize) - intx::clz(key_range)};
+    auto const shift{std::max(range_bits, 32U) - 32};
+    auto const scaled_offset{static_cast<std::uint64_t>((key - low_key) >> shift)};
+    auto const scaled_range{static_cast<std::uint64_t>(key_range >> shift)};
+    auto const probe{low + std::clamp<std::uint64_t>(scaled_offset * (high - low - 1) / scaled_range, 1, high - low - 1)};
+
+    // the answer stays within [low, high], and the bracket doubles with every step away from the guess
+    if (key_at(probe) < key) {
+      low = probe + 1;
+      for (std::uint64_t step{1}; low < high; step *= 2) {
+        auto const index{std::min(low + step - 1, high - 1)};
+        if (key_at(index) >= key) {
+          high = index;
+          break;
+        }
+        low = index + 1;
+      }
+    } else {
+      high = probe;
+      for (std::uint64_t step{1}; low < high; step *= 2) {
+        auto const index{high - std::min(step, high - low)};
+        if (key_at(index) < key) {
+          low = index + 1;
+          break;
+        }
+        high = index;
+      }
+    }
+  }
+  while (low < high) {
+    auto const middle{low + (high - low) / 2};
+    if (key_at(middle) < key) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+// A snapshot file mapped read-only. It never changes, so any number of threads can read it; values are read straight
+// from the mapping and code is returned in place.
+class MappedState final : public StateView {
+ public:
+  explicit MappedState(std::filesystem::path const& path) {
+    auto const fd{open(path.c_str(), O_RDONLY)};
+    if (fd < 0) {
+      throw std::runtime_error{std::format("[SNAPSHOT]: Could not open '{}': {}.", path.string(), std::strerror(errno))};
+    }
+    struct stat file_status{};
+    if (fstat(fd, &file_status) != 0 or static_cast<std::size_t>(file_status.st_size) < sizeof(Header)) {
+      close(fd);
+      throw std::runtime_error{std::format("[SNAPSHOT]: '{}' is not a snapshot.", path.string())};
+    }
+    m_size = static_cast<std::size_t>(file_status.st_size);
+    m_mapping = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (m_mapping == MAP_FAILED) {
+      throw std::runtime_error{std::format("[SNAPSHOT]: Could not map '{}': {}.", path.string(), std::strerror(errno))};
+    }
+    // lookups jump around the file; reading ahead would only evict pages that are still needed
+    madvise(m_mapping, m_size, MADV_RANDOM);
+
+    std::memcpy(&m_header, m_mapping, sizeof(m_header));
+    auto const section_fits{[this](std::uint64_t offset, std::uint64_t count, std::size_t record_size) {
+      return offset % kSectionAlignment == 0 and offset <= m_size and count <= (m_size - offset) / record_size;
+    }};
+    if (m_header.magic != kSnapshotMagic or m_header.version != kSnapshotVersion or m_header.file_size != m_size or
+        not section_fits(m_header.accounts_offset, m_header.account_count, sizeof(AccountRecord)) or
+        not section_fits(m_header.storage_offset, m_header.storage_count, sizeof(StorageRecord)) or
+        not section_fits(m_header.codes_offset, m_header.code_count, sizeof(CodeRecord)) or m_header.code_bytes_offset > m_size) {
+      munmap(m_mapping, m_size);
+      throw std::runtime_error{std::format("[SNAPSHOT]: '{}' is not a snapshot of version {} or is truncated.", path.string(), kSnapshotVersion)};
+    }
+  }
+  MappedState(MappedState const&) = delete;
+  auto operator=(MappedState const&) -> MappedState& = delete;
+  ~MappedState() override { munmap(m_mapping, m_size); }
+
+  auto StorageAt(word_t const& address, word_t const& slot) const -> word_t override {
+    auto const account{FindAccount(address)};
+    if (not account) {
+      return 0;
+    }
+    auto const slot_count{account->storage_end - account->storage_begin};
+    auto const slot_at{[this, account](std::uint64_t index) { return Read<StorageRecord>(m_header.storage_offset, account->storage_begin + index).slot; }};
+    auto const index{LowerBound(slot_count, slot, slot_at)};
+    if (index == slot_count) {
+      return 0;
+    }
+    auto const record{Read<StorageRecord>(m_header.storage_offset, account->storage_begin + index)};
+    return record.slot == slot ? record.value : word_t{0};
+  }
+
+  auto BalanceOf(word_t const& address) const -> word_t override {
+    auto const account{FindAccount(address)};
+    return account ? account->balance : word_t{0};
+  }
+
+  auto CodeAt(word_t const& address) const -> std::span<std::byte const> override {
+    auto const account{FindAccount(address)};
+    if (not account or account->code_hash == 0) {
+      return {};
+    }
+    auto const hash_at{[this](std::uint64_t index) { return word_t{Read<CodeRecord>(m_header.codes_offset, index).hash}; }};
+    auto const index{LowerBound(m_header.code_count, account->code_hash, hash_at)};
+    if (index == m_header.code_count) {
+      return {};
+    }
+    auto const code{Read<CodeRecord>(m_header.codes_offset, index)};
+    if (code.hash != account->code_hash or code.offset > m_size - m_header.code_bytes_offset or code.size > m_size - m_header.code_bytes_offset - code.offset) {
+      return {};
+    }
+    return {static_cast<std::byte const*>(m_mapping) + m_header.code_bytes_offset + code.offset, code.size};
+  }
+
+  auto GetHeader() const -> Header const& { return m_header; }
+
+ private:
+  void* m_mapping{nullptr};
+  std::size_t m_size{0};
+  Header m_header{};
+
+  // copied out rather than cast in place, which the mapping's alignment and lifetime rules would not allow
+  template <typename Record>
+  auto Read(std::uint64_t section_offset, std::uint64_t index) const -> Record {
+    Record record{};
+    std::memcpy(&record, static_cast<std::byte const*>(m_mapping) + section_offset + index * sizeof(Record), sizeof(Record));
+    return record;
+  }
+
+  auto FindAccount(word_t const& address) const -> std::optional<AccountRecord> {
+    auto const address_at{[this](std::uint64_t index) -> word_t {
+      word_t address{};
+      std::memcpy(&address, static_cast<std::byte const*>(m_mapping) + m_header.accounts_offset + index * sizeof(AccountRecord), sizeof(address));
+      return address;
+    }};
+    auto const index{LowerBound(m_header.account_count, address, address_at)};
+    if (index == m_header.account_count) {
+      return std::nullopt;
+    }
+    auto const account{Read<AccountRecord>(m_header.accounts_offset, index)};
+    if (account.address != address or account.storage_begin > account.storage_end or account.storage_end > m_header.storage_count) {
+      return std::nullopt;
+    }
+    return account;
+  }
+};
+
+}  // namespace evmint::flat
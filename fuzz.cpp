@@ -0,0 +1,649 @@
+// SPDX-License-Identifier: MIT
+
+// evmint-fuzz: libFuzzer target (cmake -DEVMINT_FUZZ=ON, with clang) that turns each input into structurally valid
+// bytecode and call data, runs them through Interpreter::Execute() and through the deliberately simple Reference
+// below, and aborts on any difference in status, gas used, final stack, memory, storage writes or logs.
+//
+//   evmint-fuzz [libFuzzer options] [corpus directory...]
+//
+// Input layout: one byte picks the gas limit, one the call data length, then the call data, then one byte per
+// generated instruction (and its operands). Instructions only use opcodes the interpreter implements, always get
+// the stack inputs they need, address memory below kFuzzMemorySize and storage and accounts of a small fixed state,
+// and jump to JUMPDESTs only, so most inputs run to their end or out of gas instead of failing at the first byte.
+//
+// One Interpreter serves every input, as executors use it: Execute() resets only the memory the previous input wrote
+// (MemorySize()) and the stack it left, never the whole memory array, so stale memory shows up as a mismatch in the
+// next input. Every input runs under all three dispatch modes (kTiered jitting it), or only under the one named by
+// EVMINT_FUZZ_DISPATCH=table|tos|tiered.
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <format>
+#include <limits>
+#include <optional>
+#include <print>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <magic_enum.hpp>
+#include <intx/intx.hpp>
+
+#include "evm.hpp"
+#include "interpreter.hpp"
+#include "state.hpp"
+
+using namespace evmint;
+
+namespace {
+
+constexpr std::size_t kMaxFuzzGas{30'000};
+constexpr std::size_t kMaxCodeSize{512};
+// memory offsets stay below this, so each input dirties at most this much memory
+constexpr std::size_t kFuzzMemorySize{1'024};
+// slots and accounts of the fuzzing state, the rest read as zero
+constexpr std::size_t kFuzzSlotCount{4};
+constexpr std::size_t kFuzzAccountCount{4};
+
+struct FuzzAccount {
+  word_t address{};
+  word_t balance{};
+  std::size_t code_size{0};
+};
+
+constexpr word_t kFuzzAddress{0xf0};
+
+auto FuzzAccounts() -> std::vector<FuzzAccount> { return {{.address = kFuzzAddress, .balance = 7}, {.address = 1, .balance = 1'000, .code_size = 3}, {.address = 2, .code_size = 40}, {.address = 3}}; }
+
+auto FuzzStorage() -> Storage { return {{0, 1}, {1, 0xffff}, {2, ~word_t{0}}}; }
+
+auto MakeFuzzState() -> StateSnapshot {
+  Accounts accounts{};
+  for (auto const& account : FuzzAccounts()) {
+    accounts[account.address] = {.balance = account.balance, .code = std::vector<std::byte>(account.code_size, kStop)};
+  }
+  accounts[kFuzzAddress].storage = FuzzStorage();
+  return StateSnapshot{std::move(accounts)};
+}
+
+// Reads the fuzzer's input front to back, zeros once it is used up.
+class InputReader {
+ public:
+  explicit InputReader(std::span<std::uint8_t const> input) : m_input{input} {}
+
+  auto Empty() const -> bool { return m_offset == m_input.size(); }
+  auto Byte() -> std::uint8_t { return Empty() ? 0 : m_input[m_offset++]; }
+  auto Bytes(std::size_t count) -> std::vector<std::byte> {
+    std::vector<std::byte> bytes(count);
+    std::ranges::generate(bytes, [this] { return static_cast<std::byte>(Byte()); });
+    return bytes;
+  }
+
+ private:
+  std::span<std::uint8_t const> m_input;
+  std::size_t m_offset{0};
+};
+
+struct FuzzCase {
+  std::vector<std::byte> code{};
+  std::vector<std::byte> calldata{};
+  std::size_t gas_limit{0};
+};
+
+class CodeGenerator {
+ public:
+  explicit CodeGenerator(InputReader& input) : m_input{input} {}
+
+  auto Generate() -> std::vector<std::byte> {
+    while (not m_input.Empty() and m_code.size() < kMaxCodeSize) {
+      EmitInstruction(kOpcodes[m_input.Byte() % kOpcodes.size()]);
+    }
+    // jumps go to a JUMPDEST picked by their selector byte, or to themselves (an invalid jump) if there is none
+    for (auto const& [push_offset, selector] : m_jumps) {
+      auto const target{m_jump_destinations.empty() ? push_offset : m_jump_destinations[selector % m_jump_destinations.size()]};
+      m_code[push_offset + 1] = static_cast<std::byte>(target >> kByteSize);
+      m_code[push_offset + 2] = static_cast<std::byte>(target);
+    }
+    return std::move(m_code);
+  }
+
+ private:
+  static constexpr std::array kOpcodes{kStop,  kAdd,    kMul,  kSub,  kLt,   kGt,    kEq,      kIsZero,       kAnd,          kOr,         kXor,      kNot,
+                                       kShl,   kShr,    kPop,  kMLoad, kMStore, kSLoad, kSStore,  kJump,         kJumpI,        kJumpDest,   kPush0,    kPush1,
+                                       kPush2, kPush12, kDup1, kDup2, kDup3, kSwap1, kBalance, kCallDataLoad, kCallDataSize, kExtCodeSize,
+                                       kLog0,  kLog1,   kLog2, kLog3, kLog4};
+
+  InputReader& m_input;
+  std::vector<std::byte> m_code{};
+  // stack height if the code ran straight through, to give every instruction its inputs
+  std::size_t m_stack_height{0};
+  std::vector<std::size_t> m_jump_destinations{};
+  // offset of each jump's PUSH2 and the byte selecting its target
+  std::vector<std::pair<std::size_t, std::uint8_t>> m_jumps{};
+
+  auto Push(std::size_t value) -> void {
+    if (value <= std::numeric_limits<std::uint8_t>::max()) {
+      m_code.insert(std::end(m_code), {kPush1, static_cast<std::byte>(value)});
+    } else {
+      m_code.insert(std::end(m_code), {kPush2, static_cast<std::byte>(value >> kByteSize), static_cast<std::byte>(value)});
+    }
+    m_stack_height++;
+  }
+
+  auto ReadUint16() -> std::size_t {
+    std::size_t const high{m_input.Byte()};
+    return high << kByteSize | m_input.Byte();
+  }
+
+  auto EmitInstruction(opcode_t opcode) -> void {
+    auto const& opcode_info{kOpcodeInfo.at(opcode)};
+    switch (opcode) {
+      case kMLoad:
+      case kMStore:
+        if (opcode == kMStore) {
+          Push(m_input.Byte());
+        }
+        Push(ReadUint16() % (kFuzzMemorySize - kWordSize));
+        break;
+      case kSLoad:
+      case kSStore:
+        if (opcode == kSStore) {
+          Push(m_input.Byte());
+        }
+        Push(m_input.Byte() % kFuzzSlotCount);
+        break;
+      case kBalance:
+      case kExtCodeSize:
+        Push(static_cast<std::size_t>(FuzzAccounts()[m_input.Byte() % kFuzzAccountCount].address));
+        break;
+      case kCallDataLoad:
+        Push(m_input.Byte() % (kWordSize * 2));
+        break;
+      case kLog0:
+      case kLog1:
+      case kLog2:
+      case kLog3:
+      case kLog4:
+        // topics are whatever is on the stack, the data up to two words from anywhere in the fuzzing memory
+        while (m_stack_height < opcode_info.stack_inputs - 2) {
+          Push(m_input.Byte());
+        }
+        Push(m_input.Byte() % (kWordSize * 2 + 1));
+        Push(ReadUint16() % kFuzzMemorySize);
+        break;
+      case kJump:
+      case kJumpI:
+        if (opcode == kJumpI) {
+          Push(m_input.Byte() % 2);
+        }
+        m_jumps.emplace_back(m_code.size(), m_input.Byte());
+        m_code.insert(std::end(m_code), {kPush2, std::byte{0}, std::byte{0}});
+        m_stack_height++;
+        break;
+      case kJumpDest:
+        m_jump_destinations.push_back(m_code.size());
+        break;
+      default:
+        while (m_stack_height < opcode_info.stack_inputs) {
+          Push(m_input.Byte());
+        }
+    }
+    m_code.push_back(opcode);
+    auto const immediates{m_input.Bytes(ImmediateSize(opcode))};
+    m_code.insert(std::end(m_code), std::begin(immediates), std::end(immediates));
+    m_stack_height = m_stack_height - opcode_info.stack_inputs + opcode_info.stack_outputs;
+  }
+};
+
+auto MakeFuzzCase(std::span<std::uint8_t const> data) -> FuzzCase {
+  InputReader input{data};
+  FuzzCase fuzz_case{.gas_limit = kMaxFuzzGas * (input.Byte() + 1) / 256};
+  fuzz_case.calldata = input.Bytes(input.Byte() % (kWordSize * 2));
+  fuzz_case.code = CodeGenerator{input}.Generate();
+  return fuzz_case;
+}
+
+struct ReferenceLog {
+  std::vector<word_t> topics{};
+  std::vector<std::byte> data{};
+};
+
+// Straight-line switch over the opcodes, with its own stack, memory that grows to the highest word stored, and the
+// gas schedule spelled out per opcode. Shares nothing with the interpreter but the word type and the limits.
+class Reference {
+ public:
+  Reference(FuzzCase const& fuzz_case, StateView const& state) : m_code{fuzz_case.code}, m_calldata{fuzz_case.calldata}, m_state{state}, m_gas_left{fuzz_case.gas_limit} {}
+
+  auto Run() -> ExecutionStatus {
+    while (m_program_counter < m_code.size()) {
+      auto const opcode{m_code[m_program_counter]};
+      if (auto const status{Execute(opcode)}; status) {
+        return *status;
+      }
+    }
+    return ExecutionStatus::kSuccess;
+  }
+
+  auto GasLeft() const -> std::size_t { return m_gas_left; }
+  auto Stack() const -> std::vector<word_t> const& { return m_stack; }
+  auto Memory() const -> std::vector<std::uint8_t> const& { return m_memory; }
+  auto StorageWrites() const -> Storage const& { return m_storage_writes; }
+  auto Logs() const -> std::vector<ReferenceLog> const& { return m_logs; }
+
+ private:
+  std::span<std::byte const> m_code;
+  std::span<std::byte const> m_calldata;
+  StateView const& m_state;
+  std::size_t m_gas_left;
+  std::size_t m_program_counter{0};
+  std::vector<word_t> m_stack{};
+  std::vector<std::uint8_t> m_memory{};
+  Storage m_storage_writes{};
+  std::vector<ReferenceLog> m_logs{};
+
+  auto Pop() -> word_t {
+    auto const word{m_stack.back()};
+    m_stack.pop_back();
+    return word;
+  }
+
+  // whether an instruction starts at `target`, rather than PUSH data covering it
+  auto IsInstruction(std::size_t target) const -> bool {
+    std::size_t program_counter{0};
+    while (program_counter < target) {
+      program_counter += 1 + ImmediateSize(m_code[program_counter]);
+    }
+    return program_counter == target;
+  }
+
+  // The status the instruction at the program counter ends the execution with, nullopt if it does not.
+  auto Execute(opcode_t opcode) -> std::optional<ExecutionStatus> {
+    std::size_t gas{3};
+    std::size_t inputs{2};
+    switch (opcode) {
+      case kStop:
+        gas = inputs = 0;
+        break;
+      case kMul:
+        gas = 5;
+        break;
+      case kIsZero:
+      case kNot:
+      case kMLoad:
+      case kCallDataLoad:
+      case kDup1:
+        inputs = 1;
+        break;
+      case kPop:
+        gas = 2;
+        inputs = 1;
+        break;
+      case kSLoad:
+        gas = 2'100;
+        inputs = 1;
+        break;
+      case kSStore:
+        gas = 20'000;
+        break;
+      case kBalance:
+      case kExtCodeSize:
+        gas = 2'600;
+        inputs = 1;
+        break;
+      case kJump:
+        gas = 8;
+        inputs = 1;
+        break;
+      case kJumpI:
+        gas = 10;
+        break;
+      case kJumpDest:
+        gas = 1;
+        inputs = 0;
+        break;
+      case kPush0:
+      case kCallDataSize:
+        gas = 2;
+        inputs = 0;
+        break;
+      case kPush1:
+      case kPush2:
+      case kPush12:
+        inputs = 0;
+        break;
+      case kDup3:
+        inputs = 3;
+        break;
+      case kLog0:
+      case kLog1:
+      case kLog2:
+      case kLog3:
+      case kLog4: {
+        auto const topic_count{static_cast<std::size_t>(opcode) - static_cast<std::size_t>(kLog0)};
+        gas = 375 + 375 * topic_count;
+        inputs = 2 + topic_count;
+        break;
+      }
+      case kAdd:
+      case kSub:
+      case kLt:
+      case kGt:
+      case kEq:
+      case kAnd:
+      case kOr:
+      case kXor:
+      case kShl:
+      case kShr:
+      case kMStore:
+      case kDup2:
+      case kSwap1:
+        break;
+      default:
+        return ExecutionStatus::kUnrecognizedOpcode;
+    }
+    if (m_gas_left < gas) {
+      return ExecutionStatus::kGasExceeded;
+    }
+    m_gas_left -= gas;
+    if (m_stack.size() < inputs) {
+      return ExecutionStatus::kStackUnderflow;
+    }
+
+    auto next_program_counter{m_program_counter + 1};
+    switch (opcode) {
+      case kStop:
+        next_program_counter = m_code.size();
+        break;
+      case kAdd: {
+        auto const a{Pop()};
+        m_stack.push_back(a + Pop());
+        break;
+      }
+      case kMul: {
+        auto const a{Pop()};
+        m_stack.push_back(a * Pop());
+        break;
+      }
+      case kSub: {
+        auto const a{Pop()};
+        m_stack.push_back(a - Pop());
+        break;
+      }
+      case kLt: {
+        auto const a{Pop()};
+        m_stack.push_back(a < Pop() ? 1 : 0);
+        break;
+      }
+      case kGt: {
+        auto const a{Pop()};
+        m_stack.push_back(a > Pop() ? 1 : 0);
+        break;
+      }
+      case kEq: {
+        auto const a{Pop()};
+        m_stack.push_back(a == Pop() ? 1 : 0);
+        break;
+      }
+      case kIsZero:
+        m_stack.push_back(Pop() == 0 ? 1 : 0);
+        break;
+      case kAnd: {
+        auto const a{Pop()};
+        m_stack.push_back(a & Pop());
+        break;
+      }
+      case kOr: {
+        auto const a{Pop()};
+        m_stack.push_back(a | Pop());
+        break;
+      }
+      case kXor: {
+        auto const a{Pop()};
+        m_stack.push_back(a ^ Pop());
+        break;
+      }
+      case kNot:
+        m_stack.push_back(~Pop());
+        break;
+      case kShl:
+      case kShr: {
+        auto const shift{Pop()};
+        auto const value{Pop()};
+        if (shift >= 256) {
+          m_stack.push_back(0);
+        } else {
+          m_stack.push_back(opcode == kShl ? value << static_cast<unsigned>(shift) : value >> static_cast<unsigned>(shift));
+        }
+        break;
+      }
+      case kPop:
+        Pop();
+        break;
+      case kMLoad: {
+        auto const offset{Pop()};
+        if (offset > kMemorySize - kWordSize) {
+          return ExecutionStatus::kMemoryOutOfBounds;
+        }
+        word_t word{0};
+        for (std::size_t index{0}; index < kWordSize; ++index) {
+          auto const address{static_cast<std::size_t>(offset) + index};
+          word = word << kByteSize | word_t{address < m_memory.size() ? m_memory[address] : std::uint8_t{0}};
+        }
+        m_stack.push_back(word);
+        break;
+      }
+      case kMStore: {
+        auto const offset{Pop()};
+        auto value{Pop()};
+        if (offset > kMemorySize - kWordSize) {
+          return ExecutionStatus::kMemoryOutOfBounds;
+        }
+        auto const begin{static_cast<std::size_t>(offset)};
+        m_memory.resize(std::max(m_memory.size(), begin + kWordSize));
+        for (std::size_t index{kWordSize}; index-- > 0; value >>= kByteSize) {
+          m_memory[begin + index] = static_cast<std::uint8_t>(value);
+        }
+        break;
+      }
+      case kSLoad: {
+        auto const slot{Pop()};
+        auto const written{m_storage_writes.find(slot)};
+        m_stack.push_back(written != std::end(m_storage_writes) ? written->second : m_state.StorageAt(kFuzzAddress, slot));
+        break;
+      }
+      case kSStore: {
+        auto const slot{Pop()};
+        m_storage_writes.insert_or_assign(slot, Pop());
+        break;
+      }
+      case kBalance:
+      case kExtCodeSize: {
+        auto const address{Pop()};
+        word_t result{0};
+        for (auto const& account : FuzzAccounts()) {
+          if (account.address == address) {
+            result = opcode == kBalance ? account.balance : word_t{account.code_size};
+          }
+        }
+        m_stack.push_back(result);
+        break;
+      }
+      case kCallDataLoad: {
+        auto const offset{Pop()};
+        word_t word{0};
+        for (std::size_t index{0}; index < kWordSize; ++index) {
+          auto const available{offset + index < m_calldata.size()};
+          word = word << kByteSize | word_t{available ? static_cast<std::uint8_t>(m_calldata[static_cast<std::size_t>(offset) + index]) : std::uint8_t{0}};
+        }
+        m_stack.push_back(word);
+        break;
+      }
+      case kCallDataSize:
+        m_stack.push_back(m_calldata.size());
+        break;
+      case kJump:
+      case kJumpI: {
+        auto const target{Pop()};
+        if (opcode == kJumpI and Pop() == 0) {
+          break;
+        }
+        if (target >= m_code.size() or m_code[static_cast<std::size_t>(target)] != kJumpDest or not IsInstruction(static_cast<std::size_t>(target))) {
+          return ExecutionStatus::kInvalidJump;
+        }
+        // the JUMPDEST runs next, paying its gas
+        next_program_counter = static_cast<std::size_t>(target);
+        break;
+      }
+      case kJumpDest:
+        break;
+      case kPush0:
+      case kPush1:
+      case kPush2:
+      case kPush12: {
+        auto const size{static_cast<std::size_t>(opcode) - static_cast<std::size_t>(kPush0)};
+        word_t word{0};
+        for (std::size_t index{1}; index <= size; ++index) {
+          word = word << kByteSize | word_t{static_cast<std::uint8_t>(m_code[m_program_counter + index])};
+        }
+        m_stack.push_back(word);
+        next_program_counter += size;
+        break;
+      }
+      case kDup1:
+      case kDup2:
+      case kDup3:
+        m_stack.push_back(m_stack[m_stack.size() - inputs]);
+        break;
+      case kSwap1:
+        std::swap(m_stack[m_stack.size() - 1], m_stack[m_stack.size() - 2]);
+        break;
+      case kLog0:
+      case kLog1:
+      case kLog2:
+      case kLog3:
+      case kLog4: {
+        auto const offset{Pop()};
+        auto const size{Pop()};
+        ReferenceLog log{};
+        for (std::size_t topic{2}; topic < inputs; ++topic) {
+          log.topics.push_back(Pop());
+        }
+        if (size != 0 and (size > kMemorySize or offset > kMemorySize - size)) {
+          return ExecutionStatus::kMemoryOutOfBounds;
+        }
+        if (size * 8 > m_gas_left) {
+          return ExecutionStatus::kGasExceeded;
+        }
+        m_gas_left -= static_cast<std::size_t>(size) * 8;
+        for (std::size_t index{0}; index < size; ++index) {
+          auto const address{static_cast<std::size_t>(offset) + index};
+          log.data.push_back(static_cast<std::byte>(address < m_memory.size() ? m_memory[address] : std::uint8_t{0}));
+        }
+        m_logs.push_back(std::move(log));
+        break;
+      }
+      default:
+        break;
+    }
+    if (m_stack.size() > kMaxStackSize) {
+      return ExecutionStatus::kStackOverflow;
+    }
+    m_program_counter = next_program_counter;
+    return std::nullopt;
+  }
+};
+
+auto ToHex(std::span<std::byte const> bytes) -> std::string {
+  std::string hex{};
+  for (auto const byte : bytes) {
+    hex += std::format("{:02x}", static_cast<std::uint8_t>(byte));
+  }
+  return hex;
+}
+
+// Describes how the interpreter's execution differs from the reference's, empty if it does not.
+auto Compare(Interpreter const& interpreter, ExecutionResult const& result, Reference const& reference, ExecutionStatus reference_status, std::size_t gas_limit) -> std::string {
+  if (result.status != reference_status) {
+    return std::format("status {} vs. reference {}", magic_enum::enum_name(result.status), magic_enum::enum_name(reference_status));
+  }
+  auto const reference_gas_used{reference_status == ExecutionStatus::kSuccess ? gas_limit - reference.GasLeft() : gas_limit};
+  if (result.gas_used != reference_gas_used) {
+    return std::format("gas used {} vs. reference {}", result.gas_used, reference_gas_used);
+  }
+  // a failed execution leaves stack and memory wherever the failing instruction was detected, which differs by mode,
+  // but drops every log it appended
+  if (reference_status != ExecutionStatus::kSuccess) {
+    return interpreter.Logs().empty() ? std::string{} : "a failed execution kept its logs";
+  }
+  auto const& stack{interpreter.Stack()};
+  if (stack.size() != reference.Stack().size()) {
+    return std::format("stack height {} vs. reference {}", stack.size(), reference.Stack().size());
+  }
+  for (std::size_t depth{0}; depth < stack.size(); ++depth) {
+    if (stack.peek(depth) != reference.Stack()[reference.Stack().size() - 1 - depth]) {
+      return std::format("stack item {} differs", depth);
+    }
+  }
+  if (interpreter.MemorySize() != reference.Memory().size()) {
+    return std::format("memory size {} vs. reference {}", interpreter.MemorySize(), reference.Memory().size());
+  }
+  if (not std::ranges::equal(std::span{interpreter.Memory()}.first(interpreter.MemorySize()), reference.Memory())) {
+    return "memory differs";
+  }
+  if (result.storage_writes != reference.StorageWrites()) {
+    return "storage writes differ";
+  }
+  auto const& logs{interpreter.Logs()};
+  if (logs.size() != reference.Logs().size()) {
+    return std::format("{} logs vs. reference {}", logs.size(), reference.Logs().size());
+  }
+  for (std::size_t index{0}; index < logs.size(); ++index) {
+    auto const log{logs[index]};
+    if (log.address != kFuzzAddress or not std::ranges::equal(log.topics, reference.Logs()[index].topics) or not std::ranges::equal(log.data, reference.Logs()[index].data)) {
+      return std::format("log {} differs", index);
+    }
+  }
+  return {};
+}
+
+std::vector<DispatchMode> g_dispatch_modes{DispatchMode::kHandlerTable, DispatchMode::kTopOfStackCached, DispatchMode::kTiered};
+
+}  // namespace
+
+extern "C" auto LLVMFuzzerInitialize(int* /*argc*/, char*** /*argv*/) -> int {
+  if (char const* const dispatch{std::getenv("EVMINT_FUZZ_DISPATCH")}; dispatch != nullptr) {
+    auto const dispatch_mode{ParseDispatchMode(dispatch)};
+    if (not dispatch_mode) {
+      std::println(stderr, "[ERROR] EVMINT_FUZZ_DISPATCH must be table, tos or tiered.");
+      std::exit(1);
+    }
+    g_dispatch_modes = {*dispatch_mode};
+  }
+  return 0;
+}
+
+extern "C" auto LLVMFuzzerTestOneInput(std::uint8_t const* data, std::size_t size) -> int {
+  static StateSnapshot const state{MakeFuzzState()};
+  static Interpreter interpreter{kExecutorOptions};
+
+  auto const fuzz_case{MakeFuzzCase({data, size})};
+  Reference reference{fuzz_case, state};
+  auto const reference_status{reference.Run()};
+
+  for (auto const dispatch_mode : g_dispatch_modes) {
+    auto const result{interpreter.Execute(
+        {.code = fuzz_case.code, .calldata = fuzz_case.calldata, .state = &state, .address = kFuzzAddress, .gas_limit = fuzz_case.gas_limit, .dispatch_mode = dispatch_mode})};
+    if (auto const difference{Compare(interpreter, result, reference, reference_status, fuzz_case.gas_limit)}; not difference.empty()) {
+      std::println(stderr, "[FUZZ] Mismatch under {}: {}\n  code {}\n  calldata {}\n  gas limit {}", DispatchModeName(dispatch_mode), difference, ToHex(fuzz_case.code),
+                   ToHex(fuzz_case.calldata), fuzz_case.gas_limit);
+      std::abort();
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,369 @@
+// SPDX-License-Identifier: MIT
+
+// Ingestion of raw signed transactions and blocks: decodes them into views over the caller's buffer (no field is
+// copied or allocated) and turns them into ExecutionRequests. Covers legacy transactions (with or without EIP-155
+// replay protection) and the EIP-2718 typed ones: access lists (EIP-2930), dynamic fees (EIP-1559) and blobs
+// (EIP-4844). Senders are recovered in batches, on worker threads ahead of execution (SenderRecoveryStage).
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "evm.hpp"
+#include "interpreter.hpp"
+#include "keccak.hpp"
+#include "parallel_for.hpp"
+#include "rlp.hpp"
+#include "secp256k1.hpp"
+#include "state.hpp"
+
+namespace evmint::ingest {
+
+enum class TransactionType : std::uint8_t { kLegacy = 0, kAccessList = 1, kDynamicFee = 2, kBlob = 3 };
+
+// Views into the buffer the transaction was decoded from, which must outlive it.
+struct TransactionView {
+  TransactionType type{TransactionType::kLegacy};
+  // legacy transactions without EIP-155 have none (0)
+  std::uint64_t chain_id{0};
+  std::uint64_t nonce{0};
+  // the gas price, or since EIP-1559 the maximum fee per gas
+  word_t max_fee_per_gas{0};
+  // the gas price for legacy and access list transactions
+  word_t max_priority_fee_per_gas{0};
+  std::uint64_t gas_limit{0};
+  // none for contract creation
+  std::optional<word_t> to{};
+  word_t value{0};
+  std::span<std::byte const> data{};
+  // [[address, [slot, ...]], ...]; an empty list for legacy transactions
+  rlp::Item access_list{.is_list = true};
+  word_t max_fee_per_blob_gas{0};
+  // [hash, ...]
+  rlp::Item blob_hashes{.is_list = true};
+  // signature: the y parity of R (recovery id) and its r and s
+  std::uint8_t y_parity{0};
+  word_t r{0};
+  word_t s{0};
+  // the whole transaction as in a block, type byte included, which the transaction hash covers
+  std::span<std::byte const> encoding{};
+};
+
+namespace detail {
+
+// Checks the access list's shape and counts its addresses and slots, for the intrinsic gas.
+inline auto CountAccessList(rlp::Item const& access_list, std::size_t& address_count, std::size_t& slot_count) -> bool {
+  rlp::ListReader entries{access_list};
+  while (not entries.AtEnd()) {
+    rlp::ListReader entry{entries.List()};
+    // Address() reads the empty string as no address, which an access list entry must have
+    if (not entry.Address()) {
+      return false;
+    }
+    rlp::ListReader slots{entry.List()};
+    while (not slots.AtEnd()) {
+      if (slots.String().size() != kWordSize) {
+        return false;
+      }
+      slot_count++;
+    }
+    if (not slots.Finish() or not entry.Finish()) {
+      return false;
+    }
+    address_count++;
+  }
+  return entries.Finish();
+}
+
+// The fields of a typed transaction, after its type byte.
+inline auto DecodeTyped(TransactionType type, rlp::Item const& payload, TransactionView& transaction) -> bool {
+  rlp::ListReader fields{payload};
+  transaction.chain_id = fields.Uint64();
+  transaction.nonce = fields.Uint64();
+  if (type == TransactionType::kAccessList) {
+    transaction.max_fee_per_gas = fields.Word();
+    transaction.max_priority_fee_per_gas = transaction.max_fee_per_gas;
+  } else {
+    transaction.max_priority_fee_per_gas = fields.Word();
+    transaction.max_fee_per_gas = fields.Word();
+  }
+  transaction.gas_limit = fields.Uint64();
+  transaction.to = fields.Address();
+  transaction.value = fields.Word();
+  transaction.data = fields.String();
+  transaction.access_list = fields.List();
+  if (type == TransactionType::kBlob) {
+    transaction.max_fee_per_blob_gas = fields.Word();
+    transaction.blob_hashes = fields.List();
+  }
+  auto const y_parity{fields.Uint64()};
+  transaction.y_parity = static_cast<std::uint8_t>(y_parity);
+  transaction.r = fields.Word();
+  transaction.s = fields.Word();
+  // blob transactions always call a contract
+  return fields.Finish() and y_parity <= 1 and (type != TransactionType::kBlob or transaction.to.has_value());
+}
+
+inline auto DecodeLegacy(rlp::Item const& list, TransactionView& transaction) -> bool {
+  constexpr std::uint64_t kUnprotectedV{27};
+  constexpr std::uint64_t kProtectedV{35};
+
+  rlp::ListReader fields{list};
+  transaction.nonce = fields.Uint64();
+  transaction.max_fee_per_gas = fields.Word();
+  transaction.max_priority_fee_per_gas = transaction.max_fee_per_gas;
+  transaction.gas_limit = fields.Uint64();
+  transaction.to = fields.Address();
+  transaction.value = fields.Word();
+  transaction.data = fields.String();
+  // v is 27 + y parity, or with EIP-155 35 + 2 * chain id + y parity
+  auto const v{fields.Uint64()};
+  transaction.r = fields.Word();
+  transaction.s = fields.Word();
+  if (v == kUnprotectedV or v == kUnprotectedV + 1) {
+    transaction.y_parity = static_cast<std::uint8_t>(v - kUnprotectedV);
+  } else if (v >= kProtectedV) {
+    transaction.chain_id = (v - kProtectedV) / 2;
+    transaction.y_parity = static_cast<std::uint8_t>((v - kProtectedV) % 2);
+  } else {
+    return false;
+  }
+  return fields.Finish();
+}
+
+}  // namespace detail
+
+// Decodes one transaction as a block holds it: an RLP list for legacy transactions, or for typed ones an RLP string
+// whose payload is the type byte followed by the list (`is_wrapped`). Without the wrapping, as sent to a node,
+// `encoding` is the type byte and list themselves. nullopt if it is malformed or not canonical.
+inline auto DecodeTransaction(std::span<std::byte const> encoding, bool is_wrapped = false) -> std::optional<TransactionView> {
+  constexpr std::byte kMaxTypeByte{0x7f};
+
+  TransactionView transaction{.encoding = encoding};
+  if (is_wrapped) {
+    auto const envelope{rlp::Decode(encoding)};
+    if (not envelope or envelope->is_list) {
+      return std::nullopt;
+    }
+    encoding = envelope->payload;
+    transaction.encoding = encoding;
+  }
+  if (encoding.empty()) {
+    return std::nullopt;
+  }
+  if (encoding[0] > kMaxTypeByte) {
+    auto const list{rlp::Decode(encoding)};
+    return list and detail::DecodeLegacy(*list, transaction) ? std::optional{transaction} : std::nullopt;
+  }
+
+  auto const type{static_cast<TransactionType>(encoding[0])};
+  if (type != TransactionType::kAccessList and type != TransactionType::kDynamicFee and type != TransactionType::kBlob) {
+    return std::nullopt;
+  }
+  transaction.type = type;
+  auto const payload{rlp::Decode(encoding.subspan(1))};
+  return payload and detail::DecodeTyped(type, *payload, transaction) ? std::optional{transaction} : std::nullopt;
+}
+
+// Decodes a block body's transaction list (legacy transactions as lists, typed ones wrapped in strings) in one pass,
+// appending to `transactions` so a reused vector does not allocate; false if any transaction is malformed.
+inline auto DecodeTransactions(rlp::Item const& list, std::vector<TransactionView>& transactions) -> bool {
+  if (not list.is_list) {
+    return false;
+  }
+  for (auto rest{list.payload}; not rest.empty();) {
+    auto const item{rlp::TakeItem(rest)};
+    if (not item) {
+      return false;
+    }
+    auto transaction{item->is_list ? DecodeTransaction(item->encoding) : DecodeTransaction(item->encoding, true)};
+    if (not transaction) {
+      return false;
+    }
+    transactions.push_back(*transaction);
+  }
+  return true;
+}
+
+// The transactions of an encoded block, [header, transactions, ommers, ...]; false if the block is malformed.
+inline auto DecodeBlockTransactions(std::span<std::byte const> block, std::vector<TransactionView>& transactions) -> bool {
+  auto const block_item{rlp::Decode(block)};
+  if (not block_item or not block_item->is_list) {
+    return false;
+  }
+  rlp::ListReader fields{*block_item};
+  fields.List();
+  auto const transaction_list{fields.List()};
+  return DecodeTransactions(transaction_list, transactions);
+}
+
+// The gas a transaction pays before its code runs; nullopt if its access list is malformed.
+inline auto IntrinsicGas(TransactionView const& transaction) -> std::optional<std::size_t> {
+  auto gas{kTransactionGas};
+  for (auto const byte : transaction.data) {
+    gas += byte == std::byte{0} ? kZeroDataByteGas : kNonZeroDataByteGas;
+  }
+  std::size_t address_count{0};
+  std::size_t slot_count{0};
+  if (not detail::CountAccessList(transaction.access_list, address_count, slot_count)) {
+    return std::nullopt;
+  }
+  return gas + address_count * kAccessListAddressGas + slot_count * kAccessListSlotGas;
+}
+
+// The execution of a call transaction's code: its data as call data, and the gas left after the intrinsic cost. Code
+// comes from `state`, which must outlive the request like the transaction's buffer. nullopt for contract creation
+// (not supported) and for transactions whose gas does not cover the intrinsic cost.
+inline auto ToExecutionRequest(TransactionView const& transaction, StateView const& state, DispatchMode dispatch_mode = DispatchMode::kTiered)
+    -> std::optional<ExecutionRequest> {
+  auto const intrinsic_gas{IntrinsicGas(transaction)};
+  if (not transaction.to or not intrinsic_gas or transaction.gas_limit < *intrinsic_gas) {
+    return std::nullopt;
+  }
+  return ExecutionRequest{.code = state.CodeAt(*transaction.to),
+                          .calldata = transaction.data,
+                          .state = &state,
+                          .address = *transaction.to,
+                          .gas_limit = static_cast<std::size_t>(transaction.gas_limit - *intrinsic_gas),
+                          .dispatch_mode = dispatch_mode};
+}
+
+// The hash a transaction's signature signs: its fields without the signature, in a list behind the type byte for
+// typed transactions. Legacy transactions with EIP-155 replay protection sign the chain id and two zeros in its place.
+inline auto SigningHash(TransactionView const& transaction) -> Hash {
+  // fields before the signature, by transaction type
+  constexpr std::array<std::size_t, 4> kUnsignedFieldCounts{6, 8, 9, 11};
+  constexpr std::uint64_t kProtectedV{35};
+
+  auto const is_legacy{transaction.type == TransactionType::kLegacy};
+  // checked by DecodeTransaction()
+  auto const list{*rlp::Decode(is_legacy ? transaction.encoding : transaction.encoding.subspan(1))};
+  auto rest{list.payload};
+  for (std::size_t field{0}; field < kUnsignedFieldCounts[static_cast<std::size_t>(transaction.type)]; ++field) {
+    rlp::TakeItem(rest);
+  }
+  auto const fields{list.payload.first(list.payload.size() - rest.size())};
+
+  thread_local std::vector<std::byte> message{};
+  message.clear();
+  if (not is_legacy) {
+    message.push_back(static_cast<std::byte>(transaction.type));
+  }
+  rlp::Encoder encoder{message};
+  auto const message_list{encoder.BeginList()};
+  encoder.AppendRaw(fields);
+  if (is_legacy and *rlp::ToWord(*rlp::TakeItem(rest)) >= kProtectedV) {
+    encoder.AppendWord(transaction.chain_id);
+    encoder.AppendWord(0);
+    encoder.AppendWord(0);
+  }
+  encoder.EndList(message_list);
+  return Keccak256(message);
+}
+
+// Recovers the senders of `transactions` into `senders` as one batch; nullopt where the signature is invalid. Since
+// EIP-2, that includes an s above n / 2.
+inline auto RecoverSenderBatch(std::span<TransactionView const> transactions, std::span<std::optional<word_t>> senders) -> void {
+  thread_local std::vector<secp256k1::RecoveryInput> inputs{};
+  inputs.clear();
+  for (auto const& transaction : transactions) {
+    inputs.push_back({.hash = SigningHash(transaction), .r = transaction.r, .s = transaction.s, .y_parity = transaction.y_parity});
+  }
+  secp256k1::RecoverBatch(inputs, senders);
+  for (std::size_t index{0}; index < transactions.size(); ++index) {
+    if (transactions[index].s > secp256k1::kHalfOrder) {
+      senders[index] = std::nullopt;
+    }
+  }
+}
+
+// Recovers the senders of `transactions` in batches on `thread_count` threads.
+inline auto RecoverSenders(std::span<TransactionView const> transactions, std::span<std::optional<word_t>> senders, std::size_t thread_count) -> void {
+  constexpr std::size_t kBatchSize{32};
+
+  auto const batch_count{(transactions.size() + kBatchSize - 1) / kBatchSize};
+  ParallelFor(batch_count, thread_count, [&](std::size_t batch) {
+    auto const begin{batch * kBatchSize};
+    auto const size{std::min(kBatchSize, transactions.size() - begin)};
+    RecoverSenderBatch(transactions.subspan(begin, size), senders.subspan(begin, size));
+  });
+}
+
+// The pipeline stage between decoding and execution: worker threads recover the senders of the transactions after the
+// one executing, up to `lookahead` of them, so execution only waits for a sender when the workers fall behind.
+// Sender(N) tells the stage that transaction N is next; call it in order.
+class SenderRecoveryStage final {
+ public:
+  static constexpr std::size_t kDefaultLookahead{256};
+
+  // `transactions` must outlive the stage.
+  SenderRecoveryStage(std::span<TransactionView const> transactions, std::size_t thread_count, std::size_t lookahead = kDefaultLookahead)
+      : m_transactions{transactions}, m_senders(transactions.size()), m_batch_done((transactions.size() + kBatchSize - 1) / kBatchSize),
+        m_lookahead{std::max(lookahead, kBatchSize)} {
+    for (std::size_t worker{0}; worker < std::max<std::size_t>(thread_count, 1); ++worker) {
+      m_workers.emplace_back([this] { RunWorker(); });
+    }
+  }
+
+  SenderRecoveryStage(SenderRecoveryStage const&) = delete;
+  auto operator=(SenderRecoveryStage const&) -> SenderRecoveryStage& = delete;
+
+  ~SenderRecoveryStage() {
+    // workers waiting for the window to move give up; the jthreads then join
+    m_next.store(kStopped);
+    m_next.notify_all();
+  }
+
+  // The sender of transaction `index`, nullopt if its signature is invalid; waits until it is recovered.
+  auto Sender(std::size_t index) -> std::optional<word_t> {
+    if (index > m_next.load(std::memory_order_relaxed)) {
+      m_next.store(index);
+      m_next.notify_all();
+    }
+    auto const& batch_done{m_batch_done[index / kBatchSize]};
+    batch_done.wait(false);
+    return m_senders[index];
+  }
+
+ private:
+  static constexpr std::size_t kBatchSize{16};
+  static constexpr auto kStopped{std::numeric_limits<std::size_t>::max()};
+
+  std::span<TransactionView const> m_transactions;
+  std::vector<std::optional<word_t>> m_senders;
+  std::vector<std::atomic<bool>> m_batch_done;
+  std::size_t m_lookahead;
+  std::atomic<std::size_t> m_next_batch{0};
+  // the transaction execution needs next
+  std::atomic<std::size_t> m_next{0};
+
+  // last member: joined before anything the workers use is destroyed
+  std::vector<std::jthread> m_workers{};
+
+  auto RunWorker() -> void {
+    for (auto batch{m_next_batch.fetch_add(1)}; batch < m_batch_done.size(); batch = m_next_batch.fetch_add(1)) {
+      auto const begin{batch * kBatchSize};
+      for (auto next{m_next.load()}; next != kStopped and begin >= next + m_lookahead; next = m_next.load()) {
+        m_next.wait(next);
+      }
+      if (m_next.load() == kStopped) {
+        return;
+      }
+      auto const size{std::min(kBatchSize, m_transactions.size() - begin)};
+      RecoverSenderBatch(m_transactions.subspan(begin, size), std::span{m_senders}.subspan(begin, size));
+      m_batch_done[batch].store(true);
+      m_batch_done[batch].notify_all();
+    }
+  }
+};
+
+}  // namespace evmint::ingest
@@ -0,0 +1,1775 @@
+// SPDX-License-Identifier: MIT
+
+#include "interpreter.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <print>
+#include <ranges>
+#include <unordered_map>
+#include <utility>
+
+#if defined(__x86_64__)
+#include <sys/mman.h>
+#endif
+
+#include <range/v3/all.hpp>
+#include <magic_enum.hpp>
+#include <intx/intx.hpp>
+
+#include "aot.hpp"
+#include "precompiles.hpp"
+
+namespace evmint {
+
+namespace {
+
+// Moves the program counter to a JUMP/JUMPI target, which has to be a JUMPDEST instruction (not PUSH data) inside the
+// code, the targets the compiled tiers accept. The JUMPDEST is charged here, as execution resumes right after it.
+auto JumpTo(auto& execution_context, word_t const& counter, std::string_view mnemonic) -> void {
+  auto& jump_destinations{execution_context.jump_destinations};
+  if (jump_destinations.empty()) {
+    MarkJumpDestinations(execution_context.bytecode, jump_destinations);
+  }
+  if (counter >= word_t{execution_context.bytecode.size()} or jump_destinations[static_cast<std::size_t>(counter)] == 0) {
+    throw Revert{mnemonic, RevertError::kInvalidJump};
+  }
+  if (execution_context.gas_left < kJumpDestGas) {
+    throw Revert{"JUMPDEST", RevertError::kGasExceeded};
+  }
+  execution_context.gas_left -= kJumpDestGas;
+  execution_context.program_counter = static_cast<std::size_t>(counter);
+}
+
+// TODO: stack-contents array static??
+template <std::size_t num_bytes>
+auto PushToStack(auto& execution_context) -> void {
+  // PUSHn <value>
+  // Push n byte items (following opcode) on stack.
+
+  intx::uint256 stack_item{0};
+
+  if constexpr (num_bytes) {
+    // immediate data cut short by the end of the code reads as zeros
+    std::array<std::uint8_t, num_bytes> stack_item_bytes{};
+    auto const available{execution_context.bytecode.subspan(std::min(execution_context.program_counter + 1, execution_context.bytecode.size()))};
+    std::ranges::copy(available.first(std::min(num_bytes, available.size())) | std::views::transform([](auto byte) { return static_cast<std::uint8_t>(byte); }),
+                      std::begin(stack_item_bytes));
+    stack_item = to_uint256(stack_item_bytes);
+  }
+
+  execution_context.stack.push(stack_item);
+
+  if (execution_context.stack.size() > kMaxStackSize) {
+    throw Revert{"PUSHn", RevertError::kStackOverflow};
+  }
+}
+
+auto Jump(auto& execution_context) -> void {
+  // JUMP <counter>
+  // Alter the program counter
+
+  if (execution_context.stack.size() < 1) {
+    throw Revert{"JUMP", RevertError::kStackUnderflow};
+  }
+
+  auto const counter{execution_context.stack.top()};
+  execution_context.stack.pop();
+
+  JumpTo(execution_context, counter, "JUMP");
+}
+
+auto StoreToMemory(auto& execution_context) -> void {
+  // MSTORE <offset> <value>
+  // save word to memory
+
+  if (execution_context.stack.size() < 2) {
+    throw Revert{"MSTORE", RevertError::kStackUnderflow};
+  }
+
+  auto const offset{execution_context.stack.top()};
+  execution_context.stack.pop();
+
+  auto const value{execution_context.stack.top()};
+  execution_context.stack.pop();
+  auto const memory_offset{MemoryOffset(offset, "MSTORE")};
+  StoreWord(std::next(std::data(execution_context.memory), memory_offset), value);
+  execution_context.memory_size = std::max(execution_context.memory_size, memory_offset + kWordSize);
+}
+
+auto LoadFromMemory(auto& execution_context) -> void {
+  // MLOAD <offset>
+  // Load word from memory
+
+  if (execution_context.stack.size() < 1) {
+    throw Revert{"MLOAD", RevertError::kStackUnderflow};
+  }
+
+  auto const offset{execution_context.stack.top()};
+  execution_context.stack.pop();
+  execution_context.stack.push(LoadWord(std::next(std::data(execution_context.memory), MemoryOffset(offset, "MLOAD"))));
+}
+
+// TODO: SWAPn
+auto SwapStackValues(auto& execution_context) -> void {
+  // SWAP1 <a> <b>
+  // Exchange 1st and 2nd stack items
+
+  if (execution_context.stack.size() < 2) {
+    throw Revert{"SWAPn", RevertError::kStackUnderflow};
+  }
+
+  auto first{execution_context.stack.top()};
+  execution_context.stack.pop();
+  auto second{execution_context.stack.top()};
+  execution_context.stack.pop();
+
+  execution_context.stack.push(first);
+  execution_context.stack.push(second);
+}
+
+// TODO: stack-contents array static??
+template <std::size_t idx>
+auto DuplicateStackValue(auto& execution_context) -> void {
+  // DUPn <a> <b> ...
+  // Duplicate [idx]th stack item
+
+  if (execution_context.stack.size() < idx) {
+    throw Revert{"DUPn", RevertError::kStackUnderflow};
+  }
+
+  std::array<word_t, idx> stack_contents_window{};
+  std::ranges::for_each(stack_contents_window, [&execution_context](auto& elem) {
+    elem = execution_context.stack.top();
+    execution_context.stack.pop();
+  });
+
+  std::ranges::for_each(stack_contents_window | std::views::reverse, [&execution_context](auto const& elem) { execution_context.stack.push(elem); });
+  execution_context.stack.push(stack_contents_window.back());
+
+  if (execution_context.stack.size() > kMaxStackSize) {
+    throw Revert{"DUPn", RevertError::kStackOverflow};
+  }
+}
+
+auto ShiftLeft(auto& execution_context) -> void {
+  // SHL <shift> <value>
+  // Left shift operation
+
+  if (execution_context.stack.size() < 2) {
+    throw Revert{"SHL", RevertError::kStackUnderflow};
+  }
+
+  auto shift{execution_context.stack.top()};
+  execution_context.stack.pop();
+  auto value{execution_context.stack.top()};
+  execution_context.stack.pop();
+
+  execution_context.stack.push(value << shift);
+}
+
+auto ShiftRight(auto& execution_context) -> void {
+  // SHR <shift> <value>
+  // Logical right shift operation
+
+  if (execution_context.stack.size() < 2) {
+    throw Revert{"SHR", RevertError::kStackUnderflow};
+  }
+
+  auto shift{execution_context.stack.top()};
+  execution_context.stack.pop();
+  auto value{execution_context.stack.top()};
+  execution_context.stack.pop();
+
+  execution_context.stack.push(value >> shift);
+}
+
+template <typename Operation>
+auto ApplyBinaryOperation(auto& execution_context) -> void {
+  // ADD|MUL|SUB|LT|GT|EQ|AND|OR|XOR <a> <b>
+  // Replace the two topmost items by `a op b`
+
+  if (execution_context.stack.size() < 2) {
+    throw Revert{"BINOP", RevertError::kStackUnderflow};
+  }
+
+  auto const first{execution_context.stack.top()};
+  execution_context.stack.pop();
+  auto const second{execution_context.stack.top()};
+  execution_context.stack.pop();
+
+  execution_context.stack.push(word_t{Operation{}(first, second)});
+}
+
+template <typename Operation>
+auto ApplyUnaryOperation(auto& execution_context) -> void {
+  // ISZERO|NOT <a>
+  // Replace the topmost item by `op a`
+
+  if (execution_context.stack.size() < 1) {
+    throw Revert{"UNOP", RevertError::kStackUnderflow};
+  }
+
+  auto const operand{execution_context.stack.top()};
+  execution_context.stack.pop();
+
+  execution_context.stack.push(word_t{Operation{}(operand)});
+}
+
+auto PopFromStack(auto& execution_context) -> void {
+  // POP <a>
+  // Discard the topmost item
+
+  if (execution_context.stack.size() < 1) {
+    throw Revert{"POP", RevertError::kStackUnderflow};
+  }
+
+  execution_context.stack.pop();
+}
+
+auto ConditionalJump(auto& execution_context) -> void {
+  // JUMPI <counter> <b>
+  // Alter the program counter if b is non-zero
+
+  if (execution_context.stack.size() < 2) {
+    throw Revert{"JUMPI", RevertError::kStackUnderflow};
+  }
+
+  auto const counter{execution_context.stack.top()};
+  execution_context.stack.pop();
+  auto const condition{execution_context.stack.top()};
+  execution_context.stack.pop();
+
+  if (condition != 0) {
+    JumpTo(execution_context, counter, "JUMPI");
+  }
+}
+
+auto JumpDestination(auto& execution_context) -> void {
+  // JUMPDEST
+  // Mark a valid jump target; no-op at runtime
+}
+
+auto Stop(auto& execution_context) -> void {
+  // STOP
+  // Halt execution
+
+  execution_context.halted = true;
+}
+
+// Word of call data at `offset`, zero-padded past its end.
+auto CallDataWord(std::span<std::byte const> calldata, word_t const& offset) -> word_t {
+  std::array<std::uint8_t, kWordSize> word_bytes{};
+  if (offset < calldata.size()) {
+    auto const available{calldata.subspan(static_cast<std::size_t>(offset))};
+    std::ranges::copy(available.first(std::min(kWordSize, available.size())) | std::views::transform([](auto byte) { return static_cast<std::uint8_t>(byte); }), std::begin(word_bytes));
+  }
+  return to_uint256(word_bytes);
+}
+
+// Slots written by this execution shadow the attached state; without a state every slot is zero.
+auto StorageSlot(auto const& execution_context, word_t const& key) -> word_t {
+  if (auto const written{execution_context.storage_writes.find(key)}; written != std::end(execution_context.storage_writes)) {
+    return written->second;
+  }
+  return execution_context.state == nullptr ? word_t{0} : execution_context.state->StorageAt(execution_context.address, key);
+}
+
+// The state location SLOAD, BALANCE or EXTCODESIZE reads for `operand`, none if it reads no attached state (other
+// opcodes, no state, or a slot this execution already wrote).
+auto StateReadKey(auto const& execution_context, opcode_t opcode, word_t const& operand) -> std::optional<StateKey> {
+  if (execution_context.state == nullptr) {
+    return std::nullopt;
+  }
+  if (opcode == kSLoad) {
+    return execution_context.storage_writes.contains(operand) ? std::nullopt : std::optional{StateKey::Storage(execution_context.address, operand)};
+  }
+  if (opcode == kBalance or opcode == kExtCodeSize) {
+    return StateKey::Balance(ToAddress(operand));
+  }
+  return std::nullopt;
+}
+
+auto AccountBalance(auto const& execution_context, word_t const& address) -> word_t {
+  return execution_context.state == nullptr ? word_t{0} : execution_context.state->BalanceOf(ToAddress(address));
+}
+
+auto AccountCodeSize(auto const& execution_context, word_t const& address) -> word_t {
+  return execution_context.state == nullptr ? word_t{0} : word_t{execution_context.state->CodeSizeAt(ToAddress(address))};
+}
+
+auto LoadFromCallData(auto& execution_context) -> void {
+  // CALLDATALOAD <offset>
+  // Load word from call data
+
+  if (execution_context.stack.size() < 1) {
+    throw Revert{"CALLDATALOAD", RevertError::kStackUnderflow};
+  }
+
+  auto const offset{execution_context.stack.top()};
+  execution_context.stack.pop();
+  execution_context.stack.push(CallDataWord(execution_context.calldata, offset));
+}
+
+auto PushCallDataSize(auto& execution_context) -> void {
+  // CALLDATASIZE
+  // Push size of call data in bytes
+
+  execution_context.stack.push(word_t{execution_context.calldata.size()});
+
+  if (execution_context.stack.size() > kMaxStackSize) {
+    throw Revert{"CALLDATASIZE", RevertError::kStackOverflow};
+  }
+}
+
+auto LoadFromStorage(auto& execution_context) -> void {
+  // SLOAD <key>
+  // Load word from storage
+
+  if (execution_context.stack.size() < 1) {
+    throw Revert{"SLOAD", RevertError::kStackUnderflow};
+  }
+
+  auto const key{execution_context.stack.top()};
+  execution_context.stack.pop();
+  execution_context.stack.push(StorageSlot(execution_context, key));
+}
+
+auto LoadBalance(auto& execution_context) -> void {
+  // BALANCE <address>
+  // Load balance of account
+
+  if (execution_context.stack.size() < 1) {
+    throw Revert{"BALANCE", RevertError::kStackUnderflow};
+  }
+
+  auto const address{execution_context.stack.top()};
+  execution_context.stack.pop();
+  execution_context.stack.push(AccountBalance(execution_context, address));
+}
+
+auto LoadExternalCodeSize(auto& execution_context) -> void {
+  // EXTCODESIZE <address>
+  // Load size of account code in bytes
+
+  if (execution_context.stack.size() < 1) {
+    throw Revert{"EXTCODESIZE", RevertError::kStackUnderflow};
+  }
+
+  auto const address{execution_context.stack.top()};
+  execution_context.stack.pop();
+  execution_context.stack.push(AccountCodeSize(execution_context, address));
+}
+
+auto StoreToStorage(auto& execution_context) -> void {
+  // SSTORE <key> <value>
+  // Save word to storage
+
+  if (execution_context.stack.size() < 2) {
+    throw Revert{"SSTORE", RevertError::kStackUnderflow};
+  }
+
+  auto const key{execution_context.stack.top()};
+  execution_context.stack.pop();
+  auto const value{execution_context.stack.top()};
+  execution_context.stack.pop();
+  execution_context.storage_writes.insert_or_assign(key, value);
+}
+
+// Appends a log of the `size` memory bytes at `offset` with `topics` to the execution's arena, after charging its data.
+auto AppendLog(auto& execution_context, word_t const& offset, word_t const& size, std::span<word_t const> topics) -> void {
+  auto const memory_offset{MemoryRangeOffset(offset, size, "LOGn")};
+  // at most kMemorySize once the range is in bounds
+  auto const data_size{static_cast<std::size_t>(size)};
+  if (execution_context.gas_left / kLogDataByteGas < data_size) {
+    throw Revert{"LOGn", RevertError::kGasExceeded};
+  }
+  execution_context.gas_left -= kLogDataByteGas * data_size;
+  execution_context.logs->Append(execution_context.address, topics, std::as_bytes(std::span{execution_context.memory}).subspan(memory_offset, data_size));
+}
+
+template <std::size_t topic_count>
+auto EmitLog(auto& execution_context) -> void {
+  // LOGn <offset> <size> <topic 0> ... <topic n - 1>
+  // Append a log of memory bytes and n topics
+
+  if (execution_context.stack.size() < 2 + topic_count) {
+    throw Revert{"LOGn", RevertError::kStackUnderflow};
+  }
+
+  auto const offset{execution_context.stack.top()};
+  execution_context.stack.pop();
+  auto const size{execution_context.stack.top()};
+  execution_context.stack.pop();
+  std::array<word_t, topic_count> topics{};
+  for (auto& topic : topics) {
+    topic = execution_context.stack.top();
+    execution_context.stack.pop();
+  }
+  AppendLog(execution_context, offset, size, topics);
+}
+
+// Top-of-stack caching
+//
+// The handlers below mirror the ones above but keep the topmost (up to two) stack words in a
+// `TopOfStack` that lives as a local of the dispatch loop instead of in execution_context.stack.
+// All handlers are inlined into a single switch, so the compiler is free to keep the cached words in
+// registers across dispatch and binary operations never round-trip through the std::stack. Words
+// below the cache stay in execution_context.stack; `Spill` writes the cache back whenever the plain
+// stack has to be observed (tracing, end of execution, errors).
+namespace tos {
+
+struct TopOfStack {
+  word_t first{};   // topmost word, valid if depth >= 1
+  word_t second{};  // valid if depth == 2
+  std::size_t depth{0};
+};
+
+auto Size(auto const& execution_context, TopOfStack const& tos) -> std::size_t { return execution_context.stack.size() + tos.depth; }
+
+auto Spill(auto& execution_context, TopOfStack& tos) -> void {
+  if (tos.depth == 2) {
+    execution_context.stack.push(tos.second);
+  }
+  if (tos.depth >= 1) {
+    execution_context.stack.push(tos.first);
+  }
+  tos.depth = 0;
+}
+
+// Pull words from execution_context.stack until `count` words are cached; the caller checks the stack is deep enough.
+auto Fill(auto& execution_context, TopOfStack& tos, std::size_t count) -> void {
+  if (tos.depth == 0 and count >= 1) {
+    tos.first = execution_context.stack.top();
+    execution_context.stack.pop();
+    tos.depth = 1;
+  }
+  if (tos.depth == 1 and count == 2) {
+    tos.second = execution_context.stack.top();
+    execution_context.stack.pop();
+    tos.depth = 2;
+  }
+}
+
+auto Push(auto& execution_context, TopOfStack& tos, word_t const& word) -> void {
+  if (tos.depth == 2) {
+    execution_context.stack.push(tos.second);
+  }
+  tos.second = tos.first;
+  tos.first = word;
+  tos.depth = std::min<std::size_t>(tos.depth + 1, 2);
+}
+
+auto Pop(auto& execution_context, TopOfStack& tos) -> word_t {
+  Fill(execution_context, tos, 1);
+  auto const word{tos.first};
+  tos.first = tos.second;
+  tos.depth--;
+  return word;
+}
+
+template <std::size_t num_bytes>
+auto PushToStack(auto& execution_context, TopOfStack& tos) -> void {
+  word_t stack_item{0};
+
+  if constexpr (num_bytes) {
+    // immediate data cut short by the end of the code reads as zeros
+    auto const data_begin{execution_context.program_counter + 1};
+    auto const available{data_begin < execution_context.bytecode.size() ? execution_context.bytecode.size() - data_begin : 0};
+    std::array<std::uint8_t, num_bytes> stack_item_bytes{};
+    std::memcpy(stack_item_bytes.data(), execution_context.bytecode.data() + data_begin, std::min(num_bytes, available));
+    stack_item = to_uint256(stack_item_bytes);
+  }
+
+  Push(execution_context, tos, stack_item);
+
+  if (Size(execution_context, tos) > kMaxStackSize) {
+    throw Revert{"PUSHn", RevertError::kStackOverflow};
+  }
+}
+
+auto Jump(auto& execution_context, TopOfStack& tos) -> void {
+  if (Size(execution_context, tos) < 1) {
+    throw Revert{"JUMP", RevertError::kStackUnderflow};
+  }
+
+  JumpTo(execution_context, Pop(execution_context, tos), "JUMP");
+}
+
+auto ConditionalJump(auto& execution_context, TopOfStack& tos) -> void {
+  if (Size(execution_context, tos) < 2) {
+    throw Revert{"JUMPI", RevertError::kStackUnderflow};
+  }
+
+  Fill(execution_context, tos, 2);
+  auto const counter{tos.first};
+  auto const condition{tos.second};
+  tos.depth = 0;
+
+  if (condition != 0) {
+    JumpTo(execution_context, counter, "JUMPI");
+  }
+}
+
+auto StoreToMemory(auto& execution_context, TopOfStack& tos) -> void {
+  if (Size(execution_context, tos) < 2) {
+    throw Revert{"MSTORE", RevertError::kStackUnderflow};
+  }
+
+  Fill(execution_context, tos, 2);
+  auto const offset{tos.first};
+  auto const value{tos.second};
+  tos.depth = 0;
+
+  auto const memory_offset{MemoryOffset(offset, "MSTORE")};
+  StoreWord(std::next(std::data(execution_context.memory), memory_offset), value);
+  execution_context.memory_size = std::max(execution_context.memory_size, memory_offset + kWordSize);
+}
+
+auto LoadFromMemory(auto& execution_context, TopOfStack& tos) -> void {
+  if (Size(execution_context, tos) < 1) {
+    throw Revert{"MLOAD", RevertError::kStackUnderflow};
+  }
+
+  Fill(execution_context, tos, 1);
+  tos.first = LoadWord(std::next(std::data(execution_context.memory), MemoryOffset(tos.first, "MLOAD")));
+}
+
+auto SwapStackValues(auto& execution_context, TopOfStack& tos) -> void {
+  if (Size(execution_context, tos) < 2) {
+    throw Revert{"SWAPn", RevertError::kStackUnderflow};
+  }
+
+  Fill(execution_context, tos, 2);
+  std::swap(tos.first, tos.second);
+}
+
+template <std::size_t idx>
+auto DuplicateStackValue(auto& execution_context, TopOfStack& tos) -> void {
+  if (Size(execution_context, tos) < idx) {
+    throw Revert{"DUPn", RevertError::kStackUnderflow};
+  }
+
+  word_t value{};
+  if (idx <= tos.depth) {
+    value = (idx == 1) ? tos.first : tos.second;
+  } else {
+    // the word is below the cache: fall back to walking execution_context.stack
+    Spill(execution_context, tos);
+    std::array<word_t, idx> stack_contents_window{};
+    std::ranges::for_each(stack_contents_window, [&execution_context](auto& elem) {
+      elem = execution_context.stack.top();
+      execution_context.stack.pop();
+    });
+    std::ranges::for_each(stack_contents_window | std::views::reverse, [&execution_context](auto const& elem) { execution_context.stack.push(elem); });
+    value = stack_contents_window.back();
+  }
+
+  Push(execution_context, tos, value);
+
+  if (Size(execution_context, tos) > kMaxStackSize) {
+    throw Revert{"DUPn", RevertError::kStackOverflow};
+  }
+}
+
+auto ShiftLeft(auto& execution_context, TopOfStack& tos) -> void {
+  if (Size(execution_context, tos) < 2) {
+    throw Revert{"SHL", RevertError::kStackUnderflow};
+  }
+
+  Fill(execution_context, tos, 2);
+  tos.first = tos.second << tos.first;
+  tos.depth = 1;
+}
+
+auto ShiftRight(auto& execution_context, TopOfStack& tos) -> void {
+  if (Size(execution_context, tos) < 2) {
+    throw Revert{"SHR", RevertError::kStackUnderflow};
+  }
+
+  Fill(execution_context, tos, 2);
+  tos.first = tos.second >> tos.first;
+  tos.depth = 1;
+}
+
+template <typename Operation>
+auto ApplyBinaryOperation(auto& execution_context, TopOfStack& tos) -> void {
+  if (Size(execution_context, tos) < 2) {
+    throw Revert{"BINOP", RevertError::kStackUnderflow};
+  }
+
+  Fill(execution_context, tos, 2);
+  tos.first = word_t{Operation{}(tos.first, tos.second)};
+  tos.depth = 1;
+}
+
+template <typename Operation>
+auto ApplyUnaryOperation(auto& execution_context, TopOfStack& tos) -> void {
+  if (Size(execution_context, tos) < 1) {
+    throw Revert{"UNOP", RevertError::kStackUnderflow};
+  }
+
+  Fill(execution_context, tos, 1);
+  tos.first = word_t{Operation{}(tos.first)};
+}
+
+auto PopFromStack(auto& execution_context, TopOfStack& tos) -> void {
+  if (Size(execution_context, tos) < 1) {
+    throw Revert{"POP", RevertError::kStackUnderflow};
+  }
+
+  Pop(execution_context, tos);
+}
+
+auto LoadFromCallData(auto& execution_context, TopOfStack& tos) -> void {
+  if (Size(execution_context, tos) < 1) {
+    throw Revert{"CALLDATALOAD", RevertError::kStackUnderflow};
+  }
+
+  Fill(execution_context, tos, 1);
+  tos.first = CallDataWord(execution_context.calldata, tos.first);
+}
+
+auto PushCallDataSize(auto& execution_context, TopOfStack& tos) -> void {
+  Push(execution_context, tos, word_t{execution_context.calldata.size()});
+
+  if (Size(execution_context, tos) > kMaxStackSize) {
+    throw Revert{"CALLDATASIZE", RevertError::kStackOverflow};
+  }
+}
+
+auto LoadFromStorage(auto& execution_context, TopOfStack& tos) -> void {
+  if (Size(execution_context, tos) < 1) {
+    throw Revert{"SLOAD", RevertError::kStackUnderflow};
+  }
+
+  Fill(execution_context, tos, 1);
+  tos.first = StorageSlot(execution_context, tos.first);
+}
+
+auto LoadBalance(auto& execution_context, TopOfStack& tos) -> void {
+  if (Size(execution_context, tos) < 1) {
+    throw Revert{"BALANCE", RevertError::kStackUnderflow};
+  }
+
+  Fill(execution_context, tos, 1);
+  tos.first = AccountBalance(execution_context, tos.first);
+}
+
+auto LoadExternalCodeSize(auto& execution_context, TopOfStack& tos) -> void {
+  if (Size(execution_context, tos) < 1) {
+    throw Revert{"EXTCODESIZE", RevertError::kStackUnderflow};
+  }
+
+  Fill(execution_context, tos, 1);
+  tos.first = AccountCodeSize(execution_context, tos.first);
+}
+
+auto StoreToStorage(auto& execution_context, TopOfStack& tos) -> void {
+  if (Size(execution_context, tos) < 2) {
+    throw Revert{"SSTORE", RevertError::kStackUnderflow};
+  }
+
+  Fill(execution_context, tos, 2);
+  execution_context.storage_writes.insert_or_assign(tos.first, tos.second);
+  tos.depth = 0;
+}
+
+template <std::size_t topic_count>
+auto EmitLog(auto& execution_context, TopOfStack& tos) -> void {
+  if (Size(execution_context, tos) < 2 + topic_count) {
+    throw Revert{"LOGn", RevertError::kStackUnderflow};
+  }
+
+  auto const offset{Pop(execution_context, tos)};
+  auto const size{Pop(execution_context, tos)};
+  std::array<word_t, topic_count> topics{};
+  for (auto& topic : topics) {
+    topic = Pop(execution_context, tos);
+  }
+  AppendLog(execution_context, offset, size, topics);
+}
+
+}  // namespace tos
+
+
+auto HashBytecode(std::span<std::byte const> bytecode) -> std::size_t {
+  return std::hash<std::string_view>{}(std::string_view{reinterpret_cast<char const*>(bytecode.data()), bytecode.size()});
+}
+
+auto FindTranslatedCode(std::size_t code_hash, std::span<std::byte const> bytecode) -> aot::TranslatedCode const* {
+  static auto const kTranslatedCodeByHash{[] {
+    std::unordered_map<std::size_t, aot::TranslatedCode const*> translated_code_by_hash{};
+    for (auto const& translated_code : aot::TranslatedContracts()) {
+      translated_code_by_hash.emplace(HashBytecode(translated_code.bytecode), &translated_code);
+    }
+    return translated_code_by_hash;
+  }()};
+
+  auto const translated_code{kTranslatedCodeByHash.find(code_hash)};
+  if (translated_code == std::end(kTranslatedCodeByHash) or not std::ranges::equal(translated_code->second->bytecode, bytecode)) {
+    return nullptr;
+  }
+  return translated_code->second;
+}
+
+}  // namespace
+
+#if defined(__x86_64__)
+// Baseline JIT
+//
+// Every basic block found by AnalyzeCode() is compiled into its own native function that operates on
+// a BlockFrame. Stack slots are addressed relative to the stack top on block entry (the height change
+// is tracked at compile time and written back once per exit) and the block's whole gas cost is
+// charged up front. Only the happy path is native: whenever a block cannot run to its end (not enough
+// gas or stack, out-of-range memory offset, invalid jump target) it takes a side exit that restores
+// the state before the offending instruction and lets the interpreter single-step from there, so all
+// errors are reported by the interpreter exactly as without the JIT.
+namespace jit {
+
+enum class Register : std::uint8_t { kRax = 0, kRcx = 1, kRdx = 2, kRbx = 3, kRsp = 4, kRdi = 7, kR12 = 12, kR13 = 13 };
+enum class Condition : std::uint8_t { kBelow = 0x2, kAboveOrEqual = 0x3, kEqual = 0x4, kNotEqual = 0x5, kAbove = 0x7 };
+
+// Encoder for the handful of x86-64 instructions the block compiler needs. Memory operands are always
+// [base + disp32] or [base + index + disp32].
+class X86Emitter {
+ public:
+  // ALU ops in their `op r64, r/m64` form
+  static constexpr std::uint8_t kAdd{0x03};
+  static constexpr std::uint8_t kAdc{0x13};
+  static constexpr std::uint8_t kSub{0x2b};
+  static constexpr std::uint8_t kSbb{0x1b};
+  static constexpr std::uint8_t kAnd{0x23};
+  static constexpr std::uint8_t kOr{0x0b};
+  static constexpr std::uint8_t kXor{0x33};
+  static constexpr std::uint8_t kCmp{0x3b};
+  static constexpr std::uint8_t kMov{0x8b};
+
+  auto Code() const -> std::span<std::uint8_t const> { return m_code; }
+  auto Size() const -> std::size_t { return m_code.size(); }
+
+  auto Load(Register dst, Register base, std::int32_t disp) -> void { EmitMemoryOperand({}, true, {kMov}, Index(dst), base, std::nullopt, disp); }
+  auto Load(Register dst, Register base, Register index, std::int32_t disp) -> void { EmitMemoryOperand({}, true, {kMov}, Index(dst), base, index, disp); }
+  auto Store(Register base, std::int32_t disp, Register src) -> void { EmitMemoryOperand({}, true, {0x89}, Index(src), base, std::nullopt, disp); }
+  auto Store(Register base, Register index, std::int32_t disp, Register src) -> void { EmitMemoryOperand({}, true, {0x89}, Index(src), base, index, disp); }
+  auto Arithmetic(std::uint8_t operation, Register dst, Register base, std::int32_t disp) -> void { EmitMemoryOperand({}, true, {operation}, Index(dst), base, std::nullopt, disp); }
+  auto Lea(Register dst, Register base, std::int32_t disp) -> void { EmitMemoryOperand({}, true, {0x8d}, Index(dst), base, std::nullopt, disp); }
+  auto StoreImmediate(Register base, std::int32_t disp, std::int32_t immediate) -> void {
+    EmitMemoryOperand({}, true, {0xc7}, 0, base, std::nullopt, disp);
+    EmitImmediate32(immediate);
+  }
+  auto AddImmediate(Register base, std::int32_t disp, std::int32_t immediate) -> void {
+    EmitMemoryOperand({}, true, {0x81}, 0, base, std::nullopt, disp);
+    EmitImmediate32(immediate);
+  }
+  auto SubImmediate(Register base, std::int32_t disp, std::int32_t immediate) -> void {
+    EmitMemoryOperand({}, true, {0x81}, 5, base, std::nullopt, disp);
+    EmitImmediate32(immediate);
+  }
+  auto Not(Register base, std::int32_t disp) -> void { EmitMemoryOperand({}, true, {0xf7}, 2, base, std::nullopt, disp); }
+  auto MovdquLoad(std::uint8_t xmm, Register base, std::int32_t disp) -> void { EmitMemoryOperand(0xf3, false, {0x0f, 0x6f}, xmm, base, std::nullopt, disp); }
+  auto MovdquStore(Register base, std::int32_t disp, std::uint8_t xmm) -> void { EmitMemoryOperand(0xf3, false, {0x0f, 0x7f}, xmm, base, std::nullopt, disp); }
+  auto LoadByteZeroExtended(Register dst, Register base, Register index) -> void { EmitMemoryOperand({}, false, {0x0f, 0xb6}, Index(dst), base, index, 0); }
+
+  auto Move(Register dst, Register src) -> void { EmitRegisterOperand(true, {0x89}, Index(src), dst); }
+  auto Or(Register dst, Register src) -> void { EmitRegisterOperand(true, {0x09}, Index(src), dst); }
+  auto Test(Register lhs, Register rhs) -> void { EmitRegisterOperand(true, {0x85}, Index(rhs), lhs); }
+  auto Compare(Register lhs, std::int32_t immediate) -> void {
+    EmitRegisterOperand(true, {0x81}, 7, lhs);
+    EmitImmediate32(immediate);
+  }
+  auto Add(Register dst, std::int32_t immediate) -> void {
+    EmitRegisterOperand(true, {0x81}, 0, dst);
+    EmitImmediate32(immediate);
+  }
+  auto ShiftLeft(Register dst, std::uint8_t amount) -> void {
+    EmitRegisterOperand(true, {0xc1}, 4, dst);
+    m_code.push_back(amount);
+  }
+  auto ByteSwap(Register reg) -> void { EmitRegisterOperand(true, {0x0f, static_cast<std::uint8_t>(0xc8 + (Index(reg) & 7))}, 0, reg, false); }
+  // set al to the flag and zero-extend it into rax
+  auto SetFlag(Condition condition) -> void {
+    m_code.insert(std::end(m_code), {0x0f, static_cast<std::uint8_t>(0x90 + std::to_underlying(condition)), 0xc0});
+    m_code.insert(std::end(m_code), {0x48, 0x0f, 0xb6, 0xc0});
+  }
+  auto MoveImmediate(Register dst, std::uint64_t immediate) -> void {
+    m_code.push_back(Rex(true, 0, 0, Index(dst)));
+    m_code.push_back(static_cast<std::uint8_t>(0xb8 + (Index(dst) & 7)));
+    for (std::size_t byte{0}; byte < sizeof(immediate); ++byte) {
+      m_code.push_back(static_cast<std::uint8_t>(immediate >> (byte * kByteSize)));
+    }
+  }
+  auto MoveImmediate32(std::uint32_t immediate) -> void {
+    m_code.push_back(0xb8);
+    EmitImmediate32(static_cast<std::int32_t>(immediate));
+  }
+  auto Push(Register reg) -> void { EmitPushPop(0x50, reg); }
+  auto Pop(Register reg) -> void { EmitPushPop(0x58, reg); }
+  auto Call(Register target) -> void { EmitRegisterOperand(false, {0xff}, 2, target); }
+  auto Return() -> void { m_code.push_back(0xc3); }
+
+  // Forward branches: the returned label is resolved to the current position by Bind().
+  auto JumpIf(Condition condition) -> std::size_t {
+    m_code.insert(std::end(m_code), {0x0f, static_cast<std::uint8_t>(0x80 + std::to_underlying(condition))});
+    return EmitLabel();
+  }
+  auto Jump() -> std::size_t {
+    m_code.push_back(0xe9);
+    return EmitLabel();
+  }
+  auto Bind(std::size_t label) -> void {
+    auto const displacement{static_cast<std::int32_t>(m_code.size() - (label + sizeof(std::int32_t)))};
+    std::memcpy(m_code.data() + label, &displacement, sizeof(displacement));
+  }
+
+ private:
+  std::vector<std::uint8_t> m_code{};
+
+  static constexpr auto Index(Register reg) -> std::uint8_t { return std::to_underlying(reg); }
+  static constexpr auto Rex(bool wide, std::uint8_t reg, std::uint8_t index, std::uint8_t base) -> std::uint8_t {
+    return 0x40 | (wide << 3) | ((reg >> 3) << 2) | ((index >> 3) << 1) | (base >> 3);
+  }
+
+  auto EmitImmediate32(std::int32_t immediate) -> void {
+    for (std::size_t byte{0}; byte < sizeof(immediate); ++byte) {
+      m_code.push_back(static_cast<std::uint8_t>(static_cast<std::uint32_t>(immediate) >> (byte * kByteSize)));
+    }
+  }
+
+  auto EmitLabel() -> std::size_t {
+    auto const label{m_code.size()};
+    EmitImmediate32(0);
+    return label;
+  }
+
+  auto EmitPushPop(std::uint8_t opcode, Register reg) -> void {
+    if (Index(reg) >= 8) {
+      m_code.push_back(Rex(false, 0, 0, Index(reg)));
+    }
+    m_code.push_back(static_cast<std::uint8_t>(opcode + (Index(reg) & 7)));
+  }
+
+  auto EmitRegisterOperand(bool wide, std::initializer_list<std::uint8_t> opcode, std::uint8_t reg, Register rm, bool with_modrm = true) -> void {
+    if (wide or reg >= 8 or Index(rm) >= 8) {
+      m_code.push_back(Rex(wide, reg, 0, Index(rm)));
+    }
+    m_code.insert(std::end(m_code), opcode);
+    if (with_modrm) {
+      m_code.push_back(static_cast<std::uint8_t>(0xc0 | ((reg & 7) << 3) | (Index(rm) & 7)));
+    }
+  }
+
+  // mod = 10 (disp32); a SIB byte is needed for an index register and for rsp/r12 as base
+  auto EmitMemoryOperand(std::optional<std::uint8_t> prefix, bool wide, std::initializer_list<std::uint8_t> opcode, std::uint8_t reg, Register base, std::optional<Register> index,
+                         std::int32_t disp) -> void {
+    if (prefix) {
+      m_code.push_back(*prefix);
+    }
+    auto const index_bits{index ? Index(*index) : std::uint8_t{0}};
+    if (wide or reg >= 8 or index_bits >= 8 or Index(base) >= 8) {
+      m_code.push_back(Rex(wide, reg, index_bits, Index(base)));
+    }
+    m_code.insert(std::end(m_code), opcode);
+    if (index) {
+      m_code.push_back(static_cast<std::uint8_t>(0x80 | ((reg & 7) << 3) | 0x04));
+      m_code.push_back(static_cast<std::uint8_t>(((index_bits & 7) << 3) | (Index(base) & 7)));
+    } else if ((Index(base) & 7) == 4) {
+      m_code.push_back(static_cast<std::uint8_t>(0x80 | ((reg & 7) << 3) | 0x04));
+      m_code.push_back(0x24);
+    } else {
+      m_code.push_back(static_cast<std::uint8_t>(0x80 | ((reg & 7) << 3) | (Index(base) & 7)));
+    }
+    EmitImmediate32(disp);
+  }
+};
+
+// Out-of-line handlers called from jitted code; `top` points at the topmost stack slot.
+auto Multiply(word_t* top) -> void { top[-1] = top[0] * top[-1]; }
+auto ShiftLeft(word_t* top) -> void { top[-1] = top[-1] << top[0]; }
+auto ShiftRight(word_t* top) -> void { top[-1] = top[-1] >> top[0]; }
+
+// Executable copy of finished machine code. Code is written while the mapping is writable and only
+// then made executable, so the region is never writable and executable at the same time.
+class ExecutableCode {
+ public:
+  explicit ExecutableCode(std::span<std::uint8_t const> machine_code) : m_size{std::max<std::size_t>(machine_code.size(), 1)} {
+    m_region = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (m_region == MAP_FAILED) {
+      throw std::runtime_error{"[JIT]: Could not map memory for compiled code."};
+    }
+    std::ranges::copy(machine_code, static_cast<std::uint8_t*>(m_region));
+    if (mprotect(m_region, m_size, PROT_READ | PROT_EXEC) != 0) {
+      munmap(m_region, m_size);
+      throw std::runtime_error{"[JIT]: Could not make compiled code executable."};
+    }
+  }
+  ExecutableCode(ExecutableCode const&) = delete;
+  auto operator=(ExecutableCode const&) -> ExecutableCode& = delete;
+  ~ExecutableCode() { munmap(m_region, m_size); }
+
+  auto At(std::size_t offset) const -> BlockFunction { return reinterpret_cast<BlockFunction>(static_cast<std::uint8_t*>(m_region) + offset); }
+
+ private:
+  void* m_region{nullptr};
+  std::size_t m_size{0};
+};
+
+class CompiledCode {
+ public:
+  CompiledCode(std::vector<std::byte> bytecode, CodeAnalysis analysis, std::span<std::uint8_t const> machine_code, std::vector<std::pair<std::size_t, std::size_t>> const& entries)
+      : m_bytecode{std::move(bytecode)}, m_analysis{std::move(analysis)}, m_executable{machine_code}, m_blocks(m_bytecode.size(), nullptr) {
+    for (auto const& [program_counter, offset] : entries) {
+      m_blocks[program_counter] = m_executable.At(offset);
+    }
+  }
+
+  auto Bytecode() const -> std::vector<std::byte> const& { return m_bytecode; }
+  auto JumpDestinations() const -> std::uint8_t const* { return m_analysis.jump_destinations.data(); }
+  // compiled block starting at `program_counter`, if any
+  auto BlockAt(std::size_t program_counter) const -> BlockFunction { return m_blocks[program_counter]; }
+
+ private:
+  std::vector<std::byte> m_bytecode;
+  CodeAnalysis m_analysis;
+  ExecutableCode m_executable;
+  std::vector<BlockFunction> m_blocks;
+};
+
+class BlockCompiler {
+ public:
+  BlockCompiler(X86Emitter& emitter, std::span<std::byte const> bytecode, BasicBlock const& block) : m_emitter{emitter}, m_bytecode{bytecode}, m_block{block} {}
+
+  auto Compile() -> void {
+    m_emitter.Push(Register::kRbx);
+    m_emitter.Push(Register::kR12);
+    m_emitter.Push(Register::kR13);
+    m_emitter.Move(Register::kR12, Register::kRdi);
+
+    // entry checks: bail out before charging anything if the block could not run to its end
+    auto& entry_exit{m_side_exits.emplace_back(SideExit{.program_counter = m_block.begin})};
+    m_emitter.Load(Register::kRax, Register::kR12, offsetof(BlockFrame, stack_size));
+    m_emitter.Compare(Register::kRax, static_cast<std::int32_t>(m_block.stack_required));
+    entry_exit.labels.push_back(m_emitter.JumpIf(Condition::kBelow));
+    m_emitter.Compare(Register::kRax, static_cast<std::int32_t>(kMaxStackSize - m_block.stack_growth));
+    entry_exit.labels.push_back(m_emitter.JumpIf(Condition::kAbove));
+    m_emitter.Load(Register::kRcx, Register::kR12, offsetof(BlockFrame, gas_left));
+    m_emitter.Compare(Register::kRcx, static_cast<std::int32_t>(m_block.gas_consumed));
+    entry_exit.labels.push_back(m_emitter.JumpIf(Condition::kBelow));
+    m_emitter.SubImmediate(Register::kR12, offsetof(BlockFrame, gas_left), static_cast<std::int32_t>(m_block.gas_consumed));
+
+    // rbx = address one past the topmost slot on entry, r13 = memory
+    m_emitter.ShiftLeft(Register::kRax, 5);
+    m_emitter.Arithmetic(X86Emitter::kAdd, Register::kRax, Register::kR12, offsetof(BlockFrame, stack_base));
+    m_emitter.Move(Register::kRbx, Register::kRax);
+    m_emitter.Load(Register::kR13, Register::kR12, offsetof(BlockFrame, memory));
+
+    m_gas_remaining = m_block.gas_consumed;
+    for (std::size_t pc{m_block.begin}; pc < m_block.end; pc += 1 + ImmediateSize(m_bytecode[pc])) {
+      if (not CompileInstruction(pc)) {
+        break;
+      }
+      m_gas_remaining -= kOpcodeInfo.at(m_bytecode[pc]).gas_consumed;
+    }
+    if (not m_terminated) {
+      EmitExit(BlockExit::kContinue, m_block.end, m_stack_delta);
+    }
+
+    for (auto const& side_exit : m_side_exits) {
+      for (auto const label : side_exit.labels) {
+        m_emitter.Bind(label);
+      }
+      if (side_exit.gas_refund != 0) {
+        m_emitter.AddImmediate(Register::kR12, offsetof(BlockFrame, gas_left), static_cast<std::int32_t>(side_exit.gas_refund));
+      }
+      EmitExit(BlockExit::kSideExit, side_exit.program_counter, side_exit.stack_delta);
+    }
+
+    for (auto const label : m_epilogue_labels) {
+      m_emitter.Bind(label);
+    }
+    m_emitter.Pop(Register::kR13);
+    m_emitter.Pop(Register::kR12);
+    m_emitter.Pop(Register::kRbx);
+    m_emitter.Return();
+  }
+
+ private:
+  struct SideExit {
+    std::vector<std::size_t> labels{};
+    std::size_t program_counter{0};
+    std::ptrdiff_t stack_delta{0};
+    std::size_t gas_refund{0};
+  };
+
+  X86Emitter& m_emitter;
+  std::span<std::byte const> m_bytecode;
+  BasicBlock const& m_block;
+  std::vector<SideExit> m_side_exits{};
+  std::vector<std::size_t> m_epilogue_labels{};
+  std::ptrdiff_t m_stack_delta{0};
+  std::size_t m_gas_remaining{0};
+  bool m_terminated{false};
+
+  // displacement from rbx of the slot `depth` items below the current top
+  auto Slot(std::size_t depth) const -> std::int32_t { return static_cast<std::int32_t>((m_stack_delta - 1 - static_cast<std::ptrdiff_t>(depth)) * static_cast<std::ptrdiff_t>(kWordSize)); }
+  static constexpr auto Limb(std::int32_t slot, std::size_t limb) -> std::int32_t { return slot + static_cast<std::int32_t>(limb * sizeof(std::uint64_t)); }
+
+  // leave the block with the state as it was before the instruction at `program_counter`
+  auto SideExitHere(std::size_t program_counter) -> SideExit& {
+    return m_side_exits.emplace_back(SideExit{.program_counter = program_counter, .stack_delta = m_stack_delta, .gas_refund = m_gas_remaining});
+  }
+
+  auto EmitExit(BlockExit status, std::size_t program_counter, std::ptrdiff_t stack_delta) -> void {
+    if (stack_delta != 0) {
+      m_emitter.AddImmediate(Register::kR12, offsetof(BlockFrame, stack_size), static_cast<std::int32_t>(stack_delta));
+    }
+    m_emitter.StoreImmediate(Register::kR12, offsetof(BlockFrame, program_counter), static_cast<std::int32_t>(program_counter));
+    m_emitter.MoveImmediate32(std::to_underlying(status));
+    m_epilogue_labels.push_back(m_emitter.Jump());
+  }
+
+  // ZF is set iff the word in `slot` is zero; clobbers rax
+  auto TestZero(std::int32_t slot) -> void {
+    m_emitter.Load(Register::kRax, Register::kRbx, Limb(slot, 0));
+    for (std::size_t limb{1}; limb < 4; ++limb) {
+      m_emitter.Arithmetic(X86Emitter::kOr, Register::kRax, Register::kRbx, Limb(slot, limb));
+    }
+  }
+
+  auto StoreFlagAsWord(Condition condition, std::int32_t slot) -> void {
+    m_emitter.SetFlag(condition);
+    m_emitter.Store(Register::kRbx, Limb(slot, 0), Register::kRax);
+    for (std::size_t limb{1}; limb < 4; ++limb) {
+      m_emitter.StoreImmediate(Register::kRbx, Limb(slot, limb), 0);
+    }
+  }
+
+  // rcx = low limb of the memory offset in `slot`; side exit unless a whole word fits in memory there
+  auto CheckMemoryOffset(std::int32_t slot, std::size_t program_counter) -> void {
+    auto& side_exit{SideExitHere(program_counter)};
+    m_emitter.Load(Register::kRax, Register::kRbx, Limb(slot, 1));
+    m_emitter.Arithmetic(X86Emitter::kOr, Register::kRax, Register::kRbx, Limb(slot, 2));
+    m_emitter.Arithmetic(X86Emitter::kOr, Register::kRax, Register::kRbx, Limb(slot, 3));
+    side_exit.labels.push_back(m_emitter.JumpIf(Condition::kNotEqual));
+    m_emitter.Load(Register::kRcx, Register::kRbx, Limb(slot, 0));
+    m_emitter.Compare(Register::kRcx, static_cast<std::int32_t>(kMemorySize - kWordSize));
+    side_exit.labels.push_back(m_emitter.JumpIf(Condition::kAbove));
+  }
+
+  // frame.memory_size = max(frame.memory_size, rcx + kWordSize), for the offset CheckMemoryOffset() left in rcx
+  auto EmitGrowMemorySize() -> void {
+    m_emitter.Add(Register::kRcx, static_cast<std::int32_t>(kWordSize));
+    m_emitter.Arithmetic(X86Emitter::kCmp, Register::kRcx, Register::kR12, offsetof(BlockFrame, memory_size));
+    auto const within{m_emitter.JumpIf(Condition::kBelow)};
+    m_emitter.Store(Register::kR12, offsetof(BlockFrame, memory_size), Register::kRcx);
+    m_emitter.Bind(within);
+  }
+
+  // Jump to the counter in the topmost slot, resuming after its JUMPDEST and charging its gas. Invalid
+  // targets and a JUMPDEST the gas left cannot pay for side exit so the interpreter reports them.
+  auto EmitJump(std::size_t program_counter, std::ptrdiff_t stack_delta_after) -> void {
+    auto& side_exit{SideExitHere(program_counter)};
+    auto const counter{Slot(0)};
+    m_emitter.Load(Register::kRax, Register::kRbx, Limb(counter, 1));
+    m_emitter.Arithmetic(X86Emitter::kOr, Register::kRax, Register::kRbx, Limb(counter, 2));
+    m_emitter.Arithmetic(X86Emitter::kOr, Register::kRax, Register::kRbx, Limb(counter, 3));
+    side_exit.labels.push_back(m_emitter.JumpIf(Condition::kNotEqual));
+    m_emitter.Load(Register::kRcx, Register::kRbx, Limb(counter, 0));
+    m_emitter.Arithmetic(X86Emitter::kCmp, Register::kRcx, Register::kR12, offsetof(BlockFrame, code_size));
+    side_exit.labels.push_back(m_emitter.JumpIf(Condition::kAboveOrEqual));
+    m_emitter.Load(Register::kRdx, Register::kR12, offsetof(BlockFrame, jump_destinations));
+    m_emitter.LoadByteZeroExtended(Register::kRax, Register::kRdx, Register::kRcx);
+    m_emitter.Test(Register::kRax, Register::kRax);
+    side_exit.labels.push_back(m_emitter.JumpIf(Condition::kEqual));
+    m_emitter.Load(Register::kRax, Register::kR12, offsetof(BlockFrame, gas_left));
+    m_emitter.Compare(Register::kRax, static_cast<std::int32_t>(kJumpDestGas));
+    side_exit.labels.push_back(m_emitter.JumpIf(Condition::kBelow));
+
+    m_emitter.SubImmediate(Register::kR12, offsetof(BlockFrame, gas_left), static_cast<std::int32_t>(kJumpDestGas));
+    m_emitter.Add(Register::kRcx, 1);
+    m_emitter.Store(Register::kR12, offsetof(BlockFrame, program_counter), Register::kRcx);
+    m_emitter.AddImmediate(Register::kR12, offsetof(BlockFrame, stack_size), static_cast<std::int32_t>(stack_delta_after));
+    m_emitter.MoveImmediate32(std::to_underlying(BlockExit::kContinue));
+    m_epilogue_labels.push_back(m_emitter.Jump());
+  }
+
+  auto EmitBinaryArithmetic(std::uint8_t first_limb_operation, std::uint8_t next_limbs_operation) -> void {
+    for (std::size_t limb{0}; limb < 4; ++limb) {
+      m_emitter.Load(Register::kRax, Register::kRbx, Limb(Slot(0), limb));
+      m_emitter.Arithmetic(limb == 0 ? first_limb_operation : next_limbs_operation, Register::kRax, Register::kRbx, Limb(Slot(1), limb));
+      m_emitter.Store(Register::kRbx, Limb(Slot(1), limb), Register::kRax);
+    }
+    m_stack_delta--;
+  }
+
+  // CF = lhs < rhs over the full 256 bits
+  auto EmitLessThan(std::int32_t lhs, std::int32_t rhs) -> void {
+    for (std::size_t limb{0}; limb < 4; ++limb) {
+      m_emitter.Load(Register::kRax, Register::kRbx, Limb(lhs, limb));
+      m_emitter.Arithmetic(limb == 0 ? X86Emitter::kSub : X86Emitter::kSbb, Register::kRax, Register::kRbx, Limb(rhs, limb));
+    }
+  }
+
+  auto EmitCall(void (*helper)(word_t*)) -> void {
+    m_emitter.Lea(Register::kRdi, Register::kRbx, Slot(0));
+    m_emitter.MoveImmediate(Register::kRax, reinterpret_cast<std::uint64_t>(helper));
+    m_emitter.Call(Register::kRax);
+    m_stack_delta--;
+  }
+
+  // returns false for opcodes left to the interpreter
+  auto CompileInstruction(std::size_t pc) -> bool {
+    auto const opcode{m_bytecode[pc]};
+
+    if (auto const num_bytes{ImmediateSize(opcode)}; num_bytes != 0 or opcode == kPush0) {
+      word_t value{0};
+      if (num_bytes != 0) {
+        value = to_uint256(std::span{reinterpret_cast<std::uint8_t const*>(m_bytecode.data() + pc + 1), num_bytes});
+      }
+      m_stack_delta++;
+      for (std::size_t limb{0}; limb < 4; ++limb) {
+        if (value[limb] <= static_cast<std::uint64_t>(std::numeric_limits<std::int32_t>::max())) {
+          m_emitter.StoreImmediate(Register::kRbx, Limb(Slot(0), limb), static_cast<std::int32_t>(value[limb]));
+        } else {
+          m_emitter.MoveImmediate(Register::kRax, value[limb]);
+          m_emitter.Store(Register::kRbx, Limb(Slot(0), limb), Register::kRax);
+        }
+      }
+      return true;
+    }
+
+    switch (opcode) {
+      case kStop:
+        EmitExit(BlockExit::kStop, pc + 1, m_stack_delta);
+        m_terminated = true;
+        return false;
+      case kAdd:
+        EmitBinaryArithmetic(X86Emitter::kAdd, X86Emitter::kAdc);
+        return true;
+      case kSub:
+        EmitBinaryArithmetic(X86Emitter::kSub, X86Emitter::kSbb);
+        return true;
+      case kAnd:
+        EmitBinaryArithmetic(X86Emitter::kAnd, X86Emitter::kAnd);
+        return true;
+      case kOr:
+        EmitBinaryArithmetic(X86Emitter::kOr, X86Emitter::kOr);
+        return true;
+      case kXor:
+        EmitBinaryArithmetic(X86Emitter::kXor, X86Emitter::kXor);
+        return true;
+      case kMul:
+        EmitCall(&Multiply);
+        return true;
+      case kShl:
+        EmitCall(&ShiftLeft);
+        return true;
+      case kShr:
+        EmitCall(&ShiftRight);
+        return true;
+      case kLt:
+        EmitLessThan(Slot(0), Slot(1));
+        StoreFlagAsWord(Condition::kBelow, Slot(1));
+        m_stack_delta--;
+        return true;
+      case kGt:
+        EmitLessThan(Slot(1), Slot(0));
+        StoreFlagAsWord(Condition::kBelow, Slot(1));
+        m_stack_delta--;
+        return true;
+      case kEq:
+        m_emitter.Load(Register::kRax, Register::kRbx, Limb(Slot(0), 0));
+        m_emitter.Arithmetic(X86Emitter::kXor, Register::kRax, Register::kRbx, Limb(Slot(1), 0));
+        for (std::size_t limb{1}; limb < 4; ++limb) {
+          m_emitter.Load(Register::kRcx, Register::kRbx, Limb(Slot(0), limb));
+          m_emitter.Arithmetic(X86Emitter::kXor, Register::kRcx, Register::kRbx, Limb(Slot(1), limb));
+          m_emitter.Or(Register::kRax, Register::kRcx);
+        }
+        StoreFlagAsWord(Condition::kEqual, Slot(1));
+        m_stack_delta--;
+        return true;
+      case kIsZero:
+        TestZero(Slot(0));
+        StoreFlagAsWord(Condition::kEqual, Slot(0));
+        return true;
+      case kNot:
+        for (std::size_t limb{0}; limb < 4; ++limb) {
+          m_emitter.Not(Register::kRbx, Limb(Slot(0), limb));
+        }
+        return true;
+      case kPop:
+        m_stack_delta--;
+        return true;
+      case kMLoad:
+        CheckMemoryOffset(Slot(0), pc);
+        for (std::size_t limb{0}; limb < 4; ++limb) {
+          m_emitter.Load(Register::kRax, Register::kR13, Register::kRcx, static_cast<std::int32_t>(kWordSize - (limb + 1) * sizeof(std::uint64_t)));
+          m_emitter.ByteSwap(Register::kRax);
+          m_emitter.Store(Register::kRbx, Limb(Slot(0), limb), Register::kRax);
+        }
+        return true;
+      case kMStore:
+        CheckMemoryOffset(Slot(0), pc);
+        for (std::size_t limb{0}; limb < 4; ++limb) {
+          m_emitter.Load(Register::kRax, Register::kRbx, Limb(Slot(1), limb));
+          m_emitter.ByteSwap(Register::kRax);
+          m_emitter.Store(Register::kR13, Register::kRcx, static_cast<std::int32_t>(kWordSize - (limb + 1) * sizeof(std::uint64_t)), Register::kRax);
+        }
+        EmitGrowMemorySize();
+        m_stack_delta -= 2;
+        return true;
+      case kJump:
+        EmitJump(pc, m_stack_delta - 1);
+        m_terminated = true;
+        return false;
+      case kJumpI: {
+        TestZero(Slot(1));
+        auto const not_taken{m_emitter.JumpIf(Condition::kEqual)};
+        EmitJump(pc, m_stack_delta - 2);
+        m_emitter.Bind(not_taken);
+        EmitExit(BlockExit::kContinue, pc + 1, m_stack_delta - 2);
+        m_terminated = true;
+        return false;
+      }
+      case kJumpDest:
+        return true;
+      case kDup1:
+      case kDup2:
+      case kDup3: {
+        auto const source{Slot(static_cast<std::size_t>(opcode) - static_cast<std::size_t>(kDup1))};
+        m_stack_delta++;
+        m_emitter.MovdquLoad(0, Register::kRbx, source);
+        m_emitter.MovdquLoad(1, Register::kRbx, source + 16);
+        m_emitter.MovdquStore(Register::kRbx, Slot(0), 0);
+        m_emitter.MovdquStore(Register::kRbx, Slot(0) + 16, 1);
+        return true;
+      }
+      case kSwap1:
+        m_emitter.MovdquLoad(0, Register::kRbx, Slot(0));
+        m_emitter.MovdquLoad(1, Register::kRbx, Slot(0) + 16);
+        m_emitter.MovdquLoad(2, Register::kRbx, Slot(1));
+        m_emitter.MovdquLoad(3, Register::kRbx, Slot(1) + 16);
+        m_emitter.MovdquStore(Register::kRbx, Slot(1), 0);
+        m_emitter.MovdquStore(Register::kRbx, Slot(1) + 16, 1);
+        m_emitter.MovdquStore(Register::kRbx, Slot(0), 2);
+        m_emitter.MovdquStore(Register::kRbx, Slot(0) + 16, 3);
+        return true;
+      default:
+        // not reached: AnalyzeCode() ends blocks before opcodes missing from kOpcodeInfo
+        EmitExit(BlockExit::kSideExit, pc, m_stack_delta);
+        m_terminated = true;
+        return false;
+    }
+  }
+};
+
+auto Compile(std::vector<std::byte> bytecode) -> std::unique_ptr<CompiledCode> {
+  auto analysis{AnalyzeCode(bytecode)};
+
+  X86Emitter emitter{};
+  std::vector<std::pair<std::size_t, std::size_t>> entries{};
+  for (auto const& block : analysis.basic_blocks) {
+    if (block.stack_growth > kMaxStackSize) {
+      continue;
+    }
+    entries.emplace_back(block.begin, emitter.Size());
+    BlockCompiler{emitter, bytecode, block}.Compile();
+  }
+
+  return std::make_unique<CompiledCode>(std::move(bytecode), std::move(analysis), emitter.Code(), entries);
+}
+
+}  // namespace jit
+#endif
+
+Interpreter::Interpreter(InterpreterOptions options) : m_options{options} { m_execution_context.logs = &m_logs; }
+
+Interpreter::~Interpreter() = default;
+
+#if defined(__x86_64__)
+Interpreter::TierState::~TierState() = default;
+#endif
+
+auto Interpreter::Execute(ExecutionRequest const& request) -> ExecutionResult {
+  m_logs.Clear();
+  if (request.storage_writes != nullptr) {
+    request.storage_writes->clear();
+  }
+  // calls to a precompiled contract run it natively, on the call data in place, whatever code the account holds
+  if (auto const* const precompile{precompile::Find(request.address)}) {
+    auto const gas{precompile->gas(request.calldata)};
+    if (gas > request.gas_limit) {
+      return {.status = ExecutionStatus::kGasExceeded, .gas_used = request.gas_limit};
+    }
+    ExecutionResult result{.gas_used = gas};
+    if (not precompile->run(request.calldata, result.output)) {
+      return {.status = ExecutionStatus::kPrecompileFailure, .gas_used = request.gas_limit};
+    }
+    return result;
+  }
+  m_execution_context.bytecode = request.code;
+  m_execution_context.jump_destinations.clear();
+  m_execution_context.calldata = request.calldata;
+  m_code_hash.reset();
+  AttachState(request.state, request.address);
+  m_execution_context.logs = request.logs != nullptr ? request.logs : &m_logs;
+  m_log_checkpoint = m_execution_context.logs->Checkpoint();
+  Reset(request.gas_limit);
+  m_gas_limit = request.gas_limit;
+  m_dispatch_mode = request.dispatch_mode;
+  m_storage_write_buffer = request.storage_writes;
+  return Resume();
+}
+
+auto Interpreter::Resume() -> ExecutionResult {
+  m_status = ExecutionStatus::kSuccess;
+  m_error_message.clear();
+  auto const succeeded{Interpret(m_dispatch_mode)};
+  if (not succeeded and m_status == ExecutionStatus::kStateMissing) {
+    m_suspended = true;
+    return {.status = m_status, .gas_used = m_gas_limit - m_execution_context.gas_left};
+  }
+  m_suspended = false;
+  // nothing borrowed from the request may outlive the execution
+  m_execution_context.bytecode = {};
+  m_execution_context.jump_destinations.clear();
+  m_execution_context.calldata = {};
+  m_code_hash.reset();
+  AttachState(nullptr);
+  // a failed execution emits nothing
+  if (not succeeded) {
+    m_execution_context.logs->RollbackTo(m_log_checkpoint);
+  }
+  m_execution_context.logs = &m_logs;
+  m_log_checkpoint = {};
+  if (not succeeded) {
+    return {.status = m_status, .gas_used = m_gas_limit};
+  }
+  if (auto* const storage_write_buffer{std::exchange(m_storage_write_buffer, nullptr)}; storage_write_buffer != nullptr) {
+    storage_write_buffer->assign(std::begin(m_execution_context.storage_writes), std::end(m_execution_context.storage_writes));
+    return {.gas_used = m_gas_limit - m_execution_context.gas_left};
+  }
+  return {.gas_used = m_gas_limit - m_execution_context.gas_left, .storage_writes = std::move(m_execution_context.storage_writes)};
+}
+
+auto Interpreter::LoadBytecode(bytecode_t bytecode) -> void {
+  m_bytecode = std::move(bytecode);
+  m_execution_context.bytecode = m_bytecode;
+  m_execution_context.jump_destinations.clear();
+  m_code_hash.reset();
+}
+
+auto Interpreter::Interpret(DispatchMode dispatch_mode) -> bool {
+  switch (dispatch_mode) {
+    case DispatchMode::kTopOfStackCached:
+      return InterpretCachingTopOfStack();
+    case DispatchMode::kTiered:
+      return InterpretTiered();
+    case DispatchMode::kHandlerTable:
+      break;
+  }
+  return InterpretViaHandlerTable();
+}
+
+std::unordered_map<opcode_t, auto (*)(Interpreter::ExecutionContext&) -> void> const Interpreter::kOpcodeHandlers{
+    {kJump, &Jump},
+    {kDup3, &DuplicateStackValue<3>},
+    {kPush2, &PushToStack<2>},
+    {kPush0, &PushToStack<0>},
+    {kMLoad, &LoadFromMemory},
+    {kShl, &ShiftLeft},
+    {kPush12, &PushToStack<12>},
+    {kPush1, &PushToStack<1>},
+    {kPush32, &PushToStack<32>},
+    {kMStore, &StoreToMemory},
+    {kSwap1, &SwapStackValues},
+    {kDup2, &DuplicateStackValue<2>},
+    {kStop, &Stop},
+    {kAdd, &ApplyBinaryOperation<std::plus<>>},
+    {kMul, &ApplyBinaryOperation<std::multiplies<>>},
+    {kSub, &ApplyBinaryOperation<std::minus<>>},
+    {kLt, &ApplyBinaryOperation<std::less<>>},
+    {kGt, &ApplyBinaryOperation<std::greater<>>},
+    {kEq, &ApplyBinaryOperation<std::equal_to<>>},
+    {kIsZero, &ApplyUnaryOperation<std::logical_not<>>},
+    {kAnd, &ApplyBinaryOperation<std::bit_and<>>},
+    {kOr, &ApplyBinaryOperation<std::bit_or<>>},
+    {kXor, &ApplyBinaryOperation<std::bit_xor<>>},
+    {kNot, &ApplyUnaryOperation<std::bit_not<>>},
+    {kShr, &ShiftRight},
+    {kPop, &PopFromStack},
+    {kJumpI, &ConditionalJump},
+    {kJumpDest, &JumpDestination},
+    {kDup1, &DuplicateStackValue<1>},
+    {kCallDataLoad, &LoadFromCallData},
+    {kCallDataSize, &PushCallDataSize},
+    {kBalance, &LoadBalance},
+    {kExtCodeSize, &LoadExternalCodeSize},
+    {kSLoad, &LoadFromStorage},
+    {kSStore, &StoreToStorage},
+    {kLog0, &EmitLog<0>},
+    {kLog1, &EmitLog<1>},
+    {kLog2, &EmitLog<2>},
+    {kLog3, &EmitLog<3>},
+    {kLog4, &EmitLog<4>}};
+
+auto Interpreter::Fail(ExecutionStatus status, std::string message) -> bool {
+  m_status = status;
+  m_error_message = std::move(message);
+  return false;
+}
+
+// Before SLOAD, BALANCE and EXTCODESIZE with `operand` on top of the stack: suspends the execution (kStateMissing) if
+// what the opcode reads is not resident in the attached state.
+auto Interpreter::IsStateMissing(opcode_t opcode, word_t const& operand) -> bool {
+  auto const key{StateReadKey(m_execution_context, opcode, operand)};
+  if (not key or m_execution_context.state->IsResident(*key)) {
+    return false;
+  }
+  m_missing_state = *key;
+  m_status = ExecutionStatus::kStateMissing;
+  m_error_message.clear();
+  return true;
+}
+
+auto Interpreter::CodeHash() -> std::size_t {
+  if (not m_code_hash) {
+    m_code_hash = HashBytecode(m_execution_context.bytecode);
+  }
+  return *m_code_hash;
+}
+
+auto Interpreter::InterpretViaHandlerTable() -> bool {
+  while (not m_execution_context.halted and m_execution_context.program_counter < m_execution_context.bytecode.size()) {
+    if (not Step()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Executes the instruction at the program counter; returns false on error.
+auto Interpreter::Step() -> bool {
+  auto const opcode{OpcodeAt(m_execution_context.bytecode, m_execution_context.program_counter)};
+#if defined(EVMINT_PROFILE)
+  auto const start_cycles{ReadCycleCounter()};
+#endif
+
+  try {
+    auto const& opcode_info{kOpcodeInfo.at(opcode)};
+    if (opcode_info.interpreted_only and not m_execution_context.stack.empty() and IsStateMissing(opcode, m_execution_context.stack.top())) {
+      return false;
+    }
+    if (m_execution_context.gas_left < opcode_info.gas_consumed) {
+      throw Revert{"GAS", RevertError::kGasExceeded};
+    }
+    m_execution_context.gas_left -= opcode_info.gas_consumed;
+
+    kOpcodeHandlers.at(opcode)(m_execution_context);
+
+    m_execution_context.program_counter++;
+    m_execution_context.program_counter += opcode_info.advance_by;
+#if defined(EVMINT_PROFILE)
+    m_profile.Record(opcode, ReadCycleCounter() - start_cycles);
+#endif
+  } catch (Revert const& ex) {
+    return Fail(ToExecutionStatus(ex.Error()), ex.what());
+  } catch (std::out_of_range const& ex) {
+    return Fail(ExecutionStatus::kUnrecognizedOpcode, std::format("Unrecognized opcode: {:#x}", static_cast<std::uint8_t>(opcode)));
+  } catch (std::runtime_error const& ex) {
+    return Fail(ExecutionStatus::kInternalError, ex.what());
+  }
+
+  if (m_options.trace_execution) {
+    PrintStack();
+    // PrintMemory();
+  }
+  return true;
+}
+
+// Runs compiled blocks (jit::CompiledCode or aot::TranslatedCode) wherever one starts at the program
+// counter and single-steps the interpreter everywhere else (side exits, unsupported opcodes).
+auto Interpreter::InterpretCompiled(auto const& compiled_code) -> bool {
+  auto& execution_context{m_execution_context};
+  BlockFrame frame{.stack_base = execution_context.stack.data(),
+                   .memory = execution_context.memory.data(),
+                   .jump_destinations = compiled_code.JumpDestinations(),
+                   .code_size = execution_context.bytecode.size()};
+
+  while (not execution_context.halted and execution_context.program_counter < execution_context.bytecode.size()) {
+    auto const block{compiled_code.BlockAt(execution_context.program_counter)};
+    if (block == nullptr) {
+      if (not Step()) {
+        return false;
+      }
+      continue;
+    }
+
+    frame.stack_size = execution_context.stack.size();
+    frame.gas_left = execution_context.gas_left;
+    frame.program_counter = execution_context.program_counter;
+    frame.memory_size = execution_context.memory_size;
+    auto const exit_status{block(&frame)};
+    execution_context.stack.resize(frame.stack_size);
+    execution_context.gas_left = frame.gas_left;
+    execution_context.program_counter = frame.program_counter;
+    execution_context.memory_size = frame.memory_size;
+
+    if (exit_status == BlockExit::kStop) {
+      execution_context.halted = true;
+    } else if (exit_status == BlockExit::kSideExit and not Step()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+auto Interpreter::InterpretTiered() -> bool {
+  if (auto const* translated_code{m_options.use_translated_code ? FindTranslatedCode(CodeHash(), m_execution_context.bytecode) : nullptr}; translated_code != nullptr) {
+    return InterpretCompiled(*translated_code);
+  }
+
+#if defined(__x86_64__)
+  auto const code_hash{CodeHash()};
+  auto [tier_state_it, inserted]{m_tier_states.try_emplace(code_hash)};
+  if (inserted) {
+    m_tier_order.push_front(code_hash);
+    tier_state_it->second.order = std::begin(m_tier_order);
+    // the least recently run contract (never the one just added) makes room, its compiled code is unmapped with it
+    if (m_tier_states.size() > std::max<std::size_t>(m_options.tier_cache_capacity, 1)) {
+      m_tier_states.erase(m_tier_order.back());
+      m_tier_order.pop_back();
+    }
+  } else {
+    m_tier_order.splice(std::begin(m_tier_order), m_tier_order, tier_state_it->second.order);
+  }
+  auto& tier_state{tier_state_it->second};
+  // a resumed execution was counted when it started
+  if (not m_suspended and not tier_state.compiled_code and ++tier_state.execution_count > m_options.jit_threshold) {
+    tier_state.compiled_code = jit::Compile(bytecode_t(std::begin(m_execution_context.bytecode), std::end(m_execution_context.bytecode)));
+  }
+  // the hash only picks the cache entry, a collision must not run foreign code
+  if (tier_state.compiled_code and std::ranges::equal(tier_state.compiled_code->Bytecode(), m_execution_context.bytecode)) {
+    return InterpretCompiled(*tier_state.compiled_code);
+  }
+#endif
+  return InterpretViaHandlerTable();
+}
+
+// Same instruction set as InterpretViaHandlerTable, but dispatched through a switch over the
+// tos:: handlers so the cached top-of-stack words never leave this frame.
+auto Interpreter::InterpretCachingTopOfStack() -> bool {
+  auto& execution_context{m_execution_context};
+  tos::TopOfStack top_of_stack{};
+  // for SLOAD, BALANCE and EXTCODESIZE, whose gas is charged already: suspends the execution in front of them
+  auto const state_missing{[this, &execution_context, &top_of_stack](opcode_t opcode) {
+    if (tos::Size(execution_context, top_of_stack) == 0) {
+      return false;
+    }
+    tos::Fill(execution_context, top_of_stack, 1);
+    if (not IsStateMissing(opcode, top_of_stack.first)) {
+      return false;
+    }
+    execution_context.gas_left += kGasCost[static_cast<std::size_t>(opcode)];
+    tos::Spill(execution_context, top_of_stack);
+    return true;
+  }};
+
+  while (not execution_context.halted and execution_context.program_counter < execution_context.bytecode.size()) {
+    auto const opcode{execution_context.bytecode[execution_context.program_counter]};
+#if defined(EVMINT_PROFILE)
+    auto const start_cycles{ReadCycleCounter()};
+#endif
+
+    try {
+      if (execution_context.gas_left < kGasCost[static_cast<std::size_t>(opcode)]) {
+        throw Revert{"GAS", RevertError::kGasExceeded};
+      }
+      execution_context.gas_left -= kGasCost[static_cast<std::size_t>(opcode)];
+
+      switch (opcode) {
+        case kStop:
+          execution_context.halted = true;
+          break;
+        case kAdd:
+          tos::ApplyBinaryOperation<std::plus<>>(execution_context, top_of_stack);
+          break;
+        case kMul:
+          tos::ApplyBinaryOperation<std::multiplies<>>(execution_context, top_of_stack);
+          break;
+        case kSub:
+          tos::ApplyBinaryOperation<std::minus<>>(execution_context, top_of_stack);
+          break;
+        case kLt:
+          tos::ApplyBinaryOperation<std::less<>>(execution_context, top_of_stack);
+          break;
+        case kGt:
+          tos::ApplyBinaryOperation<std::greater<>>(execution_context, top_of_stack);
+          break;
+        case kEq:
+          tos::ApplyBinaryOperation<std::equal_to<>>(execution_context, top_of_stack);
+          break;
+        case kIsZero:
+          tos::ApplyUnaryOperation<std::logical_not<>>(execution_context, top_of_stack);
+          break;
+        case kAnd:
+          tos::ApplyBinaryOperation<std::bit_and<>>(execution_context, top_of_stack);
+          break;
+        case kOr:
+          tos::ApplyBinaryOperation<std::bit_or<>>(execution_context, top_of_stack);
+          break;
+        case kXor:
+          tos::ApplyBinaryOperation<std::bit_xor<>>(execution_context, top_of_stack);
+          break;
+        case kNot:
+          tos::ApplyUnaryOperation<std::bit_not<>>(execution_context, top_of_stack);
+          break;
+        case kShl:
+          tos::ShiftLeft(execution_context, top_of_stack);
+          break;
+        case kShr:
+          tos::ShiftRight(execution_context, top_of_stack);
+          break;
+        case kPop:
+          tos::PopFromStack(execution_context, top_of_stack);
+          break;
+        case kMLoad:
+          tos::LoadFromMemory(execution_context, top_of_stack);
+          break;
+        case kMStore:
+          tos::StoreToMemory(execution_context, top_of_stack);
+          break;
+        case kJump:
+          tos::Jump(execution_context, top_of_stack);
+          break;
+        case kJumpI:
+          tos::ConditionalJump(execution_context, top_of_stack);
+          break;
+        case kJumpDest:
+          break;
+        case kPush0:
+          tos::PushToStack<0>(execution_context, top_of_stack);
+          break;
+        case kPush1:
+          tos::PushToStack<1>(execution_context, top_of_stack);
+          break;
+        case kPush2:
+          tos::PushToStack<2>(execution_context, top_of_stack);
+          break;
+        case kPush12:
+          tos::PushToStack<12>(execution_context, top_of_stack);
+          break;
+        case kPush32:
+          tos::PushToStack<32>(execution_context, top_of_stack);
+          break;
+        case kDup1:
+          tos::DuplicateStackValue<1>(execution_context, top_of_stack);
+          break;
+        case kDup2:
+          tos::DuplicateStackValue<2>(execution_context, top_of_stack);
+          break;
+        case kDup3:
+          tos::DuplicateStackValue<3>(execution_context, top_of_stack);
+          break;
+        case kSwap1:
+          tos::SwapStackValues(execution_context, top_of_stack);
+          break;
+        case kCallDataLoad:
+          tos::LoadFromCallData(execution_context, top_of_stack);
+          break;
+        case kCallDataSize:
+          tos::PushCallDataSize(execution_context, top_of_stack);
+          break;
+        case kBalance:
+          if (state_missing(opcode)) {
+            return false;
+          }
+          tos::LoadBalance(execution_context, top_of_stack);
+          break;
+        case kExtCodeSize:
+          if (state_missing(opcode)) {
+            return false;
+          }
+          tos::LoadExternalCodeSize(execution_context, top_of_stack);
+          break;
+        case kSLoad:
+          if (state_missing(opcode)) {
+            return false;
+          }
+          tos::LoadFromStorage(execution_context, top_of_stack);
+          break;
+        case kSStore:
+          tos::StoreToStorage(execution_context, top_of_stack);
+          break;
+        case kLog0:
+          tos::EmitLog<0>(execution_context, top_of_stack);
+          break;
+        case kLog1:
+          tos::EmitLog<1>(execution_context, top_of_stack);
+          break;
+        case kLog2:
+          tos::EmitLog<2>(execution_context, top_of_stack);
+          break;
+        case kLog3:
+          tos::EmitLog<3>(execution_context, top_of_stack);
+          break;
+        case kLog4:
+          tos::EmitLog<4>(execution_context, top_of_stack);
+          break;
+        default:
+          tos::Spill(execution_context, top_of_stack);
+          return Fail(ExecutionStatus::kUnrecognizedOpcode, std::format("Unrecognized opcode: {:#x}", static_cast<std::uint8_t>(opcode)));
+      }
+
+      execution_context.program_counter += 1 + ImmediateSize(opcode);
+#if defined(EVMINT_PROFILE)
+      m_profile.Record(opcode, ReadCycleCounter() - start_cycles);
+#endif
+    } catch (Revert const& ex) {
+      tos::Spill(execution_context, top_of_stack);
+      return Fail(ToExecutionStatus(ex.Error()), ex.what());
+    } catch (std::out_of_range const& ex) {
+      tos::Spill(execution_context, top_of_stack);
+      return Fail(ExecutionStatus::kUnrecognizedOpcode, std::format("Unrecognized opcode: {:#x}", static_cast<std::uint8_t>(opcode)));
+    } catch (std::runtime_error const& ex) {
+      tos::Spill(execution_context, top_of_stack);
+      return Fail(ExecutionStatus::kInternalError, ex.what());
+    }
+
+    if (m_options.trace_execution) {
+      tos::Spill(execution_context, top_of_stack);
+      PrintStack();
+    }
+  }
+
+  tos::Spill(execution_context, top_of_stack);
+  return true;
+}
+
+auto Interpreter::PrintStack() const -> void {
+  std::println("printing stack contents ...");
+
+  for (std::size_t depth{0}; depth < m_execution_context.stack.size(); ++depth) {
+    auto const word_span{std::span{intx::as_bytes(m_execution_context.stack.peek(depth)), kWordSize}};
+    for (auto byte : word_span | std::views::reverse) {
+      std::print("{:02x}, ", byte);
+    }
+    std::println("");
+  }
+
+  std::println("finished");
+}
+
+auto Interpreter::PrintMemory() -> void {
+  constexpr static std::size_t kContentSize{300};
+
+  std::println("printing (first {}) memory contents ...", kContentSize);
+  std::ranges::for_each(std::views::iota(0) | std::views::take(kContentSize), [this](auto idx) { std::println("mem[{} = {:x}] = {:x}", idx, idx, m_execution_context.memory.at(idx)); });
+  std::println("finished");
+}
+
+}  // namespace evmint
@@ -0,0 +1,300 @@
+// SPDX-License-Identifier: MIT
+
+// Embedding API of the evmint_core library. An Interpreter runs bytecode against a host's StateView (the host
+// interface: balances, code and storage the executed code reads) and reports how the run ended by value, without
+// throwing or printing for errors in the executed code. One Interpreter is meant to be reused for many executions;
+// it is not thread-safe, use one per thread.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "evm.hpp"
+#include "logs.hpp"
+#include "state.hpp"
+#if defined(EVMINT_PROFILE)
+#include "profiler.hpp"
+#endif
+
+namespace evmint {
+
+#if defined(__x86_64__)
+namespace jit {
+class CompiledCode;
+}  // namespace jit
+#endif
+
+enum class DispatchMode { kHandlerTable, kTopOfStackCached, kTiered };
+
+// "table", "tos" or "tiered", as tools and the EVMC option name them
+inline auto ParseDispatchMode(std::string_view name) -> std::optional<DispatchMode> {
+  if (name == "table") {
+    return DispatchMode::kHandlerTable;
+  }
+  if (name == "tos") {
+    return DispatchMode::kTopOfStackCached;
+  }
+  if (name == "tiered") {
+    return DispatchMode::kTiered;
+  }
+  return std::nullopt;
+}
+
+inline auto DispatchModeName(DispatchMode dispatch_mode) -> std::string_view {
+  switch (dispatch_mode) {
+    case DispatchMode::kHandlerTable:
+      return "table";
+    case DispatchMode::kTopOfStackCached:
+      return "tos";
+    case DispatchMode::kTiered:
+      break;
+  }
+  return "tiered";
+}
+
+constexpr std::size_t kDefaultGasLimit{30'000'000};
+constexpr std::size_t kDefaultJitThreshold{100};
+constexpr std::size_t kDefaultTierCacheCapacity{1'024};
+
+struct InterpreterOptions {
+  // print the stack after every instruction
+  bool trace_execution{false};
+  // kTiered: bytecode is compiled once it has been interpreted this many times
+  std::size_t jit_threshold{kDefaultJitThreshold};
+  // kTiered: run contracts translated by evmint-aot from their translated code, regardless of the threshold
+  bool use_translated_code{true};
+  // kTiered: contracts whose execution count and compiled code are kept, the least recently run one is dropped first
+  std::size_t tier_cache_capacity{kDefaultTierCacheCapacity};
+};
+
+// Executors (batches, blocks, the server) run the same contracts over and over, so by default every worker compiles a
+// contract the first time it sees it instead of interpreting it jit_threshold times first.
+constexpr InterpreterOptions kExecutorOptions{.trace_execution = false, .jit_threshold = 0};
+
+// How an execution ended: kSuccess, one of the RevertError values, or an opcode the interpreter does not implement.
+// kStateMissing does not end it: the execution is suspended until Interpreter::Resume().
+enum class ExecutionStatus {
+  kSuccess,
+  kStackOverflow,
+  kGasExceeded,
+  kStackUnderflow,
+  kMemoryUnalignedAccess,
+  kMemoryOutOfBounds,
+  kInvalidJump,
+  kUnrecognizedOpcode,
+  kInternalError,
+  kStateMissing,
+  // a precompiled contract rejected its input
+  kPrecompileFailure
+};
+
+inline auto ToExecutionStatus(RevertError error) -> ExecutionStatus {
+  switch (error) {
+    case RevertError::kStackOverflow:
+      return ExecutionStatus::kStackOverflow;
+    case RevertError::kGasExceeded:
+      return ExecutionStatus::kGasExceeded;
+    case RevertError::kStackUnderflow:
+      return ExecutionStatus::kStackUnderflow;
+    case RevertError::kMemoryUnalignedAccess:
+      return ExecutionStatus::kMemoryUnalignedAccess;
+    case RevertError::kMemoryOutOfBounds:
+      return ExecutionStatus::kMemoryOutOfBounds;
+    case RevertError::kInvalidJump:
+      return ExecutionStatus::kInvalidJump;
+  }
+  return ExecutionStatus::kInternalError;
+}
+
+// SSTOREs as (slot, value) pairs, for callers that reuse one buffer across executions
+using StorageWriteBuffer = std::vector<std::pair<word_t, word_t>>;
+
+struct ExecutionRequest {
+  std::span<std::byte const> code{};
+  std::span<std::byte const> calldata{};
+  // read by SLOAD, BALANCE and EXTCODESIZE; may be null for code that does not touch state
+  StateView const* state{nullptr};
+  // account whose storage SLOAD/SSTORE access
+  word_t address{0};
+  std::size_t gas_limit{kDefaultGasLimit};
+  DispatchMode dispatch_mode{DispatchMode::kTiered};
+  // LOGn appends here, and an execution that fails rolls it back to where it started; null: to the interpreter's own
+  // Logs(), which every execution starts empty
+  LogArena* logs{nullptr};
+  // SSTOREs of a successful execution are copied here (it is cleared first) instead of moved into the result, and the
+  // interpreter keeps its write map for the next execution; null: into the result
+  StorageWriteBuffer* storage_writes{nullptr};
+};
+
+struct ExecutionResult {
+  ExecutionStatus status{ExecutionStatus::kSuccess};
+  // a failed execution consumes its whole gas limit, as in the EVM
+  std::size_t gas_used{0};
+  // SSTOREs of a successful execution unless the request took them; the state itself is never written
+  Storage storage_writes{};
+  // what a precompiled contract returned; bytecode has no RETURN yet and leaves it empty
+  std::vector<std::byte> output{};
+};
+
+class Interpreter final {
+  using bytecode_t = std::vector<std::byte>;
+  // NOTE: we prefer an arithmetic type for byte in defining memory structure
+  using memory_t = std::array<std::uint8_t, kMemorySize>;
+  using stack_t = WordStack;
+
+  struct ExecutionContext {
+    std::size_t program_counter{0};
+    bool halted{false};
+    std::size_t gas_left{kDefaultGasLimit};
+    // borrowed: LoadBytecode()/LoadCallData() point them at the interpreter's own copies, Execute() at the request's
+    std::span<std::byte const> bytecode{};
+    std::span<std::byte const> calldata{};
+    // MarkJumpDestinations() of the bytecode, filled by the first jump and emptied when the bytecode changes
+    std::vector<std::uint8_t> jump_destinations{};
+    // read by SLOAD, BALANCE and EXTCODESIZE, not owned
+    StateView const* state{nullptr};
+    // account whose storage SLOAD/SSTORE access
+    word_t address{0};
+    Storage storage_writes{};
+    // where LOGn appends, not owned
+    LogArena* logs{nullptr};
+    stack_t stack{};
+    // bytes up to the end of the highest word MSTORE wrote, all that Reset() has to zero again
+    std::size_t memory_size{0};
+    memory_t memory{};
+  };
+
+ public:
+  explicit Interpreter(InterpreterOptions options = {});
+  Interpreter(Interpreter const&) = delete;
+  auto operator=(Interpreter const&) -> Interpreter& = delete;
+  ~Interpreter();
+
+  // Runs the request's code from a fresh state and returns the outcome; at a precompiled contract's address, runs that
+  // contract instead. Code and call data are borrowed for the call, not copied. Errors in the executed code end up in
+  // the result; exceptions thrown by the host's StateView are passed on.
+  auto Execute(ExecutionRequest const& request) -> ExecutionResult;
+  // Continues an execution that Execute() or Resume() returned with kStateMissing, once the host made MissingState()
+  // resident. Until the execution finishes, the request's code, call data and state stay borrowed.
+  auto Resume() -> ExecutionResult;
+  // the state location a suspended execution waits for
+  auto MissingState() const -> StateKey const& { return m_missing_state; }
+
+  auto LoadBytecode(bytecode_t bytecode) -> void;
+  auto LoadBytecode(std::string_view bc_filepath) -> void { LoadBytecode(ReadBytecodeFile(bc_filepath)); }
+
+  // Call data for CALLDATALOAD/CALLDATASIZE; like the bytecode it is kept across Reset().
+  auto LoadCallData(bytecode_t calldata) {
+    m_calldata = std::move(calldata);
+    m_execution_context.calldata = m_calldata;
+  }
+
+  // State read by SLOAD, BALANCE and EXTCODESIZE, which must outlive execution, and the account the code runs as. The
+  // state is never written: SSTOREs collect in StorageWrites().
+  auto AttachState(StateView const* state, word_t const& address = 0) {
+    m_execution_context.state = state;
+    m_execution_context.address = address;
+  }
+
+  // Returns false if execution was aborted by an error, which Status() and ErrorMessage() then describe.
+  auto Interpret(DispatchMode dispatch_mode = DispatchMode::kHandlerTable) -> bool;
+
+  // Rewind to the first instruction with an empty stack, zeroed memory, no storage writes or logs and a fresh gas
+  // budget, keeping the loaded bytecode, call data and state.
+  auto Reset(std::size_t gas_limit = kDefaultGasLimit) -> void {
+    m_execution_context.program_counter = 0;
+    m_execution_context.halted = false;
+    m_execution_context.gas_left = gas_limit;
+    m_execution_context.stack.clear();
+    m_execution_context.storage_writes.clear();
+    m_execution_context.logs->RollbackTo(m_log_checkpoint);
+    std::fill_n(std::begin(m_execution_context.memory), m_execution_context.memory_size, 0);
+    m_execution_context.memory_size = 0;
+    m_status = ExecutionStatus::kSuccess;
+    m_error_message.clear();
+    m_suspended = false;
+  }
+
+  auto Stack() const -> stack_t const& { return m_execution_context.stack; }
+  auto Memory() const -> memory_t const& { return m_execution_context.memory; }
+  // bytes of Memory() written since the last Reset(), rounded up to the end of the highest word stored
+  auto MemorySize() const -> std::size_t { return m_execution_context.memory_size; }
+  auto GasLeft() const -> std::size_t { return m_execution_context.gas_left; }
+  auto StorageWrites() const -> Storage const& { return m_execution_context.storage_writes; }
+  // of the last execution, unless its request brought its own arena
+  auto Logs() const -> LogArena const& { return m_logs; }
+  auto Status() const -> ExecutionStatus { return m_status; }
+  auto ErrorMessage() const -> std::string const& { return m_error_message; }
+#if defined(EVMINT_PROFILE)
+  // accumulated over every execution until cleared, not by Reset()
+  auto Profile() const -> OpcodeProfile const& { return m_profile; }
+  auto ClearProfile() -> void { m_profile.Clear(); }
+#endif
+
+ private:
+#if defined(__x86_64__)
+  struct TierState {
+    std::size_t execution_count{0};
+    std::unique_ptr<jit::CompiledCode> compiled_code{};
+    // position in m_tier_order
+    std::list<std::size_t>::iterator order{};
+
+    // jit::CompiledCode is only complete in interpreter.cpp
+    ~TierState();
+  };
+#endif
+
+  ExecutionContext m_execution_context{};
+  InterpreterOptions m_options;
+  LogArena m_logs{};
+  // where the arena stood when the current execution started, what a failure or Reset() rolls it back to
+  LogCheckpoint m_log_checkpoint{};
+  bytecode_t m_bytecode{};
+  bytecode_t m_calldata{};
+  // identifies the loaded bytecode for tiering, hashed on the first tiered run
+  std::optional<std::size_t> m_code_hash{};
+  ExecutionStatus m_status{ExecutionStatus::kSuccess};
+  std::string m_error_message{};
+  // of the execution Execute() started, for Resume()
+  std::size_t m_gas_limit{kDefaultGasLimit};
+  DispatchMode m_dispatch_mode{DispatchMode::kTiered};
+  StateKey m_missing_state{};
+  // of the execution Execute() started, for Resume()
+  StorageWriteBuffer* m_storage_write_buffer{nullptr};
+  // while an execution waits in kStateMissing for Resume(), which must not count it for tiering again
+  bool m_suspended{false};
+#if defined(__x86_64__)
+  std::unordered_map<std::size_t, TierState> m_tier_states{};
+  // code hashes of m_tier_states, most recently run first
+  std::list<std::size_t> m_tier_order{};
+#endif
+#if defined(EVMINT_PROFILE)
+  OpcodeProfile m_profile{};
+#endif
+  // handlers update the context in place, it holds the whole memory
+  static std::unordered_map<opcode_t, auto (*)(ExecutionContext&) -> void> const kOpcodeHandlers;
+
+  auto Fail(ExecutionStatus status, std::string message) -> bool;
+  auto IsStateMissing(opcode_t opcode, word_t const& operand) -> bool;
+  auto CodeHash() -> std::size_t;
+  auto InterpretViaHandlerTable() -> bool;
+  auto Step() -> bool;
+  auto InterpretTiered() -> bool;
+  auto InterpretCompiled(auto const& compiled_code) -> bool;
+  auto InterpretCachingTopOfStack() -> bool;
+  auto PrintStack() const -> void;
+  auto PrintMemory() -> void;
+};
+
+}  // namespace evmint
@@ -0,0 +1,353 @@
+// SPDX-License-Identifier: MIT
+
+// Minimal JSON reader for test fixtures and state files (evmint-statetest, evmint-snapshot). Numbers keep their text,
+// so 256-bit quantities and hex strings both go through AsWord() without loss. Objects keep their members in file
+// order.
+
+#pragma once
+
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <intx/intx.hpp>
+
+#include "evm.hpp"
+#include "state.hpp"
+
+namespace evmint::json {
+
+class Value;
+using Array = std::vector<Value>;
+using Object = std::vector<std::pair<std::string, Value>>;
+
+// A decimal or 0x-prefixed hex number, as fixtures write quantities and also object keys such as storage slots.
+inline auto ParseWord(std::string const& text) -> word_t {
+  if (text == "0x" or text == "0X") {
+    return 0;
+  }
+  try {
+    return intx::from_string<word_t>(text.c_str());
+  } catch (std::exception const&) {
+    throw std::runtime_error{std::format("[JSON]: '{}' is not an unsigned number.", text)};
+  }
+}
+
+struct Number {
+  std::string text{};
+};
+
+class Value {
+ public:
+  Value() = default;
+  template <typename Alternative>
+    requires(not std::same_as<Alternative, Value>)
+  explicit Value(Alternative alternative) : m_value{std::move(alternative)} {}
+
+  auto IsNull() const -> bool { return std::holds_alternative<std::nullptr_t>(m_value); }
+  auto IsString() const -> bool { return std::holds_alternative<std::string>(m_value); }
+  auto IsArray() const -> bool { return std::holds_alternative<Array>(m_value); }
+  auto IsObject() const -> bool { return std::holds_alternative<Object>(m_value); }
+
+  auto AsString() const -> std::string const& { return Get<std::string>("a string"); }
+  auto AsArray() const -> Array const& { return Get<Array>("an array"); }
+  auto AsObject() const -> Object const& { return Get<Object>("an object"); }
+
+  // Member `key` of an object, null if there is none.
+  auto Find(std::string_view key) const -> Value const* {
+    for (auto const& [member_key, member] : AsObject()) {
+      if (member_key == key) {
+        return &member;
+      }
+    }
+    return nullptr;
+  }
+
+  auto At(std::string_view key) const -> Value const& {
+    auto const* member{Find(key)};
+    if (member == nullptr) {
+      throw std::runtime_error{std::format("[JSON]: Missing member '{}'.", key)};
+    }
+    return *member;
+  }
+
+  // A number, or a string holding a decimal or 0x-prefixed hex number ("0x" alone is zero).
+  auto AsWord() const -> word_t { return ParseWord(std::holds_alternative<Number>(m_value) ? std::get<Number>(m_value).text : AsString()); }
+
+  auto AsUnsigned() const -> std::uint64_t {
+    auto const word{AsWord()};
+    if (word > std::numeric_limits<std::uint64_t>::max()) {
+      throw std::runtime_error{"[JSON]: Number does not fit 64 bits."};
+    }
+    return static_cast<std::uint64_t>(word);
+  }
+
+  // A 0x-prefixed hex string as bytes.
+  auto AsBytes() const -> std::vector<std::byte> {
+    std::string_view hex{AsString()};
+    if (not hex.starts_with("0x") or hex.size() % 2 != 0) {
+      throw std::runtime_error{std::format("[JSON]: '{}' is not 0x-prefixed hex bytes.", hex.substr(0, 16))};
+    }
+    hex.remove_prefix(2);
+    std::vector<std::byte> bytes(hex.size() / 2);
+    for (std::size_t index{0}; index < bytes.size(); ++index) {
+      std::uint8_t byte{0};
+      if (auto const [end, error]{std::from_chars(hex.data() + 2 * index, hex.data() + 2 * index + 2, byte, kHexBase)}; error != std::errc{} or end != hex.data() + 2 * index + 2) {
+        throw std::runtime_error{"[JSON]: Invalid hex digit."};
+      }
+      bytes[index] = static_cast<std::byte>(byte);
+    }
+    return bytes;
+  }
+
+ private:
+  std::variant<std::nullptr_t, bool, Number, std::string, Array, Object> m_value{nullptr};
+
+  template <typename Alternative>
+  auto Get(std::string_view expected) const -> Alternative const& {
+    if (auto const* alternative{std::get_if<Alternative>(&m_value)}; alternative != nullptr) {
+      return *alternative;
+    }
+    throw std::runtime_error{std::format("[JSON]: Expected {}.", expected)};
+  }
+};
+
+// Recursive descent over one document; throws std::runtime_error on malformed input.
+class Parser {
+ public:
+  explicit Parser(std::string_view text) : m_text{text} {}
+
+  auto ParseDocument() -> Value {
+    auto value{ParseValue(0)};
+    SkipWhitespace();
+    if (m_offset != m_text.size()) {
+      Fail("trailing characters");
+    }
+    return value;
+  }
+
+ private:
+  static constexpr std::size_t kMaxDepth{256};
+
+  std::string_view m_text;
+  std::size_t m_offset{0};
+
+  [[noreturn]] auto Fail(std::string_view what) const -> void { throw std::runtime_error{std::format("[JSON]: {} at offset {}.", what, m_offset)}; }
+
+  auto SkipWhitespace() -> void {
+    while (m_offset < m_text.size() and (m_text[m_offset] == ' ' or m_text[m_offset] == '\t' or m_text[m_offset] == '\n' or m_text[m_offset] == '\r')) {
+      m_offset++;
+    }
+  }
+
+  auto Peek() -> char {
+    SkipWhitespace();
+    if (m_offset == m_text.size()) {
+      Fail("unexpected end");
+    }
+    return m_text[m_offset];
+  }
+
+  auto Expect(char expected) -> void {
+    if (Peek() != expected) {
+      Fail(std::format("expected '{}'", expected));
+    }
+    m_offset++;
+  }
+
+  auto Consume(std::string_view literal) -> bool {
+    if (not m_text.substr(m_offset).starts_with(literal)) {
+      return false;
+    }
+    m_offset += literal.size();
+    return true;
+  }
+
+  auto ParseValue(std::size_t depth) -> Value {
+    if (depth > kMaxDepth) {
+      Fail("nesting too deep");
+    }
+    switch (Peek()) {
+      case '{':
+        return ParseObject(depth);
+      case '[':
+        return ParseArray(depth);
+      case '"':
+        return Value{ParseString()};
+      default:
+        break;
+    }
+    if (Consume("null")) {
+      return Value{};
+    }
+    if (Consume("true")) {
+      return Value{true};
+    }
+    if (Consume("false")) {
+      return Value{false};
+    }
+    return Value{ParseNumber()};
+  }
+
+  auto ParseObject(std::size_t depth) -> Value {
+    Expect('{');
+    Object object{};
+    if (Peek() == '}') {
+      m_offset++;
+      return Value{std::move(object)};
+    }
+    while (true) {
+      if (Peek() != '"') {
+        Fail("expected a member name");
+      }
+      auto key{ParseString()};
+      Expect(':');
+      object.emplace_back(std::move(key), ParseValue(depth + 1));
+      if (Peek() == '}') {
+        m_offset++;
+        return Value{std::move(object)};
+      }
+      Expect(',');
+    }
+  }
+
+  auto ParseArray(std::size_t depth) -> Value {
+    Expect('[');
+    Array array{};
+    if (Peek() == ']') {
+      m_offset++;
+      return Value{std::move(array)};
+    }
+    while (true) {
+      array.push_back(ParseValue(depth + 1));
+      if (Peek() == ']') {
+        m_offset++;
+        return Value{std::move(array)};
+      }
+      Expect(',');
+    }
+  }
+
+  auto ParseNumber() -> Number {
+    auto const begin{m_offset};
+    while (m_offset < m_text.size() and std::string_view{"+-0123456789.eE"}.find(m_text[m_offset]) != std::string_view::npos) {
+      m_offset++;
+    }
+    if (m_offset == begin) {
+      Fail("unexpected character");
+    }
+    return {std::string{m_text.substr(begin, m_offset - begin)}};
+  }
+
+  auto ParseHexDigits(std::size_t count) -> std::uint32_t {
+    std::uint32_t value{0};
+    if (m_offset + count > m_text.size() or std::from_chars(m_text.data() + m_offset, m_text.data() + m_offset + count, value, kHexBase).ptr != m_text.data() + m_offset + count) {
+      Fail("invalid \\u escape");
+    }
+    m_offset += count;
+    return value;
+  }
+
+  auto AppendUtf8(std::string& text, std::uint32_t code_point) -> void {
+    if (code_point < 0x80) {
+      text += static_cast<char>(code_point);
+    } else if (code_point < 0x800) {
+      text += static_cast<char>(0xc0 | (code_point >> 6));
+      text += static_cast<char>(0x80 | (code_point & 0x3f));
+    } else if (code_point < 0x10000) {
+      text += static_cast<char>(0xe0 | (code_point >> 12));
+      text += static_cast<char>(0x80 | ((code_point >> 6) & 0x3f));
+      text += static_cast<char>(0x80 | (code_point & 0x3f));
+    } else {
+      text += static_cast<char>(0xf0 | (code_point >> 18));
+      text += static_cast<char>(0x80 | ((code_point >> 12) & 0x3f));
+      text += static_cast<char>(0x80 | ((code_point >> 6) & 0x3f));
+      text += static_cast<char>(0x80 | (code_point & 0x3f));
+    }
+  }
+
+  auto ParseString() -> std::string {
+    Expect('"');
+    std::string text{};
+    while (true) {
+      if (m_offset == m_text.size()) {
+        Fail("unterminated string");
+      }
+      auto const character{m_text[m_offset++]};
+      if (character == '"') {
+        return text;
+      }
+      if (character != '\\') {
+        text += character;
+        continue;
+      }
+      if (m_offset == m_text.size()) {
+        Fail("unterminated string");
+      }
+      switch (auto const escaped{m_text[m_offset++]}) {
+        case 'b':
+          text += '\b';
+          break;
+        case 'f':
+          text += '\f';
+          break;
+        case 'n':
+          text += '\n';
+          break;
+        case 'r':
+          text += '\r';
+          break;
+        case 't':
+          text += '\t';
+          break;
+        case 'u': {
+          auto code_point{ParseHexDigits(4)};
+          // a surrogate pair encodes one code point beyond the basic plane
+          if (code_point >= 0xd800 and code_point < 0xdc00 and Consume("\\u")) {
+            code_point = 0x10000 + ((code_point - 0xd800) << 10) + (ParseHexDigits(4) - 0xdc00);
+          }
+          AppendUtf8(text, code_point);
+          break;
+        }
+        default:
+          text += escaped;
+      }
+    }
+  }
+};
+
+inline auto Parse(std::string_view text) -> Value { return Parser{text}.ParseDocument(); }
+
+// An account map as fixtures write pre- and post-states: address -> {balance, code, storage}, zero slots left out.
+inline auto ToAccounts(Value const& accounts) -> Accounts {
+  Accounts result{};
+  for (auto const& [address, account] : accounts.AsObject()) {
+    auto& [balance, code, storage]{result[ParseWord(address)]};
+    if (auto const* const value{account.Find("balance")}) {
+      balance = value->AsWord();
+    }
+    if (auto const* const value{account.Find("code")}) {
+      code = value->AsBytes();
+    }
+    if (auto const* const value{account.Find("storage")}) {
+      for (auto const& [slot, stored] : value->AsObject()) {
+        if (auto const word{stored.AsWord()}; word != 0) {
+          storage.insert_or_assign(ParseWord(slot), word);
+        }
+      }
+    }
+  }
+  return result;
+}
+
+}  // namespace evmint::json
@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: MIT
+
+// Keccak-256 as Ethereum uses it (the original Keccak padding, not SHA3-256's): trie node hashes, hashed trie keys and
+// code hashes.
+
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#include "evm.hpp"
+
+namespace evmint {
+
+using Hash = std::array<std::byte, kWordSize>;
+
+namespace keccak {
+
+constexpr std::size_t kRate{136};
+
+constexpr std::array<std::uint64_t, 24> kRoundConstants{
+    0x0000000000000001, 0x0000000000008082, 0x800000000000808a, 0x8000000080008000, 0x000000000000808b, 0x0000000080000001,
+    0x8000000080008081, 0x8000000000008009, 0x000000000000008a, 0x0000000000000088, 0x0000000080008009, 0x000000008000000a,
+    0x000000008000808b, 0x800000000000008b, 0x8000000000008089, 0x8000000000008003, 0x8000000000008002, 0x8000000000000080,
+    0x000000000000800a, 0x800000008000000a, 0x8000000080008081, 0x8000000000008080, 0x0000000080000001, 0x8000000080008008};
+
+// rho's rotations and pi's destination lanes, in the order pi moves the lanes, starting from lane 1
+constexpr std::array<int, 24> kRotations{1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14, 27, 41, 56, 8, 25, 43, 62, 18, 39, 61, 20, 44};
+constexpr std::array<std::size_t, 24> kPiLanes{10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4, 15, 23, 19, 13, 12, 2, 20, 14, 22, 9, 6, 1};
+
+inline auto Permute(std::array<std::uint64_t, 25>& state) -> void {
+  for (auto const round_constant : kRoundConstants) {
+    // theta
+    std::array<std::uint64_t, 5> parity{};
+    Unrolled<5>([&](auto column) { parity[column] = state[column] ^ state[column + 5] ^ state[column + 10] ^ state[column + 15] ^ state[column + 20]; });
+    Unrolled<5>([&](auto column) {
+      auto const mix{parity[(column + 4) % 5] ^ std::rotl(parity[(column + 1) % 5], 1)};
+      Unrolled<5>([&](auto row) { state[5 * row + column] ^= mix; });
+    });
+    // rho and pi
+    auto carried{state[1]};
+    Unrolled<24>([&](auto step) {
+      auto const displaced{state[kPiLanes[step]]};
+      state[kPiLanes[step]] = std::rotl(carried, kRotations[step]);
+      carried = displaced;
+    });
+    // chi
+    Unrolled<5>([&](auto row) {
+      std::array<std::uint64_t, 5> const lanes{state[5 * row], state[5 * row + 1], state[5 * row + 2], state[5 * row + 3], state[5 * row + 4]};
+      Unrolled<5>([&](auto column) { state[5 * row + column] = lanes[column] ^ (~lanes[(column + 1) % 5] & lanes[(column + 2) % 5]); });
+    });
+    // iota
+    state[0] ^= round_constant;
+  }
+}
+
+// Lanes are little-endian; so is every host evmint runs on, which lets blocks be absorbed with plain loads.
+static_assert(std::endian::native == std::endian::little);
+
+inline auto AbsorbBlock(std::array<std::uint64_t, 25>& state, std::byte const* block) -> void {
+  for (std::size_t lane{0}; lane < kRate / 8; ++lane) {
+    std::uint64_t word{0};
+    std::memcpy(&word, block + 8 * lane, sizeof(word));
+    state[lane] ^= word;
+  }
+  Permute(state);
+}
+
+}  // namespace keccak
+
+inline auto Keccak256(std::span<std::byte const> data) -> Hash {
+  std::array<std::uint64_t, 25> state{};
+  while (data.size() >= keccak::kRate) {
+    keccak::AbsorbBlock(state, data.data());
+    data = data.subspan(keccak::kRate);
+  }
+  std::array<std::byte, keccak::kRate> last_block{};
+  std::memcpy(last_block.data(), data.data(), data.size());
+  last_block[data.size()] ^= std::byte{0x01};
+  last_block.back() ^= std::byte{0x80};
+  keccak::AbsorbBlock(state, last_block.data());
+
+  Hash hash{};
+  std::memcpy(hash.data(), state.data(), hash.size());
+  return hash;
+}
+
+// The hash as a big-endian word, as EVM code sees it.
+inline auto ToWord(Hash const& hash) -> word_t { return LoadWord(reinterpret_cast<std::uint8_t const*>(hash.data())); }
+
+inline auto ToHash(word_t const& word) -> Hash {
+  Hash hash{};
+  StoreWord(reinterpret_cast<std::uint8_t*>(hash.data()), word);
+  return hash;
+}
+
+}  // namespace evmint
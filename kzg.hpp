@@ -0,0 +1,217 @@
+// SPDX-License-Identifier: MIT
+
+// KZG proof verification for EIP-4844's point evaluation precompile, against the trusted setup of the blob KZG
+// ceremony. The setup is read once, at startup, from its text form (c-kzg's trusted_setup.txt); the precompile only
+// needs [tau]G2 from it. What every verification would otherwise recompute is precomputed in memory when the setup is
+// loaded (a few milliseconds), so calls only read it:
+//   g2 lines        the Miller loop lines of G2's generator (bls12_381::PreparedG2)
+//   tau g2 lines    those of [tau]G2
+//   generator table G1's generator times d * 16^w for every 4-bit digit d > 0 and window w, affine, so [y]G1 is one
+//                   mixed addition per window
+// Nothing of it is cached on disk, where whoever can write the cache could make the precompile accept false proofs.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bls12_381.hpp"
+#include "curve.hpp"
+#include "field.hpp"
+#include "keccak.hpp"
+#include "sha256.hpp"
+
+namespace evmint::kzg {
+
+using bls12_381::Fr;
+
+constexpr std::size_t kFieldElementsPerBlob{4'096};
+// the first byte of a versioned hash: the rest is the commitment's SHA-256 hash
+constexpr std::byte kVersionedHashVersion{0x01};
+
+// the generator table's digits
+constexpr std::size_t kWindowBits{4};
+constexpr std::size_t kWindowCount{256 / kWindowBits};
+constexpr std::size_t kDigitCount{(1 << kWindowBits) - 1};
+
+// The versioned hash that names a blob by its commitment.
+inline auto VersionedHash(std::span<std::byte const, bls12_381::kG1CompressedSize> commitment) -> Hash {
+  auto hash{Sha256(commitment)};
+  hash[0] = kVersionedHashVersion;
+  return hash;
+}
+
+namespace detail {
+
+// a compressed point as hex, with or without a 0x prefix; nullopt for anything else
+template <std::size_t kSize>
+auto ParseHex(std::string_view hex) -> std::optional<std::array<std::byte, kSize>> {
+  if (hex.starts_with("0x")) {
+    hex.remove_prefix(2);
+  }
+  if (hex.size() != 2 * kSize) {
+    return std::nullopt;
+  }
+  std::array<std::byte, kSize> bytes{};
+  for (std::size_t index{0}; index < kSize; ++index) {
+    std::uint8_t byte{0};
+    auto const* const first{hex.data() + 2 * index};
+    if (auto const [end, error]{std::from_chars(first, first + 2, byte, 16)}; error != std::errc{} or end != first + 2) {
+      return std::nullopt;
+    }
+    bytes[index] = static_cast<std::byte>(byte);
+  }
+  return bytes;
+}
+
+// [tau]G2 from a setup's text: the number of G1 points (one per field element of a blob), the number of G2 points
+// (at least two), the G1 points, then the G2 points [tau^i]G2 from i = 0, all compressed and in hex, one per line. What
+// follows (newer setups append the G1 points in monomial form) is not read, nor are the G1 points, which only provers
+// need.
+inline auto ParseTauG2(std::string_view text, std::filesystem::path const& path) -> bls12_381::G2Affine {
+  std::istringstream tokens{std::string{text}};
+  std::size_t g1_count{0};
+  std::size_t g2_count{0};
+  if (not(tokens >> g1_count >> g2_count) or g1_count != kFieldElementsPerBlob or g2_count < 2) {
+    throw std::runtime_error{std::format("[KZG]: '{}' is not a trusted setup of {} G1 points.", path.string(), kFieldElementsPerBlob)};
+  }
+  std::string token{};
+  for (std::size_t point{0}; point < g1_count; ++point) {
+    if (not(tokens >> token)) {
+      throw std::runtime_error{std::format("[KZG]: '{}' ends after {} of its G1 points.", path.string(), point)};
+    }
+  }
+  std::array<bls12_381::G2, 2> g2_points{};
+  for (auto& g2_point : g2_points) {
+    auto const bytes{tokens >> token ? ParseHex<bls12_381::kG2CompressedSize>(token) : std::nullopt};
+    auto const point{bytes ? bls12_381::DecompressG2(bytes->data()) : std::nullopt};
+    if (not point or point->IsInfinity()) {
+      throw std::runtime_error{std::format("[KZG]: '{}' has an invalid G2 point: '{}'.", path.string(), token)};
+    }
+    g2_point = *point;
+  }
+  if (g2_points[0] != bls12_381::G2::FromAffine(bls12_381::kG2Generator)) {
+    throw std::runtime_error{std::format("[KZG]: '{}' does not start its G2 points with the generator.", path.string())};
+  }
+  return curve::ToAffine(g2_points[1]);
+}
+
+}  // namespace detail
+
+// A setup's precomputed tables. They never change, so any number of threads verify against them at once.
+class TrustedSetup final {
+ public:
+  explicit TrustedSetup(bls12_381::G2Affine const& tau_g2)
+      : m_g2_lines{bls12_381::Prepare(bls12_381::kG2Generator)}, m_tau_g2_lines{bls12_381::Prepare(tau_g2)}, m_generator_table(kWindowCount * kDigitCount) {
+    std::vector<bls12_381::G1> multiples{};
+    multiples.reserve(m_generator_table.size());
+    auto window_base{bls12_381::G1::FromAffine(bls12_381::kG1Generator)};
+    for (std::size_t window{0}; window < kWindowCount; ++window) {
+      multiples.push_back(window_base);
+      for (std::size_t digit{1}; digit < kDigitCount; ++digit) {
+        multiples.push_back(curve::Add(multiples.back(), window_base));
+      }
+      window_base = curve::Add(multiples.back(), window_base);
+    }
+    curve::ToAffine<bls12_381::Fp>(multiples, m_generator_table);
+  }
+  TrustedSetup(TrustedSetup const&) = delete;
+  auto operator=(TrustedSetup const&) -> TrustedSetup& = delete;
+
+  // [scalar]G1, from the generator table
+  auto GeneratorMultiple(Fr const& scalar) const -> bls12_381::G1 {
+    auto const limbs{scalar.ToLimbs()};
+    bls12_381::G1 result{};
+    for (std::size_t window{0}; window < kWindowCount; ++window) {
+      auto const bit{window * kWindowBits};
+      if (auto const digit{static_cast<std::size_t>(limbs[bit / 64] >> (bit % 64)) & kDigitCount}; digit != 0) {
+        result = curve::Add(result, m_generator_table[window * kDigitCount + digit - 1]);
+      }
+    }
+    return result;
+  }
+
+  // Whether `proof` shows that the polynomial `commitment` commits to is y at z: p(X) - y = q(X) (X - z) at tau, with
+  // proof = [q(tau)]G1, so e(commitment - [y]G1 + [z]proof, G2) * e(-proof, [tau]G2) == 1, a pairing check whose G2
+  // points are both fixed. Both points are in G1.
+  auto VerifyProof(bls12_381::G1 const& commitment, Fr const& z, Fr const& y, bls12_381::G1 const& proof) const -> bool {
+    auto const lhs{curve::Add(curve::Add(commitment, -GeneratorMultiple(y)), curve::Multiply(proof, z.ToLimbs()))};
+    std::array const points{lhs, -proof};
+    std::array<bls12_381::G1Affine, 2> affine_points{};
+    curve::ToAffine<bls12_381::Fp>(points, affine_points);
+
+    std::array<bls12_381::G1Affine, 2> p{};
+    std::array<bls12_381::PreparedG2 const*, 2> q{};
+    std::size_t pair_count{0};
+    // a pair with G1's point at infinity pairs to 1
+    if (not lhs.IsInfinity()) {
+      p[pair_count] = affine_points[0];
+      q[pair_count++] = &m_g2_lines;
+    }
+    if (not proof.IsInfinity()) {
+      p[pair_count] = affine_points[1];
+      q[pair_count++] = &m_tau_g2_lines;
+    }
+    return bls12_381::PairingCheck(std::span{p}.first(pair_count), std::span{q}.first(pair_count));
+  }
+
+ private:
+  bls12_381::PreparedG2 m_g2_lines;
+  bls12_381::PreparedG2 m_tau_g2_lines;
+  std::vector<bls12_381::G1Affine> m_generator_table;
+};
+
+namespace detail {
+
+// every setup loaded, kept for the process's lifetime: a call on another thread may still verify against one that a
+// later load replaced
+struct LoadedSetups {
+  std::mutex mutex{};
+  std::vector<std::unique_ptr<TrustedSetup>> setups{};
+  std::atomic<TrustedSetup const*> active{nullptr};
+};
+
+inline auto Loaded() -> LoadedSetups& {
+  static LoadedSetups loaded{};
+  return loaded;
+}
+
+}  // namespace detail
+
+// Loads the setup in the text file at `path` and makes it the one the point evaluation precompile verifies against.
+inline auto LoadTrustedSetup(std::filesystem::path const& path) -> TrustedSetup const& {
+  std::ifstream file{path, std::ios::binary};
+  std::string const text{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+  if (not file) {
+    throw std::runtime_error{std::format("[KZG]: Could not read the trusted setup '{}'.", path.string())};
+  }
+  auto setup{std::make_unique<TrustedSetup>(detail::ParseTauG2(text, path))};
+
+  auto& loaded{detail::Loaded()};
+  std::scoped_lock const lock{loaded.mutex};
+  auto const& installed{*loaded.setups.emplace_back(std::move(setup))};
+  loaded.active.store(&installed, std::memory_order_release);
+  return installed;
+}
+
+// The setup LoadTrustedSetup() loaded last, null before the first load.
+inline auto ActiveTrustedSetup() -> TrustedSetup const* { return detail::Loaded().active.load(std::memory_order_acquire); }
+
+}  // namespace evmint::kzg
@@ -0,0 +1,239 @@
+// SPDX-License-Identifier: MIT
+
+// Logs emitted by LOG0..LOG4 and the 2048-bit logs bloom of receipts and blocks.
+//
+// A LogArena keeps the logs of one transaction in three flat vectors (records, topics, data bytes), so appending a log
+// only copies into their spare capacity, and an arena that is cleared and reused across transactions stops allocating
+// once it has seen its largest transaction. Checkpoint()/RollbackTo() journal it: an execution that fails drops the
+// logs it appended by truncating the vectors. Logs read back as views into the arena, valid until the next append.
+//
+// A receipt's bloom sets three bits per address and topic, taken from the entry's Keccak-256. A block's bloom is the
+// OR of its receipts' blooms, which OrBlooms computes over whole batches of them: on x86-64 hosts with AVX2 a bloom is
+// eight 256-bit registers and every receipt eight loads and ORs, chosen once at startup; elsewhere 64-bit words.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "evm.hpp"
+#include "keccak.hpp"
+
+namespace evmint {
+
+constexpr std::size_t kMaxTopicCount{4};
+constexpr std::size_t kAddressSize{20};
+
+// bit i of the bloom is bit i % 8 of byte 255 - i / 8, as receipts encode it
+using Bloom = std::array<std::byte, 256>;
+
+struct Log {
+  word_t address{};
+  std::span<word_t const> topics{};
+  std::span<std::byte const> data{};
+};
+
+// sizes of a LogArena's vectors at the time of the checkpoint
+struct LogCheckpoint {
+  std::size_t log_count{0};
+  std::size_t topic_count{0};
+  std::size_t data_size{0};
+};
+
+class LogArena {
+ public:
+  // room a fresh arena makes on its first log, enough for most transactions
+  static constexpr std::size_t kInitialLogCapacity{16};
+  static constexpr std::size_t kInitialDataCapacity{1'024};
+
+  auto Append(word_t const& address, std::span<word_t const> topics, std::span<std::byte const> data) -> void {
+    if (m_records.capacity() == 0) {
+      m_records.reserve(kInitialLogCapacity);
+      m_topics.reserve(kInitialLogCapacity * kMaxTopicCount);
+      m_data.reserve(kInitialDataCapacity);
+    }
+    m_records.push_back({.address = address, .topic_begin = m_topics.size(), .topic_count = topics.size(), .data_begin = m_data.size(), .data_size = data.size()});
+    m_topics.insert(std::end(m_topics), std::begin(topics), std::end(topics));
+    m_data.insert(std::end(m_data), std::begin(data), std::end(data));
+  }
+
+  auto Checkpoint() const -> LogCheckpoint { return {.log_count = m_records.size(), .topic_count = m_topics.size(), .data_size = m_data.size()}; }
+
+  // Drops every log appended since `checkpoint`.
+  auto RollbackTo(LogCheckpoint const& checkpoint) -> void {
+    m_records.resize(checkpoint.log_count);
+    m_topics.resize(checkpoint.topic_count);
+    m_data.resize(checkpoint.data_size);
+  }
+
+  // Drops every log, keeping the capacity.
+  auto Clear() -> void { RollbackTo({}); }
+
+  auto size() const -> std::size_t { return m_records.size(); }
+  auto empty() const -> bool { return m_records.empty(); }
+
+  auto operator[](std::size_t index) const -> Log {
+    auto const& record{m_records[index]};
+    return {.address = record.address,
+            .topics = std::span{m_topics}.subspan(record.topic_begin, record.topic_count),
+            .data = std::span{m_data}.subspan(record.data_begin, record.data_size)};
+  }
+
+  auto operator==(LogArena const&) const -> bool = default;
+
+ private:
+  struct LogRecord {
+    word_t address{};
+    std::size_t topic_begin{0};
+    std::size_t topic_count{0};
+    std::size_t data_begin{0};
+    std::size_t data_size{0};
+
+    auto operator==(LogRecord const&) const -> bool = default;
+  };
+
+  std::vector<LogRecord> m_records{};
+  std::vector<word_t> m_topics{};
+  std::vector<std::byte> m_data{};
+};
+
+namespace bloom {
+
+// bit indices an entry sets
+using BloomBits = std::array<std::uint16_t, 3>;
+
+// the low 11 bits of the hash's byte pairs 0-1, 2-3 and 4-5
+inline auto BitsOf(std::span<std::byte const> entry) -> BloomBits {
+  auto const hash{Keccak256(entry)};
+  BloomBits bits{};
+  for (std::size_t pair{0}; pair < bits.size(); ++pair) {
+    bits[pair] = static_cast<std::uint16_t>((static_cast<unsigned>(hash[2 * pair]) << kByteSize | static_cast<unsigned>(hash[2 * pair + 1])) & 0x7ff);
+  }
+  return bits;
+}
+
+inline auto AddressBits(word_t const& address) -> BloomBits {
+  std::array<std::uint8_t, kWordSize> bytes{};
+  StoreWord(bytes.data(), address);
+  return BitsOf(std::as_bytes(std::span{bytes}).subspan(kWordSize - kAddressSize));
+}
+
+inline auto TopicBits(word_t const& topic) -> BloomBits {
+  std::array<std::uint8_t, kWordSize> bytes{};
+  StoreWord(bytes.data(), topic);
+  return BitsOf(std::as_bytes(std::span{bytes}));
+}
+
+inline auto Set(Bloom& bloom, BloomBits const& bits) -> void {
+  for (auto const bit : bits) {
+    bloom[bloom.size() - 1 - bit / kByteSize] |= static_cast<std::byte>(1u << (bit % kByteSize));
+  }
+}
+
+// Whether every bit of `bits` is set, as it is for anything added to the bloom (and by chance for some that was not).
+inline auto Contains(Bloom const& bloom, BloomBits const& bits) -> bool {
+  return std::ranges::all_of(bits, [&bloom](auto bit) { return (bloom[bloom.size() - 1 - bit / kByteSize] & static_cast<std::byte>(1u << (bit % kByteSize))) != std::byte{0}; });
+}
+
+inline auto OrBloomsPortable(Bloom& bloom, std::span<Bloom const> blooms) -> void {
+  constexpr std::size_t kWordCount{sizeof(Bloom) / sizeof(std::uint64_t)};
+  std::array<std::uint64_t, kWordCount> accumulator{};
+  std::memcpy(accumulator.data(), bloom.data(), sizeof(Bloom));
+  for (auto const& other : blooms) {
+    std::array<std::uint64_t, kWordCount> words{};
+    std::memcpy(words.data(), other.data(), sizeof(Bloom));
+#pragma GCC unroll 32
+    for (std::size_t word{0}; word < kWordCount; ++word) {
+      accumulator[word] |= words[word];
+    }
+  }
+  std::memcpy(bloom.data(), accumulator.data(), sizeof(Bloom));
+}
+
+#if defined(__x86_64__)
+// The accumulator stays in eight registers for the whole batch; each bloom is eight unaligned loads, ORed in.
+__attribute__((target("avx2"))) inline auto OrBloomsAvx2(Bloom& bloom, std::span<Bloom const> blooms) -> void {
+  constexpr std::size_t kLaneCount{sizeof(Bloom) / sizeof(__m256i)};
+  // not a std::array, which would drop __m256i's alignment attribute
+  __m256i accumulator[kLaneCount];
+#pragma GCC unroll 8
+  for (std::size_t lane{0}; lane < kLaneCount; ++lane) {
+    accumulator[lane] = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(bloom.data()) + lane);
+  }
+  for (auto const& other : blooms) {
+    auto const* const source{reinterpret_cast<__m256i const*>(other.data())};
+#pragma GCC unroll 8
+    for (std::size_t lane{0}; lane < kLaneCount; ++lane) {
+      accumulator[lane] = _mm256_or_si256(accumulator[lane], _mm256_loadu_si256(source + lane));
+    }
+  }
+#pragma GCC unroll 8
+  for (std::size_t lane{0}; lane < kLaneCount; ++lane) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(bloom.data()) + lane, accumulator[lane]);
+  }
+}
+#endif
+
+using OrBloomsFunction = auto (*)(Bloom&, std::span<Bloom const>) -> void;
+
+inline OrBloomsFunction const kOrBlooms{[]() -> OrBloomsFunction {
+#if defined(__x86_64__)
+  if (__builtin_cpu_supports("avx2")) {
+    return &OrBloomsAvx2;
+  }
+#endif
+  return &OrBloomsPortable;
+}()};
+
+}  // namespace bloom
+
+// ORs every bloom of `blooms` into `bloom`.
+inline auto OrBlooms(Bloom& bloom, std::span<Bloom const> blooms) -> void { bloom::kOrBlooms(bloom, blooms); }
+
+// The bloom of a receipt with these logs. Logs in a row, within a receipt and across the receipts a thread computes
+// one after another, mostly come from the same contract with the same event signature as first topic (a token's
+// Transfer events), so the last address and signature hashed on the thread are reused instead of hashed again.
+inline auto LogsBloom(LogArena const& logs) -> Bloom {
+  thread_local std::optional<std::pair<word_t, bloom::BloomBits>> last_address{};
+  thread_local std::optional<std::pair<word_t, bloom::BloomBits>> last_signature{};
+
+  Bloom bloom{};
+  for (std::size_t index{0}; index < logs.size(); ++index) {
+    auto const log{logs[index]};
+    if (not last_address or last_address->first != log.address) {
+      last_address.emplace(log.address, bloom::AddressBits(log.address));
+    }
+    bloom::Set(bloom, last_address->second);
+    if (log.topics.empty()) {
+      continue;
+    }
+    if (not last_signature or last_signature->first != log.topics[0]) {
+      last_signature.emplace(log.topics[0], bloom::TopicBits(log.topics[0]));
+    }
+    bloom::Set(bloom, last_signature->second);
+    for (auto const& topic : log.topics.subspan(1)) {
+      bloom::Set(bloom, bloom::TopicBits(topic));
+    }
+  }
+  return bloom;
+}
+
+// The bloom of a block whose receipts have these blooms.
+inline auto BlockBloom(std::span<Bloom const> receipt_blooms) -> Bloom {
+  Bloom bloom{};
+  OrBlooms(bloom, receipt_blooms);
+  return bloom;
+}
+
+}  // namespace evmint
@@ -1,308 +1,1715 @@
 // SPDX-License-Identifier: MIT
 
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <functional>
+#include <memory>
+#include <optional>
 #include <print>
 #include <ranges>
-#include <stack>
-#include <unordered_map>
+#include <set>
+#include <thread>
+#include <utility>
 
 #include <range/v3/all.hpp>
 #include <magic_enum.hpp>
 #include <intx/intx.hpp>
 
+#include "aot.hpp"
+#include "batch_executor.hpp"
+#include "block_executor.hpp"
+#if defined(__linux__)
+#include "disk_state.hpp"
+#endif
+#include "flat_state.hpp"
+#include "evm.hpp"
+#include "ingest.hpp"
+#include "interpreter.hpp"
+#include "keccak.hpp"
+#include "logs.hpp"
+#include "precompiles.hpp"
+#include "server.hpp"
+#include "state.hpp"
+#include "state_store.hpp"
+#include "trie.hpp"
+#include "worker_pool.hpp"
+
+using namespace evmint;
+
 namespace {
-constexpr std::size_t kHexBase{16};
-constexpr std::size_t kWordSize{32};
-constexpr std::size_t kByteSize{8};
-constexpr std::size_t kMaxStackWordsSize{1024};
-constexpr std::size_t kMaxStackSize{kMaxStackWordsSize * 8};
-// TODO: 2^256
-constexpr std::size_t kMemorySize{100'000};
-
-using opcode_t = std::byte;
-using word_t = intx::uint256;
-
-constexpr opcode_t kShl{0x1b};
-constexpr opcode_t kMLoad{0x51};
-constexpr opcode_t kMStore{0x52};
-constexpr opcode_t kJump{0x56};
-constexpr opcode_t kJumpDest{0x5b};
-constexpr opcode_t kPush0{0x5f};
-constexpr opcode_t kPush1{0x60};
-constexpr opcode_t kPush2{0x61};
-constexpr opcode_t kPush12{0x6b};
-constexpr opcode_t kDup2{0x81};
-constexpr opcode_t kDup3{0x82};
-constexpr opcode_t kSwap1{0x90};
-
-enum class RevertError { kStackOverflow, kGasExceeded, kStackUnderflow, kMemoryUnalignedAccess, kInvalidJump };
-
-struct OpcodeInfo {
-  std::size_t advance_by{0};
-  std::size_t gas_consumed{0};
-};
-
-std::unordered_map<opcode_t, OpcodeInfo> const kOpcodeInfo{
-    {kMLoad, {}}, {kJump, {}}, {kDup3, {}}, {kPush2, {.advance_by = 2}}, {kPush0, {}}, {kPush12, {.advance_by = 12}}, {kPush1, {.advance_by = 1, .gas_consumed = 0}}, {kMStore, {}},
-    {kSwap1, {}}, {kDup2, {}}, {kShl, {}}};
-
-auto to_uint256(std::span<std::uint8_t const> byte_array) -> intx::uint256 {
-  if (byte_array.size() > kWordSize) {
-    throw std::invalid_argument{"Passed in byte array can not fit in uint256 object."};
-  }
-
-  intx::uint256 word{};
-  for (auto const byte : byte_array) {
-    word = (word << kByteSize) | byte;
-  }
-  return word;
+
+// relative to the repository root, which evmint is run from
+constexpr std::string_view kDefaultBytecodeFilepath{"data/smartcontracts/bin/HelloWorld.bin"};
+
+// acc = 1; for (i = iterations; i != 0; --i) { acc = ((acc + i) * i) ^ i; }
+auto MakeArithmeticLoopBytecode(std::uint16_t iterations) -> std::vector<std::byte> {
+  std::vector<std::uint8_t> const raw_bytecode{
+      0x60, 0x01,                                                     // PUSH1 1            [acc]
+      0x61, static_cast<std::uint8_t>(iterations >> kByteSize), static_cast<std::uint8_t>(iterations),  // PUSH2 iterations   [acc, i]
+      0x5b,                                                           // JUMPDEST           loop:
+      0x90, 0x81, 0x01, 0x81, 0x02, 0x81, 0x18, 0x90,                 // SWAP1 DUP2 ADD DUP2 MUL DUP2 XOR SWAP1
+      0x60, 0x01, 0x90, 0x03,                                         // PUSH1 1 SWAP1 SUB  [acc, i - 1]
+      0x80, 0x60, 0x05, 0x57,                                         // DUP1 PUSH1 loop JUMPI
+      0x00};                                                          // STOP
+  return raw_bytecode | std::views::transform([](auto byte) { return static_cast<std::byte>(byte); }) | std::ranges::to<std::vector>();
+}
+
+auto RunDispatchBenchmark() -> bool {
+  constexpr std::uint16_t kIterations{0xffff};
+  constexpr std::size_t kRepetitions{10};
+
+  // a zero threshold compiles on the first kTiered run
+  Interpreter interpreter{{.trace_execution = false, .jit_threshold = 0}};
+  interpreter.LoadBytecode(MakeArithmeticLoopBytecode(kIterations));
+
+  std::vector<std::pair<WordStack, std::size_t>> final_states{};
+  for (auto const dispatch_mode : {DispatchMode::kHandlerTable, DispatchMode::kTopOfStackCached, DispatchMode::kTiered}) {
+    auto best{std::chrono::nanoseconds::max()};
+    for (std::size_t repetition{0}; repetition < kRepetitions; ++repetition) {
+      interpreter.Reset();
+      auto const start{std::chrono::steady_clock::now()};
+      interpreter.Interpret(dispatch_mode);
+      best = std::min(best, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start));
+    }
+    final_states.emplace_back(interpreter.Stack(), interpreter.GasLeft());
+
+    std::println("{:<20} {:>10.2f} ns/iteration (best of {})", magic_enum::enum_name(dispatch_mode), static_cast<double>(best.count()) / kIterations, kRepetitions);
+  }
+
+  if (std::ranges::adjacent_find(final_states, std::ranges::not_equal_to{}) != std::end(final_states)) {
+    std::println("[ERROR] dispatch modes disagree on the final stack or gas");
+    return false;
+  }
+  return true;
 }
 
-// TODO: in following function templates, constrain template type via concept
+// Same loop as MakeArithmeticLoopBytecode, seeded from storage slot 0, running for the number of iterations in the
+// first call data word, and storing the result in slot 1.
+auto MakeStorageLoopBytecode() -> std::vector<std::byte> {
+  std::vector<std::uint8_t> const raw_bytecode{
+      0x60, 0x00, 0x54,                                // PUSH1 0 SLOAD          [acc]
+      0x60, 0x00, 0x35,                                // PUSH1 0 CALLDATALOAD   [acc, i]
+      0x5b,                                            // JUMPDEST               loop:
+      0x90, 0x81, 0x01, 0x81, 0x02, 0x81, 0x18, 0x90,  // SWAP1 DUP2 ADD DUP2 MUL DUP2 XOR SWAP1
+      0x60, 0x01, 0x90, 0x03,                          // PUSH1 1 SWAP1 SUB      [acc, i - 1]
+      0x80, 0x60, 0x06, 0x57,                          // DUP1 PUSH1 loop JUMPI
+      0x50, 0x60, 0x01, 0x55,                          // POP PUSH1 1 SSTORE
+      0x00};                                           // STOP
+  return raw_bytecode | std::views::transform([](auto byte) { return static_cast<std::byte>(byte); }) | std::ranges::to<std::vector>();
+}
 
-// TODO: stack-contents array static??
-template <std::size_t num_bytes>
-auto PushToStack(auto&& execution_context) {
-  // PUSHn <value>
-  // Push n byte items (following opcode) on stack.
+// Runs the same batch of uneven storage-loop jobs with 1, 2, 4, ... workers up to the number of hardware threads and
+// reports throughput, speedup and per-worker throughput.
+auto RunBatchBenchmark() -> void {
+  constexpr std::size_t kJobCount{20'000};
+  constexpr std::size_t kStateCount{16};
 
-  intx::uint256 stack_item{0};
+  auto const bytecode{std::make_shared<std::vector<std::byte> const>(MakeStorageLoopBytecode())};
+  std::vector<std::shared_ptr<StateView const>> states{};
+  for (std::size_t state_index{0}; state_index < kStateCount; ++state_index) {
+    states.push_back(std::make_shared<StateSnapshot const>(Accounts{{0, {.storage = {{0, word_t{state_index + 1}}}}}}));
+  }
 
-  if constexpr (num_bytes) {
-    std::array<std::uint8_t, num_bytes> stack_item_bytes{};
-    auto raw_data_span{std::span{std::next(std::begin(execution_context.bytecode), execution_context.program_counter + 1), num_bytes} |
-                       std::views::transform([](auto byte) { return static_cast<std::uint8_t>(byte); })};
-    std::ranges::copy(raw_data_span, std::begin(stack_item_bytes));
-    stack_item = to_uint256(stack_item_bytes);
+  std::vector<BatchJob> jobs(kJobCount);
+  for (std::size_t job_index{0}; job_index < kJobCount; ++job_index) {
+    // job costs vary by 16x, and the expensive ones are clustered, so static partitioning alone would be unbalanced
+    std::vector<std::byte> calldata(kWordSize);
+    StoreWord(reinterpret_cast<std::uint8_t*>(calldata.data()), word_t{16 + (job_index * 256 / kJobCount) * (job_index % 16)});
+    jobs[job_index] = {.bytecode = bytecode, .calldata = std::move(calldata), .state = states[job_index % kStateCount]};
   }
 
-  execution_context.stack.push(stack_item);
+  std::optional<std::vector<BatchJobResult>> reference_results{};
+  double single_worker_throughput{0};
+  for (std::size_t worker_count{1}; worker_count <= std::max(std::thread::hardware_concurrency(), 1u); worker_count *= 2) {
+    BatchExecutor executor{worker_count};
+    // warm-up batch: tiers the contract up in every worker
+    executor.Execute(jobs);
+
+    auto const start{std::chrono::steady_clock::now()};
+    auto results{executor.Execute(jobs)};
+    auto const elapsed{std::chrono::duration<double>(std::chrono::steady_clock::now() - start)};
 
-  if (execution_context.stack.size() > kMaxStackSize) {
-    throw std::runtime_error{std::format("[PUSHn]: Revert due to {}.", magic_enum::enum_name(RevertError::kStackOverflow))};
+    auto const throughput{static_cast<double>(kJobCount) / elapsed.count()};
+    if (not reference_results) {
+      single_worker_throughput = throughput;
+    }
+    std::println("{:>3} workers {:>12.0f} jobs/s  speedup {:>6.2f}", worker_count, throughput, throughput / single_worker_throughput);
+    for (std::size_t worker_index{0}; worker_index < executor.WorkerCount(); ++worker_index) {
+      auto const& statistics{executor.Statistics()[worker_index]};
+      auto const busy_seconds{std::chrono::duration<double>(statistics.busy_time).count()};
+      std::println("    worker {:>3}: {:>6} jobs ({:>6} stolen) {:>12.0f} jobs/s {:>8.1f} Mgas/s", worker_index, statistics.jobs_executed, statistics.jobs_stolen,
+                   static_cast<double>(statistics.jobs_executed) / busy_seconds, static_cast<double>(statistics.gas_used) / busy_seconds / 1e6);
+    }
+
+    auto const same_results{[](auto const& lhs, auto const& rhs) { return lhs.succeeded == rhs.succeeded and lhs.gas_used == rhs.gas_used and lhs.storage_writes == rhs.storage_writes; }};
+    if (not reference_results) {
+      reference_results = std::move(results);
+    } else if (not std::ranges::equal(results, *reference_results, same_results)) {
+      std::println("[ERROR] batch results depend on the number of workers");
+    }
   }
+}
 
-  return execution_context;
+// Spins the arithmetic loop for the iterations in call data word 1, then increments the storage slot that call data
+// word 0 names.
+auto MakeCounterBytecode() -> std::vector<std::byte> {
+  std::vector<std::uint8_t> const raw_bytecode{
+      0x60, 0x01, 0x60, 0x20, 0x35,                    // PUSH1 1 PUSH1 32 CALLDATALOAD   [acc, i]
+      0x5b,                                            // JUMPDEST                        loop:
+      0x90, 0x81, 0x01, 0x81, 0x02, 0x81, 0x18, 0x90,  // SWAP1 DUP2 ADD DUP2 MUL DUP2 XOR SWAP1
+      0x60, 0x01, 0x90, 0x03,                          // PUSH1 1 SWAP1 SUB               [acc, i - 1]
+      0x80, 0x60, 0x05, 0x57,                          // DUP1 PUSH1 loop JUMPI
+      0x50, 0x60, 0x00, 0x35,                          // POP PUSH1 0 CALLDATALOAD        [acc, slot]
+      0x80, 0x54, 0x60, 0x01, 0x01,                    // DUP1 SLOAD PUSH1 1 ADD          [acc, slot, counter + 1]
+      0x90, 0x55, 0x50,                                // SWAP1 SSTORE POP
+      0x00};                                           // STOP
+  return raw_bytecode | std::views::transform([](auto byte) { return static_cast<std::byte>(byte); }) | std::ranges::to<std::vector>();
 }
 
-auto Jump(auto&& execution_context) {
-  // JUMP <counter>
-  // Alter the program counter
+// Milliseconds of the fastest of `repetitions` runs of `execute`.
+auto TimeBestOf(std::size_t repetitions, auto&& execute) -> double {
+  auto best{std::chrono::nanoseconds::max()};
+  for (std::size_t repetition{0}; repetition < repetitions; ++repetition) {
+    auto const start{std::chrono::steady_clock::now()};
+    execute();
+    best = std::min(best, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start));
+  }
+  return std::chrono::duration<double, std::milli>(best).count();
+}
 
-  if (execution_context.stack.size() < 1) {
-    throw std::runtime_error{std::format("[JUMP]: Revert due to {}.", magic_enum::enum_name(RevertError::kStackUnderflow))};
+// Synthetic blocks: mostly counter increments on one contract, every tenth transaction a plain transfer to a fresh
+// account. Contention is set by how many distinct counter slots the calls spread over.
+auto RunBlockBenchmark() -> void {
+  constexpr std::size_t kTransactionCount{10'000};
+  constexpr std::size_t kLoopIterations{32};
+  constexpr std::size_t kRepetitions{5};
+  word_t const contract{0x1000};
+  word_t const first_sender{0x2000};
+  word_t const first_recipient{0x100000};
+
+  Accounts accounts{{contract, {.code = MakeCounterBytecode()}}};
+  for (std::size_t index{0}; index < kTransactionCount; ++index) {
+    accounts[first_sender + index].balance = 1'000'000;
   }
+  StateSnapshot const pre_block_state{std::move(accounts)};
+
+  Interpreter serial_interpreter{kExecutorOptions};
+  BlockExecutor executor{};
+  std::println("{} transactions, {} workers", kTransactionCount, executor.WorkerCount());
+
+  for (auto const& [contention, slot_count] : std::array<std::pair<std::string_view, std::size_t>, 3>{{{"low", kTransactionCount}, {"medium", 100}, {"high", 1}}}) {
+    std::vector<Transaction> transactions(kTransactionCount);
+    for (std::size_t index{0}; index < kTransactionCount; ++index) {
+      if (index % 10 == 9) {
+        transactions[index] = {.from = first_sender + index, .to = first_recipient + index, .value = 1};
+        continue;
+      }
+      std::vector<std::byte> calldata(2 * kWordSize);
+      StoreWord(reinterpret_cast<std::uint8_t*>(calldata.data()), word_t{index * 2'654'435'761 % slot_count});
+      StoreWord(reinterpret_cast<std::uint8_t*>(calldata.data()) + kWordSize, word_t{kLoopIterations});
+      transactions[index] = {.from = first_sender + index, .to = contract, .calldata = std::move(calldata)};
+    }
 
-  auto const counter{execution_context.stack.top()};
-  execution_context.stack.pop();
+    BlockResult serial_result{};
+    BlockResult parallel_result{};
+    auto const serial_ms{TimeBestOf(kRepetitions, [&] {
+      serial_result = ExecuteBlockSerially(serial_interpreter, DispatchMode::kTiered, pre_block_state, transactions);
+    })};
+    auto const parallel_ms{TimeBestOf(kRepetitions, [&] { parallel_result = executor.Execute(pre_block_state, transactions); })};
+
+    auto const& statistics{executor.Statistics()};
+    std::println("{:<7} contention ({:>5} slots): serial {:>8.2f} ms, parallel {:>8.2f} ms, speedup {:>5.2f}, executions {:>6}, aborts {:>5}, dependency waits {:>5}, {}", contention,
+                 slot_count, serial_ms, parallel_ms, serial_ms / parallel_ms, statistics.executions, statistics.validation_aborts, statistics.dependency_waits,
+                 parallel_result == serial_result ? "matches serial" : "DIFFERS FROM SERIAL");
+  }
+}
 
-  execution_context.program_counter = static_cast<std::size_t>(counter);
-  if (execution_context.bytecode.at(execution_context.program_counter) != kJumpDest) {
-    throw std::runtime_error{std::format("[JUMP]: Revert due to {}.", magic_enum::enum_name(RevertError::kInvalidJump))};
+// An ERC-20 token cut down to transfer(from, to, amount), with the sender in call data word 0 as there is no CALLER:
+// moves the amount between the two holders' balance slots (keyed by holder) and emits Transfer(from, to, amount) with
+// from and to as topics. A short balance jumps to 0, which is no JUMPDEST, so the call fails and emits nothing.
+auto MakeErc20TransferBytecode(word_t const& transfer_signature) -> std::vector<std::byte> {
+  std::vector<std::uint8_t> raw_bytecode{
+      0x60, 0x40, 0x35, 0x60, 0x00, 0x35,  // PUSH1 64 CALLDATALOAD PUSH1 0 CALLDATALOAD   [amount, from]
+      0x80, 0x54,                          // DUP1 SLOAD                                [amount, from, balance]
+      0x82, 0x81, 0x10, 0x60, 0x00, 0x57,  // DUP3 DUP2 LT PUSH1 0 JUMPI                fails if balance < amount
+      0x82, 0x90, 0x03, 0x90, 0x55,        // DUP3 SWAP1 SUB SWAP1 SSTORE               [amount]
+      0x60, 0x20, 0x35, 0x80, 0x54,        // PUSH1 32 CALLDATALOAD DUP1 SLOAD          [amount, to, balance]
+      0x82, 0x01, 0x90, 0x55,              // DUP3 ADD SWAP1 SSTORE                     [amount]
+      0x60, 0x00, 0x52,                    // PUSH1 0 MSTORE                            []
+      0x60, 0x20, 0x35, 0x60, 0x00, 0x35,  // PUSH1 32 CALLDATALOAD PUSH1 0 CALLDATALOAD   [to, from]
+      0x7f};                               // PUSH32 <transfer signature>               [to, from, signature]
+  std::array<std::uint8_t, kWordSize> signature{};
+  StoreWord(signature.data(), transfer_signature);
+  raw_bytecode.insert(std::end(raw_bytecode), std::begin(signature), std::end(signature));
+  raw_bytecode.insert(std::end(raw_bytecode), {0x60, 0x20, 0x60, 0x00, 0xa3,   // PUSH1 32 PUSH1 0 LOG3   data: memory[0, 32), the amount
+                                               0x00});                         // STOP
+  return raw_bytecode | std::views::transform([](auto byte) { return static_cast<std::byte>(byte); }) | std::ranges::to<std::vector>();
+}
+
+// Blocks of ERC-20 transfers, one Transfer event each and every 50th failing on a short balance: serial against
+// Block-STM, logs and blooms included in the comparison, first spread over many holders, then all paying one. Then the
+// receipt blooms and the block bloom (portable against the OR dispatched at startup) on their own, and LOGn under every
+// dispatch mode into an arena that already holds logs: a successful call appends to it, a failing one leaves it as it
+// was.
+auto RunErc20Benchmark() -> bool {
+  constexpr std::size_t kTransactionCount{10'000};
+  constexpr std::size_t kHolderCount{10'000};
+  constexpr std::size_t kRepetitions{5};
+  word_t const token{0x1000};
+  word_t const first_holder{0x2000};
+  word_t const initial_balance{1'000'000};
+  auto const transfer_signature{ToWord(Keccak256(std::as_bytes(std::span{std::string_view{"Transfer(address,address,uint256)"}})))};
+
+  Accounts accounts{{token, {.code = MakeErc20TransferBytecode(transfer_signature)}}};
+  for (std::size_t index{0}; index < kHolderCount; ++index) {
+    accounts[token].storage[first_holder + index] = initial_balance;
+  }
+  StateSnapshot const pre_block_state{std::move(accounts)};
+
+  Interpreter serial_interpreter{kExecutorOptions};
+  BlockExecutor executor{};
+  std::println("{} transfers, {} workers", kTransactionCount, executor.WorkerCount());
+
+  auto all_match{true};
+  BlockResult block{};
+  for (auto const& [recipients, recipient_count] : std::array<std::pair<std::string_view, std::size_t>, 2>{{{"spread", kHolderCount}, {"one recipient", 1}}}) {
+    std::vector<Transaction> transactions(kTransactionCount);
+    for (std::size_t index{0}; index < kTransactionCount; ++index) {
+      auto const from{first_holder + index % kHolderCount};
+      auto const to{first_holder + (index * 7'919 + 1) % recipient_count};
+      auto const amount{index % 50 == 49 ? 2 * initial_balance : word_t{index % 1'000 + 1}};
+      std::vector<std::byte> calldata(3 * kWordSize);
+      StoreWord(reinterpret_cast<std::uint8_t*>(calldata.data()), from);
+      StoreWord(reinterpret_cast<std::uint8_t*>(calldata.data()) + kWordSize, to);
+      StoreWord(reinterpret_cast<std::uint8_t*>(calldata.data()) + 2 * kWordSize, amount);
+      transactions[index] = {.from = from, .to = token, .calldata = std::move(calldata)};
+    }
+
+    BlockResult serial_result{};
+    BlockResult parallel_result{};
+    auto const serial_ms{TimeBestOf(kRepetitions, [&] {
+      serial_result = ExecuteBlockSerially(serial_interpreter, DispatchMode::kTiered, pre_block_state, transactions);
+    })};
+    auto const parallel_ms{TimeBestOf(kRepetitions, [&] { parallel_result = executor.Execute(pre_block_state, transactions); })};
+
+    auto const log_count{std::ranges::fold_left(serial_result.transaction_logs | std::views::transform(&LogArena::size), std::size_t{0}, std::plus<>{})};
+    auto const succeeded{std::ranges::count_if(serial_result.transaction_results, &TransactionResult::succeeded)};
+    auto const first_log{serial_result.transaction_logs[0][0]};
+    auto const logged_as_emitted{log_count == static_cast<std::size_t>(succeeded) and first_log.address == token and
+                                 std::ranges::equal(first_log.topics, std::array{transfer_signature, first_holder, first_holder + 1 % recipient_count}) and
+                                 LoadWord(reinterpret_cast<std::uint8_t const*>(first_log.data.data())) == 1};
+    auto const in_block_bloom{bloom::Contains(serial_result.logs_bloom, bloom::AddressBits(token)) and bloom::Contains(serial_result.logs_bloom, bloom::TopicBits(transfer_signature))};
+    all_match = all_match and parallel_result == serial_result and logged_as_emitted and in_block_bloom;
+
+    auto const& statistics{executor.Statistics()};
+    std::println("{:<13}: serial {:>8.2f} ms ({:>9.0f} logs/s), parallel {:>8.2f} ms, speedup {:>5.2f}, aborts {:>5}, {} logs {}, bloom {}, {}", recipients, serial_ms,
+                 static_cast<double>(log_count) / serial_ms * 1e3, parallel_ms, serial_ms / parallel_ms, statistics.validation_aborts, log_count,
+                 logged_as_emitted ? "as emitted" : "WRONG", in_block_bloom ? "covers them" : "MISSES THEM", parallel_result == serial_result ? "matches serial" : "DIFFERS FROM SERIAL");
+    block = std::move(serial_result);
   }
 
-  return execution_context;
+  std::vector<Bloom> receipt_blooms(kTransactionCount);
+  auto const receipt_ms{TimeBestOf(kRepetitions, [&] {
+    std::ranges::transform(block.transaction_logs, std::begin(receipt_blooms), [](LogArena const& logs) { return logs.empty() ? Bloom{} : LogsBloom(logs); });
+  })};
+  Bloom portable_bloom{};
+  Bloom dispatched_bloom{};
+  auto const portable_ms{TimeBestOf(kRepetitions, [&] {
+    portable_bloom = {};
+    bloom::OrBloomsPortable(portable_bloom, receipt_blooms);
+  })};
+  auto const dispatched_ms{TimeBestOf(kRepetitions, [&] { dispatched_bloom = BlockBloom(receipt_blooms); })};
+  auto const blooms_match{receipt_blooms == block.logs_blooms and portable_bloom == block.logs_bloom and dispatched_bloom == block.logs_bloom};
+  std::println("receipt blooms {:>8.1f} ns each, block bloom: portable {:>7.1f} us, {} {:>7.1f} us, {}", receipt_ms * 1e6 / kTransactionCount, portable_ms * 1e3,
+               bloom::kOrBlooms == &bloom::OrBloomsPortable ? "portable" : "AVX2", dispatched_ms * 1e3, blooms_match ? "match" : "DIFFER");
+  all_match = all_match and blooms_match;
+
+  // LOG0 of memory[0, 32), then, failing only, a jump to 0
+  std::vector<std::byte> const logging_code{kPush1, std::byte{0x20}, kPush0, kLog0};
+  std::vector<std::byte> const failing_code{kPush1, std::byte{0x20}, kPush0, kLog0, kPush0, kJump};
+  Interpreter interpreter{};
+  for (auto const dispatch_mode : {DispatchMode::kHandlerTable, DispatchMode::kTopOfStackCached, DispatchMode::kTiered}) {
+    auto logs{block.transaction_logs[0]};
+    auto const before{logs};
+    auto const failed{interpreter.Execute({.code = failing_code, .address = token, .dispatch_mode = dispatch_mode, .logs = &logs})};
+    auto const rolled_back{failed.status == ExecutionStatus::kInvalidJump and logs == before};
+    auto const logged{interpreter.Execute({.code = logging_code, .address = token, .dispatch_mode = dispatch_mode, .logs = &logs})};
+    auto const appended{logged.status == ExecutionStatus::kSuccess and logged.gas_used == 3 + 2 + kLogGas + kWordSize * kLogDataByteGas and logs.size() == before.size() + 1 and
+                        logs[before.size()].topics.empty() and std::ranges::equal(logs[before.size()].data, std::vector<std::byte>(kWordSize))};
+    std::println("{:<20} failing call {}, logging call {}", magic_enum::enum_name(dispatch_mode), rolled_back ? "rolled back" : "KEPT ITS LOGS", appended ? "appended" : "WRONG");
+    all_match = all_match and rolled_back and appended;
+  }
+  return all_match;
 }
 
-auto StoreToMemory(auto&& execution_context) {
-  // MSTORE <offset> <value>
-  // save word to memory
+// Random storage reads from 1, 2, 4, ... 64 threads sharing one StateStore view, first on a quiet store, then while a
+// committer keeps installing (and pruning) new versions underneath the readers.
+auto RunStateStoreBenchmark() -> void {
+  constexpr std::size_t kSlotCount{1 << 18};
+  constexpr std::size_t kReadsPerThread{1 << 20};
+  constexpr std::size_t kMaxThreads{64};
+  constexpr std::size_t kSlotsPerCommit{1000};
+  word_t const address{0x1000};
+
+  StateStore store{};
+  for (std::size_t version{0}; version < 4; ++version) {
+    StateWrites writes{};
+    for (std::size_t slot{version}; slot < kSlotCount; slot += 2) {
+      writes.emplace(StateKey::Storage(address, slot), word_t{slot + version});
+    }
+    store.Commit(writes);
+  }
+
+  for (auto const with_committer : {false, true}) {
+    std::println("{}", with_committer ? "reads during commits:" : "reads on a quiet store:");
+    double single_thread_throughput{0};
+    for (std::size_t thread_count{1}; thread_count <= kMaxThreads; thread_count *= 2) {
+      auto const view{store.Snapshot()};
+      std::atomic<bool> readers_done{false};
+      std::size_t commits{0};
+      std::jthread committer{};
+      if (with_committer) {
+        committer = std::jthread{[&store, &readers_done, &commits, address] {
+          for (std::size_t commit{0}; not readers_done.load(); ++commit) {
+            StateWrites writes{};
+            for (std::size_t slot{0}; slot < kSlotsPerCommit; ++slot) {
+              writes.emplace(StateKey::Storage(address, (commit * kSlotsPerCommit + slot) * 7 % kSlotCount), word_t{commit});
+            }
+            store.Prune(store.Commit(writes));
+            commits++;
+          }
+        }};
+      }
+
+      std::vector<word_t> checksums(thread_count);
+      auto const start{std::chrono::steady_clock::now()};
+      {
+        std::vector<std::jthread> readers{};
+        for (std::size_t thread_index{0}; thread_index < thread_count; ++thread_index) {
+          readers.emplace_back([&view, &checksums, thread_index, address] {
+            word_t checksum{0};
+            auto slot{thread_index * 7919};
+            for (std::size_t read{0}; read < kReadsPerThread; ++read) {
+              slot = (slot * 6'364'136'223'846'793'005 + 1'442'695'040'888'963'407) % kSlotCount;
+              checksum += view->StorageAt(address, slot);
+            }
+            checksums[thread_index] = checksum;
+          });
+        }
+      }
+      auto const elapsed{std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
+      readers_done = true;
+      committer = {};
 
-  if (execution_context.stack.size() < 2) {
-    throw std::runtime_error{std::format("[MSTORE]: Revert due to {}.", magic_enum::enum_name(RevertError::kStackUnderflow))};
+      auto const throughput{static_cast<double>(thread_count * kReadsPerThread) / elapsed / 1e6};
+      if (thread_count == 1) {
+        single_thread_throughput = throughput;
+      }
+      std::println("{:>3} threads {:>9.2f} Mreads/s ({:>7.2f} per thread)  scaling {:>6.2f}{}", thread_count, throughput, throughput / static_cast<double>(thread_count),
+                   throughput / single_thread_throughput, with_committer ? std::format("  {} commits", commits) : "");
+    }
   }
+}
 
-  auto const offset{execution_context.stack.top()};
-  execution_context.stack.pop();
+// A state of 2^18 accounts and 2^20 storage slots over 1024 contracts, all keys spread like hashes: times opening it as
+// a mapped flat snapshot against building the heap maps, then random lookups on the snapshot right after dropping it
+// from the page cache (cold), again (warm) and on the heap maps, and finally counter transactions reading the mapping.
+auto RunFlatStateBenchmark() -> bool {
+  constexpr std::size_t kAccountCount{1 << 18};
+  constexpr std::size_t kContractCount{1024};
+  constexpr std::size_t kSlotsPerContract{1024};
+  constexpr std::size_t kLookupCount{1 << 18};
+  constexpr std::size_t kTransactionCount{10'000};
+  auto const snapshot_path{std::filesystem::temp_directory_path() / std::format("evmint-bench-{}.snapshot", getpid())};
+
+  std::uint64_t seed{0x2545'f491'4f6c'dd1d};
+  auto const next_random{[&seed] {
+    seed += 0x9e37'79b9'7f4a'7c15;
+    auto mixed{seed};
+    mixed = (mixed ^ (mixed >> 30)) * 0xbf58'476d'1ce4'e5b9;
+    mixed = (mixed ^ (mixed >> 27)) * 0x94d0'49bb'1331'11eb;
+    return mixed ^ (mixed >> 31);
+  }};
+  auto const random_word{[&next_random] { return word_t{next_random(), next_random(), next_random(), next_random()}; }};
+
+  Accounts accounts{};
+  std::vector<word_t> addresses{};
+  for (std::size_t index{0}; index < kAccountCount; ++index) {
+    addresses.push_back(ToAddress(random_word()));
+    accounts[addresses.back()].balance = next_random();
+  }
+  auto const counter_bytecode{MakeCounterBytecode()};
+  std::vector<std::pair<word_t, word_t>> slots{};
+  for (std::size_t contract{0}; contract < kContractCount; ++contract) {
+    auto& account{accounts[addresses[contract]]};
+    account.code = contract % 2 == 0 ? counter_bytecode : MakeStorageLoopBytecode();
+    for (std::size_t slot{0}; slot < kSlotsPerContract; ++slot) {
+      slots.emplace_back(addresses[contract], random_word());
+      account.storage[slots.back().second] = slot + 1;
+    }
+  }
 
-  auto const value{execution_context.stack.top()};
-  execution_context.stack.pop();
-  std::span<std::uint8_t const> value_bytes_span{intx::as_bytes(value), kWordSize};
-  std::ranges::copy(value_bytes_span | std::views::reverse, std::next(std::begin(execution_context.memory), static_cast<std::size_t>(offset)));
+  auto const header{flat::WriteSnapshot(snapshot_path, accounts)};
+  auto const heap_start{std::chrono::steady_clock::now()};
+  StateSnapshot const heap_state{accounts};
+  auto const heap_ms{std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - heap_start).count()};
 
-  return execution_context;
+  // drop the freshly written file from the page cache, so the first lookups fault it in from disk
+  if (auto const fd{open(snapshot_path.c_str(), O_RDONLY)}; fd >= 0) {
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+  }
+  auto const map_start{std::chrono::steady_clock::now()};
+  flat::MappedState const mapped_state{snapshot_path};
+  auto const map_us{std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - map_start).count()};
+  std::println("{} accounts, {} slots, {} MiB: mapped in {:.1f} us, heap maps built in {:.1f} ms (not counting parsing)", header.account_count, header.storage_count,
+               header.file_size >> 20, map_us, heap_ms);
+
+  // half storage reads of existing slots, half balance reads
+  std::vector<std::size_t> lookups(kLookupCount);
+  for (auto& lookup : lookups) {
+    lookup = next_random();
+  }
+  auto const run_lookups{[&](StateView const& state) {
+    word_t checksum{0};
+    auto const start{std::chrono::steady_clock::now()};
+    for (auto const lookup : lookups) {
+      auto const& [address, slot]{slots[lookup % slots.size()]};
+      checksum += lookup % 2 == 0 ? state.StorageAt(address, slot) : state.BalanceOf(addresses[lookup % kAccountCount]);
+    }
+    auto const elapsed{std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count()};
+    return std::pair{checksum, elapsed / static_cast<double>(kLookupCount)};
+  }};
+  auto const [cold_checksum, cold_ns]{run_lookups(mapped_state)};
+  auto const [warm_checksum, warm_ns]{run_lookups(mapped_state)};
+  auto const [heap_checksum, heap_ns]{run_lookups(heap_state)};
+  auto verified{cold_checksum == heap_checksum and warm_checksum == heap_checksum};
+  std::println("lookups: mapped cold {:>8.1f} ns, mapped warm {:>6.1f} ns, heap maps {:>6.1f} ns, {}", cold_ns, warm_ns, heap_ns,
+               verified ? "same values" : "VALUES DIFFER");
+
+  Interpreter interpreter{kExecutorOptions};
+  std::vector<std::byte> calldata(2 * kWordSize);
+  std::size_t mismatches{0};
+  for (std::size_t index{0}; index < kTransactionCount; ++index) {
+    auto const& [address, slot]{slots[(index * 2 % kContractCount) * kSlotsPerContract + index % kSlotsPerContract]};
+    StoreWord(reinterpret_cast<std::uint8_t*>(calldata.data()), slot);
+    StoreWord(reinterpret_cast<std::uint8_t*>(calldata.data()) + kWordSize, word_t{8});
+    auto const code{mapped_state.CodeAt(address)};
+    auto const mapped{interpreter.Execute({.code = code, .calldata = calldata, .state = &mapped_state, .address = address})};
+    auto const heap{interpreter.Execute({.code = heap_state.CodeAt(address), .calldata = calldata, .state = &heap_state, .address = address})};
+    if (mapped.status != heap.status or mapped.gas_used != heap.gas_used or mapped.storage_writes != heap.storage_writes or code.size() != counter_bytecode.size()) {
+      mismatches++;
+    }
+  }
+  std::println("{} counter transactions on mapped code and storage: {} mismatches", kTransactionCount, mismatches);
+  std::filesystem::remove(snapshot_path);
+  return verified and mismatches == 0;
 }
 
-auto LoadFromMemory(auto&& execution_context) {
-  // MLOAD <offset>
-  // Load word from memory
+// State roots after blocks touching 10k, 100k and 1M keys of a state of 100k accounts and 1M slots, updating the
+// tries incrementally on one thread and on all of them, against rebuilding the tries from scratch.
+auto RunTrieBenchmark() -> bool {
+  constexpr std::size_t kAccountCount{100'000};
+  constexpr std::size_t kContractCount{100};
+  constexpr std::size_t kSlotCount{1'000'000};
+
+  std::uint64_t seed{0x853c'49e6'748f'ea9b};
+  auto const next_random{[&seed] {
+    seed += 0x9e37'79b9'7f4a'7c15;
+    auto mixed{seed};
+    mixed = (mixed ^ (mixed >> 30)) * 0xbf58'476d'1ce4'e5b9;
+    mixed = (mixed ^ (mixed >> 27)) * 0x94d0'49bb'1331'11eb;
+    return mixed ^ (mixed >> 31);
+  }};
+
+  Accounts accounts{};
+  for (std::size_t index{0}; index < kAccountCount; ++index) {
+    accounts[word_t{0x10000 + index}].balance = next_random() % 1'000'000 + 1;
+  }
+  auto const contract_code{MakeCounterBytecode()};
+  for (std::size_t contract{0}; contract < kContractCount; ++contract) {
+    accounts[word_t{0x10000 + contract}].code = contract_code;
+  }
+  for (std::size_t slot{0}; slot < kSlotCount; ++slot) {
+    accounts[word_t{0x10000 + slot % kContractCount}].storage[slot] = next_random() | 1;
+  }
+
+  auto const time_ms{[](auto&& run) {
+    auto const start{std::chrono::steady_clock::now()};
+    run();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }};
+  trie::StateTrie state_trie{};
+  auto const rebuild_ms{time_ms([&] {
+    state_trie = trie::StateTrie{accounts};
+    state_trie.RootHash();
+  })};
+  std::println("{} accounts, {} slots: full rebuild {:.0f} ms", kAccountCount, kSlotCount, rebuild_ms);
+
+  auto const hardware_threads{std::max<std::size_t>(std::thread::hardware_concurrency(), 1)};
+  for (std::size_t touched : {10'000, 100'000, 1'000'000}) {
+    for (auto const thread_count : std::set<std::size_t>{1, hardware_threads}) {
+      // a tenth balances, the rest slots: three quarters of them existing, some of those cleared
+      StateWrites writes{};
+      while (writes.size() < touched) {
+        auto const random{next_random()};
+        auto const address{word_t{0x10000 + random % (random % 10 == 0 ? kAccountCount : kContractCount)}};
+        if (random % 10 == 0) {
+          writes[StateKey::Balance(address)] = accounts[address].balance = next_random() % 1'000'000;
+          continue;
+        }
+        auto const slot{word_t{random % (kSlotCount * 4 / 3)}};
+        auto const value{random % 7 == 0 ? word_t{0} : word_t{next_random()}};
+        if (value == 0) {
+          accounts[address].storage.erase(slot);
+        } else {
+          accounts[address].storage[slot] = value;
+        }
+        writes[StateKey::Storage(address, slot)] = value;
+      }
 
-  if (execution_context.stack.size() < 1) {
-    throw std::runtime_error{std::format("[MLOAD]: Revert due to {}.", magic_enum::enum_name(RevertError::kStackUnderflow))};
+      auto const update_ms{time_ms([&] {
+        state_trie.Apply(writes, thread_count);
+        state_trie.RootHash(thread_count);
+      })};
+      std::println("{:>9} touched keys, {:>2} threads: {:>9.1f} ms ({:>5.2f} us per key)", touched, thread_count, update_ms, update_ms * 1e3 / static_cast<double>(touched));
+    }
   }
 
-  auto const offset{execution_context.stack.top()};
-  execution_context.stack.pop();
-  auto value_span{std::span{std::next(std::begin(execution_context.memory), static_cast<std::size_t>(offset)), kWordSize}};
-  execution_context.stack.push(to_uint256(value_span));
+  trie::StateTrie rebuilt{accounts};
+  auto const matches{rebuilt.RootHash() == state_trie.RootHash()};
+  std::println("incremental root {} the rebuilt one", matches ? "matches" : "DIFFERS FROM");
+  return matches;
+}
 
-  return execution_context;
+// Encodes a block of 2000 transactions (EIP-155 legacy transfers and EIP-1559 calls with access lists) into a reused
+// buffer and decodes it back into reused views, in MB/s; checks the round trip and that non-canonical encodings are
+// rejected.
+auto RunRlpBenchmark() -> bool {
+  constexpr std::size_t kTransactionCount{2'000};
+  constexpr std::size_t kRounds{500};
+  constexpr std::uint64_t kChainId{1};
+
+  std::vector<std::byte> calldata(68);
+  for (std::size_t index{0}; index < calldata.size(); ++index) {
+    calldata[index] = static_cast<std::byte>(index % 3 == 0 ? 0 : index);
+  }
+  word_t const signature_r{0x1234'5678'9abc'def0, 0x0fed'cba9'8765'4321, 0x1111'2222'3333'4444, 0x5555'6666'7777'8888};
+  word_t const signature_s{0x0102'0304'0506'0708, 0x1112'1314'1516'1718, 0x2122'2324'2526'2728, 0x3132'3334'3536'3738};
+
+  auto const address_bytes{[](word_t const& address) {
+    auto const word_bytes{ToHash(address)};
+    std::array<std::byte, 20> bytes{};
+    std::ranges::copy(std::span{word_bytes}.last(bytes.size()), std::begin(bytes));
+    return bytes;
+  }};
+
+  std::vector<std::byte> typed{};
+  auto const encode_block{[&](std::vector<std::byte>& block) {
+    block.clear();
+    rlp::Encoder encoder{block};
+    auto const block_list{encoder.BeginList()};
+    // the header is not decoded: any list will do
+    encoder.EndList(encoder.BeginList());
+    auto const transactions{encoder.BeginList()};
+    for (std::size_t index{0}; index < kTransactionCount; ++index) {
+      auto const recipient{word_t{0x10000 + index}};
+      if (index % 2 == 0) {
+        auto const transaction{encoder.BeginList()};
+        encoder.AppendWord(index);
+        encoder.AppendWord(20'000'000'000);
+        encoder.AppendWord(21'000);
+        encoder.AppendString(address_bytes(recipient));
+        encoder.AppendWord(word_t{1'000'000'000} * (index + 1));
+        encoder.AppendString({});
+        encoder.AppendWord(35 + 2 * kChainId + index % 4 / 2);
+        encoder.AppendWord(signature_r);
+        encoder.AppendWord(signature_s);
+        encoder.EndList(transaction);
+        continue;
+      }
+      typed.assign(1, static_cast<std::byte>(ingest::TransactionType::kDynamicFee));
+      rlp::Encoder typed_encoder{typed};
+      auto const fields{typed_encoder.BeginList()};
+      typed_encoder.AppendWord(kChainId);
+      typed_encoder.AppendWord(index);
+      typed_encoder.AppendWord(1'000'000'000);
+      typed_encoder.AppendWord(30'000'000'000);
+      typed_encoder.AppendWord(100'000);
+      typed_encoder.AppendString(address_bytes(recipient));
+      typed_encoder.AppendWord(0);
+      typed_encoder.AppendString(calldata);
+      auto const access_list{typed_encoder.BeginList()};
+      auto const entry{typed_encoder.BeginList()};
+      typed_encoder.AppendString(address_bytes(recipient));
+      auto const slots{typed_encoder.BeginList()};
+      // storage keys are always 32 bytes
+      for (auto const slot : {index, index + 1}) {
+        typed_encoder.AppendString(ToHash(word_t{slot}));
+      }
+      typed_encoder.EndList(slots);
+      typed_encoder.EndList(entry);
+      typed_encoder.EndList(access_list);
+      typed_encoder.AppendWord(index % 4 / 2);
+      typed_encoder.AppendWord(signature_r);
+      typed_encoder.AppendWord(signature_s);
+      typed_encoder.EndList(fields);
+      // in a block, typed transactions are wrapped in a string
+      encoder.AppendString(typed);
+    }
+    encoder.EndList(transactions);
+    // no ommers
+    encoder.EndList(encoder.BeginList());
+    encoder.EndList(block_list);
+  }};
+
+  auto const time_s{[](auto&& run) {
+    auto const start{std::chrono::steady_clock::now()};
+    run();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }};
+  std::vector<std::byte> block{};
+  encode_block(block);
+  auto const encode_s{time_s([&] {
+    for (std::size_t round{0}; round < kRounds; ++round) {
+      encode_block(block);
+    }
+  })};
+
+  std::vector<ingest::TransactionView> transactions{};
+  transactions.reserve(kTransactionCount);
+  auto decoded{true};
+  auto const decode_s{time_s([&] {
+    for (std::size_t round{0}; round < kRounds; ++round) {
+      transactions.clear();
+      decoded = ingest::DecodeBlockTransactions(block, transactions) and decoded;
+    }
+  })};
+
+  auto const megabytes{static_cast<double>(block.size() * kRounds) / 1e6};
+  auto const transaction_count{static_cast<double>(kTransactionCount * kRounds)};
+  std::println("block of {} transactions, {} bytes", kTransactionCount, block.size());
+  std::println("encode: {:>7.0f} MB/s, {:>5.2f} M tx/s", megabytes / encode_s, transaction_count / encode_s / 1e6);
+  std::println("decode: {:>7.0f} MB/s, {:>5.2f} M tx/s", megabytes / decode_s, transaction_count / decode_s / 1e6);
+
+  std::size_t mismatches{decoded and transactions.size() == kTransactionCount ? 0 : kTransactionCount};
+  // 23 zero bytes and 45 others of call data, one address and two slots
+  auto const dynamic_fee_gas{kTransactionGas + 23 * kZeroDataByteGas + 45 * kNonZeroDataByteGas + kAccessListAddressGas + 2 * kAccessListSlotGas};
+  for (std::size_t index{0}; index < transactions.size(); ++index) {
+    auto const& transaction{transactions[index]};
+    auto const is_legacy{index % 2 == 0};
+    auto const matches{transaction.type == (is_legacy ? ingest::TransactionType::kLegacy : ingest::TransactionType::kDynamicFee) and transaction.chain_id == kChainId and
+                       transaction.nonce == index and transaction.to == word_t{0x10000 + index} and transaction.y_parity == index % 4 / 2 and
+                       transaction.r == signature_r and transaction.s == signature_s and ingest::IntrinsicGas(transaction) == (is_legacy ? kTransactionGas : dynamic_fee_gas)};
+    mismatches += matches ? 0 : 1;
+  }
+  std::println("round trip: {} mismatches", mismatches);
+
+  // a legacy transaction with its nonce encoded as given, canonical only for the empty string (nonce 0)
+  auto const encode_with_nonce{[&](std::vector<std::byte> const& nonce) {
+    std::vector<std::byte> encoding{};
+    rlp::Encoder encoder{encoding};
+    auto const list{encoder.BeginList()};
+    encoder.AppendRaw(nonce);
+    encoder.AppendWord(1);
+    encoder.AppendWord(21'000);
+    encoder.AppendString(address_bytes(word_t{0x10000}));
+    encoder.AppendWord(0);
+    encoder.AppendString({});
+    encoder.AppendWord(27);
+    encoder.AppendWord(signature_r);
+    encoder.AppendWord(signature_s);
+    encoder.EndList(list);
+    return encoding;
+  }};
+  auto const canonical{encode_with_nonce({rlp::kEmptyString})};
+  auto truncated{canonical};
+  truncated.pop_back();
+  auto trailing{canonical};
+  trailing.push_back(rlp::kEmptyString);
+  std::vector<std::vector<std::byte>> const non_canonical{
+      truncated,
+      trailing,
+      // a leading zero byte
+      encode_with_nonce({std::byte{0x81}, std::byte{0x00}}),
+      // a single byte below 0x80 behind a string header
+      encode_with_nonce({std::byte{0x81}, std::byte{0x01}}),
+      // a long string header for a short payload
+      encode_with_nonce({std::byte{0xb8}, std::byte{0x01}, std::byte{0x85}}),
+  };
+  auto const rejected{std::ranges::count_if(non_canonical, [](auto const& encoding) { return not ingest::DecodeTransaction(encoding); })};
+  auto const accepted{ingest::DecodeTransaction(canonical).has_value()};
+  std::println("non-canonical encodings rejected: {} of {}, canonical one {}", rejected, non_canonical.size(), accepted ? "accepted" : "REJECTED");
+  return mismatches == 0 and rejected == std::ssize(non_canonical) and accepted;
 }
 
-// TODO: SWAPn
-auto SwapStackValues(auto&& execution_context) {
-  // SWAP1 <a> <b>
-  // Exchange 1st and 2nd stack items
+// Signs a block of EIP-155 calls to the counter contract and recovers their senders: one at a time, in batches on 1 to
+// 32 threads, and as the pipeline stage ahead of execution against recovering everything first. Checks the senders,
+// the EIP-155 example transaction and a known ECRECOVER input.
+auto RunEcRecoverBenchmark() -> bool {
+  constexpr std::size_t kTransactionCount{2'048};
+  constexpr std::size_t kLoopIterations{500};
+  constexpr std::uint64_t kChainId{1};
+  constexpr std::size_t kSingleRecoveries{256};
+  word_t const contract{0x1000};
+  using secp256k1::Fn;
+
+  auto const time_s{[](auto&& run) {
+    auto const start{std::chrono::steady_clock::now()};
+    run();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }};
+  auto const address_bytes{[](word_t const& address) {
+    auto const word_bytes{ToHash(address)};
+    std::array<std::byte, 20> bytes{};
+    std::ranges::copy(std::span{word_bytes}.last(bytes.size()), std::begin(bytes));
+    return bytes;
+  }};
+  auto const to_affine{[](secp256k1::JacobianPoint const& point) {
+    secp256k1::AffinePoint affine_point{};
+    secp256k1::ToAffine(std::span{&point, 1}, std::span{&affine_point, 1});
+    return affine_point;
+  }};
+
+  // the EIP-155 example: signing hash and sender of a transfer signed with key 0x4646...46
+  std::vector<std::byte> example{};
+  {
+    rlp::Encoder encoder{example};
+    auto const list{encoder.BeginList()};
+    encoder.AppendWord(9);
+    encoder.AppendWord(20'000'000'000);
+    encoder.AppendWord(21'000);
+    encoder.AppendString(address_bytes(intx::from_string<word_t>("0x3535353535353535353535353535353535353535")));
+    encoder.AppendWord(intx::from_string<word_t>("1000000000000000000"));
+    encoder.AppendString({});
+    encoder.AppendWord(37);
+    encoder.AppendWord(intx::from_string<word_t>("0x28ef61340bd939bc2195fe537567866003e1a15d3c71ff63e1590620aa636276"));
+    encoder.AppendWord(intx::from_string<word_t>("0x67cbe9d8997f761aecb703304b3800ccf555c9f3dc64214b297fb1966a3b6d83"));
+    encoder.EndList(list);
+  }
+  auto const example_transaction{ingest::DecodeTransaction(example)};
+  std::optional<word_t> example_sender{};
+  if (example_transaction) {
+    ingest::RecoverSenders(std::span{&*example_transaction, 1}, std::span{&example_sender, 1}, 1);
+  }
+  auto const example_matches{example_transaction and
+                             ToWord(ingest::SigningHash(*example_transaction)) == intx::from_string<word_t>("0xdaf5a779ae972f972197303d7b574746c7ef83eadac0f2791ad23db92e4c8e53") and
+                             example_sender == intx::from_string<word_t>("0x9d8a62f656a8d1615c1294fd71e9cfb3e4855a4f")};
+  std::println("EIP-155 example transaction: {}", example_matches ? "matches" : "DIFFERS");
+
+  // an ECRECOVER call with a known signer
+  std::vector<std::byte> precompile_input(4 * kWordSize);
+  auto* const input_bytes{reinterpret_cast<std::uint8_t*>(precompile_input.data())};
+  StoreWord(input_bytes, intx::from_string<word_t>("0x38d18acb67d25c8bb9942764b62f18e17054f66a817bd4295423adf9ed98873e"));
+  StoreWord(input_bytes + kWordSize, word_t{27});
+  StoreWord(input_bytes + 2 * kWordSize, intx::from_string<word_t>("0x38d18acb67d25c8bb9942764b62f18e17054f66a817bd4295423adf9ed98873e"));
+  StoreWord(input_bytes + 3 * kWordSize, intx::from_string<word_t>("0x789d1dd423d25f0772d2748d60f7e4b81bb14d086eba8e8e8efb6dcff8a4ae02"));
+  std::vector<std::byte> precompile_output{};
+  precompile::EcRecover(precompile_input, precompile_output);
+  auto const precompile_matches{precompile_output.size() == kWordSize and
+                                ToWord(*reinterpret_cast<Hash const*>(precompile_output.data())) == intx::from_string<word_t>("0xceaccac640adf55b2028469bd36ba501f28b699d")};
+  std::println("ECRECOVER known signer: {}", precompile_matches ? "matches" : "DIFFERS");
+
+  // a block of calls, each signed by its own key
+  std::vector<word_t> signers(kTransactionCount);
+  std::vector<std::byte> block{};
+  std::vector<std::byte> unsigned_transaction{};
+  rlp::Encoder encoder{block};
+  auto const block_list{encoder.BeginList()};
+  // the header is not decoded: any list will do
+  encoder.EndList(encoder.BeginList());
+  auto const transaction_list{encoder.BeginList()};
+  for (std::size_t index{0}; index < kTransactionCount; ++index) {
+    std::vector<std::byte> calldata(2 * kWordSize);
+    StoreWord(reinterpret_cast<std::uint8_t*>(calldata.data()), word_t{index % 64});
+    StoreWord(reinterpret_cast<std::uint8_t*>(calldata.data()) + kWordSize, word_t{kLoopIterations});
+    auto const encode{[&](rlp::Encoder& transaction_encoder, word_t const& v, word_t const& r, word_t const& s) {
+      auto const list{transaction_encoder.BeginList()};
+      transaction_encoder.AppendWord(index);
+      transaction_encoder.AppendWord(20'000'000'000);
+      transaction_encoder.AppendWord(1'000'000);
+      transaction_encoder.AppendString(address_bytes(contract));
+      transaction_encoder.AppendWord(0);
+      transaction_encoder.AppendString(calldata);
+      transaction_encoder.AppendWord(v);
+      transaction_encoder.AppendWord(r);
+      transaction_encoder.AppendWord(s);
+      transaction_encoder.EndList(list);
+    }};
+    // the signing hash does not depend on r and s
+    unsigned_transaction.clear();
+    rlp::Encoder unsigned_encoder{unsigned_transaction};
+    encode(unsigned_encoder, 35 + 2 * kChainId, 0, 0);
+    auto const hash{ingest::SigningHash(*ingest::DecodeTransaction(unsigned_transaction))};
+
+    auto const key{Fn::Reduce(secp256k1::ToLimbs(ToWord(Keccak256(ToHash(word_t{index + 1})))))};
+    auto const nonce{Fn::Reduce(secp256k1::ToLimbs(ToWord(Keccak256(ToHash(word_t{index + 1} << 128)))))};
+    signers[index] = secp256k1::ToAddress(to_affine(secp256k1::MultiplyGenerator(key.ToLimbs())));
+    auto const point{to_affine(secp256k1::MultiplyGenerator(nonce.ToLimbs()))};
+    auto const r{Fn::Reduce(point.x.ToLimbs())};
+    auto s{nonce.Inverse() * (Fn::Reduce(secp256k1::ToLimbs(ToWord(hash))) + r * key)};
+    auto y_parity{point.y.IsOdd() ? 1U : 0U};
+    // EIP-2: the low s of the two
+    if (secp256k1::ToWord(s.ToLimbs()) > secp256k1::kHalfOrder) {
+      s = -s;
+      y_parity ^= 1;
+    }
+    encode(encoder, 35 + 2 * kChainId + y_parity, secp256k1::ToWord(r.ToLimbs()), secp256k1::ToWord(s.ToLimbs()));
+  }
+  encoder.EndList(transaction_list);
+  // no ommers
+  encoder.EndList(encoder.BeginList());
+  encoder.EndList(block_list);
+
+  std::vector<ingest::TransactionView> transactions{};
+  auto const decoded{ingest::DecodeBlockTransactions(block, transactions) and transactions.size() == kTransactionCount};
+  if (not decoded) {
+    std::println("[ERROR] the signed block does not decode");
+    return false;
+  }
 
-  if (execution_context.stack.size() < 2) {
-    throw std::runtime_error{std::format("[SWAPn]: Revert due to {}.", magic_enum::enum_name(RevertError::kStackUnderflow))};
+  std::vector<std::optional<word_t>> senders(kTransactionCount);
+  auto const single_s{time_s([&] {
+    for (std::size_t index{0}; index < kSingleRecoveries; ++index) {
+      ingest::RecoverSenders(std::span{transactions}.subspan(index, 1), std::span{senders}.subspan(index, 1), 1);
+    }
+  })};
+  std::println("{} transactions, {} hardware threads", kTransactionCount, std::thread::hardware_concurrency());
+  std::println("one at a time:   {:>7.1f} us per sender", single_s / kSingleRecoveries * 1e6);
+
+  auto mismatches{std::size_t{0}};
+  for (std::size_t thread_count{1}; thread_count <= 32; thread_count *= 2) {
+    std::ranges::fill(senders, std::nullopt);
+    auto const batch_s{time_s([&] { ingest::RecoverSenders(transactions, senders, thread_count); })};
+    auto const wrong{static_cast<std::size_t>(std::ranges::count_if(std::views::iota(std::size_t{0}, kTransactionCount), [&](auto index) { return senders[index] != signers[index]; }))};
+    mismatches += wrong;
+    std::println("batched, {:>2} threads: {:>7.1f} us per sender, {:>8.0f} senders/s, {} wrong", thread_count, batch_s / kTransactionCount * 1e6, kTransactionCount / batch_s, wrong);
   }
 
-  auto first{execution_context.stack.top()};
-  execution_context.stack.pop();
-  auto second{execution_context.stack.top()};
-  execution_context.stack.pop();
+  // execution with the senders recovered first, then with the stage recovering ahead of it
+  StateSnapshot const state{Accounts{{contract, {.code = MakeCounterBytecode()}}}};
+  Interpreter interpreter{kExecutorOptions};
+  auto const execute{[&](std::size_t index, std::optional<word_t> const& sender) {
+    auto const request{ingest::ToExecutionRequest(transactions[index], state)};
+    return sender and request and interpreter.Execute(*request).status == ExecutionStatus::kSuccess;
+  }};
+  std::size_t executed{0};
+  auto const execution_s{time_s([&] {
+    for (std::size_t index{0}; index < kTransactionCount; ++index) {
+      executed += execute(index, senders[index]) ? 1 : 0;
+    }
+  })};
+  auto const sequential_s{time_s([&] { ingest::RecoverSenders(transactions, senders, 1); })};
+  std::println("execution alone: {:>7.1f} ms, recovery first: {:>7.1f} ms", execution_s * 1e3, (sequential_s + execution_s) * 1e3);
+  for (auto const thread_count : {std::size_t{1}, std::size_t{2}, std::size_t{4}}) {
+    std::size_t pipelined{0};
+    auto const pipeline_s{time_s([&] {
+      ingest::SenderRecoveryStage stage{transactions, thread_count};
+      for (std::size_t index{0}; index < kTransactionCount; ++index) {
+        auto const sender{stage.Sender(index)};
+        mismatches += sender == signers[index] ? 0 : 1;
+        pipelined += execute(index, sender) ? 1 : 0;
+      }
+    })};
+    std::println("pipelined, {} recovery threads: {:>7.1f} ms, {} of {} executed", thread_count, pipeline_s * 1e3, pipelined, kTransactionCount);
+    mismatches += pipelined == kTransactionCount ? 0 : 1;
+  }
+  mismatches += executed == kTransactionCount ? 0 : 1;
+  return example_matches and precompile_matches and mismatches == 0;
+}
 
-  execution_context.stack.push(first);
-  execution_context.stack.push(second);
+// Calls SHA256 and RIPEMD160 through Interpreter::Execute() at several input sizes, with SHA-256 also on the portable
+// rounds for comparison, in MB/s and ns per call; checks known digests and the gas charged.
+auto RunPrecompileBenchmark() -> bool {
+  constexpr std::size_t kBytesPerSize{64 << 20};
+  constexpr std::size_t kSha256Address{2};
+  constexpr std::size_t kRipemd160Address{3};
 
-  return execution_context;
+  Interpreter interpreter{};
+  auto const call{[&](std::size_t address, std::span<std::byte const> input, std::size_t gas_limit = kDefaultGasLimit) {
+    return interpreter.Execute({.calldata = input, .address = address, .gas_limit = gas_limit});
+  }};
+  auto const to_hex{[](std::span<std::byte const> bytes) {
+    std::string hex{};
+    for (auto const byte : bytes) {
+      hex += std::format("{:02x}", static_cast<unsigned>(byte));
+    }
+    return hex;
+  }};
+
+  auto const abc{std::as_bytes(std::span{"abc", 3})};
+  auto const sha256_abc{call(kSha256Address, abc)};
+  auto const ripemd160_abc{call(kRipemd160Address, abc)};
+  auto const out_of_gas{call(kSha256Address, abc, precompile::kSha256Gas + precompile::kSha256WordGas - 1)};
+  auto const known_outputs{to_hex(sha256_abc.output) == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" and
+                           to_hex(ripemd160_abc.output) == "0000000000000000000000008eb208f7e05d987a9b044a8e98c6b087f15a0bfc"};
+  auto const gas_charged{sha256_abc.gas_used == precompile::kSha256Gas + precompile::kSha256WordGas and
+                         ripemd160_abc.gas_used == precompile::kRipemd160Gas + precompile::kRipemd160WordGas and out_of_gas.status == ExecutionStatus::kGasExceeded};
+  std::println("known digests: {}, gas: {}", known_outputs ? "match" : "DIFFER", gas_charged ? "as charged" : "WRONG");
+  std::println("SHA-256 compression: {}", sha256::kCompress == &sha256::CompressPortable ? "portable" : "SHA-NI");
+
+  auto all_match{known_outputs and gas_charged};
+  for (auto const size : {std::size_t{32}, std::size_t{256}, std::size_t{4'096}, std::size_t{65'536}}) {
+    std::vector<std::byte> input(size);
+    for (std::size_t index{0}; index < size; ++index) {
+      input[index] = static_cast<std::byte>(index * 7 + 3);
+    }
+    auto const calls{kBytesPerSize / size};
+    auto const rate{[&](auto&& run) {
+      auto const start{std::chrono::steady_clock::now()};
+      for (std::size_t repetition{0}; repetition < calls; ++repetition) {
+        run();
+      }
+      auto const seconds{std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
+      return std::pair{static_cast<double>(kBytesPerSize) / seconds / 1e6, seconds / static_cast<double>(calls) * 1e9};
+    }};
+    auto const [sha256_mbs, sha256_ns]{rate([&] { call(kSha256Address, input); })};
+    auto const [portable_mbs, portable_ns]{rate([&] { Sha256(input, &sha256::CompressPortable); })};
+    auto const [ripemd160_mbs, ripemd160_ns]{rate([&] { call(kRipemd160Address, input); })};
+    std::println("{:>6} bytes: SHA256 {:>6.0f} MB/s {:>8.0f} ns, portable rounds {:>6.0f} MB/s, RIPEMD160 {:>6.0f} MB/s {:>8.0f} ns", size, sha256_mbs, sha256_ns, portable_mbs,
+                 ripemd160_mbs, ripemd160_ns);
+    all_match = all_match and Sha256(input, &sha256::CompressPortable) == Sha256(input);
+  }
+  return all_match;
 }
 
-// TODO: stack-contents array static??
-template <std::size_t idx>
-auto DuplicateStackValue(auto&& execution_context) {
-  // DUPn <a> <b> ...
-  // Duplicate [idx]th stack item
+// Times MODEXP on the EIPs' inputs (EIP-198's example, EIP-2565's nagydani squares, cubes and 0x10001 powers for 64-
+// to 1024-byte moduli) and the worst cases for its pricing (full-width exponents), with and without the fixed-width
+// paths, in us per call and Mgas/s; checks that both agree and EIP-198's example gives 1.
+auto RunModExpBenchmark() -> bool {
+  constexpr double kSecondsPerCase{0.2};
+
+  std::uint64_t stream_counter{0};
+  auto const random_bytes{[&stream_counter](std::size_t size) {
+    std::vector<std::byte> bytes{};
+    while (bytes.size() < size) {
+      auto const block{Keccak256(ToHash(word_t{++stream_counter}))};
+      bytes.insert(std::end(bytes), std::begin(block), std::begin(block) + static_cast<std::ptrdiff_t>(std::min(block.size(), size - bytes.size())));
+    }
+    return bytes;
+  }};
+  // odd with the top bit set, like an RSA modulus
+  auto const random_modulus{[&](std::size_t size) {
+    auto modulus{random_bytes(size)};
+    modulus.front() |= std::byte{0x80};
+    modulus.back() |= std::byte{0x01};
+    return modulus;
+  }};
+  auto const encode{[](std::vector<std::byte> const& base, std::vector<std::byte> const& exponent, std::vector<std::byte> const& modulus) {
+    std::vector<std::byte> input(3 * kWordSize);
+    StoreWord(reinterpret_cast<std::uint8_t*>(input.data()), word_t{base.size()});
+    StoreWord(reinterpret_cast<std::uint8_t*>(input.data()) + kWordSize, word_t{exponent.size()});
+    StoreWord(reinterpret_cast<std::uint8_t*>(input.data()) + 2 * kWordSize, word_t{modulus.size()});
+    for (auto const* const number : {&base, &exponent, &modulus}) {
+      input.insert(std::end(input), std::begin(*number), std::end(*number));
+    }
+    return input;
+  }};
+  auto const ones{[](std::size_t size) { return std::vector<std::byte>(size, std::byte{0xff}); }};
+
+  std::vector<std::pair<std::string, std::vector<std::byte>>> cases{};
+  auto const secp256k1_prime{ToHash(intx::from_string<word_t>("0xfffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2f"))};
+  auto const prime_minus_one{ToHash(intx::from_string<word_t>("0xfffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2e"))};
+  cases.emplace_back("eip-198 example 1", encode({std::byte{3}}, {std::begin(prime_minus_one), std::end(prime_minus_one)}, {std::begin(secp256k1_prime), std::end(secp256k1_prime)}));
+  for (auto const& [index, size] : std::array<std::pair<int, std::size_t>, 5>{{{1, 64}, {2, 128}, {3, 256}, {4, 512}, {5, 1024}}}) {
+    for (auto const& [name, exponent] : std::array<std::pair<std::string_view, std::vector<std::byte>>, 3>{
+             {{"square", {std::byte{2}}}, {"qube", {std::byte{3}}}, {"pow0x10001", {std::byte{1}, std::byte{0}, std::byte{1}}}}}) {
+      cases.emplace_back(std::format("nagydani-{}-{}", index, name), encode(random_bytes(size), exponent, random_modulus(size)));
+    }
+  }
+  for (auto const size : {std::size_t{32}, std::size_t{128}, std::size_t{256}}) {
+    cases.emplace_back(std::format("{}-byte modulus, {}-byte all-ones exponent", size, size), encode(random_bytes(size), ones(size), random_modulus(size)));
+  }
+  auto even_modulus{random_modulus(256)};
+  even_modulus.back() = std::byte{0};
+  cases.emplace_back("256-byte even modulus, 256-byte all-ones exponent", encode(random_bytes(256), ones(256), even_modulus));
+  cases.emplace_back("1-byte modulus, 1024-byte all-ones exponent", encode(random_bytes(1), ones(1'024), random_modulus(1)));
+
+  std::size_t mismatches{0};
+  std::vector<std::byte> output{};
+  std::vector<std::byte> run_time_width_output{};
+  for (auto const& [name, input] : cases) {
+    auto const gas{precompile::ModExpGas(input)};
+    auto const [base_size, exponent_size, modulus_size]{precompile::detail::ModExpSizes(input)};
+    auto const base{precompile::detail::BigEndianAt(input, 3 * kWordSize, static_cast<std::size_t>(base_size))};
+    auto const exponent{precompile::detail::BigEndianAt(input, 3 * kWordSize + base_size, static_cast<std::size_t>(exponent_size))};
+    auto const modulus{precompile::detail::BigEndianAt(input, 3 * kWordSize + base_size + exponent_size, static_cast<std::size_t>(modulus_size))};
+
+    auto const time_us{[&](bool fixed_width_paths, std::vector<std::byte>& result) {
+      std::size_t calls{0};
+      auto const start{std::chrono::steady_clock::now()};
+      auto elapsed{0.0};
+      for (; elapsed < kSecondsPerCase; elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()) {
+        modexp::ModExp(base, exponent, modulus, result, fixed_width_paths);
+        ++calls;
+      }
+      return elapsed / static_cast<double>(calls) * 1e6;
+    }};
+    auto const fixed_us{time_us(true, output)};
+    auto const run_time_us{time_us(false, run_time_width_output)};
+    mismatches += output == run_time_width_output ? 0 : 1;
+    std::println("{:<52} {:>7} gas {:>10.1f} us {:>7.1f} Mgas/s, run-time width {:>10.1f} us", name, gas, fixed_us, static_cast<double>(gas) / fixed_us, run_time_us);
+  }
 
-  // TODO: check stack should contain idx elements
+  // 3^(p - 1) = 1 mod p
+  precompile::ModExp(cases.front().second, output);
+  auto const example_matches{output.size() == kWordSize and output.back() == std::byte{1} and static_cast<std::size_t>(std::ranges::count(output, std::byte{0})) == kWordSize - 1};
+  std::println("eip-198 example 1: {}, fixed and run-time widths: {} mismatches", example_matches ? "1" : "WRONG", mismatches);
+  return example_matches and mismatches == 0;
+}
 
-  std::array<word_t, idx> stack_contents_window{};
-  std::ranges::for_each(stack_contents_window, [&execution_context](auto& elem) {
-    elem = execution_context.stack.top();
-    execution_context.stack.pop();
-  });
+// Calls ECADD, ECMUL and ECPAIRING through Interpreter::Execute(), the pairing check with 2, 4 and 8 pairs, in us per
+// call, and times the final exponentiation every check pays once; checks 2 * G by addition and by multiplication,
+// pairing checks that hold and that fail, and that an invalid point fails the call.
+auto RunBn254Benchmark() -> bool {
+  constexpr double kSecondsPerCase{0.5};
+  constexpr std::size_t kEcAddAddress{6};
+  constexpr std::size_t kEcMulAddress{7};
+  constexpr std::size_t kEcPairingAddress{8};
+  constexpr std::size_t kPairSize{bn254::kG1Size + bn254::kG2Size};
 
-  std::ranges::for_each(stack_contents_window | std::views::reverse, [&execution_context](auto const& elem) { execution_context.stack.push(elem); });
-  execution_context.stack.push(stack_contents_window.back());
+  Interpreter interpreter{};
+  auto const call{[&](std::size_t address, std::span<std::byte const> input) { return interpreter.Execute({.calldata = input, .address = address}); }};
+  auto const to_hex{[](std::span<std::byte const> bytes) {
+    std::string hex{};
+    for (auto const byte : bytes) {
+      hex += std::format("{:02x}", static_cast<unsigned>(byte));
+    }
+    return hex;
+  }};
+  auto const time_us{[](auto&& run) {
+    std::size_t calls{0};
+    auto const start{std::chrono::steady_clock::now()};
+    auto elapsed{0.0};
+    for (; elapsed < kSecondsPerCase; elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()) {
+      run();
+      ++calls;
+    }
+    return elapsed / static_cast<double>(calls) * 1e6;
+  }};
+
+  std::uint64_t stream_counter{0};
+  auto const random_scalar{[&stream_counter] { return bn254::Fr::Reduce(field::LoadBigEndian<4>(Keccak256(ToHash(word_t{++stream_counter})).data())); }};
+  auto const g1_generator{bn254::G1::FromAffine(bn254::kG1Generator)};
+  auto const g2_generator{bn254::G2::FromAffine(bn254::kG2Generator)};
+  // pairs (a * G1, b * G2) and a last one that cancels them, (-sum(a * b) * G1, G2), unless `holds` is false
+  auto const pairing_input{[&](std::size_t pair_count, bool holds) {
+    std::vector<std::byte> input(pair_count * kPairSize);
+    bn254::Fr sum{};
+    for (std::size_t pair{0}; pair + 1 < pair_count; ++pair) {
+      auto const a{random_scalar()};
+      auto const b{random_scalar()};
+      sum += a * b;
+      bn254::WriteG1(curve::Multiply(g1_generator, a.ToLimbs()), input.data() + pair * kPairSize);
+      bn254::WriteG2(curve::Multiply(g2_generator, b.ToLimbs()), input.data() + pair * kPairSize + bn254::kG1Size);
+    }
+    auto const last{holds ? -sum : bn254::Fr::One() - sum};
+    bn254::WriteG1(curve::Multiply(g1_generator, last.ToLimbs()), input.data() + (pair_count - 1) * kPairSize);
+    bn254::WriteG2(g2_generator, input.data() + (pair_count - 1) * kPairSize + bn254::kG1Size);
+    return input;
+  }};
+  auto const check_result{[&](std::span<std::byte const> input) {
+    auto const result{call(kEcPairingAddress, input)};
+    return result.status == ExecutionStatus::kSuccess ? std::optional{result.output.back() == std::byte{1}} : std::nullopt;
+  }};
+
+  std::vector<std::byte> add_input(2 * bn254::kG1Size);
+  bn254::WriteG1(g1_generator, add_input.data());
+  bn254::WriteG1(g1_generator, add_input.data() + bn254::kG1Size);
+  std::vector<std::byte> mul_input(bn254::kG1Size + kWordSize);
+  bn254::WriteG1(g1_generator, mul_input.data());
+  mul_input.back() = std::byte{2};
+  constexpr std::string_view kDoubleGenerator{"030644e72e131a029b85045b68181585d97816a916871ca8d3c208c16d87cfd3"
+                                              "15ed738c0e0a7c92e7845f96b2ae9c0a68a6a449e3538fc7ff3ebf7a5a18a2c4"};
+  auto const known_outputs{to_hex(call(kEcAddAddress, add_input).output) == kDoubleGenerator and to_hex(call(kEcMulAddress, mul_input).output) == kDoubleGenerator};
+  auto off_curve_input{add_input};
+  off_curve_input[bn254::kG1Size - 1] = std::byte{3};
+  auto const invalid_fails{call(kEcAddAddress, off_curve_input).status == ExecutionStatus::kPrecompileFailure};
+  auto checks_match{check_result({}) == true and check_result(pairing_input(1, false)) == false and invalid_fails};
+  for (auto const pair_count : {std::size_t{2}, std::size_t{3}, std::size_t{5}}) {
+    checks_match = checks_match and check_result(pairing_input(pair_count, true)) == true and check_result(pairing_input(pair_count, false)) == false;
+  }
+#if defined(__x86_64__)
+  std::println("field multiplication: {}", field::detail::kHasMulxAdx ? "mulx/adx" : "portable");
+#endif
+  std::println("2 * G: {}, pairing checks: {}", known_outputs ? "match" : "DIFFER", checks_match ? "as expected" : "WRONG");
+
+  auto const ec_add_us{time_us([&] { call(kEcAddAddress, add_input); })};
+  mul_input = pairing_input(2, true);
+  mul_input.resize(bn254::kG1Size);
+  auto const scalar{Keccak256(mul_input)};
+  mul_input.insert(std::end(mul_input), std::begin(scalar), std::end(scalar));
+  auto const ec_mul_us{time_us([&] { call(kEcMulAddress, mul_input); })};
+  std::println("ECADD {:>8.2f} us, ECMUL {:>8.2f} us ({:.1f} Mgas/s)", ec_add_us, ec_mul_us, static_cast<double>(precompile::kEcMulGas) / ec_mul_us);
+
+  // chained, so no exponentiation can be left out
+  auto f{bn254::MillerLoop(std::array{bn254::kG1Generator}, std::array{bn254::kG2Generator})};
+  std::println("final exponentiation alone: {:>8.1f} us", time_us([&] { f = bn254::FinalExponentiation(f); }));
+  for (auto const pair_count : {std::size_t{2}, std::size_t{4}, std::size_t{8}}) {
+    auto const input{pairing_input(pair_count, true)};
+    auto const check_us{time_us([&] { call(kEcPairingAddress, input); })};
+    auto const gas{precompile::kEcPairingGas + precompile::kEcPairingPairGas * pair_count};
+    std::println("pairing check, {} pairs: {:>8.1f} us ({:.1f} us per pair), {:>7} gas {:>5.1f} Mgas/s", pair_count, check_us, check_us / static_cast<double>(pair_count), gas,
+                 static_cast<double>(gas) / check_us);
+  }
+  return known_outputs and checks_match;
+}
+
+// Calls BLAKE2F through Interpreter::Execute() at 12 rounds (one BLAKE2b block) and at round counts up to a whole
+// block's gas limit, on the AVX2 rounds and on the portable ones, in ns per round and Mgas/s; checks EIP-152's vectors,
+// the gas charged and that malformed input fails the call.
+auto RunBlake2FBenchmark() -> bool {
+  constexpr double kSecondsPerCase{0.5};
+  constexpr std::size_t kBlake2FAddress{9};
 
-  if (execution_context.stack.size() > kMaxStackSize) {
-    throw std::runtime_error{std::format("[DUPn]: Revert due to {}.", magic_enum::enum_name(RevertError::kStackOverflow))};
+  Interpreter interpreter{};
+  auto const call{[&](std::span<std::byte const> input, std::size_t gas_limit = kDefaultGasLimit) {
+    return interpreter.Execute({.calldata = input, .address = kBlake2FAddress, .gas_limit = gas_limit});
+  }};
+  auto const to_hex{[](std::span<std::byte const> bytes) {
+    std::string hex{};
+    for (auto const byte : bytes) {
+      hex += std::format("{:02x}", static_cast<unsigned>(byte));
+    }
+    return hex;
+  }};
+  // EIP-152's vectors: BLAKE2b-512 of "abc", a single final block of 3 bytes, from the initial state of an unkeyed
+  // 64-byte digest
+  auto const input_for{[](std::uint32_t rounds, bool final_block) {
+    auto state{blake2::kInitializationVector};
+    state[0] ^= 0x0101'0040;
+    blake2::Offset const offset{3, 0};
+    std::vector<std::byte> input(precompile::kBlake2FInputSize);
+    auto const big_endian_rounds{std::byteswap(rounds)};
+    std::memcpy(input.data(), &big_endian_rounds, sizeof(big_endian_rounds));
+    std::memcpy(input.data() + 4, state.data(), sizeof(state));
+    std::memcpy(input.data() + 4 + sizeof(state), "abc", 3);
+    std::memcpy(input.data() + 4 + sizeof(state) + blake2::kBlockSize, offset.data(), sizeof(offset));
+    input.back() = final_block ? std::byte{1} : std::byte{0};
+    return input;
+  }};
+
+  auto const no_rounds{call(input_for(0, true))};
+  auto const twelve_rounds{call(input_for(12, true))};
+  auto const not_final{call(input_for(12, false))};
+  auto const known_outputs{
+      to_hex(no_rounds.output) == "08c9bcf367e6096a3ba7ca8485ae67bb2bf894fe72f36e3cf1361d5f3af54fa5d282e6ad7f520e511f6c3e2b8c68059b9442be0454267ce079217e1319cde05b" and
+      to_hex(twelve_rounds.output) == "ba80a53f981c4d0d6a2797b69f12f6e94c212f14685ac4b74b12bb6fdbffa2d17d87c5392aab792dc252d5de4533cc9518d38aa8dbf1925ab92386edd4009923" and
+      to_hex(not_final.output) == "75ab69d3190a562c51aef8d88f1c2775876944407270c42c9844252c26d2875298743e7f6d5ea2f2d3e8d226039cd31b4e426ac4f2d3d666a610c2116fde4735"};
+  auto bad_flag{input_for(12, true)};
+  bad_flag.back() = std::byte{2};
+  auto short_input{input_for(12, true)};
+  short_input.pop_back();
+  auto const rejects_invalid{call(bad_flag).status == ExecutionStatus::kPrecompileFailure and call(short_input).status == ExecutionStatus::kPrecompileFailure};
+  // 2^32 - 1 rounds are priced beyond any gas limit and refused before a single one runs
+  auto const gas_charged{twelve_rounds.gas_used == 12 * precompile::kBlake2FRoundGas and call(input_for(13, true), 12).status == ExecutionStatus::kGasExceeded and
+                         call(input_for(0xffff'ffff, true)).status == ExecutionStatus::kGasExceeded};
+  std::println("eip-152 vectors: {}, gas: {}, malformed input: {}", known_outputs ? "match" : "DIFFER", gas_charged ? "as charged" : "WRONG",
+               rejects_invalid ? "fails" : "ACCEPTED");
+  std::println("BLAKE2b rounds: {}", blake2::kCompress == &blake2::CompressPortable ? "portable" : "AVX2");
+
+  auto all_match{known_outputs and gas_charged and rejects_invalid};
+  for (auto const rounds : {std::uint32_t{12}, std::uint32_t{1'000}, std::uint32_t{1'000'000}, std::uint32_t{kDefaultGasLimit}}) {
+    auto const input{input_for(rounds, true)};
+    auto const ns_per_round{[&](auto&& run) {
+      std::size_t calls{0};
+      auto const start{std::chrono::steady_clock::now()};
+      auto elapsed{0.0};
+      for (; elapsed < kSecondsPerCase; elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()) {
+        run();
+        ++calls;
+      }
+      return elapsed / static_cast<double>(calls) / static_cast<double>(rounds) * 1e9;
+    }};
+    auto const call_ns{ns_per_round([&] { call(input); })};
+    blake2::State portable_state{};
+    auto const portable_ns{ns_per_round([&] {
+      std::memcpy(portable_state.data(), input.data() + 4, sizeof(portable_state));
+      blake2::CompressPortable(portable_state, input.data() + 4 + sizeof(portable_state), {3, 0}, true, rounds);
+    })};
+    all_match = all_match and std::ranges::equal(call(input).output, std::as_bytes(std::span{portable_state}));
+    std::println("{:>10} rounds: {:>12.0f} ns per call, {:>6.2f} ns per round {:>7.1f} Mgas/s, portable rounds {:>6.2f} ns per round", rounds,
+                 call_ns * rounds, call_ns, static_cast<double>(precompile::kBlake2FRoundGas) * 1e3 / call_ns, portable_ns);
   }
+  return all_match;
+}
+
+// Writes an insecure trusted setup whose tau is known, so proofs can be made without a prover, and times loading it
+// (parse, precompute); then calls POINT_EVALUATION through Interpreter::Execute() in us and Mgas/s, checking that a
+// valid proof verifies and that a wrong y, a versioned hash of another commitment and z not below r fail the call.
+auto RunKzgBenchmark() -> bool {
+  constexpr double kSecondsPerCase{0.5};
+  constexpr std::size_t kPointEvaluationAddress{10};
+  constexpr std::size_t kG2PointCount{65};
+  auto const setup_path{std::filesystem::temp_directory_path() / std::format("evmint-bench-{}-trusted_setup.txt", getpid())};
 
-  return execution_context;
+  Interpreter interpreter{};
+  auto const call{[&](std::span<std::byte const> input) { return interpreter.Execute({.calldata = input, .address = kPointEvaluationAddress}); }};
+  auto const to_hex{[](std::span<std::byte const> bytes) {
+    std::string hex{};
+    for (auto const byte : bytes) {
+      hex += std::format("{:02x}", static_cast<unsigned>(byte));
+    }
+    return hex;
+  }};
+  auto const time_us{[](auto&& run) {
+    std::size_t calls{0};
+    auto const start{std::chrono::steady_clock::now()};
+    auto elapsed{0.0};
+    for (; elapsed < kSecondsPerCase; elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()) {
+      run();
+      ++calls;
+    }
+    return elapsed / static_cast<double>(calls) * 1e6;
+  }};
+  std::uint64_t stream_counter{0};
+  auto const random_scalar{[&stream_counter] { return bls12_381::Fr::Reduce(field::LoadBigEndian<4>(Keccak256(ToHash(word_t{++stream_counter})).data())); }};
+  auto const g1_generator{bls12_381::G1::FromAffine(bls12_381::kG1Generator)};
+
+  // the G1 points are only read by provers, so the generator stands in for all of them
+  auto const tau{random_scalar()};
+  {
+    std::ofstream setup_file{setup_path};
+    std::array<std::byte, bls12_381::kG2CompressedSize> compressed{};
+    bls12_381::CompressG1(g1_generator, compressed.data());
+    auto const g1_line{to_hex(std::span{compressed}.first<bls12_381::kG1CompressedSize>())};
+    setup_file << kzg::kFieldElementsPerBlob << '\n' << kG2PointCount << '\n';
+    for (std::size_t point{0}; point < kzg::kFieldElementsPerBlob; ++point) {
+      setup_file << g1_line << '\n';
+    }
+    auto g2_power{bls12_381::G2::FromAffine(bls12_381::kG2Generator)};
+    for (std::size_t point{0}; point < kG2PointCount; ++point) {
+      bls12_381::CompressG2(g2_power, compressed.data());
+      setup_file << to_hex(compressed) << '\n';
+      g2_power = curve::Multiply(g2_power, tau.ToLimbs());
+    }
+  }
+  auto const load_start{std::chrono::steady_clock::now()};
+  kzg::LoadTrustedSetup(setup_path);
+  std::println("trusted setup: loaded in {:.1f} ms (parse, precompute)", std::chrono::duration<double>(std::chrono::steady_clock::now() - load_start).count() * 1e3);
+  std::filesystem::remove(setup_path);
+
+  // p(tau) = a and p(z) = y: the commitment is [a]G1 and the proof [(a - y) / (tau - z)]G1
+  auto const a{random_scalar()};
+  auto const z{random_scalar()};
+  auto const y{random_scalar()};
+  std::vector<std::byte> input(precompile::kPointEvaluationInputSize);
+  auto const commitment{input.data() + 3 * kWordSize};
+  bls12_381::CompressG1(curve::Multiply(g1_generator, a.ToLimbs()), commitment);
+  bls12_381::CompressG1(curve::Multiply(g1_generator, ((a - y) * (tau - z).Inverse()).ToLimbs()), commitment + bls12_381::kG1CompressedSize);
+  auto const versioned_hash{kzg::VersionedHash(std::span{commitment, bls12_381::kG1CompressedSize}.first<bls12_381::kG1CompressedSize>())};
+  std::ranges::copy(versioned_hash, input.data());
+  field::StoreBigEndian(z.ToLimbs(), input.data() + kWordSize);
+  field::StoreBigEndian(y.ToLimbs(), input.data() + 2 * kWordSize);
+
+  auto const valid{call(input)};
+  auto const verifies{valid.status == ExecutionStatus::kSuccess and valid.gas_used == precompile::kPointEvaluationGas and
+                      to_hex(valid.output) ==
+                          "0000000000000000000000000000000000000000000000000000000000001000"
+                          "73eda753299d7d483339d80809a1d80553bda402fffe5bfeffffffff00000001"};
+  auto wrong_y{input};
+  field::StoreBigEndian((y + bls12_381::Fr::One()).ToLimbs(), wrong_y.data() + 2 * kWordSize);
+  auto wrong_hash{input};
+  wrong_hash[kWordSize - 1] ^= std::byte{1};
+  auto z_not_below_r{input};
+  field::StoreBigEndian(bls12_381::Fr::kModulus, z_not_below_r.data() + kWordSize);
+  auto const rejects_invalid{std::ranges::all_of(std::array{&wrong_y, &wrong_hash, &z_not_below_r},
+                                                 [&](auto const* invalid) { return call(*invalid).status == ExecutionStatus::kPrecompileFailure; })};
+  std::println("valid proof: {}, wrong y, other commitment's hash, z >= r: {}", verifies ? "verifies" : "REJECTED", rejects_invalid ? "fail" : "ACCEPTED");
+
+  auto const& setup{*kzg::ActiveTrustedSetup()};
+  auto fixed_base{g1_generator};
+  auto const fixed_base_us{time_us([&] { fixed_base = setup.GeneratorMultiple(y); })};
+  auto variable_base{g1_generator};
+  auto const variable_base_us{time_us([&] { variable_base = curve::Multiply(g1_generator, y.ToLimbs()); })};
+  auto const call_us{time_us([&] { call(input); })};
+  std::println("[y]G1 from the table {:>8.1f} us, by windows {:>8.1f} us ({})", fixed_base_us, variable_base_us, fixed_base == variable_base ? "equal" : "DIFFER");
+  std::println("POINT_EVALUATION {:>8.1f} us, {:>6} gas {:>5.1f} Mgas/s", call_us, precompile::kPointEvaluationGas,
+               static_cast<double>(precompile::kPointEvaluationGas) / call_us);
+
+  return verifies and rejects_invalid and fixed_base == variable_base;
 }
 
-auto ShiftLeft(auto&& execution_context) {
-  // SHL <shift> <value>
-  // Left shift operation
+#if defined(EVMINT_PROFILE)
+// Runs the bytecode kProfileRuns times (or until it fails) and prints where the interpreter spent its cycles, sorted by
+// opcode; the same report goes to `json_filepath` as JSON if given.
+auto RunProfile(std::string_view bytecode_filepath, DispatchMode dispatch_mode, std::optional<std::string> const& json_filepath) -> bool {
+  constexpr std::size_t kProfileRuns{1'000};
 
-  if (execution_context.stack.size() < 2) {
-    throw std::runtime_error{std::format("[SHL]: Revert due to {}.", magic_enum::enum_name(RevertError::kStackUnderflow))};
+  Interpreter interpreter{};
+  interpreter.LoadBytecode(bytecode_filepath);
+  auto succeeded{true};
+  for (std::size_t run{0}; run < kProfileRuns and succeeded; ++run) {
+    interpreter.Reset();
+    succeeded = interpreter.Interpret(dispatch_mode);
+  }
+  if (not succeeded) {
+    std::println("[ERROR] {} (profiled up to here)", interpreter.ErrorMessage());
   }
 
-  auto shift{execution_context.stack.top()};
-  execution_context.stack.pop();
-  auto value{execution_context.stack.top()};
-  execution_context.stack.pop();
+  interpreter.Profile().PrintTable();
+  if (json_filepath) {
+    std::ofstream json_file{*json_filepath};
+    json_file << interpreter.Profile().ToJson() << '\n';
+    if (not json_file) {
+      std::println("[ERROR] Could not write the profile to '{}'.", *json_filepath);
+      return false;
+    }
+  }
+  return succeeded;
+}
+#endif
+
+#if defined(__linux__)
+// Account 0 with slot 0 set, which storage-loop requests read.
+auto MakeServerStore() -> std::unique_ptr<StateStore> {
+  auto store{std::make_unique<StateStore>()};
+  store->Commit(Accounts{{0, {.storage = {{0, word_t{1}}}}}});
+  return store;
+}
 
-  execution_context.stack.push(value << shift);
+// Load generator for the execution server: pipelines `request_count` storage-loop requests over one connection, at
+// most `window` in flight, and checks every response. The first request carries the code, the rest only its hash.
+auto RunServerLoad(std::string const& socket_path, std::size_t request_count, std::size_t window) -> bool {
+  constexpr std::size_t kLoopIterations{64};
+  auto const bytecode{MakeStorageLoopBytecode()};
+  auto const code_hash{ToWord(Keccak256(bytecode))};
+
+  std::vector<std::byte> calldata(kWordSize);
+  StoreWord(reinterpret_cast<std::uint8_t*>(calldata.data()), word_t{kLoopIterations});
+  auto const reference_store{MakeServerStore()};
+  auto const reference_view{reference_store->Snapshot()};
+  Interpreter reference{kExecutorOptions};
+  auto const expected{reference.Execute({.code = bytecode, .calldata = calldata, .state = reference_view.get()})};
+
+  auto socket_fd{-1};
+  // the server may still be starting up
+  for (auto attempt{0}; socket_fd < 0; ++attempt) {
+    try {
+      socket_fd = server::ConnectToUnixSocket(socket_path);
+    } catch (std::runtime_error const& ex) {
+      if (attempt == 100) {
+        std::println("[ERROR] {}", ex.what());
+        return false;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+  }
+
+  std::vector<std::chrono::steady_clock::time_point> sent_at(request_count);
+  std::vector<double> latencies{};
+  latencies.reserve(request_count);
+  std::vector<std::byte> output{};
+  std::vector<std::byte> input(64 * 1024);
+  std::size_t input_end{0};
+  std::size_t sent{0};
+  std::size_t received{0};
+  std::size_t mismatches{0};
+
+  auto const start{std::chrono::steady_clock::now()};
+  while (received < request_count) {
+    output.clear();
+    for (; sent < request_count and sent - received < window; ++sent) {
+      server::AppendRequest(output, {.request_id = sent, .flags = sent == 0 ? server::kHasCode : std::uint8_t{0}, .code_hash = code_hash}, bytecode, calldata);
+      sent_at[sent] = std::chrono::steady_clock::now();
+    }
+    for (std::size_t written{0}; written < output.size();) {
+      auto const bytes_written{send(socket_fd, output.data() + written, output.size() - written, MSG_NOSIGNAL)};
+      if (bytes_written <= 0) {
+        std::println("[ERROR] Lost the connection to the server.");
+        close(socket_fd);
+        return false;
+      }
+      written += static_cast<std::size_t>(bytes_written);
+    }
 
-  return execution_context;
+    auto const bytes_read{recv(socket_fd, input.data() + input_end, input.size() - input_end, 0)};
+    if (bytes_read <= 0) {
+      std::println("[ERROR] Lost the connection to the server.");
+      close(socket_fd);
+      return false;
+    }
+    input_end += static_cast<std::size_t>(bytes_read);
+
+    std::size_t input_begin{0};
+    for (auto pending{std::span<std::byte const>{input}.first(input_end)}; auto const frame_size{server::CompleteFrameSize(pending.subspan(input_begin)).value_or(0)};
+         input_begin += frame_size) {
+      auto const response{server::ParseResponse(pending.subspan(input_begin + server::kLengthSize, frame_size - server::kLengthSize))};
+      if (not response or response->status != static_cast<std::uint8_t>(expected.status) or response->gas_used != expected.gas_used or
+          response->storage_write_count != expected.storage_writes.size()) {
+        mismatches++;
+      } else {
+        latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - sent_at[response->request_id]).count());
+      }
+      received++;
+    }
+    std::copy(std::next(std::begin(input), static_cast<std::ptrdiff_t>(input_begin)), std::next(std::begin(input), static_cast<std::ptrdiff_t>(input_end)),
+              std::begin(input));
+    input_end -= input_begin;
+  }
+  auto const elapsed{std::chrono::duration<double>(std::chrono::steady_clock::now() - start)};
+  close(socket_fd);
+
+  std::ranges::sort(latencies);
+  auto const percentile{[&latencies](double fraction) { return latencies.empty() ? 0.0 : latencies[static_cast<std::size_t>(fraction * static_cast<double>(latencies.size() - 1))]; }};
+  std::println("{} requests, window {}: {:.0f} requests/s, latency p50 {:.1f} us, p99 {:.1f} us, {} mismatches", request_count, window,
+               static_cast<double>(request_count) / elapsed.count(), percentile(0.5), percentile(0.99), mismatches);
+  return mismatches == 0;
 }
 
-}  // namespace
+// Runs the server on a temporary socket in this process and drives it with the load generator at growing windows.
+auto RunServerBenchmark() -> bool {
+  constexpr std::size_t kRequestCount{50'000};
+  auto const socket_path{std::format("/tmp/evmint-bench-{}.sock", getpid())};
+
+  auto const store{MakeServerStore()};
+  server::ExecutionServer execution_server{{}, store.get()};
+  std::jthread serving{[&] { execution_server.ServeUnixSocket(socket_path); }};
 
-// TODO: Use a more performant data structure for stack_t (ideally we should be able to peek in the middle of stack randomly) that provides generic stack interface of push,pop,top,empty,size
+  auto verified{true};
+  for (std::size_t window : {1, 16, 256}) {
+    verified = RunServerLoad(socket_path, kRequestCount, window) and verified;
+  }
+  execution_server.Stop();
+  return verified;
+}
 
-class Interpreter final {
-  using bytecode_t = std::vector<std::byte>;
-  // NOTE: we prefer an arithmetic type for byte in defining memory structure
-  using memory_t = std::array<std::uint8_t, kMemorySize>;
-  using stack_t = std::stack<word_t>;
+// Replays counter transactions over a contract whose 2^18 storage slots live in a state file, every batch starting
+// cold, with 1 to 64 executions in flight per thread; one lane blocks on every read like a synchronous executor.
+auto RunColdStateBenchmark() -> bool {
+  constexpr std::size_t kSlotCount{1 << 18};
+  constexpr std::size_t kTransactionCount{20'000};
+  constexpr std::size_t kLoopIterations{32};
+  word_t const contract{0x1000};
+  auto const state_path{std::filesystem::temp_directory_path() / std::format("evmint-bench-{}.state", getpid())};
+
+  auto const bytecode{MakeCounterBytecode()};
+  Accounts accounts{{contract, {.code = bytecode}}};
+  for (std::size_t slot{0}; slot < kSlotCount; ++slot) {
+    accounts[contract].storage[slot] = word_t{slot + 1};
+  }
+  disk::WriteStateFile(state_path, accounts);
+  StateSnapshot const snapshot{std::move(accounts)};
+
+  std::vector<std::vector<std::byte>> calldata(kTransactionCount, std::vector<std::byte>(2 * kWordSize));
+  std::vector<ExecutionRequest> requests(kTransactionCount);
+  for (std::size_t index{0}; index < kTransactionCount; ++index) {
+    StoreWord(reinterpret_cast<std::uint8_t*>(calldata[index].data()), word_t{index * 2'654'435'761 % kSlotCount});
+    StoreWord(reinterpret_cast<std::uint8_t*>(calldata[index].data()) + kWordSize, word_t{kLoopIterations});
+    requests[index] = {.code = bytecode, .calldata = calldata[index], .state = &snapshot, .address = contract};
+  }
 
-  struct ExecutionContext {
-    std::size_t program_counter{0};
-    bytecode_t bytecode{};
-    stack_t stack{};
-    memory_t memory{};
-  };
+  Interpreter warm_interpreter{kExecutorOptions};
+  std::vector<ExecutionResult> expected{};
+  auto const warm_start{std::chrono::steady_clock::now()};
+  for (auto const& request : requests) {
+    expected.push_back(warm_interpreter.Execute(request));
+  }
+  auto const warm_elapsed{std::chrono::duration<double>(std::chrono::steady_clock::now() - warm_start).count()};
+  std::println("{} transactions over {} slots; in memory: {:>10.0f} tx/s", kTransactionCount, kSlotCount, static_cast<double>(kTransactionCount) / warm_elapsed);
+
+  auto verified{true};
+  for (std::size_t lane_count : {1, 4, 16, 64}) {
+    disk::AsyncExecutor executor{state_path, lane_count};
+    auto const start{std::chrono::steady_clock::now()};
+    auto const results{executor.Execute(requests)};
+    auto const elapsed{std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
+
+    auto const same_result{[](auto const& lhs, auto const& rhs) { return lhs.status == rhs.status and lhs.gas_used == rhs.gas_used and lhs.storage_writes == rhs.storage_writes; }};
+    auto const matches{std::ranges::equal(results, expected, same_result)};
+    verified = verified and matches;
+    std::println("{:>3} lanes, cold: {:>10.0f} tx/s, {:>6} suspensions, {:>6} page reads, {}", lane_count, static_cast<double>(kTransactionCount) / elapsed,
+                 executor.Statistics().suspensions, executor.Statistics().page_reads, matches ? "matches in-memory state" : "DIFFERS FROM IN-MEMORY STATE");
+  }
+  std::filesystem::remove(state_path);
+  return verified;
+}
+#endif
+
+// Runs the bytecode through the handler-table interpreter and through compiled code (kTiered with
+// `compiled_options`) and checks that both end in bit-for-bit identical state (success, gas, stack and memory).
+auto VerifyAgainstInterpreter(auto const& bytecode_source, InterpreterOptions compiled_options, std::string_view label) -> bool {
+  Interpreter reference{{.trace_execution = false}};
+  Interpreter compiled{compiled_options};
+  reference.LoadBytecode(bytecode_source);
+  compiled.LoadBytecode(bytecode_source);
+
+  auto const reference_succeeded{reference.Interpret(DispatchMode::kHandlerTable)};
+  auto const compiled_succeeded{compiled.Interpret(DispatchMode::kTiered)};
+
+  // a failed execution discards its state, so only the outcome has to agree
+  auto const identical{reference_succeeded == compiled_succeeded and
+                       (not reference_succeeded or (reference.GasLeft() == compiled.GasLeft() and reference.Stack() == compiled.Stack() and reference.Memory() == compiled.Memory()))};
+  std::println("[VERIFY] {} execution {} the interpreter", label, identical ? "matches" : "DIFFERS FROM");
+  return identical;
+}
 
- public:
-  auto LoadBytecode(std::string_view bc_filepath) {
-    m_execution_context.bytecode.clear();
+auto VerifyJitAgainstInterpreter(auto const& bytecode_source) -> bool {
+  return VerifyAgainstInterpreter(bytecode_source, {.trace_execution = false, .jit_threshold = 0, .use_translated_code = false}, "jitted");
+}
 
-    std::ifstream bc_ifs{bc_filepath};
-    if (not bc_ifs.is_open()) {
-      throw std::runtime_error(std::format("Could not find '{}' file.", bc_filepath).c_str());
+auto VerifyTranslatedContractsAgainstInterpreter() -> bool {
+  auto verified{true};
+  for (auto const& translated_code : aot::TranslatedContracts()) {
+    std::vector<std::byte> const bytecode(std::begin(translated_code.bytecode), std::end(translated_code.bytecode));
+    verified = VerifyAgainstInterpreter(bytecode, {.trace_execution = false, .jit_threshold = std::numeric_limits<std::size_t>::max()}, "translated") and verified;
+  }
+  return verified;
+}
+
+}  // namespace
+
+auto main(int argc, char* argv[]) -> int {
+  std::vector<std::string_view> const arguments(argv + 1, argv + argc);
+  auto const has_flag{[&arguments](std::string_view flag) { return std::ranges::find(arguments, flag) != std::end(arguments); }};
+
+  // value of a flag given as `--flag value`
+  auto const flag_value{[&arguments](std::string_view flag) -> std::optional<std::string> {
+    auto const found{std::ranges::find(arguments, flag)};
+    return found == std::end(arguments) or std::next(found) == std::end(arguments) ? std::nullopt : std::optional<std::string>{*std::next(found)};
+  }};
+
+  // the first argument that is neither a flag nor a flag's value, if any
+  constexpr std::array kFlagsWithValue{std::string_view{"--serve"}, std::string_view{"--load"}, std::string_view{"--profile-json"},
+                                       std::string_view{"--trusted-setup"}};
+  std::string_view bytecode_filepath{kDefaultBytecodeFilepath};
+  for (std::size_t index{0}; index < arguments.size(); ++index) {
+    if (std::ranges::find(kFlagsWithValue, arguments[index]) != std::end(kFlagsWithValue)) {
+      ++index;
+    } else if (not arguments[index].starts_with("--")) {
+      bytecode_filepath = arguments[index];
+      break;
     }
+  }
 
-    auto bc_str{std::views::istream<char>(bc_ifs) | std::ranges::to<std::string>()};
-    m_execution_context.bytecode.reserve(bc_str.size());
-    m_execution_context.bytecode = bc_str | ranges::views::chunk(2) | ranges::views::transform([](auto const& chunk) {
-                                     std::string byte_str{std::begin(chunk), std::end(chunk)};
-                                     return static_cast<std::byte>(std::stoi(byte_str, nullptr, kHexBase));
-                                   }) |
-                                   ranges::to<std::vector>;
+  // the point evaluation precompile fails every call until a trusted setup is loaded
+  if (auto const setup_path{flag_value("--trusted-setup")}) {
+    try {
+      kzg::LoadTrustedSetup(*setup_path);
+    } catch (std::runtime_error const& ex) {
+      std::println("[ERROR] {}", ex.what());
+      return 1;
+    }
   }
 
-  auto Interpret() {
-    while (m_execution_context.program_counter < m_execution_context.bytecode.size()) {
-      auto const& opcode{m_execution_context.bytecode.at(m_execution_context.program_counter)};
+  if (has_flag("--bench-dispatch")) {
+    return RunDispatchBenchmark() ? 0 : 1;
+  }
 
-      try {
-        m_execution_context = kOpcodeHandlers.at(opcode)(std::move(m_execution_context));
+  if (has_flag("--bench-batch")) {
+    RunBatchBenchmark();
+    return 0;
+  }
 
-        m_execution_context.program_counter++;
-        m_execution_context.program_counter += kOpcodeInfo.at(opcode).advance_by;
-      } catch (std::out_of_range const& ex) {
-        std::println("[ERROR] Unrecognized opcode: {:#x}", static_cast<std::uint8_t>(opcode));
-        return;
-      } catch (std::runtime_error const& ex) {
-        std::println("[ERROR] {}", ex.what());
-        return;
-      }
+  if (has_flag("--bench-block")) {
+    RunBlockBenchmark();
+    return 0;
+  }
 
-      PrintStack();
-      // PrintMemory();
-    }
+  if (has_flag("--bench-erc20")) {
+    return RunErc20Benchmark() ? 0 : 1;
+  }
 
-    // TODO: clear stack and initialize memory to 0 for next function call
+  if (has_flag("--bench-state")) {
+    RunStateStoreBenchmark();
+    return 0;
   }
 
- private:
-  ExecutionContext m_execution_context{};
-  inline static std::unordered_map<opcode_t, ExecutionContext (*)(ExecutionContext&&)> const kOpcodeHandlers{{kJump, &Jump},
-                                                                                                             {kDup3, &DuplicateStackValue<3>},
-                                                                                                             {kPush2, &PushToStack<2>},
-                                                                                                             {kPush0, &PushToStack<0>},
-                                                                                                             {kMLoad, &LoadFromMemory},
-                                                                                                             {kShl, &ShiftLeft},
-                                                                                                             {kPush12, &PushToStack<12>},
-                                                                                                             {kPush1, &PushToStack<1>},
-                                                                                                             {kMStore, &StoreToMemory},
-                                                                                                             {kSwap1, &SwapStackValues},
-                                                                                                             {kDup2, &DuplicateStackValue<2>}};
+  if (has_flag("--bench-trie")) {
+    return RunTrieBenchmark() ? 0 : 1;
+  }
 
-  auto PrintStack() const -> void {
-    std::println("printing stack contents ...");
+  if (has_flag("--bench-rlp")) {
+    return RunRlpBenchmark() ? 0 : 1;
+  }
 
-    auto tmp_stack{m_execution_context.stack};
-    while (not tmp_stack.empty()) {
-      auto const top_word{tmp_stack.top()};
-      auto const top_word_span{std::span{intx::as_bytes(top_word), kWordSize}};
-      for (auto byte : top_word_span | std::views::reverse) {
-        std::print("{:02x}, ", byte);
-      }
-      std::println("");
+  if (has_flag("--bench-ecrecover")) {
+    return RunEcRecoverBenchmark() ? 0 : 1;
+  }
 
-      tmp_stack.pop();
-    }
+  if (has_flag("--bench-precompiles")) {
+    return RunPrecompileBenchmark() ? 0 : 1;
+  }
 
-    std::println("finished");
+  if (has_flag("--bench-modexp")) {
+    return RunModExpBenchmark() ? 0 : 1;
   }
 
-  auto PrintMemory() -> void {
-    constexpr static std::size_t kContentSize{300};
+  if (has_flag("--bench-bn254")) {
+    return RunBn254Benchmark() ? 0 : 1;
+  }
 
-    std::println("printing (first {}) memory contents ...", kContentSize);
-    std::ranges::for_each(std::views::iota(0) | std::views::take(kContentSize), [this](auto idx) { std::println("mem[{} = {:x}] = {:x}", idx, idx, m_execution_context.memory.at(idx)); });
-    std::println("finished");
+  if (has_flag("--bench-blake2f")) {
+    return RunBlake2FBenchmark() ? 0 : 1;
   }
-};
 
-auto main() -> int {
-  Interpreter interpreter{};
-  interpreter.LoadBytecode("/home/ush/evm_interpreter/data/smartcontracts/bin/HelloWorld.bin");
-  interpreter.Interpret();
+  if (has_flag("--bench-kzg")) {
+    return RunKzgBenchmark() ? 0 : 1;
+  }
+
+  if (has_flag("--bench-flat-state")) {
+    return RunFlatStateBenchmark() ? 0 : 1;
+  }
+
+#if defined(__linux__)
+  if (auto const socket_path{flag_value("--serve")}) {
+    auto const store{MakeServerStore()};
+    server::ExecutionServer{{}, store.get()}.ServeUnixSocket(*socket_path);
+    return 0;
+  }
+
+  if (has_flag("--serve-stdio")) {
+    auto const store{MakeServerStore()};
+    server::ExecutionServer{{}, store.get()}.ServeStream(STDIN_FILENO, STDOUT_FILENO);
+    return 0;
+  }
+
+  if (auto const socket_path{flag_value("--load")}) {
+    return RunServerLoad(*socket_path, 100'000, 256) ? 0 : 1;
+  }
+
+  if (has_flag("--bench-server")) {
+    return RunServerBenchmark() ? 0 : 1;
+  }
+
+  if (has_flag("--bench-cold-state")) {
+    return RunColdStateBenchmark() ? 0 : 1;
+  }
+#endif
+
+  if (has_flag("--verify-aot")) {
+    return VerifyTranslatedContractsAgainstInterpreter() ? 0 : 1;
+  }
+
+  if (has_flag("--verify-jit")) {
+    auto const verified{VerifyJitAgainstInterpreter(bytecode_filepath) and VerifyJitAgainstInterpreter(MakeArithmeticLoopBytecode(0xff))};
+    return verified ? 0 : 1;
+  }
+
+  auto dispatch_mode{DispatchMode::kHandlerTable};
+  if (has_flag("--tos")) {
+    dispatch_mode = DispatchMode::kTopOfStackCached;
+  } else if (has_flag("--tiered")) {
+    dispatch_mode = DispatchMode::kTiered;
+  }
+
+  if (has_flag("--profile")) {
+#if defined(EVMINT_PROFILE)
+    return RunProfile(bytecode_filepath, dispatch_mode, flag_value("--profile-json")) ? 0 : 1;
+#else
+    std::println("[ERROR] This build does not profile opcodes; configure it with -DEVMINT_PROFILE=ON.");
+    return 1;
+#endif
+  }
+
+  Interpreter interpreter{{.trace_execution = true}};
+  interpreter.LoadBytecode(bytecode_filepath);
+  if (not interpreter.Interpret(dispatch_mode)) {
+    std::println("[ERROR] {}", interpreter.ErrorMessage());
+    return 1;
+  }
 }
@@ -0,0 +1,225 @@
+// SPDX-License-Identifier: MIT
+
+// evmint-microbench: times every opcode the interpreter implements on its own, to catch regressions in single
+// handlers that whole-contract benchmarks (evmint-bench) average away.
+//
+//   evmint-microbench [--dispatch table|tos|tiered] [--repetitions <n>] [--json <path>] [<mnemonic>...]
+//
+// For each opcode of kOpcodeInfo (STOP aside) it generates a loop whose body is the opcode kRepeat times. Where the
+// opcode leaves values an equal opcode can take (ADD's sum, MLOAD's word, DUP's inputs) they are carried into the next
+// repetition; the missing inputs are pushed before and the surplus outputs popped after each repetition, so the stack
+// stays balanced. The same loop with an empty body is timed as well and subtracted, which leaves
+//
+//   ns per op = (loop time - empty loop time) / (iterations * kRepeat)
+//
+// including the repetition's setup pushes and balancing pops, reported as `setup` (instructions per op).
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <format>
+#include <limits>
+#include <optional>
+#include <print>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bench.hpp"
+#include "evm.hpp"
+#include "interpreter.hpp"
+
+using namespace evmint;
+using namespace evmint::bench;
+
+namespace {
+
+constexpr std::size_t kRepeat{64};
+constexpr std::uint16_t kIterations{1'000};
+// the loop counter lives in memory, above the word opcodes under test store to (offset 0)
+constexpr std::uint8_t kCounterOffset{0x40};
+
+struct OpcodeLoop {
+  std::vector<std::byte> bytecode{};
+  // pushes and pops around each execution of the opcode
+  std::size_t setup_instructions{0};
+};
+
+// Appends PUSH1 or PUSH2 of `value`; always PUSH2 if `wide`, for jump targets computed before the push is emitted.
+auto AppendPush(std::vector<std::byte>& bytecode, std::uint16_t value, bool wide = false) -> void {
+  if (not wide and value <= std::numeric_limits<std::uint8_t>::max()) {
+    bytecode.insert(std::end(bytecode), {kPush1, static_cast<std::byte>(value)});
+  } else {
+    bytecode.insert(std::end(bytecode), {kPush2, static_cast<std::byte>(value >> kByteSize), static_cast<std::byte>(value)});
+  }
+}
+
+auto IsJump(opcode_t opcode) -> bool { return opcode == kJump or opcode == kJumpI; }
+
+// Fresh inputs of one repetition in push order (the last ends up on top), for `count` inputs pushed from `pc` on.
+// Carried inputs are always zero (from a previous result or the prefill), so every opcode sees valid operands.
+auto FreshInputs(opcode_t opcode, std::size_t count, std::size_t pc) -> std::vector<std::uint16_t> {
+  if (opcode == kJump) {
+    // to the JUMPDEST right behind it: PUSH2 target JUMP JUMPDEST
+    return {static_cast<std::uint16_t>(pc + 4)};
+  }
+  if (opcode == kJumpI) {
+    // taken: PUSH2 1 PUSH2 target JUMPI JUMPDEST
+    return {1, static_cast<std::uint16_t>(pc + 7)};
+  }
+  if (opcode == kMStore) {
+    // value 1 to offset 0
+    return {1, 0};
+  }
+  return std::vector<std::uint16_t>(count, 1);
+}
+
+// The loop for `opcode`, or the empty loop without one.
+auto MakeOpcodeLoop(std::optional<opcode_t> opcode) -> OpcodeLoop {
+  std::size_t carried{0};
+  std::size_t fresh_count{0};
+  std::size_t pop_count{0};
+  if (opcode) {
+    auto const& opcode_info{kOpcodeInfo.at(*opcode)};
+    carried = std::min(opcode_info.stack_inputs, opcode_info.stack_outputs);
+    fresh_count = opcode_info.stack_inputs - carried;
+    pop_count = opcode_info.stack_outputs - carried;
+  }
+
+  OpcodeLoop loop{.setup_instructions = fresh_count + pop_count};
+  auto& bytecode{loop.bytecode};
+  for (std::size_t prefill{0}; prefill < carried; ++prefill) {
+    AppendPush(bytecode, 0);
+  }
+  AppendPush(bytecode, kIterations);
+  AppendPush(bytecode, kCounterOffset);
+  bytecode.push_back(kMStore);
+
+  auto const loop_begin{bytecode.size()};
+  bytecode.push_back(kJumpDest);
+  for (std::size_t repetition{0}; opcode and repetition < kRepeat; ++repetition) {
+    for (auto const input : FreshInputs(*opcode, fresh_count, bytecode.size())) {
+      AppendPush(bytecode, input, IsJump(*opcode));
+    }
+    bytecode.push_back(*opcode);
+    // PUSHn immediates: 0x01 0x02 ...
+    for (std::size_t immediate{0}; immediate < ImmediateSize(*opcode); ++immediate) {
+      bytecode.push_back(static_cast<std::byte>(immediate + 1));
+    }
+    if (IsJump(*opcode)) {
+      bytecode.push_back(kJumpDest);
+    }
+    bytecode.insert(std::end(bytecode), pop_count, kPop);
+  }
+
+  // counter = mem[kCounterOffset] - 1; loop while non-zero
+  AppendPush(bytecode, kCounterOffset);
+  bytecode.push_back(kMLoad);
+  AppendPush(bytecode, 1);
+  bytecode.insert(std::end(bytecode), {kSwap1, kSub, kDup1});
+  AppendPush(bytecode, kCounterOffset);
+  bytecode.push_back(kMStore);
+  AppendPush(bytecode, static_cast<std::uint16_t>(loop_begin), true);
+  bytecode.insert(std::end(bytecode), {kJumpI, kStop});
+  return loop;
+}
+
+struct OpcodeResult {
+  opcode_t opcode{};
+  DispatchMode dispatch_mode{};
+  std::size_t setup_instructions{0};
+  double ns_per_op{0};
+  double stddev_ns_per_op{0};
+};
+
+auto ToJson(std::vector<OpcodeResult> const& results) -> std::string {
+  auto json{std::format(R"({{"repeat": {}, "iterations": {}, "results": [)", kRepeat, kIterations)};
+  for (auto separator{""}; auto const& result : results) {
+    json += std::format(R"({}{{"opcode": "{:#04x}", "mnemonic": "{}", "dispatch": "{}", "setup": {}, "ns_per_op": {:.4f}, "stddev_ns_per_op": {:.4f}}})", separator,
+                        static_cast<std::uint8_t>(result.opcode), Mnemonic(result.opcode), DispatchModeName(result.dispatch_mode), result.setup_instructions, result.ns_per_op,
+                        result.stddev_ns_per_op);
+    separator = ", ";
+  }
+  return json + "]}";
+}
+
+}  // namespace
+
+auto main(int argc, char* argv[]) -> int {
+  std::vector<std::string_view> const arguments(argv + 1, argv + argc);
+
+  std::vector<DispatchMode> dispatch_modes{DispatchMode::kHandlerTable, DispatchMode::kTopOfStackCached, DispatchMode::kTiered};
+  std::size_t repetitions{kDefaultRepetitions};
+  std::optional<std::string> json_filepath{};
+  std::vector<std::string_view> selected_mnemonics{};
+  for (std::size_t index{0}; index < arguments.size(); ++index) {
+    auto const value{index + 1 < arguments.size() ? std::optional{arguments[index + 1]} : std::nullopt};
+    if (arguments[index] == "--dispatch" and value and ParseDispatchMode(*value)) {
+      dispatch_modes = {*ParseDispatchMode(*value)};
+      ++index;
+    } else if (arguments[index] == "--repetitions" and value) {
+      repetitions = std::max<std::size_t>(std::stoul(std::string{*value}), 1);
+      ++index;
+    } else if (arguments[index] == "--json" and value) {
+      json_filepath = std::string{*value};
+      ++index;
+    } else if (arguments[index].starts_with("--")) {
+      std::println("[ERROR] Unknown or incomplete option '{}'.", arguments[index]);
+      return 1;
+    } else {
+      selected_mnemonics.push_back(arguments[index]);
+    }
+  }
+
+  auto opcodes{kOpcodeInfo | std::views::keys | std::views::filter([&selected_mnemonics](opcode_t opcode) {
+                 return opcode != kStop and (selected_mnemonics.empty() or std::ranges::find(selected_mnemonics, Mnemonic(opcode)) != std::end(selected_mnemonics));
+               }) |
+               std::ranges::to<std::vector>()};
+  std::ranges::sort(opcodes);
+
+  // memory and storage opcodes run far beyond the default gas limit
+  ExecutionRequest request{.gas_limit = std::numeric_limits<std::size_t>::max()};
+  auto const operation_count{static_cast<double>(kIterations) * kRepeat};
+  std::vector<OpcodeResult> results{};
+  std::println("{:<14} {:<8} {:>6} {:>10} {:>8}", "opcode", "dispatch", "setup", "ns/op", "stddev");
+  for (auto const dispatch_mode : dispatch_modes) {
+    request.dispatch_mode = dispatch_mode;
+
+    auto const empty_loop{MakeOpcodeLoop(std::nullopt)};
+    Interpreter empty_interpreter{kExecutorOptions};
+    request.code = empty_loop.bytecode;
+    auto const empty_measurement{MeasureCalls(empty_interpreter, request, repetitions)};
+
+    for (auto const opcode : opcodes) {
+      auto const loop{MakeOpcodeLoop(opcode)};
+      // a fresh interpreter per loop, so kTiered compiles each loop anew
+      Interpreter interpreter{kExecutorOptions};
+      request.code = loop.bytecode;
+      if (auto const result{interpreter.Execute(request)}; result.status != ExecutionStatus::kSuccess) {
+        std::println("[ERROR] The {} loop failed under {}: {}", Mnemonic(opcode), DispatchModeName(dispatch_mode), interpreter.ErrorMessage());
+        return 1;
+      }
+
+      auto const measurement{MeasureCalls(interpreter, request, repetitions)};
+      results.push_back({.opcode = opcode,
+                         .dispatch_mode = dispatch_mode,
+                         .setup_instructions = loop.setup_instructions,
+                         .ns_per_op = (measurement.mean_ns_per_call - empty_measurement.mean_ns_per_call) / operation_count,
+                         .stddev_ns_per_op = measurement.stddev_ns_per_call / operation_count});
+      std::println("{:<14} {:<8} {:>6} {:>10.2f} {:>8.2f}", Mnemonic(opcode), DispatchModeName(dispatch_mode), results.back().setup_instructions, results.back().ns_per_op,
+                   results.back().stddev_ns_per_op);
+    }
+  }
+
+  if (json_filepath) {
+    std::ofstream json_file{*json_filepath};
+    json_file << ToJson(results) << '\n';
+    if (not json_file) {
+      std::println("[ERROR] Could not write the results to '{}'.", *json_filepath);
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,505 @@
+// SPDX-License-Identifier: MIT
+
+// Modular exponentiation of arbitrarily long numbers, for the MODEXP precompile. Odd moduli use Montgomery
+// multiplication, with the width fixed at compile time for 256-, 1024- and 2048-bit moduli (the common ones: field
+// elements and RSA keys) and known only at run time otherwise. An even modulus is split in its odd part and a power of
+// two, exponentiated modulo each and recombined (CRT). Exponents are scanned with sliding windows.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "field.hpp"
+
+namespace evmint::modexp {
+
+using Limb = std::uint64_t;
+using field::uint128_t;
+
+// A big-endian number of `size` bytes of which the first `bytes` are present; the ones missing at the end are zeros
+// (as for precompile input cut short). Views the caller's buffer.
+struct BigEndian {
+  std::span<std::byte const> bytes{};
+  std::size_t size{0};
+
+  // little-endian limbs, as many as `size` takes
+  auto ToLimbs() const -> std::vector<Limb> {
+    std::vector<Limb> limbs((size + sizeof(Limb) - 1) / sizeof(Limb));
+    for (std::size_t index{0}; index < bytes.size(); ++index) {
+      auto const position{size - 1 - index};
+      limbs[position / sizeof(Limb)] |= static_cast<Limb>(bytes[index]) << (position % sizeof(Limb) * kByteSize);
+    }
+    return limbs;
+  }
+
+  auto BitWidth() const -> std::size_t {
+    auto const first_nonzero{std::ranges::find_if(bytes, [](auto byte) { return byte != std::byte{0}; })};
+    if (first_nonzero == std::end(bytes)) {
+      return 0;
+    }
+    auto const position{size - 1 - static_cast<std::size_t>(first_nonzero - std::begin(bytes))};
+    return position * kByteSize + static_cast<std::size_t>(std::bit_width(static_cast<unsigned>(*first_nonzero)));
+  }
+
+  // bit 0 is the least significant; `bit` below 8 * size
+  auto Bit(std::size_t bit) const -> bool {
+    auto const index{size - 1 - bit / kByteSize};
+    return index < bytes.size() and ((static_cast<unsigned>(bytes[index]) >> (bit % kByteSize)) & 1) != 0;
+  }
+};
+
+namespace detail {
+
+inline auto AddTo(Limb* lhs, Limb const* rhs, std::size_t size) -> Limb {
+  Limb carry{0};
+  for (std::size_t limb{0}; limb < size; ++limb) {
+    auto const sum{uint128_t{lhs[limb]} + rhs[limb] + carry};
+    lhs[limb] = static_cast<Limb>(sum);
+    carry = static_cast<Limb>(sum >> 64);
+  }
+  return carry;
+}
+
+inline auto SubtractFrom(Limb* lhs, Limb const* rhs, std::size_t size) -> Limb {
+  Limb borrow{0};
+  for (std::size_t limb{0}; limb < size; ++limb) {
+    auto const difference{uint128_t{lhs[limb]} - rhs[limb] - borrow};
+    lhs[limb] = static_cast<Limb>(difference);
+    borrow = static_cast<Limb>(difference >> 64) & 1;
+  }
+  return borrow;
+}
+
+inline auto Less(Limb const* lhs, Limb const* rhs, std::size_t size) -> bool {
+  for (auto limb{size}; limb-- != 0;) {
+    if (lhs[limb] != rhs[limb]) {
+      return lhs[limb] < rhs[limb];
+    }
+  }
+  return false;
+}
+
+// limbs up to the most significant nonzero one
+inline auto Significant(std::span<Limb const> limbs) -> std::span<Limb const> {
+  auto size{limbs.size()};
+  while (size != 0 and limbs[size - 1] == 0) {
+    --size;
+  }
+  return limbs.first(size);
+}
+
+// the whole product
+inline auto MultiplyFull(std::span<Limb const> lhs, std::span<Limb const> rhs) -> std::vector<Limb> {
+  std::vector<Limb> product(lhs.size() + rhs.size());
+  for (std::size_t limb{0}; limb < rhs.size(); ++limb) {
+    Limb carry{0};
+    for (std::size_t index{0}; index < lhs.size(); ++index) {
+      auto const partial{uint128_t{lhs[index]} * rhs[limb] + product[limb + index] + carry};
+      product[limb + index] = static_cast<Limb>(partial);
+      carry = static_cast<Limb>(partial >> 64);
+    }
+    product[limb + lhs.size()] = carry;
+  }
+  return product;
+}
+
+}  // namespace detail
+
+// Arithmetic modulo an odd modulus in Montgomery form (x * R mod modulus, R = 2^(64 * limbs)). `kLimbCount` fixes the
+// width at compile time, so loops have constant bounds and elements live in arrays; 0 leaves it to the modulus.
+template <std::size_t kLimbCount>
+class Montgomery final {
+ public:
+  using element_t = std::conditional_t<kLimbCount == 0, std::vector<Limb>, std::array<Limb, kLimbCount>>;
+
+  // `modulus`: odd and above 1, its significant limbs (at most kLimbCount of them if that is fixed)
+  explicit Montgomery(std::span<Limb const> modulus) : m_modulus{Zero(modulus.size())} {
+    std::ranges::copy(modulus, std::begin(m_modulus));
+    if constexpr (kLimbCount == 0) {
+      m_accumulator.resize(modulus.size() + 2);
+      m_product.resize(2 * modulus.size());
+    }
+    // -modulus^-1 mod 2^64 by Newton's iteration (each round doubles the correct low bits)
+    Limb inverse{1};
+    for (auto round{0}; round < 6; ++round) {
+      inverse *= 2 - m_modulus[0] * inverse;
+    }
+    m_inverse = ~inverse + 1;
+
+    // R mod modulus, doubling from the highest power of two below the modulus
+    auto const modulus_bits{64 * (modulus.size() - 1) + static_cast<std::size_t>(std::bit_width(modulus.back()))};
+    m_one = Zero(Size());
+    m_one[(modulus_bits - 1) / 64] = Limb{1} << ((modulus_bits - 1) % 64);
+    auto const double_times{[this](element_t& value, std::size_t times) {
+      for (std::size_t time{0}; time < times; ++time) {
+        if (detail::AddTo(value.data(), value.data(), Size()) != 0 or not detail::Less(value.data(), m_modulus.data(), Size())) {
+          detail::SubtractFrom(value.data(), m_modulus.data(), Size());
+        }
+      }
+    }};
+    double_times(m_one, 64 * Size() - modulus_bits + 1);
+
+    // R^2 mod modulus: 2^s in Montgomery form by doubling R, then squared 6 times for 2^(64 * s) = R with s the limb
+    // count (a doubling costs about as much as a limb of a squaring, which is where the two balance)
+    m_r_squared = m_one;
+    double_times(m_r_squared, Size());
+    for (auto squaring{0}; squaring < 6; ++squaring) {
+      Square(m_r_squared, m_r_squared);
+    }
+  }
+
+  auto Size() const -> std::size_t {
+    if constexpr (kLimbCount == 0) {
+      return m_modulus.size();
+    } else {
+      return kLimbCount;
+    }
+  }
+
+  auto One() const -> element_t const& { return m_one; }
+
+  // `value`, of any length, modulo the modulus in Montgomery form: the value's chunks of Size() limbs, from the most
+  // significant, by Horner's rule
+  auto ToMontgomery(std::span<Limb const> value) const -> element_t {
+    auto result{Zero(Size())};
+    auto chunk{Zero(Size())};
+    for (auto chunk_index{(value.size() + Size() - 1) / Size()}; chunk_index-- != 0;) {
+      auto const begin{chunk_index * Size()};
+      std::ranges::fill(chunk, 0);
+      std::ranges::copy(value.subspan(begin, std::min(Size(), value.size() - begin)), std::begin(chunk));
+      // chunk * R, and the chunks so far (none for the top one) moved up by R
+      Multiply(chunk, m_r_squared, chunk);
+      if (begin + Size() < value.size()) {
+        Multiply(result, m_r_squared, result);
+      }
+      if (detail::AddTo(result.data(), chunk.data(), Size()) != 0 or not detail::Less(result.data(), m_modulus.data(), Size())) {
+        detail::SubtractFrom(result.data(), m_modulus.data(), Size());
+      }
+    }
+    return result;
+  }
+
+  auto FromMontgomery(element_t const& value) const -> element_t {
+    auto unit{Zero(Size())};
+    unit[0] = 1;
+    Multiply(value, unit, unit);
+    return unit;
+  }
+
+  // lhs * rhs / R mod modulus (coarsely integrated operand scanning); `result` may be either operand
+  auto Multiply(element_t const& lhs, element_t const& rhs, element_t& result) const -> void {
+    if constexpr (kLimbCount == 0) {
+      std::ranges::fill(m_accumulator, 0);
+      Multiply(lhs.data(), rhs.data(), result.data(), m_accumulator.data(), Size());
+    } else {
+      std::array<Limb, kLimbCount + 2> accumulator{};
+      Multiply(lhs.data(), rhs.data(), result.data(), accumulator.data(), kLimbCount);
+    }
+  }
+
+  // value^2 / R mod modulus, each cross product computed once and doubled before the reduction: about a quarter fewer
+  // multiplications than Multiply(), for the squarings that dominate an exponentiation; `result` may be `value`
+  auto Square(element_t const& value, element_t& result) const -> void {
+    if constexpr (kLimbCount == 0) {
+      Square(value.data(), result.data(), m_product.data(), Size());
+    } else {
+      std::array<Limb, 2 * kLimbCount> product;
+      Square(value.data(), result.data(), product.data(), kLimbCount);
+    }
+  }
+
+ private:
+  element_t m_modulus;
+  element_t m_one{};
+  element_t m_r_squared{};
+  // -modulus^-1 mod 2^64
+  Limb m_inverse{0};
+  // only for run-time widths: fixed ones keep them on the stack
+  mutable std::vector<Limb> m_accumulator{};
+  mutable std::vector<Limb> m_product{};
+
+  static auto Zero(std::size_t size) -> element_t {
+    if constexpr (kLimbCount == 0) {
+      return element_t(size);
+    } else {
+      return element_t{};
+    }
+  }
+
+  // `size` is a constant for fixed widths, which is what unrolls and schedules these loops
+  auto Multiply(Limb const* lhs, Limb const* rhs, Limb* result, Limb* accumulator, std::size_t size) const -> void {
+    auto const* const modulus{m_modulus.data()};
+    for (std::size_t limb{0}; limb < size; ++limb) {
+      Limb carry{0};
+      for (std::size_t index{0}; index < size; ++index) {
+        auto const product{uint128_t{lhs[index]} * rhs[limb] + accumulator[index] + carry};
+        accumulator[index] = static_cast<Limb>(product);
+        carry = static_cast<Limb>(product >> 64);
+      }
+      auto const top{uint128_t{accumulator[size]} + carry};
+      accumulator[size] = static_cast<Limb>(top);
+      accumulator[size + 1] = static_cast<Limb>(top >> 64);
+
+      // adding factor * modulus clears the lowest limb, which is then shifted out
+      auto const factor{accumulator[0] * m_inverse};
+      carry = static_cast<Limb>((uint128_t{factor} * modulus[0] + accumulator[0]) >> 64);
+      for (std::size_t index{1}; index < size; ++index) {
+        auto const product{uint128_t{factor} * modulus[index] + accumulator[index] + carry};
+        accumulator[index - 1] = static_cast<Limb>(product);
+        carry = static_cast<Limb>(product >> 64);
+      }
+      auto const sum{uint128_t{accumulator[size]} + carry};
+      accumulator[size - 1] = static_cast<Limb>(sum);
+      accumulator[size] = accumulator[size + 1] + static_cast<Limb>(sum >> 64);
+    }
+
+    std::copy_n(accumulator, size, result);
+    if (accumulator[size] != 0 or not detail::Less(result, modulus, size)) {
+      detail::SubtractFrom(result, modulus, size);
+    }
+  }
+
+  auto Square(Limb const* value, Limb* result, Limb* product, std::size_t size) const -> void {
+    // the cross products value[i] * value[j], i < j
+    std::fill_n(product, 2 * size, 0);
+    for (std::size_t limb{0}; limb < size; ++limb) {
+      Limb carry{0};
+      for (auto index{limb + 1}; index < size; ++index) {
+        auto const partial{uint128_t{value[limb]} * value[index] + product[limb + index] + carry};
+        product[limb + index] = static_cast<Limb>(partial);
+        carry = static_cast<Limb>(partial >> 64);
+      }
+      product[limb + size] = carry;
+    }
+    // doubled, plus the squares of the limbs
+    Limb shifted_out{0};
+    Limb carry{0};
+    for (std::size_t limb{0}; limb < size; ++limb) {
+      auto const square{uint128_t{value[limb]} * value[limb]};
+      auto const low{product[2 * limb]};
+      auto const high{product[2 * limb + 1]};
+      auto const low_sum{uint128_t{low << 1 | shifted_out} + static_cast<Limb>(square) + carry};
+      auto const high_sum{uint128_t{high << 1 | low >> 63} + static_cast<Limb>(square >> 64) + static_cast<Limb>(low_sum >> 64)};
+      product[2 * limb] = static_cast<Limb>(low_sum);
+      product[2 * limb + 1] = static_cast<Limb>(high_sum);
+      carry = static_cast<Limb>(high_sum >> 64);
+      shifted_out = high >> 63;
+    }
+
+    // Montgomery reduction, a limb at a time; `top_carry` is what overflowed the limb above the reduced ones
+    auto const* const modulus{m_modulus.data()};
+    Limb top_carry{0};
+    for (std::size_t limb{0}; limb < size; ++limb) {
+      auto const factor{product[limb] * m_inverse};
+      Limb reduction_carry{0};
+      for (std::size_t index{0}; index < size; ++index) {
+        auto const partial{uint128_t{factor} * modulus[index] + product[limb + index] + reduction_carry};
+        product[limb + index] = static_cast<Limb>(partial);
+        reduction_carry = static_cast<Limb>(partial >> 64);
+      }
+      auto const sum{uint128_t{product[limb + size]} + reduction_carry + top_carry};
+      product[limb + size] = static_cast<Limb>(sum);
+      top_carry = static_cast<Limb>(sum >> 64);
+    }
+
+    std::copy_n(product + size, size, result);
+    if (top_carry != 0 or not detail::Less(result, modulus, size)) {
+      detail::SubtractFrom(result, modulus, size);
+    }
+  }
+};
+
+// Arithmetic modulo 2^bits: products truncated to the low limbs.
+class PowerOfTwo final {
+ public:
+  using element_t = std::vector<Limb>;
+
+  explicit PowerOfTwo(std::size_t bits) : m_size{(bits + 63) / 64}, m_top_mask{bits % 64 == 0 ? ~Limb{0} : (Limb{1} << (bits % 64)) - 1}, m_product(m_size) {}
+
+  auto Size() const -> std::size_t { return m_size; }
+
+  auto One() const -> element_t {
+    auto one{Reduce({})};
+    one[0] = 1;
+    return one;
+  }
+
+  auto Reduce(std::span<Limb const> value) const -> element_t {
+    element_t result(m_size);
+    std::copy_n(std::begin(value), std::min(value.size(), m_size), std::begin(result));
+    result.back() &= m_top_mask;
+    return result;
+  }
+
+  // `result` may be either operand
+  auto Multiply(element_t const& lhs, element_t const& rhs, element_t& result) const -> void {
+    std::ranges::fill(m_product, 0);
+    for (std::size_t limb{0}; limb < m_size; ++limb) {
+      Limb carry{0};
+      for (std::size_t index{0}; index + limb < m_size; ++index) {
+        auto const partial{uint128_t{lhs[index]} * rhs[limb] + m_product[limb + index] + carry};
+        m_product[limb + index] = static_cast<Limb>(partial);
+        carry = static_cast<Limb>(partial >> 64);
+      }
+    }
+    m_product.back() &= m_top_mask;
+    std::ranges::copy(m_product, std::begin(result));
+  }
+
+  auto Square(element_t const& value, element_t& result) const -> void { Multiply(value, value, result); }
+
+  auto Subtract(element_t const& lhs, element_t const& rhs) const -> element_t {
+    auto difference{lhs};
+    detail::SubtractFrom(difference.data(), rhs.data(), m_size);
+    difference.back() &= m_top_mask;
+    return difference;
+  }
+
+  // 1 / value for an odd value, by Newton's iteration (each round doubles the correct low bits, from the 3 any odd
+  // value is its own inverse to)
+  auto Inverse(element_t const& value) const -> element_t {
+    auto inverse{value};
+    auto two{Reduce({})};
+    two[0] = 2;
+    auto product{Reduce({})};
+    for (std::size_t correct_bits{3}; correct_bits < 64 * m_size; correct_bits *= 2) {
+      Multiply(value, inverse, product);
+      Multiply(inverse, Subtract(two, product), inverse);
+    }
+    return inverse;
+  }
+
+ private:
+  std::size_t m_size;
+  Limb m_top_mask;
+  mutable std::vector<Limb> m_product;
+};
+
+// Bits per window: wider windows save multiplications on long exponents and cost a larger table of odd powers.
+constexpr auto WindowBits(std::size_t exponent_bits) -> std::size_t {
+  constexpr std::array<std::size_t, 5> kThresholds{6, 24, 80, 240, 672};
+  return 1 + static_cast<std::size_t>(std::ranges::count_if(kThresholds, [exponent_bits](auto threshold) { return exponent_bits >= threshold; }));
+}
+
+// base^exponent with left-to-right sliding windows: one squaring per bit and one multiplication per window, each
+// window ending in a 1 so only odd powers of the base are tabulated.
+template <typename Arithmetic>
+auto Pow(Arithmetic const& arithmetic, typename Arithmetic::element_t const& base, BigEndian const& exponent) -> typename Arithmetic::element_t {
+  auto const bits{exponent.BitWidth()};
+  if (bits == 0) {
+    return arithmetic.One();
+  }
+  auto const window_bits{WindowBits(bits)};
+
+  // base, base^3, base^5, ...
+  std::vector<typename Arithmetic::element_t> odd_powers(std::size_t{1} << (window_bits - 1), base);
+  auto square{base};
+  arithmetic.Square(base, square);
+  for (std::size_t power{1}; power < odd_powers.size(); ++power) {
+    arithmetic.Multiply(odd_powers[power - 1], square, odd_powers[power]);
+  }
+
+  auto result{base};
+  auto started{false};
+  // bits left to scan, from the most significant
+  for (auto remaining{bits}; remaining != 0;) {
+    auto const top{remaining - 1};
+    if (not exponent.Bit(top)) {
+      arithmetic.Square(result, result);
+      remaining = top;
+      continue;
+    }
+    auto bottom{top + 1 >= window_bits ? top + 1 - window_bits : 0};
+    while (not exponent.Bit(bottom)) {
+      ++bottom;
+    }
+    std::size_t window{0};
+    for (auto bit{top + 1}; bit-- != bottom;) {
+      window = window << 1 | (exponent.Bit(bit) ? 1 : 0);
+    }
+    if (started) {
+      for (auto bit{bottom}; bit <= top; ++bit) {
+        arithmetic.Square(result, result);
+      }
+      arithmetic.Multiply(result, odd_powers[window >> 1], result);
+    } else {
+      result = odd_powers[window >> 1];
+      started = true;
+    }
+    remaining = bottom;
+  }
+  return result;
+}
+
+// base^exponent mod modulus as the modulus's size in big-endian bytes; zeros for a zero modulus. Without
+// `fixed_width_paths` every odd modulus takes the run-time width (for comparison).
+inline auto ModExp(BigEndian const& base, BigEndian const& exponent, BigEndian const& modulus, std::vector<std::byte>& output, bool fixed_width_paths = true) -> void {
+  output.assign(modulus.size, std::byte{0});
+  auto const modulus_limbs{modulus.ToLimbs()};
+  auto const significant_modulus{detail::Significant(modulus_limbs)};
+  if (significant_modulus.empty()) {
+    return;
+  }
+  auto const base_limbs{base.ToLimbs()};
+
+  // modulus = odd * 2^twos
+  auto const zero_limbs{static_cast<std::size_t>(std::ranges::find_if(significant_modulus, [](auto limb) { return limb != 0; }) - std::begin(significant_modulus))};
+  auto const twos{64 * zero_limbs + static_cast<std::size_t>(std::countr_zero(significant_modulus[zero_limbs]))};
+  std::vector<Limb> odd(significant_modulus.size() - zero_limbs);
+  for (std::size_t limb{0}; limb < odd.size(); ++limb) {
+    auto const next{zero_limbs + limb + 1 < significant_modulus.size() ? significant_modulus[zero_limbs + limb + 1] : 0};
+    odd[limb] = twos % 64 == 0 ? significant_modulus[zero_limbs + limb] : significant_modulus[zero_limbs + limb] >> (twos % 64) | next << (64 - twos % 64);
+  }
+  auto const significant_odd{detail::Significant(odd)};
+
+  // modulo the odd part (nothing to compute modulo 1)
+  std::vector<Limb> odd_result(significant_odd.size());
+  auto const odd_pow{[&]<std::size_t kLimbCount>() {
+    Montgomery<kLimbCount> const montgomery{significant_odd};
+    auto const result{montgomery.FromMontgomery(Pow(montgomery, montgomery.ToMontgomery(base_limbs), exponent))};
+    std::copy_n(std::begin(result), odd_result.size(), std::begin(odd_result));
+  }};
+  if (significant_odd.size() != 1 or significant_odd[0] != 1) {
+    if (fixed_width_paths and significant_odd.size() == 4) {
+      odd_pow.template operator()<4>();
+    } else if (fixed_width_paths and significant_odd.size() == 16) {
+      odd_pow.template operator()<16>();
+    } else if (fixed_width_paths and significant_odd.size() == 32) {
+      odd_pow.template operator()<32>();
+    } else {
+      odd_pow.template operator()<0>();
+    }
+  }
+
+  auto result{odd_result};
+  if (twos != 0) {
+    // modulo 2^twos, then the number below the modulus that matches both: odd_result + odd * y with
+    // y = (two_result - odd_result) / odd mod 2^twos
+    PowerOfTwo const power_of_two{twos};
+    auto const two_result{Pow(power_of_two, power_of_two.Reduce(base_limbs), exponent)};
+    std::vector<Limb> y(power_of_two.Size());
+    power_of_two.Multiply(power_of_two.Subtract(two_result, power_of_two.Reduce(odd_result)), power_of_two.Inverse(power_of_two.Reduce(significant_odd)), y);
+    result = detail::MultiplyFull(significant_odd, y);
+    for (std::size_t limb{0}, carry{0}; limb < result.size(); ++limb) {
+      auto const sum{uint128_t{result[limb]} + (limb < odd_result.size() ? odd_result[limb] : 0) + carry};
+      result[limb] = static_cast<Limb>(sum);
+      carry = static_cast<std::size_t>(sum >> 64);
+    }
+  }
+
+  for (std::size_t index{0}; index < modulus.size; ++index) {
+    auto const position{modulus.size - 1 - index};
+    if (position / sizeof(Limb) < result.size()) {
+      output[index] = static_cast<std::byte>(result[position / sizeof(Limb)] >> (position % sizeof(Limb) * kByteSize));
+    }
+  }
+}
+
+}  // namespace evmint::modexp
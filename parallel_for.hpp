@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace evmint {
+
+// Runs `body(index)` for every index below `count` on up to `thread_count` threads, the calling thread included.
+inline auto ParallelFor(std::size_t count, std::size_t thread_count, auto const& body) -> void {
+  // below this, starting threads costs more than the work
+  constexpr std::size_t kMinCountPerThread{4};
+
+  std::atomic<std::size_t> next_index{0};
+  auto const work{[&] {
+    for (auto index{next_index.fetch_add(1)}; index < count; index = next_index.fetch_add(1)) {
+      body(index);
+    }
+  }};
+  std::vector<std::jthread> threads{};
+  for (std::size_t thread{1}; thread < std::min(thread_count, count / kMinCountPerThread); ++thread) {
+    threads.emplace_back(work);
+  }
+  work();
+}
+
+}  // namespace evmint
@@ -0,0 +1,321 @@
+// SPDX-License-Identifier: MIT
+
+// Precompiled contracts: functions at fixed addresses that calls run natively instead of as bytecode. Each one reads
+// its input where the caller has it, without a copy (short input reads as if padded with zeros where the contract
+// pads), and writes its output to a reused buffer. Their gas depends on the input alone and is charged before they run.
+// Invalid input (a point off its curve, say) fails the call, which then consumes all its gas.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "blake2.hpp"
+#include "bn254.hpp"
+#include "evm.hpp"
+#include "keccak.hpp"
+#include "kzg.hpp"
+#include "modexp.hpp"
+#include "ripemd160.hpp"
+#include "secp256k1.hpp"
+#include "sha256.hpp"
+
+namespace evmint::precompile {
+
+constexpr std::size_t kEcRecoverGas{3'000};
+constexpr std::size_t kSha256Gas{60};
+constexpr std::size_t kSha256WordGas{12};
+constexpr std::size_t kRipemd160Gas{600};
+constexpr std::size_t kRipemd160WordGas{120};
+constexpr std::size_t kIdentityGas{15};
+constexpr std::size_t kIdentityWordGas{3};
+// EIP-2565
+constexpr std::size_t kModExpMinimumGas{200};
+constexpr std::size_t kModExpGasDivisor{3};
+// EIP-1108
+constexpr std::size_t kEcAddGas{150};
+constexpr std::size_t kEcMulGas{6'000};
+constexpr std::size_t kEcPairingGas{45'000};
+constexpr std::size_t kEcPairingPairGas{34'000};
+// EIP-152
+constexpr std::size_t kBlake2FRoundGas{1};
+constexpr std::size_t kBlake2FInputSize{213};
+// EIP-4844
+constexpr std::size_t kPointEvaluationGas{50'000};
+constexpr std::size_t kPointEvaluationInputSize{3 * kWordSize + 2 * bls12_381::kG1CompressedSize};
+
+// input words, the last one partial
+constexpr auto WordCount(std::size_t size) -> std::size_t { return (size + kWordSize - 1) / kWordSize; }
+
+// ECRECOVER (0x01): the address that signed a hash, from (hash, v, r, s) as four words; the address left-padded to a
+// word, or no output for a signature that does not recover. v is 27 or 28, and unlike in transactions a high s is
+// accepted.
+inline auto EcRecover(std::span<std::byte const> input, std::vector<std::byte>& output) -> bool {
+  constexpr std::size_t kInputSize{4 * kWordSize};
+
+  std::array<std::uint8_t, kInputSize> padded{};
+  std::memcpy(padded.data(), input.data(), std::min(input.size(), kInputSize));
+  output.clear();
+  auto const v{LoadWord(padded.data() + kWordSize)};
+  if (v != 27 and v != 28) {
+    return true;
+  }
+  secp256k1::RecoveryInput const recovery_input{.hash = ToHash(LoadWord(padded.data())),
+                                                .r = LoadWord(padded.data() + 2 * kWordSize),
+                                                .s = LoadWord(padded.data() + 3 * kWordSize),
+                                                .y_parity = static_cast<std::uint8_t>(v - 27)};
+  if (auto const address{secp256k1::Recover(recovery_input)}) {
+    auto const address_word{ToHash(*address)};
+    output.assign(std::begin(address_word), std::end(address_word));
+  }
+  return true;
+}
+
+// SHA256 (0x02): the SHA-256 hash of the input.
+inline auto Sha256(std::span<std::byte const> input, std::vector<std::byte>& output) -> bool {
+  auto const hash{evmint::Sha256(input)};
+  output.assign(std::begin(hash), std::end(hash));
+  return true;
+}
+
+// RIPEMD160 (0x03): the RIPEMD-160 hash of the input, left-padded to a word.
+inline auto Ripemd160(std::span<std::byte const> input, std::vector<std::byte>& output) -> bool {
+  auto const digest{evmint::Ripemd160(input)};
+  output.assign(kWordSize - digest.size(), std::byte{0});
+  output.insert(std::end(output), std::begin(digest), std::end(digest));
+  return true;
+}
+
+// IDENTITY (0x04): the input.
+inline auto Identity(std::span<std::byte const> input, std::vector<std::byte>& output) -> bool {
+  output.assign(std::begin(input), std::end(input));
+  return true;
+}
+
+namespace detail {
+
+// `size` bytes of the input from `offset` on, as far as the input goes
+inline auto BigEndianAt(std::span<std::byte const> input, word_t const& offset, std::size_t size) -> modexp::BigEndian {
+  auto const begin{offset < input.size() ? static_cast<std::size_t>(offset) : input.size()};
+  return {.bytes = input.subspan(begin, std::min(size, input.size() - begin)), .size = size};
+}
+
+// MODEXP's base, exponent and modulus sizes, the words its input starts with
+inline auto ModExpSizes(std::span<std::byte const> input) -> std::array<word_t, 3> {
+  std::array<std::uint8_t, 3 * kWordSize> header{};
+  std::memcpy(header.data(), input.data(), std::min(input.size(), header.size()));
+  return {LoadWord(header.data()), LoadWord(header.data() + kWordSize), LoadWord(header.data() + 2 * kWordSize)};
+}
+
+}  // namespace detail
+
+// MODEXP's gas (EIP-2565): the squared words of the longer of base and modulus, times about the bits of the exponent
+// (only the first 32 bytes of which are read), over 3. Saturates for sizes that no gas limit could pay for.
+inline auto ModExpGas(std::span<std::byte const> input) -> std::size_t {
+  constexpr auto kUnaffordable{std::numeric_limits<std::size_t>::max()};
+  constexpr word_t kMaxSize{std::numeric_limits<std::uint64_t>::max()};
+  constexpr std::size_t kExponentHeadSize{32};
+
+  auto const [base_size, exponent_size, modulus_size]{detail::ModExpSizes(input)};
+  auto const longer_size{std::max(base_size, modulus_size)};
+  if (longer_size > kMaxSize) {
+    return kUnaffordable;
+  }
+  auto const words{(longer_size + 7) / word_t{8}};
+  auto const complexity{words * words};
+  if (complexity == 0) {
+    return kModExpMinimumGas;
+  }
+  if (exponent_size > kMaxSize) {
+    return kUnaffordable;
+  }
+
+  auto const head_size{static_cast<std::size_t>(std::min(exponent_size, word_t{kExponentHeadSize}))};
+  auto const head_bits{detail::BigEndianAt(input, 3 * kWordSize + base_size, head_size).BitWidth()};
+  auto iterations{word_t{head_bits == 0 ? 0 : head_bits - 1}};
+  if (exponent_size > kExponentHeadSize) {
+    iterations += 8 * (exponent_size - kExponentHeadSize);
+  }
+  auto const gas{std::max(complexity * std::max(iterations, word_t{1}) / word_t{kModExpGasDivisor}, word_t{kModExpMinimumGas})};
+  return gas > kUnaffordable ? kUnaffordable : static_cast<std::size_t>(gas);
+}
+
+// MODEXP (0x05): base^exponent mod modulus, from their sizes as three words and then the numbers themselves,
+// big-endian; the result has the modulus's size. The exponent is read in place.
+inline auto ModExp(std::span<std::byte const> input, std::vector<std::byte>& output) -> bool {
+  auto const [base_size, exponent_size, modulus_size]{detail::ModExpSizes(input)};
+  // the gas bounds every size but when the modulus is empty, and then there is nothing to compute
+  if (modulus_size == 0) {
+    output.clear();
+    return true;
+  }
+  auto const exponent_begin{3 * kWordSize + base_size};
+  auto const modulus_begin{exponent_begin + exponent_size};
+  modexp::ModExp(detail::BigEndianAt(input, 3 * kWordSize, static_cast<std::size_t>(base_size)),
+                 detail::BigEndianAt(input, exponent_begin, static_cast<std::size_t>(exponent_size)),
+                 detail::BigEndianAt(input, modulus_begin, static_cast<std::size_t>(modulus_size)), output);
+  return true;
+}
+
+// ECADD (0x06): the sum of two alt_bn128 G1 points, each (x, y) as two words and (0, 0) for the point at infinity, as
+// is the output. Fails for a coordinate not below p or a point off the curve.
+inline auto EcAdd(std::span<std::byte const> input, std::vector<std::byte>& output) -> bool {
+  std::array<std::byte, 2 * bn254::kG1Size> padded{};
+  std::memcpy(padded.data(), input.data(), std::min(input.size(), padded.size()));
+  auto const lhs{bn254::ReadG1(padded.data())};
+  auto const rhs{bn254::ReadG1(padded.data() + bn254::kG1Size)};
+  if (not lhs or not rhs) {
+    return false;
+  }
+  output.resize(bn254::kG1Size);
+  bn254::WriteG1(curve::Add(*lhs, *rhs), output.data());
+  return true;
+}
+
+// ECMUL (0x07): a G1 point, as for ECADD, times a scalar word.
+inline auto EcMul(std::span<std::byte const> input, std::vector<std::byte>& output) -> bool {
+  std::array<std::byte, bn254::kG1Size + kWordSize> padded{};
+  std::memcpy(padded.data(), input.data(), std::min(input.size(), padded.size()));
+  auto const point{bn254::ReadG1(padded.data())};
+  if (not point) {
+    return false;
+  }
+  output.resize(bn254::kG1Size);
+  bn254::WriteG1(curve::Multiply(*point, field::LoadBigEndian<4>(padded.data() + bn254::kG1Size)), output.data());
+  return true;
+}
+
+// ECPAIRING (0x08): whether the pairings of the (G1, G2) pairs the input lists multiply to 1, as a word holding 1 or 0;
+// 1 for no pairs. A pair is a G1 point as for ECADD, then a G2 point (bn254::ReadG2()). Fails for input that is not
+// whole pairs or for invalid points, G2 points outside the order-r subgroup included.
+inline auto EcPairing(std::span<std::byte const> input, std::vector<std::byte>& output) -> bool {
+  constexpr std::size_t kPairSize{bn254::kG1Size + bn254::kG2Size};
+
+  if (input.size() % kPairSize != 0) {
+    return false;
+  }
+  thread_local std::vector<bn254::G1> p{};
+  thread_local std::vector<bn254::G2> q{};
+  p.clear();
+  q.clear();
+  for (std::size_t offset{0}; offset < input.size(); offset += kPairSize) {
+    auto const g1_point{bn254::ReadG1(input.data() + offset)};
+    auto const g2_point{bn254::ReadG2(input.data() + offset + bn254::kG1Size)};
+    if (not g1_point or not g2_point) {
+      return false;
+    }
+    p.push_back(*g1_point);
+    q.push_back(*g2_point);
+  }
+  output.assign(kWordSize, std::byte{0});
+  output.back() = bn254::PairingCheck(p, q) ? std::byte{1} : std::byte{0};
+  return true;
+}
+
+// BLAKE2F's gas (EIP-152): a round count as a 4-byte big-endian number, then 1 gas per round. Input of any other size
+// than 213 bytes costs nothing and fails.
+inline auto Blake2FGas(std::span<std::byte const> input) -> std::size_t {
+  if (input.size() != kBlake2FInputSize) {
+    return 0;
+  }
+  std::uint32_t rounds{0};
+  std::memcpy(&rounds, input.data(), sizeof(rounds));
+  return kBlake2FRoundGas * std::byteswap(rounds);
+}
+
+// BLAKE2F (0x09): BLAKE2b's compression function, from the round count, the state h (8 words), the message block m
+// (16 words), the offset counter t (2 words), all little-endian, and the final block flag f, a byte holding 0 or 1; the
+// new state as 64 bytes. Everything is read in place. Fails for input of another size than 213 bytes or another flag.
+inline auto Blake2F(std::span<std::byte const> input, std::vector<std::byte>& output) -> bool {
+  constexpr std::size_t kStateOffset{4};
+  constexpr std::size_t kMessageOffset{kStateOffset + sizeof(blake2::State)};
+  constexpr std::size_t kOffsetOffset{kMessageOffset + blake2::kBlockSize};
+  constexpr std::size_t kFlagOffset{kOffsetOffset + sizeof(blake2::Offset)};
+  static_assert(kFlagOffset + 1 == kBlake2FInputSize);
+
+  if (input.size() != kBlake2FInputSize or (input[kFlagOffset] != std::byte{0} and input[kFlagOffset] != std::byte{1})) {
+    return false;
+  }
+  std::uint32_t rounds{0};
+  std::memcpy(&rounds, input.data(), sizeof(rounds));
+  blake2::State state{};
+  std::memcpy(state.data(), input.data() + kStateOffset, sizeof(state));
+  blake2::Offset offset{};
+  std::memcpy(offset.data(), input.data() + kOffsetOffset, sizeof(offset));
+  blake2::kCompress(state, input.data() + kMessageOffset, offset, input[kFlagOffset] == std::byte{1}, std::byteswap(rounds));
+  output.resize(sizeof(state));
+  std::memcpy(output.data(), state.data(), sizeof(state));
+  return true;
+}
+
+// POINT_EVALUATION (0x0a): whether a KZG proof shows that the blob a versioned hash names is y at z, from the versioned
+// hash, z and y (words, big-endian, below BLS12-381's order r), the commitment and the proof (compressed G1 points);
+// the blob's field element count and r as two words. Fails for input of another size than 192 bytes, a versioned hash
+// that is not the commitment's, invalid points or scalars, a proof that does not verify, or while no trusted setup is
+// loaded (kzg::LoadTrustedSetup()).
+inline auto PointEvaluation(std::span<std::byte const> input, std::vector<std::byte>& output) -> bool {
+  constexpr std::size_t kCommitmentOffset{3 * kWordSize};
+  constexpr std::size_t kProofOffset{kCommitmentOffset + bls12_381::kG1CompressedSize};
+
+  auto const* const setup{kzg::ActiveTrustedSetup()};
+  if (input.size() != kPointEvaluationInputSize or setup == nullptr) {
+    return false;
+  }
+  auto const commitment_bytes{input.subspan<kCommitmentOffset, bls12_381::kG1CompressedSize>()};
+  if (not std::ranges::equal(kzg::VersionedHash(commitment_bytes), input.first<kWordSize>())) {
+    return false;
+  }
+  auto const z{bls12_381::Fr::FromLimbs(field::LoadBigEndian<4>(input.data() + kWordSize))};
+  auto const y{bls12_381::Fr::FromLimbs(field::LoadBigEndian<4>(input.data() + 2 * kWordSize))};
+  if (not z or not y) {
+    return false;
+  }
+  auto const commitment{bls12_381::DecompressG1(commitment_bytes.data())};
+  auto const proof{bls12_381::DecompressG1(input.data() + kProofOffset)};
+  if (not commitment or not proof or not setup->VerifyProof(*commitment, *z, *y, *proof)) {
+    return false;
+  }
+  output.assign(2 * kWordSize, std::byte{0});
+  field::StoreBigEndian(field::Limbs<4>{kzg::kFieldElementsPerBlob}, output.data());
+  field::StoreBigEndian(bls12_381::Fr::kModulus, output.data() + kWordSize);
+  return true;
+}
+
+struct Precompile {
+  std::string_view name{};
+  auto (*gas)(std::span<std::byte const> input) -> std::size_t {nullptr};
+  // false if the input is invalid, which fails the call
+  auto (*run)(std::span<std::byte const> input, std::vector<std::byte>& output) -> bool {nullptr};
+};
+
+// by address, from 0x01
+inline constexpr std::array<Precompile, 10> kPrecompiles{{
+    {"ECRECOVER", [](std::span<std::byte const>) { return kEcRecoverGas; }, &EcRecover},
+    {"SHA256", [](std::span<std::byte const> input) { return kSha256Gas + kSha256WordGas * WordCount(input.size()); }, &Sha256},
+    {"RIPEMD160", [](std::span<std::byte const> input) { return kRipemd160Gas + kRipemd160WordGas * WordCount(input.size()); }, &Ripemd160},
+    {"IDENTITY", [](std::span<std::byte const> input) { return kIdentityGas + kIdentityWordGas * WordCount(input.size()); }, &Identity},
+    {"MODEXP", &ModExpGas, &ModExp},
+    {"ECADD", [](std::span<std::byte const>) { return kEcAddGas; }, &EcAdd},
+    {"ECMUL", [](std::span<std::byte const>) { return kEcMulGas; }, &EcMul},
+    {"ECPAIRING", [](std::span<std::byte const> input) { return kEcPairingGas + kEcPairingPairGas * (input.size() / (bn254::kG1Size + bn254::kG2Size)); }, &EcPairing},
+    {"BLAKE2F", &Blake2FGas, &Blake2F},
+    {"POINT_EVALUATION", [](std::span<std::byte const>) { return kPointEvaluationGas; }, &PointEvaluation},
+}};
+
+// The precompiled contract at `address`, null for any other account. Checked before an account's code runs.
+inline auto Find(word_t const& address) -> Precompile const* {
+  if (address == 0 or address > kPrecompiles.size()) {
+    return nullptr;
+  }
+  return &kPrecompiles[static_cast<std::size_t>(address) - 1];
+}
+
+}  // namespace evmint::precompile
@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: MIT
+
+// Per-opcode execution profile, filled by the interpreter's dispatch loops in builds configured with EVMINT_PROFILE
+// (cmake -DEVMINT_PROFILE=ON); other builds contain no profiling code at all. Every interpreted instruction is counted
+// and timed with the CPU's time stamp counter (rdtsc; steady_clock nanoseconds on other architectures), from before
+// its gas check to after its handler. The timestamps themselves cost some 20 cycles, which is included in every sample.
+//
+// Instructions kTiered runs inside compiled blocks are not attributed to opcodes; only the ones it single-steps
+// through the interpreter are.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <print>
+#include <ranges>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+#include "evm.hpp"
+
+namespace evmint {
+
+inline auto ReadCycleCounter() -> std::uint64_t {
+#if defined(__x86_64__)
+  return __rdtsc();
+#else
+  return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// bucket b of a histogram counts samples of [2^b, 2^(b + 1)) cycles, bucket 0 also those of 0 cycles
+constexpr std::size_t kCycleBuckets{32};
+
+struct OpcodeStats {
+  std::uint64_t count{0};
+  std::uint64_t cycles{0};
+  std::array<std::uint64_t, kCycleBuckets> histogram{};
+
+  auto MeanCycles() const -> double { return count == 0 ? 0.0 : static_cast<double>(cycles) / static_cast<double>(count); }
+};
+
+class OpcodeProfile {
+ public:
+  auto Record(opcode_t opcode, std::uint64_t cycles) -> void {
+    auto& stats{m_stats[static_cast<std::size_t>(opcode)]};
+    stats.count++;
+    stats.cycles += cycles;
+    stats.histogram[std::min<std::size_t>(std::max<std::size_t>(std::bit_width(cycles), 1) - 1, kCycleBuckets - 1)]++;
+  }
+
+  auto Merge(OpcodeProfile const& other) -> void {
+    for (std::size_t opcode{0}; opcode < m_stats.size(); ++opcode) {
+      auto& stats{m_stats[opcode]};
+      auto const& other_stats{other.m_stats[opcode]};
+      stats.count += other_stats.count;
+      stats.cycles += other_stats.cycles;
+      std::ranges::transform(stats.histogram, other_stats.histogram, std::begin(stats.histogram), std::plus<>{});
+    }
+  }
+
+  auto Clear() -> void { m_stats = {}; }
+
+  auto Stats(opcode_t opcode) const -> OpcodeStats const& { return m_stats[static_cast<std::size_t>(opcode)]; }
+
+  auto TotalCycles() const -> std::uint64_t {
+    std::uint64_t total_cycles{0};
+    for (auto const& stats : m_stats) {
+      total_cycles += stats.cycles;
+    }
+    return total_cycles;
+  }
+
+  // Opcodes that ran at least once, most total cycles first.
+  auto ExecutedOpcodes() const -> std::vector<opcode_t> {
+    auto opcodes{std::views::iota(std::size_t{0}, m_stats.size()) | std::views::filter([this](auto opcode) { return m_stats[opcode].count != 0; }) |
+                 std::views::transform([](auto opcode) { return static_cast<opcode_t>(opcode); }) | std::ranges::to<std::vector>()};
+    std::ranges::stable_sort(opcodes, std::ranges::greater{}, [this](opcode_t opcode) { return Stats(opcode).cycles; });
+    return opcodes;
+  }
+
+  auto PrintTable() const -> void {
+    auto const total_cycles{std::max<std::uint64_t>(TotalCycles(), 1)};
+    std::println("{:<14} {:>12} {:>16} {:>8} {:>12}", "opcode", "count", "cycles", "share", "cycles/op");
+    for (auto const opcode : ExecutedOpcodes()) {
+      auto const& stats{Stats(opcode)};
+      std::println("{:<14} {:>12} {:>16} {:>7.2f}% {:>12.1f}", Name(opcode), stats.count, stats.cycles,
+                   100.0 * static_cast<double>(stats.cycles) / static_cast<double>(total_cycles), stats.MeanCycles());
+    }
+  }
+
+  // {"total_cycles": n, "opcodes": [{"opcode": "0x01", "mnemonic": "ADD", "count": n, "cycles": n, "mean_cycles": x,
+  // "histogram": [n, ...]}, ...]} with the opcodes in PrintTable() order and kCycleBuckets histogram buckets each.
+  auto ToJson() const -> std::string {
+    auto json{std::format(R"({{"total_cycles": {}, "opcodes": [)", TotalCycles())};
+    for (auto separator{""}; auto const opcode : ExecutedOpcodes()) {
+      auto const& stats{Stats(opcode)};
+      json += std::format(R"({}{{"opcode": "{:#04x}", "mnemonic": "{}", "count": {}, "cycles": {}, "mean_cycles": {:.3f}, "histogram": [)", separator,
+                          static_cast<std::uint8_t>(opcode), Mnemonic(opcode), stats.count, stats.cycles, stats.MeanCycles());
+      for (auto bucket_separator{""}; auto const bucket : stats.histogram) {
+        json += std::format("{}{}", bucket_separator, bucket);
+        bucket_separator = ", ";
+      }
+      json += "]}";
+      separator = ", ";
+    }
+    return json + "]}";
+  }
+
+ private:
+  std::array<OpcodeStats, 256> m_stats{};
+
+  static auto Name(opcode_t opcode) -> std::string {
+    auto const mnemonic{Mnemonic(opcode)};
+    return mnemonic.empty() ? std::format("{:#04x}", static_cast<std::uint8_t>(opcode)) : std::format("{} ({:#04x})", mnemonic, static_cast<std::uint8_t>(opcode));
+  }
+};
+
+}  // namespace evmint
@@ -0,0 +1,119 @@
+// SPDX-License-Identifier: MIT
+
+// RIPEMD-160, for the RIPEMD160 precompile. Both lines of a compression run interleaved in one fully unrolled loop:
+// every message word, rotation and round function is then a constant, and the two independent lines fill each other's
+// latencies. Whole blocks are compressed straight from the input; only the padded tail is copied.
+
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#include "evm.hpp"
+
+namespace evmint {
+
+namespace ripemd160 {
+
+constexpr std::size_t kBlockSize{64};
+
+using State = std::array<std::uint32_t, 5>;
+using Digest = std::array<std::byte, 20>;
+
+constexpr State kInitialState{0x6745'2301, 0xefcd'ab89, 0x98ba'dcfe, 0x1032'5476, 0xc3d2'e1f0};
+
+// message words and rotations by step, for the left and right lines
+constexpr std::array<std::uint8_t, 80> kLeftWords{
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 7, 4, 13, 1, 10, 6, 15, 3, 12, 0, 9, 5, 2, 14, 11, 8, 3, 10, 14, 4, 9, 15, 8, 1, 2, 7, 0, 6, 13, 11, 5, 12, 1, 9, 11, 10, 0, 8, 12, 4, 13, 3,
+    7, 15, 14, 5, 6, 2, 4, 0, 5, 9, 7, 12, 2, 10, 14, 1, 3, 8, 11, 6, 15, 13};
+constexpr std::array<std::uint8_t, 80> kRightWords{
+    5, 14, 7, 0, 9, 2, 11, 4, 13, 6, 15, 8, 1, 10, 3, 12, 6, 11, 3, 7, 0, 13, 5, 10, 14, 15, 8, 12, 4, 9, 1, 2, 15, 5, 1, 3, 7, 14, 6, 9, 11, 8, 12, 2, 10, 0, 4, 13, 8, 6, 4, 1, 3, 11, 15, 0, 5, 12,
+    2, 13, 9, 7, 10, 14, 12, 15, 10, 4, 1, 5, 8, 7, 6, 2, 13, 14, 0, 3, 9, 11};
+constexpr std::array<std::uint8_t, 80> kLeftRotations{
+    11, 14, 15, 12, 5, 8, 7, 9, 11, 13, 14, 15, 6, 7, 9, 8, 7, 6, 8, 13, 11, 9, 7, 15, 7, 12, 15, 9, 11, 7, 13, 12, 11, 13, 6, 7, 14, 9, 13, 15, 14, 8, 13, 6, 5, 12, 7, 5, 11, 12, 14, 15, 14, 15, 9,
+    8, 9, 14, 5, 6, 8, 6, 5, 12, 9, 15, 5, 11, 6, 8, 13, 12, 5, 12, 13, 14, 11, 8, 5, 6};
+constexpr std::array<std::uint8_t, 80> kRightRotations{
+    8, 9, 9, 11, 13, 15, 15, 5, 7, 7, 8, 11, 14, 14, 12, 6, 9, 13, 15, 7, 12, 8, 9, 11, 7, 7, 12, 7, 6, 15, 13, 11, 9, 7, 15, 11, 8, 6, 6, 14, 12, 13, 5, 14, 13, 13, 7, 5, 15, 5, 8, 11, 14, 14, 6, 14,
+    6, 9, 12, 9, 12, 5, 15, 8, 8, 5, 12, 9, 12, 5, 14, 6, 8, 13, 6, 5, 15, 13, 11, 11};
+// by round of 16 steps
+constexpr std::array<std::uint32_t, 5> kLeftConstants{0x0000'0000, 0x5a82'7999, 0x6ed9'eba1, 0x8f1b'bcdc, 0xa953'fd4e};
+constexpr std::array<std::uint32_t, 5> kRightConstants{0x50a2'8be6, 0x5c4d'd124, 0x6d70'3ef3, 0x7a6d'76e9, 0x0000'0000};
+
+// the round functions; the left line uses them in order, the right one in reverse
+template <std::size_t kRound>
+constexpr auto RoundFunction(std::uint32_t x, std::uint32_t y, std::uint32_t z) -> std::uint32_t {
+  if constexpr (kRound == 0) {
+    return x ^ y ^ z;
+  } else if constexpr (kRound == 1) {
+    return (x & y) | (~x & z);
+  } else if constexpr (kRound == 2) {
+    return (x | ~y) ^ z;
+  } else if constexpr (kRound == 3) {
+    return (x & z) | (y & ~z);
+  } else {
+    return x ^ (y | ~z);
+  }
+}
+
+// Words are little-endian, like every host evmint runs on.
+static_assert(std::endian::native == std::endian::little);
+
+inline auto Compress(State& state, std::byte const* blocks, std::size_t block_count) -> void {
+  for (; block_count != 0; --block_count, blocks += kBlockSize) {
+    std::array<std::uint32_t, 16> words{};
+    std::memcpy(words.data(), blocks, kBlockSize);
+
+    auto [a, b, c, d, e]{state};
+    auto [right_a, right_b, right_c, right_d, right_e]{state};
+    Unrolled<80>([&](auto step) {
+      constexpr std::size_t kRound{step / 16};
+      auto const left{std::rotl(a + RoundFunction<kRound>(b, c, d) + words[kLeftWords[step]] + kLeftConstants[kRound], kLeftRotations[step]) + e};
+      a = e;
+      e = d;
+      d = std::rotl(c, 10);
+      c = b;
+      b = left;
+      auto const right{std::rotl(right_a + RoundFunction<4 - kRound>(right_b, right_c, right_d) + words[kRightWords[step]] + kRightConstants[kRound], kRightRotations[step]) +
+                       right_e};
+      right_a = right_e;
+      right_e = right_d;
+      right_d = std::rotl(right_c, 10);
+      right_c = right_b;
+      right_b = right;
+    });
+    auto const combined{state[1] + c + right_d};
+    state[1] = state[2] + d + right_e;
+    state[2] = state[3] + e + right_a;
+    state[3] = state[4] + a + right_b;
+    state[4] = state[0] + b + right_c;
+    state[0] = combined;
+  }
+}
+
+}  // namespace ripemd160
+
+inline auto Ripemd160(std::span<std::byte const> data) -> ripemd160::Digest {
+  auto state{ripemd160::kInitialState};
+  auto const block_count{data.size() / ripemd160::kBlockSize};
+  ripemd160::Compress(state, data.data(), block_count);
+
+  // the tail, a 1 bit, zeros and the length in bits (little-endian): one block, or two if the length does not fit
+  auto const tail{data.subspan(block_count * ripemd160::kBlockSize)};
+  std::array<std::byte, 2 * ripemd160::kBlockSize> last_blocks{};
+  std::memcpy(last_blocks.data(), tail.data(), tail.size());
+  last_blocks[tail.size()] = std::byte{0x80};
+  auto const last_block_count{tail.size() + 1 + sizeof(std::uint64_t) > ripemd160::kBlockSize ? 2 : 1};
+  auto const bit_count{static_cast<std::uint64_t>(data.size()) * kByteSize};
+  std::memcpy(last_blocks.data() + last_block_count * ripemd160::kBlockSize - sizeof(bit_count), &bit_count, sizeof(bit_count));
+  ripemd160::Compress(state, last_blocks.data(), last_block_count);
+
+  ripemd160::Digest digest{};
+  std::memcpy(digest.data(), state.data(), digest.size());
+  return digest;
+}
+
+}  // namespace evmint
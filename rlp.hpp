@@ -0,0 +1,220 @@
+// SPDX-License-Identifier: MIT
+
+// Recursive Length Prefix encoding, Ethereum's serialisation of trie nodes, accounts and transactions.
+//
+// Decoding is zero-copy: an Item is a view into the input, which must outlive it, and nothing is allocated. It is also
+// strict, as consensus requires: anything but the one canonical encoding of a value (a single byte below 0x80 wrapped
+// in a string header, a long header for a short payload, length or integer bytes with leading zeros) is rejected.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "evm.hpp"
+
+namespace evmint::rlp {
+
+constexpr std::byte kEmptyString{0x80};
+constexpr std::byte kEmptyList{0xc0};
+// payloads up to this size have their length in the prefix byte itself
+constexpr std::size_t kMaxShortPayload{55};
+
+// Appends encodings to a caller-owned buffer, which is reused across encodings so steady state never allocates. Lists
+// are written as BeginList() ... EndList(): the header goes in front of the payload once its size is known.
+class Encoder {
+ public:
+  explicit Encoder(std::vector<std::byte>& output) : m_output{output} {}
+
+  auto AppendString(std::span<std::byte const> bytes) -> void {
+    if (bytes.size() == 1 and bytes[0] < kEmptyString) {
+      m_output.push_back(bytes[0]);
+      return;
+    }
+    AppendHeader(kEmptyString, bytes.size());
+    m_output.insert(std::end(m_output), std::begin(bytes), std::end(bytes));
+  }
+
+  // An unsigned integer: big-endian without leading zero bytes, so zero is the empty string.
+  auto AppendWord(word_t const& word) -> void {
+    std::array<std::uint8_t, kWordSize> bytes{};
+    StoreWord(bytes.data(), word);
+    auto const leading_zeros{static_cast<std::size_t>(std::ranges::find_if(bytes, [](auto byte) { return byte != 0; }) - std::begin(bytes))};
+    AppendString(std::as_bytes(std::span{bytes}).subspan(leading_zeros));
+  }
+
+  // An already encoded item, such as a trie node embedded in its parent.
+  auto AppendRaw(std::span<std::byte const> encoded) -> void { m_output.insert(std::end(m_output), std::begin(encoded), std::end(encoded)); }
+
+  // Returns where the list starts, for EndList().
+  auto BeginList() -> std::size_t { return m_output.size(); }
+
+  auto EndList(std::size_t list_begin) -> void {
+    auto const payload_size{m_output.size() - list_begin};
+    auto const header_size{HeaderSize(payload_size)};
+    m_output.resize(m_output.size() + header_size);
+    std::copy_backward(std::next(std::begin(m_output), static_cast<std::ptrdiff_t>(list_begin)), std::prev(std::end(m_output), static_cast<std::ptrdiff_t>(header_size)),
+                       std::end(m_output));
+    WriteHeader(m_output.data() + list_begin, kEmptyList, payload_size);
+  }
+
+ private:
+  std::vector<std::byte>& m_output;
+
+  static auto HeaderSize(std::size_t payload_size) -> std::size_t {
+    return payload_size <= kMaxShortPayload ? 1 : 1 + (std::bit_width(payload_size) + kByteSize - 1) / kByteSize;
+  }
+
+  // The header of a string (offset kEmptyString) or list (kEmptyList) with a payload of `payload_size` bytes.
+  static auto WriteHeader(std::byte* destination, std::byte offset, std::size_t payload_size) -> void {
+    if (payload_size <= kMaxShortPayload) {
+      *destination = static_cast<std::byte>(static_cast<std::size_t>(offset) + payload_size);
+      return;
+    }
+    auto const length_size{HeaderSize(payload_size) - 1};
+    *destination++ = static_cast<std::byte>(static_cast<std::size_t>(offset) + kMaxShortPayload + length_size);
+    for (auto shift{length_size * kByteSize}; shift != 0; shift -= kByteSize) {
+      *destination++ = static_cast<std::byte>(payload_size >> (shift - kByteSize));
+    }
+  }
+
+  auto AppendHeader(std::byte offset, std::size_t payload_size) -> void {
+    auto const header_begin{m_output.size()};
+    m_output.resize(header_begin + HeaderSize(payload_size));
+    WriteHeader(m_output.data() + header_begin, offset, payload_size);
+  }
+};
+
+struct Item {
+  bool is_list{false};
+  // a string's bytes or a list's encoded items
+  std::span<std::byte const> payload{};
+  // the whole item, header included
+  std::span<std::byte const> encoding{};
+};
+
+// Splits the first item off the front of `input`; nullopt if it is truncated or not canonical.
+inline auto TakeItem(std::span<std::byte const>& input) -> std::optional<Item> {
+  constexpr std::size_t kLongStringOffset{static_cast<std::size_t>(kEmptyString) + kMaxShortPayload};
+  constexpr std::size_t kLongListOffset{static_cast<std::size_t>(kEmptyList) + kMaxShortPayload};
+
+  if (input.empty()) {
+    return std::nullopt;
+  }
+  auto const prefix{static_cast<std::size_t>(input[0])};
+  if (prefix < static_cast<std::size_t>(kEmptyString)) {
+    Item const item{.payload = input.first(1), .encoding = input.first(1)};
+    input = input.subspan(1);
+    return item;
+  }
+
+  auto const is_list{prefix >= static_cast<std::size_t>(kEmptyList)};
+  auto const short_offset{static_cast<std::size_t>(is_list ? kEmptyList : kEmptyString)};
+  auto const long_offset{is_list ? kLongListOffset : kLongStringOffset};
+  std::size_t header_size{1};
+  std::size_t payload_size{prefix - short_offset};
+  if (prefix > long_offset) {
+    auto const length_size{prefix - long_offset};
+    if (length_size > sizeof(std::size_t) or input.size() <= length_size or input[1] == std::byte{0}) {
+      return std::nullopt;
+    }
+    payload_size = 0;
+    for (auto const byte : input.subspan(1, length_size)) {
+      payload_size = payload_size << kByteSize | static_cast<std::size_t>(byte);
+    }
+    if (payload_size <= kMaxShortPayload) {
+      return std::nullopt;
+    }
+    header_size += length_size;
+  }
+  if (input.size() - header_size < payload_size) {
+    return std::nullopt;
+  }
+
+  Item const item{.is_list = is_list, .payload = input.subspan(header_size, payload_size), .encoding = input.first(header_size + payload_size)};
+  if (not is_list and payload_size == 1 and item.payload[0] < kEmptyString) {
+    return std::nullopt;
+  }
+  input = input.subspan(header_size + payload_size);
+  return item;
+}
+
+// The single item `input` holds; nullopt if it holds anything else or more.
+inline auto Decode(std::span<std::byte const> input) -> std::optional<Item> {
+  auto item{TakeItem(input)};
+  return input.empty() ? item : std::nullopt;
+}
+
+// Bytes as a big-endian integer, padded with leading zeros: one word load rather than a shift per byte.
+inline auto FromBigEndian(std::span<std::byte const> bytes) -> word_t {
+  bytes = bytes.last(std::min(bytes.size(), kWordSize));
+  std::array<std::uint8_t, kWordSize> word_bytes{};
+  std::memcpy(word_bytes.data() + kWordSize - bytes.size(), bytes.data(), bytes.size());
+  return LoadWord(word_bytes.data());
+}
+
+// An unsigned integer of at most `kMaxBytes` bytes: big-endian without leading zeros.
+template <std::size_t kMaxBytes = kWordSize>
+auto ToWord(Item const& item) -> std::optional<word_t> {
+  if (item.is_list or item.payload.size() > kMaxBytes or (not item.payload.empty() and item.payload[0] == std::byte{0})) {
+    return std::nullopt;
+  }
+  return FromBigEndian(item.payload);
+}
+
+// Reads the items of a list in order. A failure sticks: the readers then return zero values, and Finish() reports
+// whether every item read was well-formed and none was left over, so decoders check once at the end.
+class ListReader {
+ public:
+  explicit ListReader(Item const& list) : m_rest{list.payload}, m_ok{list.is_list} {}
+
+  auto Next() -> Item {
+    auto item{m_ok ? TakeItem(m_rest) : std::nullopt};
+    m_ok = item.has_value();
+    return item.value_or(Item{});
+  }
+
+  auto String() -> std::span<std::byte const> { return Expect(false).payload; }
+  auto List() -> Item { return Expect(true); }
+
+  auto Word() -> word_t { return Checked(ToWord(Next())); }
+  auto Uint64() -> std::uint64_t { return static_cast<std::uint64_t>(Checked(ToWord<sizeof(std::uint64_t)>(Next()))); }
+
+  // a 20-byte address, nullopt for the empty string (no recipient: contract creation)
+  auto Address() -> std::optional<word_t> {
+    auto const bytes{String()};
+    if (bytes.empty()) {
+      return std::nullopt;
+    }
+    m_ok = m_ok and bytes.size() == 20;
+    return FromBigEndian(bytes);
+  }
+
+  auto AtEnd() const -> bool { return m_rest.empty(); }
+  auto Finish() const -> bool { return m_ok and m_rest.empty(); }
+
+ private:
+  std::span<std::byte const> m_rest;
+  bool m_ok;
+
+  auto Expect(bool is_list) -> Item {
+    auto const item{Next()};
+    m_ok = m_ok and item.is_list == is_list;
+    return m_ok ? item : Item{};
+  }
+
+  auto Checked(std::optional<word_t> const& word) -> word_t {
+    m_ok = m_ok and word.has_value();
+    return word.value_or(0);
+  }
+};
+
+}  // namespace evmint::rlp
@@ -0,0 +1,265 @@
+// SPDX-License-Identifier: MIT
+
+// Public key recovery on secp256k1 (y^2 = x^3 + 7), which gives every transaction its sender and backs the ECRECOVER
+// precompile. A recovery computes u1 * G + u2 * R: the generator's multiple from a precomputed table of its 4-bit
+// window multiples (additions only), R's by 4-bit windows over u2 split in two 128-bit halves (GLV). Batches share
+// their field inversions.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "curve.hpp"
+#include "evm.hpp"
+#include "field.hpp"
+#include "keccak.hpp"
+
+namespace evmint::secp256k1 {
+
+struct FieldModulus {
+  static constexpr field::Limbs<4> kModulus{0xffff'fffe'ffff'fc2f, 0xffff'ffff'ffff'ffff, 0xffff'ffff'ffff'ffff, 0xffff'ffff'ffff'ffff};
+};
+
+struct OrderModulus {
+  static constexpr field::Limbs<4> kModulus{0xbfd2'5e8c'd036'4141, 0xbaae'dce6'af48'a03b, 0xffff'ffff'ffff'fffe, 0xffff'ffff'ffff'ffff};
+};
+
+// coordinates
+using Fp = field::PrimeField<FieldModulus>;
+// scalars: the group order n
+using Fn = field::PrimeField<OrderModulus>;
+
+inline auto ToLimbs(word_t const& word) -> field::Limbs<4> { return {word[0], word[1], word[2], word[3]}; }
+inline auto ToWord(field::Limbs<4> const& limbs) -> word_t { return word_t{limbs[0], limbs[1], limbs[2], limbs[3]}; }
+
+// n / 2: since EIP-2, transaction signatures with a larger s are invalid (each signature has one valid twin otherwise)
+inline word_t const kHalfOrder{ToWord(OrderModulus::kModulus) >> 1};
+
+using AffinePoint = curve::AffinePoint<Fp>;
+using JacobianPoint = curve::JacobianPoint<Fp>;
+using curve::Add;
+using curve::Double;
+
+inline auto ToAffine(std::span<JacobianPoint const> points, std::span<AffinePoint> affine_points) -> void { curve::ToAffine(points, affine_points); }
+
+namespace detail {
+
+constexpr std::size_t kWindowBits{4};
+constexpr std::size_t kWindowCount{256 / kWindowBits};
+constexpr std::size_t kWindowSize{1 << kWindowBits};
+
+inline auto WindowAt(field::Limbs<4> const& scalar, std::size_t window) -> std::size_t {
+  auto const bit{window * kWindowBits};
+  return static_cast<std::size_t>(scalar[bit / 64] >> (bit % 64)) & (kWindowSize - 1);
+}
+
+// table[window][digit - 1] = digit * 16^window * G, built on first use
+inline auto GeneratorTable() -> std::vector<AffinePoint> const& {
+  static auto const table{[] {
+    constexpr field::Limbs<4> kGeneratorX{0x59f2'815b'16f8'1798, 0x029b'fcdb'2dce'28d9, 0x55a0'6295'ce87'0b07, 0x79be'667e'f9dc'bbac};
+    constexpr field::Limbs<4> kGeneratorY{0x9c47'd08f'fb10'd4b8, 0xfd17'b448'a685'5419, 0x5da4'fbfc'0e11'08a8, 0x483a'da77'26a3'c465};
+
+    std::vector<JacobianPoint> multiples{};
+    multiples.reserve(kWindowCount * (kWindowSize - 1));
+    auto base{JacobianPoint::FromAffine({*Fp::FromLimbs(kGeneratorX), *Fp::FromLimbs(kGeneratorY)})};
+    for (std::size_t window{0}; window < kWindowCount; ++window) {
+      auto multiple{base};
+      for (std::size_t digit{1}; digit < kWindowSize; ++digit) {
+        multiples.push_back(multiple);
+        multiple = Add(multiple, base);
+      }
+      // 16 * base
+      base = multiple;
+    }
+    std::vector<AffinePoint> affine_multiples(multiples.size());
+    ToAffine(multiples, affine_multiples);
+    return affine_multiples;
+  }()};
+  return table;
+}
+
+}  // namespace detail
+
+inline auto MultiplyGenerator(field::Limbs<4> const& scalar) -> JacobianPoint {
+  auto const& table{detail::GeneratorTable()};
+  JacobianPoint result{};
+  for (std::size_t window{0}; window < detail::kWindowCount; ++window) {
+    if (auto const digit{detail::WindowAt(scalar, window)}; digit != 0) {
+      result = Add(result, table[window * (detail::kWindowSize - 1) + digit - 1]);
+    }
+  }
+  return result;
+}
+
+// digit * point for every nonzero 4-bit digit, the table Multiply() adds from
+inline auto AppendWindowMultiples(AffinePoint const& point, std::vector<JacobianPoint>& multiples) -> void {
+  auto multiple{JacobianPoint::FromAffine(point)};
+  for (std::size_t digit{1}; digit < detail::kWindowSize; ++digit) {
+    multiples.push_back(multiple);
+    multiple = Add(multiple, point);
+  }
+}
+
+namespace detail {
+
+// lambda * (x, y) = (beta * x, y): the endomorphism that lets a multiplication split its scalar in two halves
+constexpr auto kLambda{*Fn::FromLimbs({0xdf02'967c'1b23'bd72, 0x122e'22ea'2081'6678, 0xa526'1c02'8812'645a, 0x5363'ad4c'c05c'30e0})};
+constexpr auto kBeta{*Fp::FromLimbs({0xc139'6c28'7195'01ee, 0x9cf0'4975'12f5'8995, 0x6e64'479e'ac34'34e9, 0x7ae9'6a2b'657c'0710})};
+
+struct HalfScalar {
+  // below 2^128
+  field::Limbs<4> magnitude{};
+  bool is_negative{false};
+};
+
+// scalar = first + second * lambda (mod n) with both halves below 2^128 in magnitude (the GLV decomposition, with the
+// short lattice basis (a1, b1), (a2, b2) and g = round(2^384 * b / n) to divide by n without dividing)
+inline auto Split(Fn const& scalar) -> std::array<HalfScalar, 2> {
+  constexpr field::Limbs<4> kG1{0xe893'209a'45db'b031, 0x3daa'8a14'71e8'ca7f, 0xe86c'90e4'9284'eb15, 0x3086'd221'a7d4'6bcd};
+  constexpr field::Limbs<4> kG2{0x1571'b4ae'8ac4'7f71, 0x2212'08ac'9df5'06c6, 0x6f54'7fa9'0abf'e4c4, 0xe443'7ed6'010e'8828};
+  constexpr auto kA1{*Fn::FromLimbs({0xe86c'90e4'9284'eb15, 0x3086'd221'a7d4'6bcd, 0, 0})};
+  constexpr auto kMinusB1{*Fn::FromLimbs({0x6f54'7fa9'0abf'e4c3, 0xe443'7ed6'010e'8828, 0, 0})};
+  // b2 = a1
+
+  // round(scalar * g / 2^384)
+  auto const scaled{[limbs = scalar.ToLimbs()](field::Limbs<4> const& g) {
+    std::array<std::uint64_t, 8> product{};
+    for (std::size_t limb{0}; limb < 4; ++limb) {
+      std::uint64_t carry{0};
+      for (std::size_t index{0}; index < 4; ++index) {
+        auto const partial{field::uint128_t{limbs[index]} * g[limb] + product[limb + index] + carry};
+        product[limb + index] = static_cast<std::uint64_t>(partial);
+        carry = static_cast<std::uint64_t>(partial >> 64);
+      }
+      product[limb + 4] = carry;
+    }
+    auto const round_up{product[5] >> 63};
+    auto const low{field::uint128_t{product[6]} + round_up};
+    return *Fn::FromLimbs({static_cast<std::uint64_t>(low), product[7] + static_cast<std::uint64_t>(low >> 64), 0, 0});
+  }};
+  auto const c1{scaled(kG1)};
+  auto const c2{scaled(kG2)};
+  auto const second{c1 * kMinusB1 - c2 * kA1};
+  auto const first{scalar - second * kLambda};
+
+  // a half above n / 2 is a negative one
+  auto const to_half{[](Fn const& half) {
+    auto const limbs{half.ToLimbs()};
+    if (ToWord(limbs) > kHalfOrder) {
+      return HalfScalar{(-half).ToLimbs(), true};
+    }
+    return HalfScalar{limbs, false};
+  }};
+  return {to_half(first), to_half(second)};
+}
+
+}  // namespace detail
+
+// scalar * point, given the point's window multiples in affine coordinates: 128 doublings for the two halves of the
+// split scalar, the second half's multiples being lambda times the first's
+inline auto Multiply(std::span<AffinePoint const> multiples, Fn const& scalar) -> JacobianPoint {
+  auto const [first, second]{detail::Split(scalar)};
+  JacobianPoint result{};
+  for (auto window{detail::kWindowCount / 2}; window-- != 0;) {
+    for (std::size_t bit{0}; bit < detail::kWindowBits; ++bit) {
+      result = Double(result);
+    }
+    if (auto const digit{detail::WindowAt(first.magnitude, window)}; digit != 0) {
+      auto const& multiple{multiples[digit - 1]};
+      result = Add(result, AffinePoint{multiple.x, first.is_negative ? -multiple.y : multiple.y});
+    }
+    if (auto const digit{detail::WindowAt(second.magnitude, window)}; digit != 0) {
+      auto const& multiple{multiples[digit - 1]};
+      result = Add(result, AffinePoint{multiple.x * detail::kBeta, second.is_negative ? -multiple.y : multiple.y});
+    }
+  }
+  return result;
+}
+
+// The address of a public key: the last 20 bytes of the Keccak-256 hash of x and y.
+inline auto ToAddress(AffinePoint const& public_key) -> word_t {
+  std::array<std::byte, 2 * kWordSize> coordinates{};
+  StoreWord(reinterpret_cast<std::uint8_t*>(coordinates.data()), ToWord(public_key.x.ToLimbs()));
+  StoreWord(reinterpret_cast<std::uint8_t*>(coordinates.data() + kWordSize), ToWord(public_key.y.ToLimbs()));
+  auto const address_mask{(word_t{1} << 160) - 1};
+  return evmint::ToWord(Keccak256(coordinates)) & address_mask;
+}
+
+struct RecoveryInput {
+  // the signed message's hash
+  Hash hash{};
+  word_t r{0};
+  word_t s{0};
+  // of R's y coordinate: 0 or 1
+  std::uint8_t y_parity{0};
+};
+
+// Recovers the signers' addresses of `inputs` into `addresses`, nullopt for signatures that do not recover (r or s
+// out of range, r not on the curve, or the key at infinity). The batch shares its field inversions: of the r values,
+// of the window multiples of the R points (so every addition is a mixed one) and of the keys' z coordinates.
+inline auto RecoverBatch(std::span<RecoveryInput const> inputs, std::span<std::optional<word_t>> addresses) -> void {
+  constexpr auto kMultipleCount{detail::kWindowSize - 1};
+
+  thread_local std::vector<Fn> r_inverses{};
+  thread_local std::vector<JacobianPoint> multiples{};
+  thread_local std::vector<AffinePoint> affine_multiples{};
+  thread_local std::vector<JacobianPoint> public_keys{};
+  thread_local std::vector<AffinePoint> affine_keys{};
+  r_inverses.assign(inputs.size(), Fn{});
+  multiples.clear();
+  public_keys.assign(inputs.size(), JacobianPoint{});
+  affine_keys.resize(inputs.size());
+
+  for (std::size_t index{0}; index < inputs.size(); ++index) {
+    auto const& input{inputs[index]};
+    auto const r{Fn::FromLimbs(ToLimbs(input.r))};
+    if (not r or r->IsZero() or input.s == 0 or not Fn::FromLimbs(ToLimbs(input.s)) or input.y_parity > 1) {
+      continue;
+    }
+    // R: the point with x = r (r >= p - n, which needs x = r + n, is as good as never signed and rejected here)
+    auto const x{Fp::FromLimbs(ToLimbs(input.r))};
+    auto y{x ? (x->Square() * *x + *Fp::FromLimbs({7, 0, 0, 0})).Sqrt() : std::nullopt};
+    if (not y) {
+      continue;
+    }
+    if (y->IsOdd() != (input.y_parity == 1)) {
+      *y = -*y;
+    }
+    r_inverses[index] = *r;
+    AppendWindowMultiples({*x, *y}, multiples);
+  }
+  field::InvertAll(std::span{r_inverses});
+  affine_multiples.resize(multiples.size());
+  ToAffine(multiples, affine_multiples);
+
+  std::size_t recovered{0};
+  for (std::size_t index{0}; index < inputs.size(); ++index) {
+    if (r_inverses[index].IsZero()) {
+      continue;
+    }
+    // Q = r^-1 * (s * R - z * G)
+    auto const z{Fn::Reduce(ToLimbs(evmint::ToWord(inputs[index].hash)))};
+    auto const u1{(-z * r_inverses[index]).ToLimbs()};
+    auto const u2{*Fn::FromLimbs(ToLimbs(inputs[index].s)) * r_inverses[index]};
+    auto const r_multiples{std::span{affine_multiples}.subspan(recovered++ * kMultipleCount, kMultipleCount)};
+    public_keys[index] = Add(Multiply(r_multiples, u2), MultiplyGenerator(u1));
+  }
+  ToAffine(public_keys, affine_keys);
+
+  for (std::size_t index{0}; index < inputs.size(); ++index) {
+    addresses[index] = public_keys[index].IsInfinity() ? std::nullopt : std::optional{ToAddress(affine_keys[index])};
+  }
+}
+
+inline auto Recover(RecoveryInput const& input) -> std::optional<word_t> {
+  std::optional<word_t> address{};
+  RecoverBatch(std::span{&input, 1}, std::span{&address, 1});
+  return address;
+}
+
+}  // namespace evmint::secp256k1
@@ -0,0 +1,742 @@
+// SPDX-License-Identifier: MIT
+
+// Resident execution server: a long-running evmint that takes execution requests over a Unix domain socket (any
+// number of clients) or over a pair of stream descriptors such as stdin/stdout, runs them on warm interpreters and
+// streams the results back. Linux only (epoll and eventfd).
+//
+// Protocol. Both directions are frames of a little-endian u32 payload length followed by the payload; integers are
+// little-endian, words (hashes, addresses, slots, values) 32 bytes big-endian. A client may pipeline any number of
+// requests; responses come back as executions finish, not necessarily in request order, tagged with the request id.
+//
+//   request:  u64 request id, u8 flags, word code hash, word address, u64 state version, u64 gas limit,
+//             u32 code size, u32 call data size, code, call data
+//   response: u64 request id, u8 status, u64 gas used, u32 storage write count, that many (word slot, word value)
+//
+// Code is cached by its keccak256. A request with kHasCode carries the code and caches it, later requests may send the
+// hash alone until the code is evicted as the least recently used; code that does not match its hash is refused. The
+// state version names a version of the server's StateStore, kLatestState the newest one. The status is an
+// ExecutionStatus, or kUnknownCode / kCodeHashMismatch / kUnknownState when the request could not be run.
+//
+// After warm-up the server allocates nothing per request: request and response buffers of a bounded pool of job
+// slots and of the connections are reused, and so is each worker's storage write buffer. Only the map the interpreter
+// collects SSTOREs in still allocates, one node per slot written.
+
+#pragma once
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "evm.hpp"
+#include "interpreter.hpp"
+#include "keccak.hpp"
+#include "state_store.hpp"
+
+namespace evmint::server {
+
+static_assert(std::endian::native == std::endian::little, "frames are encoded by copying integers as they are");
+
+constexpr std::uint8_t kHasCode{1};
+constexpr std::uint64_t kLatestState{std::numeric_limits<std::uint64_t>::max()};
+
+// statuses for requests that were not executed, beyond the ExecutionStatus values
+constexpr std::uint8_t kCodeHashMismatch{0xfd};
+constexpr std::uint8_t kUnknownCode{0xfe};
+constexpr std::uint8_t kUnknownState{0xff};
+
+constexpr std::size_t kLengthSize{sizeof(std::uint32_t)};
+constexpr std::size_t kRequestHeaderSize{8 + 1 + kWordSize + kWordSize + 8 + 8 + 4 + 4};
+constexpr std::size_t kResponseHeaderSize{8 + 1 + 8 + 4};
+constexpr std::size_t kStorageWriteSize{2 * kWordSize};
+// a connection sending a longer frame is dropped
+constexpr std::size_t kMaxFrameSize{16 << 20};
+
+struct RequestHeader {
+  std::uint64_t request_id{0};
+  std::uint8_t flags{0};
+  word_t code_hash{0};
+  word_t address{0};
+  std::uint64_t state_version{kLatestState};
+  std::uint64_t gas_limit{kDefaultGasLimit};
+  std::uint32_t code_size{0};
+  std::uint32_t calldata_size{0};
+};
+
+struct ResponseHeader {
+  std::uint64_t request_id{0};
+  std::uint8_t status{0};
+  std::uint64_t gas_used{0};
+  std::uint32_t storage_write_count{0};
+};
+
+template <typename Integer>
+auto AppendInteger(std::vector<std::byte>& buffer, Integer value) -> void {
+  auto const bytes{std::as_bytes(std::span{&value, 1})};
+  buffer.insert(std::end(buffer), std::begin(bytes), std::end(bytes));
+}
+
+inline auto AppendWord(std::vector<std::byte>& buffer, word_t const& word) -> void {
+  buffer.resize(buffer.size() + kWordSize);
+  StoreWord(reinterpret_cast<std::uint8_t*>(buffer.data() + buffer.size() - kWordSize), word);
+}
+
+// Readers consume from the front of `bytes`, which the caller has checked is long enough.
+template <typename Integer>
+auto TakeInteger(std::span<std::byte const>& bytes) -> Integer {
+  Integer value{};
+  std::memcpy(&value, bytes.data(), sizeof(Integer));
+  bytes = bytes.subspan(sizeof(Integer));
+  return value;
+}
+
+inline auto TakeWord(std::span<std::byte const>& bytes) -> word_t {
+  auto const word{LoadWord(reinterpret_cast<std::uint8_t const*>(bytes.data()))};
+  bytes = bytes.subspan(kWordSize);
+  return word;
+}
+
+// Appends a whole request frame; code is only sent with kHasCode.
+inline auto AppendRequest(std::vector<std::byte>& buffer, RequestHeader header, std::span<std::byte const> code, std::span<std::byte const> calldata) -> void {
+  if ((header.flags & kHasCode) == 0) {
+    code = {};
+  }
+  header.code_size = static_cast<std::uint32_t>(code.size());
+  header.calldata_size = static_cast<std::uint32_t>(calldata.size());
+
+  AppendInteger(buffer, static_cast<std::uint32_t>(kRequestHeaderSize + code.size() + calldata.size()));
+  AppendInteger(buffer, header.request_id);
+  AppendInteger(buffer, header.flags);
+  AppendWord(buffer, header.code_hash);
+  AppendWord(buffer, header.address);
+  AppendInteger(buffer, header.state_version);
+  AppendInteger(buffer, header.gas_limit);
+  AppendInteger(buffer, header.code_size);
+  AppendInteger(buffer, header.calldata_size);
+  buffer.insert(std::end(buffer), std::begin(code), std::end(code));
+  buffer.insert(std::end(buffer), std::begin(calldata), std::end(calldata));
+}
+
+// Parses a request payload (the frame without its length); nullopt if it is malformed.
+inline auto ParseRequest(std::span<std::byte const> payload) -> std::optional<std::pair<RequestHeader, std::span<std::byte const>>> {
+  if (payload.size() < kRequestHeaderSize) {
+    return std::nullopt;
+  }
+  RequestHeader header{};
+  header.request_id = TakeInteger<std::uint64_t>(payload);
+  header.flags = TakeInteger<std::uint8_t>(payload);
+  header.code_hash = TakeWord(payload);
+  header.address = TakeWord(payload);
+  header.state_version = TakeInteger<std::uint64_t>(payload);
+  header.gas_limit = TakeInteger<std::uint64_t>(payload);
+  header.code_size = TakeInteger<std::uint32_t>(payload);
+  header.calldata_size = TakeInteger<std::uint32_t>(payload);
+  if (payload.size() != std::size_t{header.code_size} + header.calldata_size) {
+    return std::nullopt;
+  }
+  // code followed by call data
+  return std::pair{header, payload};
+}
+
+inline auto AppendResponse(std::vector<std::byte>& buffer, ResponseHeader const& header, std::span<std::pair<word_t, word_t> const> storage_writes = {}) -> void {
+  AppendInteger(buffer, static_cast<std::uint32_t>(kResponseHeaderSize + storage_writes.size() * kStorageWriteSize));
+  AppendInteger(buffer, header.request_id);
+  AppendInteger(buffer, header.status);
+  AppendInteger(buffer, header.gas_used);
+  AppendInteger(buffer, static_cast<std::uint32_t>(storage_writes.size()));
+  for (auto const& [slot, value] : storage_writes) {
+    AppendWord(buffer, slot);
+    AppendWord(buffer, value);
+  }
+}
+
+// Parses a response payload's header; the storage writes follow it.
+inline auto ParseResponse(std::span<std::byte const> payload) -> std::optional<ResponseHeader> {
+  if (payload.size() < kResponseHeaderSize) {
+    return std::nullopt;
+  }
+  ResponseHeader header{};
+  header.request_id = TakeInteger<std::uint64_t>(payload);
+  header.status = TakeInteger<std::uint8_t>(payload);
+  header.gas_used = TakeInteger<std::uint64_t>(payload);
+  header.storage_write_count = TakeInteger<std::uint32_t>(payload);
+  if (payload.size() != std::size_t{header.storage_write_count} * kStorageWriteSize) {
+    return std::nullopt;
+  }
+  return header;
+}
+
+// Length of the first complete frame in `bytes` including its length prefix, 0 if it has not fully arrived, nullopt if
+// it is too long.
+inline auto CompleteFrameSize(std::span<std::byte const> bytes) -> std::optional<std::size_t> {
+  if (bytes.size() < kLengthSize) {
+    return 0;
+  }
+  auto const payload_size{TakeInteger<std::uint32_t>(bytes)};
+  if (payload_size > kMaxFrameSize) {
+    return std::nullopt;
+  }
+  return bytes.size() < payload_size ? 0 : kLengthSize + payload_size;
+}
+
+// Binds and listens on a Unix domain socket, replacing a stale socket file.
+inline auto ListenOnUnixSocket(std::string const& path) -> int {
+  sockaddr_un address{.sun_family = AF_UNIX, .sun_path = {}};
+  if (path.size() >= sizeof(address.sun_path)) {
+    throw std::runtime_error{std::format("[SERVER]: Socket path '{}' is too long.", path)};
+  }
+  std::ranges::copy(path, address.sun_path);
+
+  auto const socket_fd{socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)};
+  unlink(path.c_str());
+  if (socket_fd < 0 or bind(socket_fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) != 0 or listen(socket_fd, SOMAXCONN) != 0) {
+    auto const error{errno};
+    if (socket_fd >= 0) {
+      close(socket_fd);
+    }
+    throw std::runtime_error{std::format("[SERVER]: Could not listen on '{}': {}.", path, std::strerror(error))};
+  }
+  return socket_fd;
+}
+
+inline auto ConnectToUnixSocket(std::string const& path) -> int {
+  sockaddr_un address{.sun_family = AF_UNIX, .sun_path = {}};
+  std::ranges::copy(path | std::views::take(sizeof(address.sun_path) - 1), address.sun_path);
+  auto const socket_fd{socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)};
+  if (socket_fd < 0 or connect(socket_fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) != 0) {
+    auto const error{errno};
+    if (socket_fd >= 0) {
+      close(socket_fd);
+    }
+    throw std::runtime_error{std::format("[SERVER]: Could not connect to '{}': {}.", path, std::strerror(error))};
+  }
+  return socket_fd;
+}
+
+struct ServerOptions {
+  std::size_t worker_count{std::max(std::thread::hardware_concurrency(), 1u)};
+  // requests accepted but not answered yet, over all connections; beyond it the server stops reading (backpressure)
+  std::size_t max_in_flight{1024};
+  DispatchMode dispatch_mode{DispatchMode::kTiered};
+  // contracts kept in the code cache, the least recently requested one is evicted first
+  std::size_t code_cache_capacity{4096};
+};
+
+// One thread (the one calling Serve*()) runs the epoll loop: it reads and parses frames, answers what needs no
+// execution and hands the rest to the workers as job slots. Workers execute on their own warm Interpreter, encode the
+// response into the slot and pass it back through a completion queue and an eventfd. While every slot is taken the
+// loop stops watching the connections that have complete requests waiting, so clients see backpressure.
+class ExecutionServer final {
+ public:
+  // `store` may be null, then requests run without state; otherwise it must outlive the server.
+  explicit ExecutionServer(ServerOptions options = {}, StateStore* store = nullptr)
+      : m_options{options}, m_store{store}, m_jobs(std::max<std::size_t>(options.max_in_flight, 1)), m_work_queue(m_jobs.size()), m_completion_queue(m_jobs.size()) {
+    m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    m_stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    m_completion_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_epoll_fd < 0 or m_stop_fd < 0 or m_completion_fd < 0) {
+      throw std::runtime_error{std::format("[SERVER]: Could not set up the event loop: {}.", std::strerror(errno))};
+    }
+    Watch(EPOLL_CTL_ADD, m_stop_fd, kStopToken, EPOLLIN);
+    Watch(EPOLL_CTL_ADD, m_completion_fd, kCompletionToken, EPOLLIN);
+
+    for (std::size_t job_index{0}; job_index < m_jobs.size(); ++job_index) {
+      m_free_jobs.push_back(job_index);
+    }
+    for (std::size_t worker_index{0}; worker_index < std::max<std::size_t>(options.worker_count, 1); ++worker_index) {
+      m_workers.emplace_back([this](std::stop_token stop_token) { RunWorker(stop_token); });
+    }
+  }
+  ExecutionServer(ExecutionServer const&) = delete;
+  auto operator=(ExecutionServer const&) -> ExecutionServer& = delete;
+  ~ExecutionServer() {
+    for (auto& worker : m_workers) {
+      worker.request_stop();
+    }
+    m_workers.clear();
+    for (auto const& [id, connection] : m_connections) {
+      CloseConnection(*connection);
+    }
+    close(m_completion_fd);
+    close(m_stop_fd);
+    close(m_epoll_fd);
+  }
+
+  // Serves clients connecting to the Unix socket at `path` until Stop().
+  auto ServeUnixSocket(std::string const& path) -> void {
+    auto const listen_fd{ListenOnUnixSocket(path)};
+    Watch(EPOLL_CTL_ADD, listen_fd, kListenToken, EPOLLIN);
+    RunEventLoop(listen_fd);
+    epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, listen_fd, nullptr);
+    close(listen_fd);
+    unlink(path.c_str());
+  }
+
+  // Serves the requests read from `input` (a pipe, socket or terminal; not a regular file) on `output` until `input`
+  // ends and every response is written, or Stop(). Both descriptors are left open.
+  auto ServeStream(int input, int output) -> void {
+    AddConnection(input, output, false).owns_descriptors = false;
+    RunEventLoop(-1);
+  }
+
+  // Makes Serve*() return once the requests in flight are answered. May be called from any thread.
+  auto Stop() -> void {
+    std::uint64_t const one{1};
+    [[maybe_unused]] auto const written{write(m_stop_fd, &one, sizeof(one))};
+  }
+
+ private:
+  static constexpr std::uint64_t kStopToken{0};
+  static constexpr std::uint64_t kCompletionToken{1};
+  static constexpr std::uint64_t kListenToken{2};
+  // connection tokens are (id << 1) | is_output, so ids start above the fixed tokens
+  static constexpr std::uint64_t kFirstConnectionId{2};
+  static constexpr std::size_t kReadChunkSize{64 * 1024};
+
+  struct Connection {
+    std::uint64_t id{0};
+    int input{-1};
+    int output{-1};
+    bool is_socket{true};
+    bool owns_descriptors{true};
+    bool input_closed{false};
+    // complete requests are waiting for a free job slot, input is not watched meanwhile
+    bool parked{false};
+    bool output_watched{false};
+    bool failed{false};
+    std::size_t in_flight{0};
+    std::vector<std::byte> input_buffer{};
+    std::size_t input_begin{0};
+    std::size_t input_end{0};
+    std::vector<std::byte> output_buffer{};
+    std::size_t output_begin{0};
+  };
+
+  struct Job {
+    std::uint64_t connection_id{0};
+    RequestHeader header{};
+    // shared with the code cache, so evicting the code does not pull it from under a running job
+    std::shared_ptr<std::vector<std::byte> const> code{};
+    std::vector<std::byte> calldata{};
+    std::vector<std::byte> response{};
+  };
+
+  struct CachedCode {
+    std::shared_ptr<std::vector<std::byte> const> code{};
+    // position in m_code_order
+    std::list<word_t>::iterator order{};
+  };
+
+  // Fixed-capacity FIFO of job indices; it never holds more than all jobs, so it never grows.
+  class JobQueue {
+   public:
+    explicit JobQueue(std::size_t capacity) : m_slots(capacity) {}
+
+    auto Push(std::size_t job_index) -> void {
+      m_slots[(m_begin + m_size) % m_slots.size()] = job_index;
+      m_size++;
+    }
+    auto Pop() -> std::size_t {
+      auto const job_index{m_slots[m_begin]};
+      m_begin = (m_begin + 1) % m_slots.size();
+      m_size--;
+      return job_index;
+    }
+    auto Empty() const -> bool { return m_size == 0; }
+
+   private:
+    std::vector<std::size_t> m_slots;
+    std::size_t m_begin{0};
+    std::size_t m_size{0};
+  };
+
+  ServerOptions m_options;
+  StateStore* m_store;
+  int m_epoll_fd{-1};
+  int m_stop_fd{-1};
+  int m_completion_fd{-1};
+
+  // only touched by the event loop thread
+  bool m_stopping{false};
+  std::unordered_map<std::uint64_t, std::unique_ptr<Connection>> m_connections{};
+  std::uint64_t m_next_connection_id{kFirstConnectionId};
+  std::unordered_map<word_t, CachedCode, WordHash> m_code_cache{};
+  // hashes of m_code_cache, most recently requested first
+  std::list<word_t> m_code_order{};
+  std::vector<std::size_t> m_free_jobs{};
+
+  std::vector<Job> m_jobs;
+  std::mutex m_work_mutex{};
+  std::condition_variable_any m_work_available{};
+  JobQueue m_work_queue;
+  std::mutex m_completion_mutex{};
+  JobQueue m_completion_queue;
+  // declared last: workers stop (and join) before the queues they use are destroyed
+  std::vector<std::jthread> m_workers{};
+
+  auto Watch(int operation, int fd, std::uint64_t token, std::uint32_t events) -> void {
+    epoll_event event{.events = events, .data = {.u64 = token}};
+    if (epoll_ctl(m_epoll_fd, operation, fd, &event) != 0) {
+      throw std::runtime_error{std::format("[SERVER]: Could not watch descriptor {}: {}.", fd, std::strerror(errno))};
+    }
+  }
+
+  // Watches the input unless parked and the output while responses are stuck in its buffer.
+  auto UpdateWatch(Connection& connection, bool parked, bool output_watched) -> void {
+    if (parked == connection.parked and output_watched == connection.output_watched) {
+      return;
+    }
+    auto const input_events{parked ? 0u : EPOLLIN | EPOLLRDHUP};
+    if (connection.output == connection.input) {
+      Watch(EPOLL_CTL_MOD, connection.input, connection.id << 1, input_events | (output_watched ? EPOLLOUT : 0u));
+    } else {
+      if (parked != connection.parked) {
+        Watch(EPOLL_CTL_MOD, connection.input, connection.id << 1, input_events);
+      }
+      if (output_watched != connection.output_watched) {
+        Watch(output_watched ? EPOLL_CTL_ADD : EPOLL_CTL_DEL, connection.output, (connection.id << 1) | 1, EPOLLOUT);
+      }
+    }
+    connection.parked = parked;
+    connection.output_watched = output_watched;
+  }
+
+  auto AddConnection(int input, int output, bool is_socket) -> Connection& {
+    auto connection{std::make_unique<Connection>(Connection{.id = m_next_connection_id++, .input = input, .output = output, .is_socket = is_socket})};
+    connection->input_buffer.resize(kReadChunkSize);
+    fcntl(input, F_SETFL, fcntl(input, F_GETFL) | O_NONBLOCK);
+    fcntl(output, F_SETFL, fcntl(output, F_GETFL) | O_NONBLOCK);
+    Watch(EPOLL_CTL_ADD, input, connection->id << 1, EPOLLIN | EPOLLRDHUP);
+    auto& added{*connection};
+    m_connections.emplace(added.id, std::move(connection));
+    return added;
+  }
+
+  auto CloseConnection(Connection& connection) -> void {
+    epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, connection.input, nullptr);
+    if (connection.output_watched and connection.output != connection.input) {
+      epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, connection.output, nullptr);
+    }
+    if (connection.owns_descriptors) {
+      close(connection.input);
+      if (connection.output != connection.input) {
+        close(connection.output);
+      }
+    }
+  }
+
+  // Socket servers run until Stop(), stream servers also until their one connection is done; both finish the jobs in
+  // flight first.
+  auto RunEventLoop(int listen_fd) -> void {
+    m_stopping = false;
+    std::array<epoll_event, 64> events{};
+    while (m_free_jobs.size() != m_jobs.size() or not(m_stopping or (listen_fd < 0 and m_connections.empty()))) {
+      auto const event_count{epoll_wait(m_epoll_fd, events.data(), static_cast<int>(events.size()), -1)};
+      if (event_count < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        throw std::runtime_error{std::format("[SERVER]: epoll_wait failed: {}.", std::strerror(errno))};
+      }
+
+      for (auto const& event : std::span{events}.first(static_cast<std::size_t>(event_count))) {
+        switch (event.data.u64) {
+          case kStopToken:
+            ConsumeEvent(m_stop_fd);
+            m_stopping = true;
+            break;
+          case kCompletionToken:
+            ConsumeEvent(m_completion_fd);
+            DrainCompletions();
+            break;
+          case kListenToken:
+            AcceptConnections(listen_fd);
+            break;
+          default:
+            auto const connection{m_connections.find(event.data.u64 >> 1)};
+            if (connection == std::end(m_connections)) {
+              break;
+            }
+            if ((event.events & EPOLLOUT) != 0 or (event.data.u64 & 1) != 0) {
+              Flush(*connection->second);
+            }
+            if ((event.data.u64 & 1) == 0 and (event.events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) != 0) {
+              ReadFrom(*connection->second);
+            }
+        }
+      }
+
+      ResumeParkedConnections();
+      CloseFinishedConnections();
+    }
+  }
+
+  auto ConsumeEvent(int event_fd) -> void {
+    std::uint64_t count{0};
+    [[maybe_unused]] auto const bytes_read{read(event_fd, &count, sizeof(count))};
+  }
+
+  auto AcceptConnections(int listen_fd) -> void {
+    for (auto fd{accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)}; fd >= 0; fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) {
+      AddConnection(fd, fd, true);
+    }
+  }
+
+  auto ReadFrom(Connection& connection) -> void {
+    while (not connection.input_closed and not connection.failed and not connection.parked) {
+      if (connection.input_end == connection.input_buffer.size()) {
+        // compact, and grow only when one frame does not fit
+        std::copy(std::next(std::begin(connection.input_buffer), static_cast<std::ptrdiff_t>(connection.input_begin)),
+                  std::next(std::begin(connection.input_buffer), static_cast<std::ptrdiff_t>(connection.input_end)), std::begin(connection.input_buffer));
+        connection.input_end -= connection.input_begin;
+        connection.input_begin = 0;
+        if (connection.input_end == connection.input_buffer.size()) {
+          connection.input_buffer.resize(connection.input_buffer.size() * 2);
+        }
+      }
+
+      auto const bytes_read{read(connection.input, connection.input_buffer.data() + connection.input_end, connection.input_buffer.size() - connection.input_end)};
+      if (bytes_read > 0) {
+        connection.input_end += static_cast<std::size_t>(bytes_read);
+        ParseRequests(connection);
+      } else if (bytes_read == 0) {
+        connection.input_closed = true;
+      } else if (errno == EAGAIN or errno == EWOULDBLOCK) {
+        return;
+      } else if (errno != EINTR) {
+        connection.failed = true;
+      }
+    }
+  }
+
+  // Starts the complete requests in the input buffer, parking the connection when the job slots run out.
+  auto ParseRequests(Connection& connection) -> void {
+    while (not connection.failed and not m_stopping) {
+      auto const pending{std::span<std::byte const>{connection.input_buffer}.subspan(connection.input_begin, connection.input_end - connection.input_begin)};
+      auto const frame_size{CompleteFrameSize(pending)};
+      if (not frame_size) {
+        connection.failed = true;
+        return;
+      }
+      if (*frame_size == 0) {
+        return;
+      }
+      if (m_free_jobs.empty()) {
+        UpdateWatch(connection, true, connection.output_watched);
+        return;
+      }
+
+      auto const request{ParseRequest(pending.subspan(kLengthSize, *frame_size - kLengthSize))};
+      if (not request) {
+        connection.failed = true;
+        return;
+      }
+      Dispatch(connection, request->first, request->second);
+      connection.input_begin += *frame_size;
+    }
+  }
+
+  auto ResumeParkedConnections() -> void {
+    for (auto const& [id, connection] : m_connections) {
+      if (m_free_jobs.empty()) {
+        return;
+      }
+      if (connection->parked) {
+        UpdateWatch(*connection, false, connection->output_watched);
+        ParseRequests(*connection);
+        ReadFrom(*connection);
+      }
+    }
+  }
+
+  auto Dispatch(Connection& connection, RequestHeader const& header, std::span<std::byte const> code_and_calldata) -> void {
+    auto const code{code_and_calldata.first(header.code_size)};
+    auto const calldata{code_and_calldata.subspan(header.code_size)};
+
+    auto cached_code{FindCode(header, code)};
+    if (cached_code == nullptr) {
+      // either no code is cached for the hash, or the code sent along does not match it
+      auto const status{(header.flags & kHasCode) != 0 ? kCodeHashMismatch : kUnknownCode};
+      AppendResponse(connection.output_buffer, {.request_id = header.request_id, .status = status});
+      Flush(connection);
+      return;
+    }
+
+    auto const job_index{m_free_jobs.back()};
+    m_free_jobs.pop_back();
+    auto& job{m_jobs[job_index]};
+    job.connection_id = connection.id;
+    job.header = header;
+    job.code = std::move(cached_code);
+    job.calldata.assign(std::begin(calldata), std::end(calldata));
+    connection.in_flight++;
+
+    {
+      std::scoped_lock const lock{m_work_mutex};
+      m_work_queue.Push(job_index);
+    }
+    m_work_available.notify_one();
+  }
+
+  // The cached code for the request, caching the code it carries once it matches the hash; null if there is none or the
+  // code does not match.
+  auto FindCode(RequestHeader const& header, std::span<std::byte const> code) -> std::shared_ptr<std::vector<std::byte> const> {
+    auto const has_code{(header.flags & kHasCode) != 0};
+    if (auto const cached_code{m_code_cache.find(header.code_hash)}; cached_code != std::end(m_code_cache)) {
+      if (has_code and not std::ranges::equal(*cached_code->second.code, code)) {
+        return nullptr;
+      }
+      m_code_order.splice(std::begin(m_code_order), m_code_order, cached_code->second.order);
+      return cached_code->second.code;
+    }
+    if (not has_code) {
+      return nullptr;
+    }
+    if (ToWord(Keccak256(code)) != header.code_hash) {
+      return nullptr;
+    }
+
+    if (m_code_cache.size() >= std::max<std::size_t>(m_options.code_cache_capacity, 1)) {
+      m_code_cache.erase(m_code_order.back());
+      m_code_order.pop_back();
+    }
+    m_code_order.push_front(header.code_hash);
+    auto cached_code{std::make_shared<std::vector<std::byte> const>(std::begin(code), std::end(code))};
+    m_code_cache.emplace(header.code_hash, CachedCode{.code = cached_code, .order = std::begin(m_code_order)});
+    return cached_code;
+  }
+
+  auto DrainCompletions() -> void {
+    std::scoped_lock const lock{m_completion_mutex};
+    while (not m_completion_queue.Empty()) {
+      auto const job_index{m_completion_queue.Pop()};
+      auto& job{m_jobs[job_index]};
+      // the connection may have gone away while the job ran
+      if (auto const connection{m_connections.find(job.connection_id)}; connection != std::end(m_connections)) {
+        connection->second->in_flight--;
+        connection->second->output_buffer.insert(std::end(connection->second->output_buffer), std::begin(job.response), std::end(job.response));
+        Flush(*connection->second);
+      }
+      job.code.reset();
+      m_free_jobs.push_back(job_index);
+    }
+  }
+
+  auto Flush(Connection& connection) -> void {
+    while (not connection.failed and connection.output_begin < connection.output_buffer.size()) {
+      auto const* data{connection.output_buffer.data() + connection.output_begin};
+      auto const size{connection.output_buffer.size() - connection.output_begin};
+      auto const bytes_written{connection.is_socket ? send(connection.output, data, size, MSG_NOSIGNAL) : write(connection.output, data, size)};
+      if (bytes_written >= 0) {
+        connection.output_begin += static_cast<std::size_t>(bytes_written);
+      } else if (errno == EAGAIN or errno == EWOULDBLOCK) {
+        UpdateWatch(connection, connection.parked, true);
+        return;
+      } else if (errno != EINTR) {
+        connection.failed = true;
+      }
+    }
+    connection.output_buffer.clear();
+    connection.output_begin = 0;
+    UpdateWatch(connection, connection.parked, false);
+  }
+
+  auto CloseFinishedConnections() -> void {
+    std::erase_if(m_connections, [this](auto const& entry) {
+      auto& connection{*entry.second};
+      auto const finished{connection.failed or (connection.input_closed and not connection.parked and connection.in_flight == 0 and connection.output_buffer.empty())};
+      if (finished) {
+        CloseConnection(connection);
+      }
+      return finished;
+    });
+  }
+
+  auto RunWorker(std::stop_token stop_token) -> void {
+    Interpreter interpreter{kExecutorOptions};
+    StorageWriteBuffer storage_writes{};
+    // kept while requests keep asking for its version, so consecutive requests do not pin a new view each
+    std::unique_ptr<StateStore::View> view{};
+
+    while (true) {
+      std::size_t job_index{0};
+      {
+        std::unique_lock lock{m_work_mutex};
+        if (not m_work_available.wait(lock, stop_token, [this] { return not m_work_queue.Empty(); })) {
+          return;
+        }
+        job_index = m_work_queue.Pop();
+      }
+
+      auto& job{m_jobs[job_index]};
+      job.response.clear();
+      if (auto const* state{ViewFor(job.header.state_version, view)}; state != nullptr or m_store == nullptr) {
+        auto const result{interpreter.Execute({.code = *job.code,
+                                               .calldata = job.calldata,
+                                               .state = state,
+                                               .address = job.header.address,
+                                               .gas_limit = job.header.gas_limit,
+                                               .dispatch_mode = m_options.dispatch_mode,
+                                               .storage_writes = &storage_writes})};
+        AppendResponse(job.response, {.request_id = job.header.request_id, .status = static_cast<std::uint8_t>(result.status), .gas_used = result.gas_used},
+                       storage_writes);
+      } else {
+        AppendResponse(job.response, {.request_id = job.header.request_id, .status = kUnknownState});
+      }
+
+      {
+        std::scoped_lock const lock{m_completion_mutex};
+        m_completion_queue.Push(job_index);
+      }
+      std::uint64_t const one{1};
+      [[maybe_unused]] auto const written{write(m_completion_fd, &one, sizeof(one))};
+    }
+  }
+
+  // The store's view at `version`, reusing `view` if it already is; null without a store or if the version is gone.
+  auto ViewFor(std::uint64_t version, std::unique_ptr<StateStore::View>& view) -> StateView const* {
+    if (m_store == nullptr) {
+      return nullptr;
+    }
+    if (version == kLatestState) {
+      version = m_store->LatestVersion();
+    }
+    if (view == nullptr or view->Version() != version) {
+      view.reset();
+      try {
+        view = m_store->SnapshotAt(version);
+      } catch (std::runtime_error const&) {
+        return nullptr;
+      }
+    }
+    return view.get();
+  }
+};
+
+}  // namespace evmint::server
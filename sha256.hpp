@@ -0,0 +1,154 @@
+// SPDX-License-Identifier: MIT
+
+// SHA-256, for the SHA256 precompile. Whole blocks are compressed straight from the input; only the padded tail is
+// copied. On x86-64 hosts with the SHA extensions (SHA-NI) the compression runs on those, chosen once at startup;
+// everywhere else on the portable rounds.
+
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "evm.hpp"
+#include "keccak.hpp"
+
+namespace evmint {
+
+namespace sha256 {
+
+constexpr std::size_t kBlockSize{64};
+
+using State = std::array<std::uint32_t, 8>;
+
+constexpr State kInitialState{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+alignas(16) constexpr std::array<std::uint32_t, 64> kRoundConstants{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74,
+    0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152, 0xa831c66d,
+    0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e,
+    0x92722c85, 0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+inline auto CompressPortable(State& state, std::byte const* blocks, std::size_t block_count) -> void {
+  for (; block_count != 0; --block_count, blocks += kBlockSize) {
+    // the message schedule, 16 words at a time
+    std::array<std::uint32_t, 16> schedule{};
+    for (std::size_t word{0}; word < schedule.size(); ++word) {
+      std::uint32_t big_endian{0};
+      std::memcpy(&big_endian, blocks + 4 * word, sizeof(big_endian));
+      schedule[word] = std::byteswap(big_endian);
+    }
+    auto [a, b, c, d, e, f, g, h]{state};
+    Unrolled<64>([&](auto round) {
+      if constexpr (round >= 16) {
+        auto const w15{schedule[(round + 1) % 16]};
+        auto const w2{schedule[(round + 14) % 16]};
+        auto const sigma0{std::rotr(w15, 7) ^ std::rotr(w15, 18) ^ (w15 >> 3)};
+        auto const sigma1{std::rotr(w2, 17) ^ std::rotr(w2, 19) ^ (w2 >> 10)};
+        schedule[round % 16] += sigma0 + schedule[(round + 9) % 16] + sigma1;
+      }
+      auto const t1{h + (std::rotr(e, 6) ^ std::rotr(e, 11) ^ std::rotr(e, 25)) + ((e & f) ^ (~e & g)) + kRoundConstants[round] + schedule[round % 16]};
+      auto const t2{(std::rotr(a, 2) ^ std::rotr(a, 13) ^ std::rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c))};
+      h = g;
+      g = f;
+      f = e;
+      e = d + t1;
+      d = c;
+      c = b;
+      b = a;
+      a = t1 + t2;
+    });
+    std::array const working{a, b, c, d, e, f, g, h};
+    for (std::size_t word{0}; word < state.size(); ++word) {
+      state[word] += working[word];
+    }
+  }
+}
+
+#if defined(__x86_64__)
+// Four rounds per pair of SHA256RNDS2, the state split in ABEF and CDGH halves as the instructions want it, and the
+// message schedule four words at a time with SHA256MSG1/SHA256MSG2.
+__attribute__((target("sha,sse4.1"))) inline auto CompressShaNi(State& state, std::byte const* blocks, std::size_t block_count) -> void {
+  auto const byte_order{_mm_set_epi64x(0x0c0d'0e0f'0809'0a0b, 0x0405'0607'0001'0203)};
+
+  auto const dcba{_mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(state.data())), 0xb1)};
+  auto const efgh{_mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(state.data() + 4)), 0x1b)};
+  auto abef{_mm_alignr_epi8(dcba, efgh, 8)};
+  auto cdgh{_mm_blend_epi16(efgh, dcba, 0xf0)};
+
+  for (; block_count != 0; --block_count, blocks += kBlockSize) {
+    auto const abef_before{abef};
+    auto const cdgh_before{cdgh};
+    // not a std::array, which would drop __m128i's alignment attribute
+    __m128i schedule[4]{};
+    // a loop rather than Unrolled(): lambdas do not inherit the target attribute the intrinsics need
+#pragma GCC unroll 16
+    for (std::size_t quarter{0}; quarter < 16; ++quarter) {
+      if (quarter < 4) {
+        schedule[quarter] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(blocks + 16 * quarter)), byte_order);
+      } else {
+        auto const partial{_mm_add_epi32(_mm_sha256msg1_epu32(schedule[quarter % 4], schedule[(quarter + 1) % 4]),
+                                         _mm_alignr_epi8(schedule[(quarter + 3) % 4], schedule[(quarter + 2) % 4], 4))};
+        schedule[quarter % 4] = _mm_sha256msg2_epu32(partial, schedule[(quarter + 3) % 4]);
+      }
+      auto const message{_mm_add_epi32(schedule[quarter % 4], _mm_load_si128(reinterpret_cast<__m128i const*>(kRoundConstants.data() + 4 * quarter)))};
+      cdgh = _mm_sha256rnds2_epu32(cdgh, abef, message);
+      abef = _mm_sha256rnds2_epu32(abef, cdgh, _mm_shuffle_epi32(message, 0x0e));
+    }
+    abef = _mm_add_epi32(abef, abef_before);
+    cdgh = _mm_add_epi32(cdgh, cdgh_before);
+  }
+
+  auto const feba{_mm_shuffle_epi32(abef, 0x1b)};
+  auto const dchg{_mm_shuffle_epi32(cdgh, 0xb1)};
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state.data()), _mm_blend_epi16(feba, dchg, 0xf0));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state.data() + 4), _mm_alignr_epi8(dchg, feba, 8));
+}
+#endif
+
+using CompressFunction = auto (*)(State&, std::byte const*, std::size_t) -> void;
+
+inline CompressFunction const kCompress{[]() -> CompressFunction {
+#if defined(__x86_64__)
+  if (__builtin_cpu_supports("sha") and __builtin_cpu_supports("sse4.1")) {
+    return &CompressShaNi;
+  }
+#endif
+  return &CompressPortable;
+}()};
+
+}  // namespace sha256
+
+// `compress` picks the implementation, the fastest the host has by default.
+inline auto Sha256(std::span<std::byte const> data, sha256::CompressFunction compress = sha256::kCompress) -> Hash {
+  auto state{sha256::kInitialState};
+  auto const block_count{data.size() / sha256::kBlockSize};
+  compress(state, data.data(), block_count);
+
+  // the tail, a 1 bit, zeros and the length in bits: one block, or two if the length does not fit behind the tail
+  auto const tail{data.subspan(block_count * sha256::kBlockSize)};
+  std::array<std::byte, 2 * sha256::kBlockSize> last_blocks{};
+  std::memcpy(last_blocks.data(), tail.data(), tail.size());
+  last_blocks[tail.size()] = std::byte{0x80};
+  auto const last_block_count{tail.size() + 1 + sizeof(std::uint64_t) > sha256::kBlockSize ? 2 : 1};
+  auto const bit_count{std::byteswap(static_cast<std::uint64_t>(data.size()) * kByteSize)};
+  std::memcpy(last_blocks.data() + last_block_count * sha256::kBlockSize - sizeof(bit_count), &bit_count, sizeof(bit_count));
+  compress(state, last_blocks.data(), last_block_count);
+
+  Hash hash{};
+  for (std::size_t word{0}; word < state.size(); ++word) {
+    auto const big_endian{std::byteswap(state[word])};
+    std::memcpy(hash.data() + 4 * word, &big_endian, sizeof(big_endian));
+  }
+  return hash;
+}
+
+}  // namespace evmint
@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: MIT
+
+// evmint-snapshot: writes a flat state snapshot (flat_state.hpp) that executors map instead of parsing the state.
+//
+//   evmint-snapshot <output> <state.json>...
+//   evmint-snapshot --info <snapshot>
+//
+// A state file is an account map (address -> {balance, code, storage}), a genesis file with such a map under `alloc`,
+// or a state test fixture, whose tests' `pre` states are all taken. Accounts in later files replace those in earlier
+// ones. --info checks a snapshot by mapping it and prints what it holds.
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <print>
+#include <ranges>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "flat_state.hpp"
+#include "json.hpp"
+#include "state.hpp"
+
+using namespace evmint;
+
+namespace {
+
+auto ReadFile(std::filesystem::path const& path) -> std::string {
+  std::ifstream file{path, std::ios::binary};
+  if (not file.is_open()) {
+    throw std::runtime_error{std::format("[SNAPSHOT]: Could not open '{}'.", path.string())};
+  }
+  std::ostringstream text{};
+  text << file.rdbuf();
+  return std::move(text).str();
+}
+
+// A fixture is an object of tests that all have `pre`; anything else is taken for an account map.
+auto AddAccounts(Accounts& accounts, json::Value const& document) -> void {
+  if (auto const* const alloc{document.Find("alloc")}) {
+    AddAccounts(accounts, *alloc);
+    return;
+  }
+  auto const& members{document.AsObject()};
+  auto const is_fixture{not members.empty() and std::ranges::all_of(members, [](auto const& member) { return member.second.IsObject() and member.second.Find("pre") != nullptr; })};
+  if (is_fixture) {
+    for (auto const& [name, test] : members) {
+      AddAccounts(accounts, test.At("pre"));
+    }
+    return;
+  }
+  for (auto& [address, account] : json::ToAccounts(document)) {
+    accounts.insert_or_assign(address, std::move(account));
+  }
+}
+
+auto PrintInfo(std::filesystem::path const& path) -> void {
+  auto const start{std::chrono::steady_clock::now()};
+  flat::MappedState const state{path};
+  auto const elapsed{std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start)};
+  auto const& header{state.GetHeader()};
+  std::println("{}: {} accounts, {} storage slots, {} distinct codes, {} bytes (mapped in {:.1f} us)", path.string(), header.account_count, header.storage_count,
+               header.code_count, header.file_size, elapsed.count());
+}
+
+}  // namespace
+
+auto main(int argc, char* argv[]) -> int {
+  std::vector<std::string_view> const arguments(argv + 1, argv + argc);
+  if (arguments.size() == 2 and arguments[0] == "--info") {
+    try {
+      PrintInfo(std::filesystem::path{arguments[1]});
+    } catch (std::exception const& ex) {
+      std::println("[ERROR] {}", ex.what());
+      return 1;
+    }
+    return 0;
+  }
+  if (arguments.size() < 2 or arguments[0].starts_with("--")) {
+    std::println("Usage: evmint-snapshot <output> <state.json>...\n       evmint-snapshot --info <snapshot>");
+    return 1;
+  }
+
+  try {
+    Accounts accounts{};
+    for (auto const& input : arguments | std::views::drop(1)) {
+      AddAccounts(accounts, json::Parse(ReadFile(std::filesystem::path{input})));
+    }
+    std::filesystem::path const output{arguments[0]};
+    flat::WriteSnapshot(output, accounts);
+    PrintInfo(output);
+  } catch (std::exception const& ex) {
+    std::println("[ERROR] {}", ex.what());
+    return 1;
+  }
+}
@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: MIT
+
+// World state as the interpreter sees it: account balances, code and storage behind the StateView
+// interface that SLOAD, BALANCE, EXTCODESIZE and the executors read through.
+
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "evm.hpp"
+
+namespace evmint {
+
+// Accounts are addressed by the low 160 bits of a word.
+inline auto ToAddress(word_t const& word) -> word_t { return word & ((word_t{1} << 160) - 1); }
+
+// A balance or a storage slot; the unit executors track reads and writes in.
+struct StateKey {
+  word_t address{};
+  word_t slot{};  // unused for balances
+  bool is_balance{false};
+
+  static auto Balance(word_t const& address) -> StateKey { return {.address = address, .is_balance = true}; }
+  static auto Storage(word_t const& address, word_t const& slot) -> StateKey { return {.address = address, .slot = slot}; }
+
+  auto operator==(StateKey const&) const -> bool = default;
+};
+
+struct StateKeyHash {
+  auto operator()(StateKey const& key) const noexcept -> std::size_t { return WordHash{}(key.address) * 31 + WordHash{}(key.slot) + key.is_balance; }
+};
+
+// Read access to the state an execution runs against. Implementations used by executors must allow
+// concurrent calls from several threads.
+class StateView {
+ public:
+  virtual ~StateView() = default;
+
+  virtual auto StorageAt(word_t const& address, word_t const& slot) const -> word_t = 0;
+  virtual auto BalanceOf(word_t const& address) const -> word_t = 0;
+  // empty for accounts without code
+  virtual auto CodeAt(word_t const& address) const -> std::span<std::byte const> = 0;
+  // for hosts that can tell the size without handing out the code
+  virtual auto CodeSizeAt(word_t const& address) const -> std::size_t { return CodeAt(address).size(); }
+  // False if reading `key` now would block, e.g. on a disk read; the interpreter then suspends the execution in front
+  // of the reading instruction (ExecutionStatus::kStateMissing) until the host made it resident. A balance key stands
+  // for the whole account, which EXTCODESIZE reads as well.
+  virtual auto IsResident(StateKey const& /*key*/) const -> bool { return true; }
+};
+
+struct Account {
+  word_t balance{};
+  std::vector<std::byte> code{};
+  Storage storage{};
+};
+
+using Accounts = std::unordered_map<word_t, Account, WordHash>;
+
+// State that never changes after construction, so any number of threads can read it.
+class StateSnapshot final : public StateView {
+ public:
+  StateSnapshot() = default;
+  explicit StateSnapshot(Accounts accounts) : m_accounts{std::move(accounts)} {}
+
+  auto StorageAt(word_t const& address, word_t const& slot) const -> word_t override {
+    auto const* account{Find(address)};
+    if (account == nullptr) {
+      return 0;
+    }
+    auto const stored{account->storage.find(slot)};
+    return stored == std::end(account->storage) ? word_t{0} : stored->second;
+  }
+
+  auto BalanceOf(word_t const& address) const -> word_t override {
+    auto const* account{Find(address)};
+    return account == nullptr ? word_t{0} : account->balance;
+  }
+
+  auto CodeAt(word_t const& address) const -> std::span<std::byte const> override {
+    auto const* account{Find(address)};
+    return account == nullptr ? std::span<std::byte const>{} : std::span<std::byte const>{account->code};
+  }
+
+ private:
+  Accounts m_accounts{};
+
+  auto Find(word_t const& address) const -> Account const* {
+    auto const account{m_accounts.find(address)};
+    return account == std::end(m_accounts) ? nullptr : &account->second;
+  }
+};
+
+// Values written to state locations, e.g. by one transaction or a whole block.
+using StateWrites = std::unordered_map<StateKey, word_t, StateKeyHash>;
+
+inline auto ReadState(StateView const& state, StateKey const& key) -> word_t { return key.is_balance ? state.BalanceOf(key.address) : state.StorageAt(key.address, key.slot); }
+
+}  // namespace evmint
@@ -0,0 +1,436 @@
+// SPDX-License-Identifier: MIT
+
+// Multi-version state store: every commit installs a new version of the state, readers get a StateView
+// pinned to one version and never take a lock, so any number of executors can read while a single
+// committer installs the next block. Memory that readers might still be walking is reclaimed with
+// epoch-based reclamation.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <span>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "evm.hpp"
+#include "state.hpp"
+
+namespace evmint {
+
+// Epoch-based reclamation. A reader pins the current epoch while it walks shared nodes (Guard); a writer
+// retires the nodes it unlinks with the epoch at that time, and Reclaim() frees them once every pinned
+// reader entered a later epoch, so no reader can still hold a pointer to them.
+class EpochDomain {
+  static constexpr std::uint64_t kUnpinned{std::numeric_limits<std::uint64_t>::max()};
+
+  struct alignas(64) Slot {
+    std::atomic<std::uint64_t> epoch{kUnpinned};
+    std::atomic<bool> claimed{false};
+    // only touched by the owning thread
+    std::size_t depth{0};
+  };
+
+ public:
+  static constexpr std::size_t kMaxThreads{1024};
+
+  static auto Global() -> EpochDomain& {
+    static EpochDomain domain{};
+    return domain;
+  }
+
+  // Pins the calling thread for its lifetime; guards nest.
+  class Guard {
+   public:
+    Guard() : m_slot{Global().ThreadSlot()} {
+      if (m_slot.depth++ == 0) {
+        // seq_cst: the pin is visible to Reclaim() before this thread loads any shared pointer
+        m_slot.epoch.store(Global().m_epoch.load());
+      }
+    }
+    Guard(Guard const&) = delete;
+    auto operator=(Guard const&) -> Guard& = delete;
+    ~Guard() {
+      if (--m_slot.depth == 0) {
+        m_slot.epoch.store(kUnpinned, std::memory_order_release);
+      }
+    }
+
+   private:
+    Slot& m_slot;
+  };
+
+  // `deleter` runs once no reader pinned before this call is left; the caller has already unlinked what it frees.
+  auto Retire(std::function<void()> deleter) -> void {
+    std::scoped_lock const lock{m_retired_mutex};
+    m_retired.emplace_back(m_epoch.load(), std::move(deleter));
+  }
+
+  auto Reclaim() -> void {
+    std::vector<std::function<void()>> reclaimable{};
+    {
+      std::scoped_lock const lock{m_retired_mutex};
+      // readers pinning from now on cannot reach anything retired so far
+      m_epoch.fetch_add(1);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      auto oldest_pinned{kUnpinned};
+      for (auto const& slot : m_slots) {
+        oldest_pinned = std::min(oldest_pinned, slot.epoch.load());
+      }
+
+      // a reader pinned at the retirement epoch may have loaded the pointer just before it was unlinked
+      auto const unreachable{std::ranges::partition(m_retired, [oldest_pinned](auto const& retired) { return retired.first >= oldest_pinned; })};
+      for (auto& retired : unreachable) {
+        reclaimable.push_back(std::move(retired.second));
+      }
+      m_retired.erase(std::begin(unreachable), std::end(m_retired));
+    }
+    for (auto const& deleter : reclaimable) {
+      deleter();
+    }
+  }
+
+ private:
+  // claims a slot for the calling thread and releases it at thread exit
+  struct ThreadRegistration {
+    Slot* slot{nullptr};
+
+    explicit ThreadRegistration(EpochDomain& domain) {
+      for (auto& candidate : domain.m_slots) {
+        if (not candidate.claimed.exchange(true)) {
+          slot = &candidate;
+          return;
+        }
+      }
+      throw std::runtime_error{std::format("[STATE]: More than {} threads read the state store.", kMaxThreads)};
+    }
+    ThreadRegistration(ThreadRegistration const&) = delete;
+    auto operator=(ThreadRegistration const&) -> ThreadRegistration& = delete;
+    ~ThreadRegistration() {
+      slot->epoch.store(kUnpinned);
+      slot->claimed.store(false);
+    }
+  };
+
+  std::atomic<std::uint64_t> m_epoch{0};
+  std::array<Slot, kMaxThreads> m_slots{};
+  std::mutex m_retired_mutex{};
+  std::vector<std::pair<std::uint64_t, std::function<void()>>> m_retired{};
+
+  EpochDomain() = default;
+  // runs at exit, after every reader thread
+  ~EpochDomain() {
+    for (auto const& retired : m_retired) {
+      retired.second();
+    }
+  }
+
+  auto ThreadSlot() -> Slot& {
+    thread_local ThreadRegistration const registration{*this};
+    return *registration.slot;
+  }
+};
+
+// Hash table from keys to version chains (newest first). Readers walk buckets and chains without locks; writers lock
+// only the shard a key falls into. Growing a shard builds a new bucket array with new key nodes that share the old
+// version chains, publishes it, and retires the old array.
+template <typename Key, typename Value, typename Hash>
+class VersionedTable {
+ public:
+  using version_t = std::uint64_t;
+
+  VersionedTable() {
+    for (auto& shard : m_shards) {
+      shard.buckets.store(new Buckets{kInitialBucketCount});
+    }
+  }
+  VersionedTable(VersionedTable const&) = delete;
+  auto operator=(VersionedTable const&) -> VersionedTable& = delete;
+  // no reader may be left
+  ~VersionedTable() {
+    for (auto& shard : m_shards) {
+      auto* const buckets{shard.buckets.load()};
+      for (std::size_t bucket{0}; bucket < buckets->size; ++bucket) {
+        for (auto* key_node{buckets->heads[bucket].load()}; key_node != nullptr;) {
+          DeleteChain(key_node->versions.load());
+          delete std::exchange(key_node, key_node->next.load());
+        }
+      }
+      delete buckets;
+    }
+  }
+
+  // Newest value of `key` no newer than `version`; call under an EpochDomain::Guard.
+  auto Read(Key const& key, version_t version) const -> Value const* {
+    auto const hash{Hash{}(key)};
+    auto const* buckets{ShardOf(hash).buckets.load(std::memory_order_acquire)};
+    for (auto const* key_node{buckets->heads[Bucket(hash, buckets->size)].load(std::memory_order_acquire)}; key_node != nullptr; key_node = key_node->next.load(std::memory_order_acquire)) {
+      if (key_node->key == key) {
+        for (auto const* version_node{key_node->versions.load(std::memory_order_acquire)}; version_node != nullptr; version_node = version_node->next.load(std::memory_order_acquire)) {
+          if (version_node->version <= version) {
+            return &version_node->value;
+          }
+        }
+        return nullptr;
+      }
+    }
+    return nullptr;
+  }
+
+  // Versions must grow from one write of a key to the next.
+  auto Write(Key const& key, version_t version, Value value) -> void {
+    auto const hash{Hash{}(key)};
+    auto& shard{ShardOf(hash)};
+    std::scoped_lock const lock{shard.mutex};
+
+    auto* key_node{Find(shard, hash, key)};
+    if (key_node == nullptr) {
+      if (shard.key_count >= shard.buckets.load()->size * kMaxLoadFactor) {
+        Grow(shard);
+      }
+      auto& head{shard.buckets.load()->heads[Bucket(hash, shard.buckets.load()->size)]};
+      key_node = new KeyNode{.key = key};
+      key_node->next.store(head.load());
+      head.store(key_node, std::memory_order_release);
+      shard.key_count++;
+    }
+
+    auto* const version_node{new VersionNode{.version = version, .value = std::move(value)}};
+    version_node->next.store(key_node->versions.load());
+    key_node->versions.store(version_node, std::memory_order_release);
+  }
+
+  // Drops the versions no reader at `oldest_readable` or later can see: everything behind the newest version not
+  // newer than it.
+  auto Prune(version_t oldest_readable) -> void {
+    for (auto& shard : m_shards) {
+      std::scoped_lock const lock{shard.mutex};
+      auto* const buckets{shard.buckets.load()};
+      for (std::size_t bucket{0}; bucket < buckets->size; ++bucket) {
+        for (auto* key_node{buckets->heads[bucket].load()}; key_node != nullptr; key_node = key_node->next.load()) {
+          auto* version_node{key_node->versions.load()};
+          while (version_node != nullptr and version_node->version > oldest_readable) {
+            version_node = version_node->next.load();
+          }
+          if (version_node != nullptr) {
+            if (auto* const pruned{version_node->next.exchange(nullptr, std::memory_order_acq_rel)}; pruned != nullptr) {
+              EpochDomain::Global().Retire([pruned] { DeleteChain(pruned); });
+            }
+          }
+        }
+      }
+    }
+    EpochDomain::Global().Reclaim();
+  }
+
+ private:
+  static constexpr std::size_t kShardCount{256};
+  static constexpr std::size_t kInitialBucketCount{16};
+  static constexpr std::size_t kMaxLoadFactor{2};
+
+  struct VersionNode {
+    version_t version{0};
+    Value value{};
+    std::atomic<VersionNode*> next{nullptr};
+  };
+
+  struct KeyNode {
+    Key key{};
+    std::atomic<VersionNode*> versions{nullptr};
+    std::atomic<KeyNode*> next{nullptr};
+  };
+
+  struct Buckets {
+    explicit Buckets(std::size_t bucket_count) : size{bucket_count}, heads{std::make_unique<std::atomic<KeyNode*>[]>(bucket_count)} {}
+
+    std::size_t size;
+    std::unique_ptr<std::atomic<KeyNode*>[]> heads;
+  };
+
+  struct alignas(64) Shard {
+    std::mutex mutex{};
+    std::atomic<Buckets*> buckets{nullptr};
+    std::size_t key_count{0};
+  };
+
+  std::array<Shard, kShardCount> m_shards{};
+
+  // the low bits pick the shard, the bits above them the bucket
+  static auto Bucket(std::size_t hash, std::size_t bucket_count) -> std::size_t { return (hash / kShardCount) % bucket_count; }
+  auto ShardOf(std::size_t hash) -> Shard& { return m_shards[hash % kShardCount]; }
+  auto ShardOf(std::size_t hash) const -> Shard const& { return m_shards[hash % kShardCount]; }
+
+  static auto DeleteChain(VersionNode* version_node) -> void {
+    while (version_node != nullptr) {
+      delete std::exchange(version_node, version_node->next.load());
+    }
+  }
+
+  static auto Find(Shard& shard, std::size_t hash, Key const& key) -> KeyNode* {
+    auto* const buckets{shard.buckets.load()};
+    for (auto* key_node{buckets->heads[Bucket(hash, buckets->size)].load()}; key_node != nullptr; key_node = key_node->next.load()) {
+      if (key_node->key == key) {
+        return key_node;
+      }
+    }
+    return nullptr;
+  }
+
+  // Readers still in the old array see the version chains as they were, which holds every version they can read: new
+  // versions only go to the new key nodes, and only readers pinned to them can see those versions.
+  static auto Grow(Shard& shard) -> void {
+    auto* const old_buckets{shard.buckets.load()};
+    auto* const new_buckets{new Buckets{old_buckets->size * 2}};
+    std::vector<KeyNode*> old_key_nodes{};
+    for (std::size_t bucket{0}; bucket < old_buckets->size; ++bucket) {
+      for (auto* key_node{old_buckets->heads[bucket].load()}; key_node != nullptr; key_node = key_node->next.load()) {
+        auto* const moved{new KeyNode{.key = key_node->key}};
+        moved->versions.store(key_node->versions.load());
+        auto& head{new_buckets->heads[Bucket(Hash{}(key_node->key), new_buckets->size)]};
+        moved->next.store(head.load());
+        head.store(moved);
+        old_key_nodes.push_back(key_node);
+      }
+    }
+
+    shard.buckets.store(new_buckets, std::memory_order_release);
+    EpochDomain::Global().Retire([old_buckets, old_key_nodes = std::move(old_key_nodes)] {
+      for (auto* const key_node : old_key_nodes) {
+        delete key_node;
+      }
+      delete old_buckets;
+    });
+  }
+};
+
+using CodeWrites = std::unordered_map<word_t, std::vector<std::byte>, WordHash>;
+
+// Balances, storage and code by version. Commit() installs a new version (one committer at a time); views read any
+// retained version concurrently with commits and pruning without locking.
+class StateStore {
+ public:
+  using version_t = std::uint64_t;
+
+  // Pinned to one version, which Prune() keeps readable while the view exists. Safe to share between threads.
+  class View final : public StateView {
+   public:
+    View(View const&) = delete;
+    auto operator=(View const&) -> View& = delete;
+    ~View() override { m_store.Release(m_version); }
+
+    auto StorageAt(word_t const& address, word_t const& slot) const -> word_t override { return m_store.ReadWord(StateKey::Storage(address, slot), m_version); }
+    auto BalanceOf(word_t const& address) const -> word_t override { return m_store.ReadWord(StateKey::Balance(address), m_version); }
+    // stays valid while the view exists
+    auto CodeAt(word_t const& address) const -> std::span<std::byte const> override {
+      EpochDomain::Guard const guard{};
+      auto const* code{m_store.m_code.Read(address, m_version)};
+      return code == nullptr ? std::span<std::byte const>{} : std::span<std::byte const>{*code};
+    }
+
+    auto Version() const -> version_t { return m_version; }
+
+   private:
+    friend class StateStore;
+
+    StateStore& m_store;
+    version_t m_version;
+
+    View(StateStore& store, version_t version) : m_store{store}, m_version{version} {}
+  };
+
+  StateStore() = default;
+  StateStore(StateStore const&) = delete;
+  auto operator=(StateStore const&) -> StateStore& = delete;
+
+  auto LatestVersion() const -> version_t { return m_latest_version.load(std::memory_order_acquire); }
+
+  auto Snapshot() -> std::unique_ptr<View> { return SnapshotAt(LatestVersion()); }
+
+  auto SnapshotAt(version_t version) -> std::unique_ptr<View> {
+    std::scoped_lock const lock{m_views_mutex};
+    if (version < m_oldest_version or version > LatestVersion()) {
+      throw std::runtime_error{std::format("[STATE]: Version {} is not retained (oldest {}, latest {}).", version, m_oldest_version, LatestVersion())};
+    }
+    m_view_versions.insert(version);
+    return std::unique_ptr<View>{new View{*this, version}};
+  }
+
+  // Installs the writes as the next version and returns it; readers see it once this returns.
+  auto Commit(StateWrites const& writes, CodeWrites const& code_writes = {}) -> version_t {
+    std::scoped_lock const lock{m_commit_mutex};
+    auto const version{m_latest_version.load() + 1};
+    for (auto const& [key, value] : writes) {
+      m_values.Write(key, version, value);
+    }
+    for (auto const& [address, code] : code_writes) {
+      m_code.Write(address, version, code);
+    }
+    m_latest_version.store(version, std::memory_order_release);
+    return version;
+  }
+
+  auto Commit(Accounts const& accounts) -> version_t {
+    StateWrites writes{};
+    CodeWrites code_writes{};
+    for (auto const& [address, account] : accounts) {
+      writes.emplace(StateKey::Balance(address), account.balance);
+      for (auto const& [slot, value] : account.storage) {
+        writes.emplace(StateKey::Storage(address, slot), value);
+      }
+      if (not account.code.empty()) {
+        code_writes.emplace(address, account.code);
+      }
+    }
+    return Commit(writes, code_writes);
+  }
+
+  // Frees versions older than `oldest_readable` (or the oldest live view, if older); SnapshotAt() rejects them from
+  // then on.
+  auto Prune(version_t oldest_readable) -> void {
+    version_t prune_below{0};
+    {
+      std::scoped_lock const lock{m_views_mutex};
+      prune_below = std::min(oldest_readable, LatestVersion());
+      if (not m_view_versions.empty()) {
+        prune_below = std::min(prune_below, *std::begin(m_view_versions));
+      }
+      m_oldest_version = std::max(m_oldest_version, prune_below);
+    }
+    m_values.Prune(prune_below);
+    m_code.Prune(prune_below);
+  }
+
+ private:
+  VersionedTable<StateKey, word_t, StateKeyHash> m_values{};
+  VersionedTable<word_t, std::vector<std::byte>, WordHash> m_code{};
+  std::mutex m_commit_mutex{};
+  std::atomic<version_t> m_latest_version{0};
+
+  std::mutex m_views_mutex{};
+  version_t m_oldest_version{0};
+  std::multiset<version_t> m_view_versions{};
+
+  auto ReadWord(StateKey const& key, version_t version) const -> word_t {
+    EpochDomain::Guard const guard{};
+    auto const* value{m_values.Read(key, version)};
+    return value == nullptr ? word_t{0} : *value;
+  }
+
+  auto Release(version_t version) -> void {
+    std::scoped_lock const lock{m_views_mutex};
+    m_view_versions.erase(m_view_versions.find(version));
+  }
+};
+
+}  // namespace evmint
@@ -0,0 +1,408 @@
+// SPDX-License-Identifier: MIT
+
+// evmint-statetest: runs Ethereum GeneralStateTests and VMTests JSON fixtures (the ethereum/tests and
+// execution-spec-tests formats) through the Interpreter, one test file at a time on every core.
+//
+//   evmint-statetest [--fork <name>] [--dispatch table|tos|tiered] [--jobs <n>] [--slowest <n>] <file or directory>...
+//
+// Directories are searched recursively for *.json files. Each state test case (one fork, one data/gas/value index
+// triple) builds its pre-state, runs the code of `transaction.to` with the case's data and the gas left after the
+// intrinsic cost, and compares the storage of every account against the case's expected post-state and its logs
+// against the expected logs hash. VMTests run `exec` against `pre` and compare with `post` the same way, or expect the
+// execution to fail where there is no `post`. --fork restricts state tests to one fork; VMTests have none and always
+// run.
+//
+// Post-state roots are not recomputed: cases whose fixture carries only the root (ethereum/tests, unlike
+// execution-spec-tests with its `state`) are reported as unverified. Logs are hashed as the fixtures hash them,
+// keccak256 of the RLP list of [address, [topics...], data]. There is no transaction processing (value transfer, gas
+// purchase, nonces), so balances and nonces are not compared, and BALANCE reads pre-state balances. Cases that create
+// contracts, expect the transaction to be invalid or execute what the interpreter does not implement are reported as
+// unsupported.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <print>
+#include <ranges>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <magic_enum.hpp>
+#include <intx/intx.hpp>
+
+#include "evm.hpp"
+#include "interpreter.hpp"
+#include "json.hpp"
+#include "keccak.hpp"
+#include "logs.hpp"
+#include "rlp.hpp"
+#include "state.hpp"
+#include "worker_pool.hpp"
+
+using namespace evmint;
+
+namespace {
+
+constexpr std::size_t kDefaultSlowestCount{10};
+
+// keccak256(rlp([])), the logs hash of a transaction that emits no logs
+constexpr std::string_view kEmptyLogsHash{"0x1dcc4de8dec75d7aab85b567b6ccd41ad312451b948a7413f0a142fd40d49347"};
+
+enum class Outcome { kPassed, kFailed, kUnsupported, kUnverified };
+
+struct CaseResult {
+  // <file>:<test>[<fork> d<data> g<gas> v<value>]
+  std::string name{};
+  Outcome outcome{Outcome::kPassed};
+  std::string detail{};
+  std::chrono::nanoseconds duration{};
+};
+
+struct Options {
+  std::optional<std::string> fork{};
+  DispatchMode dispatch_mode{DispatchMode::kTiered};
+};
+
+auto ReadFile(std::filesystem::path const& path) -> std::string {
+  std::ifstream file{path, std::ios::binary};
+  if (not file.is_open()) {
+    throw std::runtime_error{std::format("[STATETEST]: Could not open '{}'.", path.string())};
+  }
+  std::ostringstream text{};
+  text << file.rdbuf();
+  return std::move(text).str();
+}
+
+auto IntrinsicGas(std::span<std::byte const> calldata, json::Value const* access_list) -> std::size_t {
+  auto gas{kTransactionGas};
+  for (auto const byte : calldata) {
+    gas += byte == std::byte{0} ? kZeroDataByteGas : kNonZeroDataByteGas;
+  }
+  if (access_list != nullptr and not access_list->IsNull()) {
+    for (auto const& entry : access_list->AsArray()) {
+      gas += kAccessListAddressGas + kAccessListSlotGas * entry.At("storageKeys").AsArray().size();
+    }
+  }
+  return gas;
+}
+
+// As the fixtures' `logs`: "0x" and keccak256(rlp([[address, [topic, ...], data], ...])) in hex.
+auto LogsHash(LogArena const& logs) -> std::string {
+  if (logs.empty()) {
+    return std::string{kEmptyLogsHash};
+  }
+  std::vector<std::byte> encoding{};
+  rlp::Encoder encoder{encoding};
+  auto const logs_begin{encoder.BeginList()};
+  std::array<std::uint8_t, kWordSize> word{};
+  for (std::size_t index{0}; index < logs.size(); ++index) {
+    auto const log{logs[index]};
+    auto const log_begin{encoder.BeginList()};
+    StoreWord(word.data(), log.address);
+    encoder.AppendString(std::as_bytes(std::span{word}).last(kAddressSize));
+    auto const topics_begin{encoder.BeginList()};
+    for (auto const& topic : log.topics) {
+      // topics are 32-byte strings, not integers: leading zeros stay
+      StoreWord(word.data(), topic);
+      encoder.AppendString(std::as_bytes(std::span{word}));
+    }
+    encoder.EndList(topics_begin);
+    encoder.AppendString(log.data);
+    encoder.EndList(log_begin);
+  }
+  encoder.EndList(logs_begin);
+
+  std::string hash{"0x"};
+  for (auto const byte : Keccak256(encoding)) {
+    hash += std::format("{:02x}", static_cast<unsigned>(byte));
+  }
+  return hash;
+}
+
+// Describes how the storage after the execution differs from `expected`, empty if it does not. Only successful
+// executions keep their writes; the others leave the pre-state as it was.
+auto CompareStorage(Accounts const& pre, word_t const& address, ExecutionResult const& result, Accounts const& expected) -> std::string {
+  auto post{pre};
+  if (result.status == ExecutionStatus::kSuccess) {
+    auto& storage{post[address].storage};
+    for (auto const& [slot, value] : result.storage_writes) {
+      if (value == 0) {
+        storage.erase(slot);
+      } else {
+        storage.insert_or_assign(slot, value);
+      }
+    }
+  }
+
+  auto const describe{[](word_t const& account, word_t const& slot, word_t const& value, word_t const& expected_value) {
+    return std::format("account 0x{} slot 0x{} holds 0x{}, expected 0x{}", intx::to_string(account, kHexBase), intx::to_string(slot, kHexBase), intx::to_string(value, kHexBase),
+                       intx::to_string(expected_value, kHexBase));
+  }};
+  for (auto const& [account_address, expected_account] : expected) {
+    auto const account{post.find(account_address)};
+    Storage const empty_storage{};
+    auto const& storage{account == std::end(post) ? empty_storage : account->second.storage};
+    for (auto const& [slot, expected_value] : expected_account.storage) {
+      auto const stored{storage.find(slot)};
+      if (auto const value{stored == std::end(storage) ? word_t{0} : stored->second}; value != expected_value) {
+        return describe(account_address, slot, value, expected_value);
+      }
+    }
+    for (auto const& [slot, value] : storage) {
+      if (not expected_account.storage.contains(slot)) {
+        return describe(account_address, slot, value, 0);
+      }
+    }
+  }
+  return {};
+}
+
+// The outcome of one execution with these logs, given the expected post-state (if the fixture has one) and logs hash
+// (if any).
+auto Judge(Accounts const& pre, word_t const& address, ExecutionResult const& result, LogArena const& logs, std::optional<Accounts> const& expected_post,
+           json::Value const* logs_hash) -> std::pair<Outcome, std::string> {
+  if (result.status == ExecutionStatus::kUnrecognizedOpcode or result.status == ExecutionStatus::kMemoryUnalignedAccess) {
+    return {Outcome::kUnsupported, std::format("execution ended with {}", magic_enum::enum_name(result.status))};
+  }
+  if (result.status == ExecutionStatus::kInternalError) {
+    return {Outcome::kFailed, "internal error"};
+  }
+  if (logs_hash != nullptr) {
+    if (auto const emitted{LogsHash(logs)}; emitted != logs_hash->AsString()) {
+      return {Outcome::kFailed, std::format("logs hash {}, expected {}", emitted, logs_hash->AsString())};
+    }
+  }
+  if (not expected_post) {
+    return {Outcome::kUnverified, "only the post-state root is given"};
+  }
+  if (auto detail{CompareStorage(pre, address, result, *expected_post)}; not detail.empty()) {
+    return {Outcome::kFailed, std::move(detail)};
+  }
+  return {Outcome::kPassed, {}};
+}
+
+class TestRunner final {
+ public:
+  TestRunner(Interpreter& interpreter, Options const& options, std::vector<CaseResult>& results) : m_interpreter{interpreter}, m_options{options}, m_results{results} {}
+
+  auto RunFile(std::filesystem::path const& path) -> void {
+    try {
+      auto const document{json::Parse(ReadFile(path))};
+      for (auto const& [test_name, test] : document.AsObject()) {
+        auto const name{std::format("{}:{}", path.filename().string(), test_name)};
+        if (test.Find("transaction") != nullptr) {
+          RunStateTest(name, test);
+        } else if (test.Find("exec") != nullptr) {
+          RunVmTest(name, test);
+        } else {
+          m_results.push_back({.name = name, .outcome = Outcome::kUnsupported, .detail = "neither a state test nor a VM test"});
+        }
+      }
+    } catch (std::exception const& ex) {
+      m_results.push_back({.name = path.string(), .outcome = Outcome::kFailed, .detail = ex.what()});
+    }
+  }
+
+ private:
+  Interpreter& m_interpreter;
+  Options const& m_options;
+  std::vector<CaseResult>& m_results;
+
+  auto TimedExecute(ExecutionRequest const& request, std::chrono::nanoseconds& duration) -> ExecutionResult {
+    auto const start{std::chrono::steady_clock::now()};
+    auto result{m_interpreter.Execute(request)};
+    duration = std::chrono::steady_clock::now() - start;
+    return result;
+  }
+
+  auto RunStateTest(std::string const& name, json::Value const& test) -> void {
+    auto const& transaction{test.At("transaction")};
+    auto const pre{json::ToAccounts(test.At("pre"))};
+    StateSnapshot const state{pre};
+
+    for (auto const& [fork, cases] : test.At("post").AsObject()) {
+      if (m_options.fork and *m_options.fork != fork) {
+        continue;
+      }
+      for (auto const& post : cases.AsArray()) {
+        auto const& indexes{post.At("indexes")};
+        auto const data_index{indexes.At("data").AsUnsigned()};
+        auto const gas_index{indexes.At("gas").AsUnsigned()};
+        CaseResult result{.name = std::format("{}[{} d{} g{} v{}]", name, fork, data_index, gas_index, indexes.At("value").AsUnsigned())};
+
+        auto const& to{transaction.At("to")};
+        if (post.Find("expectException") != nullptr) {
+          result.outcome = Outcome::kUnsupported;
+          result.detail = "expects an invalid transaction";
+        } else if (to.IsNull() or to.AsString().empty()) {
+          result.outcome = Outcome::kUnsupported;
+          result.detail = "creates a contract";
+        } else {
+          auto const address{to.AsWord()};
+          auto const calldata{transaction.At("data").AsArray().at(data_index).AsBytes()};
+          auto const* const access_lists{transaction.Find("accessLists")};
+          auto const intrinsic_gas{IntrinsicGas(calldata, access_lists == nullptr ? nullptr : &access_lists->AsArray().at(data_index))};
+          auto const gas_limit{transaction.At("gasLimit").AsArray().at(gas_index).AsUnsigned()};
+          if (gas_limit < intrinsic_gas) {
+            result.outcome = Outcome::kFailed;
+            result.detail = std::format("gas limit {} is below the intrinsic gas {}", gas_limit, intrinsic_gas);
+          } else {
+            ExecutionRequest const request{.code = state.CodeAt(address),
+                                           .calldata = calldata,
+                                           .state = &state,
+                                           .address = address,
+                                           .gas_limit = static_cast<std::size_t>(gas_limit) - intrinsic_gas,
+                                           .dispatch_mode = m_options.dispatch_mode};
+            auto const execution{TimedExecute(request, result.duration)};
+            auto const* const expected_state{post.Find("state")};
+            std::tie(result.outcome, result.detail) =
+                Judge(pre, address, execution, m_interpreter.Logs(), expected_state == nullptr ? std::nullopt : std::optional{json::ToAccounts(*expected_state)}, post.Find("logs"));
+          }
+        }
+        m_results.push_back(std::move(result));
+      }
+    }
+  }
+
+  auto RunVmTest(std::string const& name, json::Value const& test) -> void {
+    auto const& exec{test.At("exec")};
+    auto const pre{json::ToAccounts(test.At("pre"))};
+    StateSnapshot const state{pre};
+    auto const code{exec.At("code").AsBytes()};
+    auto const calldata{exec.At("data").AsBytes()};
+    auto const address{exec.At("address").AsWord()};
+    ExecutionRequest const request{.code = code,
+                                   .calldata = calldata,
+                                   .state = &state,
+                                   .address = address,
+                                   .gas_limit = static_cast<std::size_t>(exec.At("gas").AsUnsigned()),
+                                   .dispatch_mode = m_options.dispatch_mode};
+
+    CaseResult result{.name = name};
+    auto const execution{TimedExecute(request, result.duration)};
+    if (auto const* const post{test.Find("post")}) {
+      std::tie(result.outcome, result.detail) = Judge(pre, address, execution, m_interpreter.Logs(), json::ToAccounts(*post), test.Find("logs"));
+    } else if (execution.status == ExecutionStatus::kUnrecognizedOpcode) {
+      result.outcome = Outcome::kUnsupported;
+      result.detail = "execution ended with kUnrecognizedOpcode";
+    } else if (execution.status == ExecutionStatus::kSuccess) {
+      result.outcome = Outcome::kFailed;
+      result.detail = "succeeded, expected the execution to fail";
+    }
+    m_results.push_back(std::move(result));
+  }
+};
+
+auto FindTestFiles(std::vector<std::filesystem::path> const& roots) -> std::vector<std::filesystem::path> {
+  std::vector<std::filesystem::path> files{};
+  for (auto const& root : roots) {
+    if (not std::filesystem::is_directory(root)) {
+      files.push_back(root);
+      continue;
+    }
+    for (auto const& entry : std::filesystem::recursive_directory_iterator{root}) {
+      if (entry.is_regular_file() and entry.path().extension() == ".json") {
+        files.push_back(entry.path());
+      }
+    }
+  }
+  std::ranges::sort(files);
+  return files;
+}
+
+}  // namespace
+
+auto main(int argc, char* argv[]) -> int {
+  std::vector<std::string_view> const arguments(argv + 1, argv + argc);
+
+  Options options{};
+  std::size_t worker_count{std::max(std::thread::hardware_concurrency(), 1u)};
+  std::size_t slowest_count{kDefaultSlowestCount};
+  std::vector<std::filesystem::path> roots{};
+  for (std::size_t index{0}; index < arguments.size(); ++index) {
+    auto const value{index + 1 < arguments.size() ? std::optional{arguments[index + 1]} : std::nullopt};
+    if (arguments[index] == "--fork" and value) {
+      options.fork = std::string{*value};
+      ++index;
+    } else if (arguments[index] == "--dispatch" and value and ParseDispatchMode(*value)) {
+      options.dispatch_mode = *ParseDispatchMode(*value);
+      ++index;
+    } else if (arguments[index] == "--jobs" and value) {
+      worker_count = std::max<std::size_t>(std::stoul(std::string{*value}), 1);
+      ++index;
+    } else if (arguments[index] == "--slowest" and value) {
+      slowest_count = std::stoul(std::string{*value});
+      ++index;
+    } else if (arguments[index].starts_with("--")) {
+      std::println("[ERROR] Unknown or incomplete option '{}'.", arguments[index]);
+      return 1;
+    } else {
+      roots.emplace_back(arguments[index]);
+    }
+  }
+  if (roots.empty()) {
+    std::println("Usage: evmint-statetest [--fork <name>] [--dispatch table|tos|tiered] [--jobs <n>] [--slowest <n>] <file or directory>...");
+    return 1;
+  }
+
+  std::vector<std::filesystem::path> files{};
+  try {
+    files = FindTestFiles(roots);
+  } catch (std::exception const& ex) {
+    std::println("[ERROR] {}", ex.what());
+    return 1;
+  }
+
+  auto const start{std::chrono::steady_clock::now()};
+  // files are handed out one at a time, as their case counts and run times vary widely
+  std::atomic<std::size_t> next_file{0};
+  std::vector<std::vector<CaseResult>> worker_results(worker_count);
+  WorkerPool pool{worker_count, kExecutorOptions};
+  pool.RunOnEveryWorker([&](std::size_t worker_index, Interpreter& interpreter) {
+    TestRunner runner{interpreter, options, worker_results[worker_index]};
+    for (auto file{next_file.fetch_add(1)}; file < files.size(); file = next_file.fetch_add(1)) {
+      runner.RunFile(files[file]);
+    }
+  });
+  auto const elapsed{std::chrono::duration<double>(std::chrono::steady_clock::now() - start)};
+
+  std::vector<CaseResult> results{};
+  for (auto& worker_result : worker_results) {
+    results.insert(std::end(results), std::make_move_iterator(std::begin(worker_result)), std::make_move_iterator(std::end(worker_result)));
+  }
+  std::ranges::sort(results, {}, &CaseResult::name);
+
+  for (auto const& result : results) {
+    if (result.outcome == Outcome::kFailed) {
+      std::println("FAILED {}: {}", result.name, result.detail);
+    }
+  }
+  auto const count{[&results](Outcome outcome) { return std::ranges::count(results, outcome, &CaseResult::outcome); }};
+  std::println("{} files, {} cases in {:.2f}s on {} workers: {} passed, {} failed, {} unsupported, {} unverified", files.size(), results.size(), elapsed.count(), worker_count,
+               count(Outcome::kPassed), count(Outcome::kFailed), count(Outcome::kUnsupported), count(Outcome::kUnverified));
+  auto const failed_count{count(Outcome::kFailed)};
+
+  if (slowest_count != 0 and not results.empty()) {
+    std::ranges::sort(results, std::ranges::greater{}, &CaseResult::duration);
+    std::println("\nslowest cases:");
+    for (auto const& result : results | std::views::take(slowest_count)) {
+      std::println("{:>12.1f} us  {}", std::chrono::duration<double, std::micro>(result.duration).count(), result.name);
+    }
+  }
+  return failed_count == 0 ? 0 : 1;
+}
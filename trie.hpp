@@ -0,0 +1,530 @@
+// SPDX-License-Identifier: MIT
+
+// Merkle Patricia tries for the state root, kept in memory and updated in place: every node caches its reference
+// (its encoding, or the hash of it), and an update only clears the caches on its path, so computing the next root
+// rehashes just the paths a block touched. Independent subtrees are hashed on several threads.
+//
+// Keys are always 32-byte hashes (Ethereum's "secure" tries hash addresses and slots), so every key has 64 nibbles,
+// no key is a prefix of another and branch nodes never carry a value.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "evm.hpp"
+#include "keccak.hpp"
+#include "parallel_for.hpp"
+#include "rlp.hpp"
+#include "state.hpp"
+
+namespace evmint::trie {
+
+constexpr std::size_t kKeyNibbles{2 * kWordSize};
+constexpr std::size_t kBranchWidth{16};
+
+inline auto NibbleAt(Hash const& key, std::size_t index) -> std::size_t {
+  auto const byte{static_cast<std::size_t>(key[index / 2])};
+  return index % 2 == 0 ? byte >> 4 : byte & 0x0f;
+}
+
+// First nibble index in [begin, end) where the keys differ, `end` if there is none.
+inline auto MismatchAt(Hash const& lhs, Hash const& rhs, std::size_t begin, std::size_t end = kKeyNibbles) -> std::size_t {
+  while (begin < end and NibbleAt(lhs, begin) == NibbleAt(rhs, begin)) {
+    begin++;
+  }
+  return begin;
+}
+
+// How a parent refers to a node: its encoding if that is shorter than a hash, otherwise the hash of the encoding.
+struct Reference {
+  std::array<std::byte, kWordSize> bytes{};
+  // 0 while not computed
+  std::uint8_t size{0};
+
+  auto IsHash() const -> bool { return size == kWordSize; }
+  auto View() const -> std::span<std::byte const> { return std::span{bytes}.first(size); }
+};
+
+struct Node {
+  enum class Kind : std::uint8_t { kLeaf, kExtension, kBranch };
+
+  explicit Node(Kind node_kind) : kind{node_kind} {}
+  Node(Node const&) = delete;
+  auto operator=(Node const&) -> Node& = delete;
+  virtual ~Node() = default;
+
+  Kind kind;
+  // the cache: cleared whenever anything in the subtree changes
+  Reference reference{};
+};
+
+struct Leaf final : Node {
+  Leaf(Hash const& leaf_key, std::size_t leaf_depth, std::vector<std::byte> leaf_value)
+      : Node{Kind::kLeaf}, key{leaf_key}, depth{static_cast<std::uint8_t>(leaf_depth)}, value{std::move(leaf_value)} {}
+
+  // the leaf's path is the key's nibbles from `depth` on
+  Hash key;
+  std::uint8_t depth;
+  std::vector<std::byte> value;
+};
+
+struct Extension final : Node {
+  Extension(Hash const& sample_key, std::size_t path_depth, std::size_t path_length, std::unique_ptr<Node> path_child)
+      : Node{Kind::kExtension}, key{sample_key}, depth{static_cast<std::uint8_t>(path_depth)}, length{static_cast<std::uint8_t>(path_length)}, child{std::move(path_child)} {}
+
+  // any key below; the path is its nibbles [depth, depth + length)
+  Hash key;
+  std::uint8_t depth;
+  std::uint8_t length;
+  std::unique_ptr<Node> child;
+};
+
+struct Branch final : Node {
+  Branch() : Node{Kind::kBranch} {}
+
+  std::array<std::unique_ptr<Node>, kBranchWidth> children{};
+};
+
+// Hex-prefix encoding of the key's nibbles [begin, end): a flag nibble (leaf or extension, odd or even length), then
+// the nibbles packed two to a byte.
+inline auto AppendPath(rlp::Encoder& encoder, Hash const& key, std::size_t begin, std::size_t end, bool is_leaf) -> void {
+  std::array<std::byte, kWordSize + 1> path{};
+  auto const is_odd{(end - begin) % 2 == 1};
+  auto flags{(is_leaf ? 2U : 0U) + (is_odd ? 1U : 0U)};
+  path[0] = static_cast<std::byte>(flags << 4 | (is_odd ? NibbleAt(key, begin++) : 0));
+  std::size_t size{1};
+  for (; begin < end; begin += 2) {
+    path[size++] = static_cast<std::byte>(NibbleAt(key, begin) << 4 | NibbleAt(key, begin + 1));
+  }
+  encoder.AppendString(std::span{path}.first(size));
+}
+
+inline auto AppendReference(rlp::Encoder& encoder, Node const* node) -> void {
+  if (node == nullptr) {
+    encoder.AppendString({});
+  } else if (node->reference.IsHash()) {
+    encoder.AppendString(node->reference.View());
+  } else {
+    // short nodes are embedded in their parent as they are
+    encoder.AppendRaw(node->reference.View());
+  }
+}
+
+// Computes the references of `node` and of everything below it that is not cached.
+inline auto Commit(Node& node) -> Reference const& {
+  if (node.reference.size != 0) {
+    return node.reference;
+  }
+  // one per thread: children are committed before their parent is encoded, so a commit never needs it twice at once
+  thread_local std::vector<std::byte> encoding{};
+
+  switch (node.kind) {
+    case Node::Kind::kExtension:
+      Commit(*static_cast<Extension&>(node).child);
+      break;
+    case Node::Kind::kBranch:
+      for (auto const& child : static_cast<Branch&>(node).children) {
+        if (child) {
+          Commit(*child);
+        }
+      }
+      break;
+    case Node::Kind::kLeaf:
+      break;
+  }
+
+  encoding.clear();
+  rlp::Encoder encoder{encoding};
+  auto const list{encoder.BeginList()};
+  switch (node.kind) {
+    case Node::Kind::kLeaf: {
+      auto const& leaf{static_cast<Leaf const&>(node)};
+      AppendPath(encoder, leaf.key, leaf.depth, kKeyNibbles, true);
+      encoder.AppendString(leaf.value);
+      break;
+    }
+    case Node::Kind::kExtension: {
+      auto const& extension{static_cast<Extension const&>(node)};
+      AppendPath(encoder, extension.key, extension.depth, extension.depth + extension.length, false);
+      AppendReference(encoder, extension.child.get());
+      break;
+    }
+    case Node::Kind::kBranch:
+      for (auto const& child : static_cast<Branch const&>(node).children) {
+        AppendReference(encoder, child.get());
+      }
+      // no value: no key ends at a branch
+      encoder.AppendString({});
+      break;
+  }
+  encoder.EndList(list);
+
+  if (encoding.size() < kWordSize) {
+    std::ranges::copy(encoding, std::begin(node.reference.bytes));
+    node.reference.size = static_cast<std::uint8_t>(encoding.size());
+  } else {
+    node.reference.bytes = Keccak256(encoding);
+    node.reference.size = kWordSize;
+  }
+  return node.reference;
+}
+
+inline auto EmptyRoot() -> Hash {
+  static auto const empty_root{Keccak256(std::span{&rlp::kEmptyString, 1})};
+  return empty_root;
+}
+
+class Trie final {
+ public:
+  // An empty value erases the key, as the trie holds no empty values.
+  auto Put(Hash const& key, std::vector<std::byte> value) -> void {
+    if (value.empty()) {
+      Erase(m_root, 0, key);
+    } else {
+      Insert(m_root, 0, key, value);
+    }
+  }
+
+  auto Erase(Hash const& key) -> void { Erase(m_root, 0, key); }
+  auto Empty() const -> bool { return m_root == nullptr; }
+
+  // Appends the nodes whose references are not cached, down to `levels` branches below the root, for committing them
+  // in parallel before RootHash().
+  auto CollectDirtySubtrees(std::vector<Node*>& subtrees, std::size_t levels) -> void {
+    if (m_root) {
+      CollectDirtySubtrees(*m_root, levels, subtrees);
+    }
+  }
+
+  auto RootHash() -> Hash {
+    if (not m_root) {
+      return EmptyRoot();
+    }
+    auto const& reference{Commit(*m_root)};
+    // the root is hashed even when it is short
+    return reference.IsHash() ? reference.bytes : Keccak256(reference.View());
+  }
+
+ private:
+  std::unique_ptr<Node> m_root{};
+
+  static auto CollectDirtySubtrees(Node& node, std::size_t levels, std::vector<Node*>& subtrees) -> void {
+    if (node.reference.size != 0) {
+      return;
+    }
+    if (levels == 0 or node.kind != Node::Kind::kBranch) {
+      subtrees.push_back(&node);
+      return;
+    }
+    for (auto const& child : static_cast<Branch&>(node).children) {
+      if (child) {
+        CollectDirtySubtrees(*child, levels - 1, subtrees);
+      }
+    }
+  }
+
+  static auto SampleKey(Node const& node) -> Hash const& {
+    switch (node.kind) {
+      case Node::Kind::kLeaf:
+        return static_cast<Leaf const&>(node).key;
+      case Node::Kind::kExtension:
+        return static_cast<Extension const&>(node).key;
+      case Node::Kind::kBranch:
+        break;
+    }
+    return SampleKey(**std::ranges::find_if(static_cast<Branch const&>(node).children, [](auto const& child) { return child != nullptr; }));
+  }
+
+  // `branch`, behind an extension if it sits deeper than `depth`.
+  static auto AtDepth(std::unique_ptr<Branch> branch, Hash const& key, std::size_t depth, std::size_t branch_depth) -> std::unique_ptr<Node> {
+    if (branch_depth == depth) {
+      return branch;
+    }
+    return std::make_unique<Extension>(key, depth, branch_depth - depth, std::move(branch));
+  }
+
+  // Inserts into the subtree in `slot`, whose path starts at nibble `depth`; returns whether anything changed.
+  static auto Insert(std::unique_ptr<Node>& slot, std::size_t depth, Hash const& key, std::vector<std::byte>& value) -> bool {
+    if (not slot) {
+      slot = std::make_unique<Leaf>(key, depth, std::move(value));
+      return true;
+    }
+
+    switch (slot->kind) {
+      case Node::Kind::kLeaf: {
+        auto& leaf{static_cast<Leaf&>(*slot)};
+        if (leaf.key == key) {
+          if (leaf.value == value) {
+            return false;
+          }
+          leaf.value = std::move(value);
+          leaf.reference = {};
+          return true;
+        }
+        // a branch where the keys part, the old leaf and the new one below it
+        auto const split{MismatchAt(leaf.key, key, depth)};
+        auto branch{std::make_unique<Branch>()};
+        leaf.depth = static_cast<std::uint8_t>(split + 1);
+        leaf.reference = {};
+        branch->children[NibbleAt(leaf.key, split)] = std::move(slot);
+        branch->children[NibbleAt(key, split)] = std::make_unique<Leaf>(key, split + 1, std::move(value));
+        slot = AtDepth(std::move(branch), key, depth, split);
+        return true;
+      }
+
+      case Node::Kind::kExtension: {
+        auto& extension{static_cast<Extension&>(*slot)};
+        auto const end{depth + extension.length};
+        auto const split{MismatchAt(extension.key, key, depth, end)};
+        if (split == end) {
+          if (not Insert(extension.child, end, key, value)) {
+            return false;
+          }
+          extension.reference = {};
+          return true;
+        }
+        // a branch where the paths part, the rest of the extension and the new leaf below it
+        auto branch{std::make_unique<Branch>()};
+        auto& extension_side{branch->children[NibbleAt(extension.key, split)]};
+        if (split + 1 == end) {
+          extension_side = std::move(extension.child);
+        } else {
+          extension.depth = static_cast<std::uint8_t>(split + 1);
+          extension.length = static_cast<std::uint8_t>(end - split - 1);
+          extension.reference = {};
+          extension_side = std::move(slot);
+        }
+        branch->children[NibbleAt(key, split)] = std::make_unique<Leaf>(key, split + 1, std::move(value));
+        slot = AtDepth(std::move(branch), key, depth, split);
+        return true;
+      }
+
+      case Node::Kind::kBranch: {
+        auto& branch{static_cast<Branch&>(*slot)};
+        if (not Insert(branch.children[NibbleAt(key, depth)], depth + 1, key, value)) {
+          return false;
+        }
+        branch.reference = {};
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Erases from the subtree in `slot`, whose path starts at nibble `depth`, and folds nodes left with a single child
+  // into their neighbours, so the trie stays canonical; returns whether anything changed.
+  static auto Erase(std::unique_ptr<Node>& slot, std::size_t depth, Hash const& key) -> bool {
+    if (not slot) {
+      return false;
+    }
+
+    switch (slot->kind) {
+      case Node::Kind::kLeaf:
+        if (static_cast<Leaf&>(*slot).key != key) {
+          return false;
+        }
+        slot.reset();
+        return true;
+
+      case Node::Kind::kExtension: {
+        auto& extension{static_cast<Extension&>(*slot)};
+        auto const end{depth + extension.length};
+        if (MismatchAt(extension.key, key, depth, end) != end or not Erase(extension.child, end, key)) {
+          return false;
+        }
+        extension.reference = {};
+        // the branch below lost its second-to-last child and became a leaf or an extension, which absorbs this path
+        if (extension.child->kind == Node::Kind::kLeaf) {
+          auto& leaf{static_cast<Leaf&>(*extension.child)};
+          leaf.depth = extension.depth;
+          leaf.reference = {};
+          slot = std::move(extension.child);
+        } else if (extension.child->kind == Node::Kind::kExtension) {
+          auto& child{static_cast<Extension&>(*extension.child)};
+          child.depth = extension.depth;
+          child.length = static_cast<std::uint8_t>(child.length + extension.length);
+          child.reference = {};
+          slot = std::move(extension.child);
+        }
+        return true;
+      }
+
+      case Node::Kind::kBranch: {
+        auto& branch{static_cast<Branch&>(*slot)};
+        if (not Erase(branch.children[NibbleAt(key, depth)], depth + 1, key)) {
+          return false;
+        }
+        branch.reference = {};
+        if (std::ranges::count_if(branch.children, [](auto const& child) { return child != nullptr; }) > 1) {
+          return true;
+        }
+        // a single child left: it takes the branch's place, its path one nibble longer
+        auto& last_child{*std::ranges::find_if(branch.children, [](auto const& child) { return child != nullptr; })};
+        switch (last_child->kind) {
+          case Node::Kind::kLeaf: {
+            auto& leaf{static_cast<Leaf&>(*last_child)};
+            leaf.depth = static_cast<std::uint8_t>(depth);
+            leaf.reference = {};
+            slot = std::move(last_child);
+            break;
+          }
+          case Node::Kind::kExtension: {
+            auto& extension{static_cast<Extension&>(*last_child)};
+            extension.depth = static_cast<std::uint8_t>(depth);
+            extension.length++;
+            extension.reference = {};
+            slot = std::move(last_child);
+            break;
+          }
+          case Node::Kind::kBranch: {
+            auto const& sample_key{SampleKey(*last_child)};
+            slot = std::make_unique<Extension>(sample_key, depth, 1, std::move(last_child));
+            break;
+          }
+        }
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+// The account trie over per-account storage tries, updated with the state writes of each block. Nonces are not
+// modelled (the interpreter has no transactions that would bump them), so every account has nonce 0.
+class StateTrie final {
+ public:
+  StateTrie() = default;
+
+  // Builds the tries for `accounts` from scratch.
+  explicit StateTrie(Accounts const& accounts, std::size_t thread_count = 1) {
+    StateWrites writes{};
+    for (auto const& [address, account] : accounts) {
+      writes.emplace(StateKey::Balance(address), account.balance);
+      for (auto const& [slot, value] : account.storage) {
+        writes.emplace(StateKey::Storage(address, slot), value);
+      }
+      SetCode(address, account.code);
+    }
+    Apply(writes, thread_count);
+  }
+
+  auto SetCode(word_t const& address, std::span<std::byte const> code) -> void {
+    auto& account{FindOrAdd(address)};
+    account.code_hash = Keccak256(code);
+    MarkDirty(address, account);
+  }
+
+  // Applies the balances and storage values in `writes`; keys are hashed on `thread_count` threads.
+  auto Apply(StateWrites const& writes, std::size_t thread_count = 1) -> void {
+    std::vector<StateWrites::value_type const*> entries{};
+    entries.reserve(writes.size());
+    for (auto const& entry : writes) {
+      entries.push_back(&entry);
+    }
+    std::vector<Hash> hashed_slots(entries.size());
+    ParallelFor(entries.size(), thread_count, [&](std::size_t index) {
+      if (not entries[index]->first.is_balance) {
+        hashed_slots[index] = Keccak256(ToHash(entries[index]->first.slot));
+      }
+    });
+
+    std::vector<std::byte> value{};
+    for (std::size_t index{0}; index < entries.size(); ++index) {
+      auto const& [key, word]{*entries[index]};
+      auto& account{FindOrAdd(key.address)};
+      if (key.is_balance) {
+        account.balance = word;
+      } else {
+        value.clear();
+        if (word != 0) {
+          rlp::Encoder{value}.AppendWord(word);
+        }
+        account.storage.Put(hashed_slots[index], value);
+      }
+      MarkDirty(key.address, account);
+    }
+  }
+
+  // The state root, hashing subtrees of the tries on `thread_count` threads: first the storage tries of the accounts
+  // written since the last root, then the account trie their new storage roots go into.
+  auto RootHash(std::size_t thread_count = 1) -> Hash {
+    constexpr std::size_t kParallelLevels{2};
+
+    std::vector<Node*> subtrees{};
+    for (auto const& address : m_dirty_accounts) {
+      m_accounts.at(address).storage.CollectDirtySubtrees(subtrees, kParallelLevels);
+    }
+    ParallelFor(subtrees.size(), thread_count, [&subtrees](std::size_t index) { Commit(*subtrees[index]); });
+
+    std::vector<std::byte> encoded_account{};
+    for (auto const& address : m_dirty_accounts) {
+      auto& account{m_accounts.at(address)};
+      account.is_dirty = false;
+      if (account.balance == 0 and account.code_hash == EmptyCodeHash() and account.storage.Empty()) {
+        // empty accounts are not part of the state
+        m_account_trie.Erase(account.hashed_address);
+        continue;
+      }
+      encoded_account.clear();
+      rlp::Encoder encoder{encoded_account};
+      auto const list{encoder.BeginList()};
+      encoder.AppendWord(0);
+      encoder.AppendWord(account.balance);
+      encoder.AppendString(account.storage.RootHash());
+      encoder.AppendString(account.code_hash);
+      encoder.EndList(list);
+      m_account_trie.Put(account.hashed_address, encoded_account);
+    }
+    m_dirty_accounts.clear();
+
+    subtrees.clear();
+    m_account_trie.CollectDirtySubtrees(subtrees, kParallelLevels);
+    ParallelFor(subtrees.size(), thread_count, [&subtrees](std::size_t index) { Commit(*subtrees[index]); });
+    return m_account_trie.RootHash();
+  }
+
+ private:
+  struct AccountState {
+    Hash hashed_address{};
+    word_t balance{0};
+    Hash code_hash{EmptyCodeHash()};
+    Trie storage{};
+    bool is_dirty{false};
+  };
+
+  std::unordered_map<word_t, AccountState, WordHash> m_accounts{};
+  Trie m_account_trie{};
+  std::vector<word_t> m_dirty_accounts{};
+
+  static auto EmptyCodeHash() -> Hash const& {
+    static auto const empty_code_hash{Keccak256({})};
+    return empty_code_hash;
+  }
+
+  auto FindOrAdd(word_t const& address) -> AccountState& {
+    auto const [account, inserted]{m_accounts.try_emplace(address)};
+    if (inserted) {
+      // addresses are hashed as their 20 bytes
+      auto const address_bytes{ToHash(address)};
+      account->second.hashed_address = Keccak256(std::span{address_bytes}.last(20));
+    }
+    return account->second;
+  }
+
+  auto MarkDirty(word_t const& address, AccountState& account) -> void {
+    if (not account.is_dirty) {
+      account.is_dirty = true;
+      m_dirty_accounts.push_back(address);
+    }
+  }
+};
+
+}  // namespace evmint::trie
@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+#include "interpreter.hpp"
+
+namespace evmint {
+
+// Fixed set of worker threads, each owning one reusable Interpreter (so its JIT cache survives across tasks). The
+// interpreter is constructed on its worker thread, so its stack and memory are first touched (and placed) there.
+class WorkerPool final {
+ public:
+  using task_t = std::function<void(std::size_t worker_index, Interpreter& interpreter)>;
+
+  WorkerPool(std::size_t worker_count, InterpreterOptions options) {
+    m_workers.reserve(worker_count);
+    for (std::size_t worker_index{0}; worker_index < worker_count; ++worker_index) {
+      m_workers.emplace_back([this, worker_index, options](std::stop_token stop_token) { RunWorker(stop_token, worker_index, options); });
+    }
+  }
+
+  auto WorkerCount() const -> std::size_t { return m_workers.size(); }
+
+  // Runs `task` once on every worker and blocks until all of them returned. Not reentrant.
+  auto RunOnEveryWorker(task_t const& task) -> void {
+    {
+      std::scoped_lock const lock{m_mutex};
+      m_task = &task;
+      m_busy_workers = m_workers.size();
+      m_generation++;
+    }
+    m_task_ready.notify_all();
+
+    for (auto busy_workers{m_busy_workers.load()}; busy_workers != 0; busy_workers = m_busy_workers.load()) {
+      m_busy_workers.wait(busy_workers);
+    }
+  }
+
+ private:
+  std::mutex m_mutex{};
+  std::condition_variable_any m_task_ready{};
+  std::size_t m_generation{0};
+  task_t const* m_task{nullptr};
+  std::atomic<std::size_t> m_busy_workers{0};
+
+  // last member: joined before anything the workers use is destroyed
+  std::vector<std::jthread> m_workers{};
+
+  auto RunWorker(std::stop_token stop_token, std::size_t worker_index, InterpreterOptions options) -> void {
+    Interpreter interpreter{options};
+    std::size_t generation{0};
+
+    while (true) {
+      task_t const* task{nullptr};
+      {
+        std::unique_lock lock{m_mutex};
+        if (not m_task_ready.wait(lock, stop_token, [this, generation] { return m_generation != generation; })) {
+          return;
+        }
+        generation = m_generation;
+        task = m_task;
+      }
+
+      (*task)(worker_index, interpreter);
+
+      if (m_busy_workers.fetch_sub(1) == 1) {
+        m_busy_workers.notify_all();
+      }
+    }
+  }
+};
+
+}  // namespace evmint